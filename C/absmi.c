@@ -763,7 +763,10 @@ Yap_absmi(int inp)
 
   {
     op_numbers opcode = _Ystop;
-    op_numbers old_op;
+    op_numbers old_op = _Ystop;
+#ifdef ANALYST
+    op_numbers old_old_op = _Ystop;
+#endif
 #ifdef DEBUG_XX
     unsigned long ops_done;
 #endif
@@ -772,20 +775,27 @@ Yap_absmi(int inp)
 
   nextop_write:
 
+#ifdef ANALYST
+    old_old_op = old_op;
+#endif
     old_op = opcode;
     opcode = PREG->u.o.opcw;
     goto op_switch;
 
   nextop:
 
+#ifdef ANALYST
+    old_old_op = old_op;
+#endif
     old_op = opcode;
     opcode = PREG->opc;
 
   op_switch:
 
 #ifdef ANALYST
-    GLOBAL_opcount[opcode]++;
-    GLOBAL_2opcount[old_op][opcode]++;
+    LOCAL_opcount[opcode]++;
+    LOCAL_opcount2[old_op][opcode]++;
+    Yap_count_op_triple(old_old_op, old_op, opcode);
 #ifdef DEBUG_XX
     ops_done++;
     /*    if (B->cp_b > 0x103fff90)
@@ -957,6 +967,117 @@ Yap_absmi(int inp)
       GONext();
       ENDOp();
 
+/*****************************************************************
+*        Exo predicates: tables of ground facts                  *
+*****************************************************************/
+
+      /* exo    NArgs,Pred */
+      BOp(exo, Otapl);
+      {
+	PredEntry *ap = PREG->u.Otapl.p;
+	UInt arity = ap->ArityOfPE, next;
+
+	saveregs();
+	SREG = Yap_ExoFirst(ap, &next PASS_REGS);
+	setregs();
+	if (!SREG) {
+	  FAIL();
+	}
+	if (next) {
+	  /* more rows may match, remember where to restart */
+	  check_trail(TR);
+	  XREGS[arity+1] = MkIntTerm(next);
+	  CACHE_Y(YREG);
+	  store_args(PREG->u.Otapl.s);
+	  store_yaam_regs(NEXTOP(PREG, Otapl), 0);
+	  set_cut(S_YREG, B);
+	  B = B_YREG;
+#ifdef YAPOR
+	  SCH_set_load(B_YREG);
+#endif	/* YAPOR */
+	  SET_BB(B_YREG);
+	  ENDCACHE_Y();
+	}
+      }
+      goto exo_unify;
+      ENDBOp();
+
+      /* retry_exo    NArgs,Pred */
+      BOp(retry_exo, Otapl);
+      {
+	PredEntry *ap = PREG->u.Otapl.p;
+	UInt arity = ap->ArityOfPE, next;
+
+	CACHE_Y(B);
+	restore_yaam_regs(PREG);
+	restore_args(PREG->u.Otapl.s);
+	ENDCACHE_Y();
+	saveregs();
+	SREG = Yap_ExoNext(ap, IntOfTerm(XREGS[arity+1]), &next PASS_REGS);
+	setregs();
+	CACHE_Y(B);
+	if (next) {
+	  ((CELL *)(B_YREG+1))[arity] = MkIntTerm(next);
+#ifdef FROZEN_STACKS
+	  S_YREG = (CELL *) PROTECT_FROZEN_B(B_YREG);
+	  set_cut(S_YREG, B->cp_b);
+#else
+	  set_cut(S_YREG, B_YREG->cp_b);
+#endif /* FROZEN_STACKS */
+	} else
+#ifdef YAPOR
+	if (SCH_top_shared_cp(B)) {
+	  SCH_last_alternative(PREG, B_YREG);
+#ifdef FROZEN_STACKS
+	  S_YREG = (CELL *) PROTECT_FROZEN_B(B_YREG);
+#endif /* FROZEN_STACKS */
+	  set_cut(S_YREG, B->cp_b);
+	} else
+#endif	/* YAPOR */
+	{
+	  /* this was the last matching row */
+	  pop_yaam_regs();
+	  pop_args(PREG->u.Otapl.s);
+#ifdef FROZEN_STACKS
+	  S_YREG = (CELL *) PROTECT_FROZEN_B(B_YREG);
+#endif /* FROZEN_STACKS */
+	  set_cut(S_YREG, B);
+	}
+	SET_BB(B_YREG);
+	ENDCACHE_Y();
+      }
+    exo_unify:
+      /* SREG points to the row, bind the free arguments */
+      BEGD(d0);
+      BEGP(pt0);
+      {
+	UInt i, arity = PREG->u.Otapl.p->ArityOfPE;
+
+	for (i = 0; i < arity; i++) {
+	  d0 = XREGS[i+1];
+	  deref_head(d0, exo_unk);
+	exo_nonvar:
+	  if (d0 != SREG[i]) {
+	    FAIL();
+	  }
+	  continue;
+
+	  deref_body(d0, pt0, exo_unk, exo_nonvar);
+	  Bind(pt0, SREG[i]);
+	}
+      }
+      ENDP(pt0);
+      ENDD(d0);
+      PREG = CPREG;
+      /* for profiler */
+      save_pc();
+      YREG = ENV;
+#ifdef DEPTH_LIMIT
+      DEPTH = YREG[E_DEPTH];
+#endif
+      JMPNext();
+      ENDBOp();
+
 /*****************************************************************
 *        Profiled try - retry - trust instructions               *
 *****************************************************************/
@@ -2004,6 +2125,7 @@ Yap_absmi(int inp)
 	      case _profiled_retry_and_mark:
 	      case _retry:
 	      case _trust:
+	      case _retry_exo:
 		low_level_trace(retry_pred, ipc->u.Otapl.p, B->cp_args);
 		break;
 	      case _try_logical:
@@ -2121,6 +2243,11 @@ Yap_absmi(int inp)
 		  PredEntry *ap = cl->ClPred;
 #endif
 
+#if THREADS
+		  if (!(cl->ClFlags & (ErasedMask|DirtyMask)) &&
+		      drop_clref_unless_last(&cl->ClRefCount))
+		    goto failloop;
+#endif
 		  PELOCK(8,ap);
 		  DEC_CLREF_COUNT(cl);
 		  erase = (cl->ClFlags & ErasedMask) && !(cl->ClRefCount);
@@ -2147,6 +2274,10 @@ Yap_absmi(int inp)
 		  PredEntry *ap = cl->ClPred;
 #endif
 
+#if THREADS
+		  if (drop_clref_unless_last(&cl->ClRefCount))
+		    goto failloop;
+#endif
 		  PELOCK(9,ap);
 		  DEC_CLREF_COUNT(cl);
 //		  fprintf(stderr,"%d %p=%lx\n",worker_id, cl, cl->ClRefCount);
@@ -4286,6 +4417,85 @@ Yap_absmi(int inp)
       ENDD(d0);
       ENDOpRW();
 
+      /* get_list followed by unify_x_val and unify_last_x_var:
+	 the head of a list that is threaded through a recursive call */
+      OpRW(glist_valx_varx, xxx);
+      BEGD(d0);
+      d0 = XREG(PREG->u.xxx.x);
+      deref_head(d0, glist_valx_varx_write);
+    glist_valx_varx_read:
+      BEGP(pt0);
+      /* did we find a list? */
+      if (!IsPairTerm(d0))
+	FAIL();
+      START_PREFETCH(xxx);
+      pt0 = RepPair(d0);
+      BEGD(d1);
+      d1 = XREG(PREG->u.xxx.x1);
+      /* the tail register may be the same as the list or head register */
+      XREG(PREG->u.xxx.x2) = pt0[1];
+      PREG = NEXTOP(PREG, xxx);
+      /* start unification with first argument */
+      d0 = *pt0;
+      deref_head(d0, glist_valx_varx_unk);
+
+    glist_valx_varx_nonvar:
+      /* first argument is bound */
+      deref_head(d1, glist_valx_varx_nonvar_unk);
+
+    glist_valx_varx_nonvar_nonvar:
+      /* both arguments are bound */
+      UnifyBound(d0, d1);
+
+      BEGP(pt1);
+      /* deref second argument */
+      deref_body(d1, pt1, glist_valx_varx_nonvar_unk, glist_valx_varx_nonvar_nonvar);
+      /* head bound, argument unbound */
+      Bind(pt1, d0);
+      GONext();
+      ENDP(pt1);
+
+      /* head may be unbound */
+      derefa_body(d0, pt0, glist_valx_varx_unk, glist_valx_varx_nonvar);
+      /* head is unbound, pt0 has the value */
+      deref_head(d1, glist_valx_varx_var_unk);
+
+    glist_valx_varx_var_nonvar:
+      /* head is unbound, second arg bound */
+      Bind_Global(pt0, d1);
+      GONext();
+
+      BEGP(pt1);
+      deref_body(d1, pt1, glist_valx_varx_var_unk, glist_valx_varx_var_nonvar);
+      /* head and second argument are unbound */
+      UnifyGlobalCellToCell(pt0, pt1);
+      GONext();
+      ENDP(pt1);
+      ENDD(d1);
+      END_PREFETCH();
+      ENDP(pt0);
+
+      BEGP(pt0);
+      deref_body(d0, pt0, glist_valx_varx_write, glist_valx_varx_read);
+      /* build the list cell, the tail is a fresh variable */
+      START_PREFETCH(xxx);
+      BEGP(pt1);
+      pt1 = H;
+      pt1[0] = XREG(PREG->u.xxx.x1);
+      RESET_VARIABLE(pt1+1);
+      XREG(PREG->u.xxx.x2) = (CELL)(pt1+1);
+      H = pt1 + 2;
+      d0 = AbsPair(pt1);
+      ENDP(pt1);
+      Bind(pt0, d0);
+      PREG = NEXTOP(PREG, xxx);
+      GONext();
+      END_PREFETCH();
+      ENDP(pt0);
+
+      ENDD(d0);
+      ENDOpRW();
+
       OpRW(glist_valy, yx);
       BEGD(d0);
       d0 = XREG(PREG->u.yx.x);
@@ -7351,6 +7561,12 @@ Yap_absmi(int inp)
       BOp(lock_pred, e);
       {
 	PredEntry *ap = PredFromDefCode(PREG);
+#if THREADS
+	/* no clauses when we were called: no need to wait for writers */
+	if (!ap->cs.p_code.NOfClauses) {
+	  FAIL();
+	}
+#endif
  	PELOCK(10,ap);
 	PP = ap;
 	if (!ap->cs.p_code.NOfClauses) {
@@ -7589,6 +7805,18 @@ Yap_absmi(int inp)
 	  /* IPred can generate errors, it thus must get rid of the lock itself */
 	  setregs();
 	}
+#ifdef TABLING_INCREMENTAL
+	/* the tables being evaluated now depend on this predicate */
+	if ((pe->ExtraPredFlags & IncrementalPredFlag)) {
+	  if (LOCAL_top_sg_fr)
+	    add_incremental_dependency(pe);
+	  if (!(pe->PredFlags & (CountPredFlag|ProfiledPredFlag|SpiedPredFlag))) {
+	    PREG = pe->cs.p_code.TrueCodeOfPred;
+	    UNLOCKPE(102,pe);
+	    JMPNext();
+	  }
+	}
+#endif /* TABLING_INCREMENTAL */
 	/* first check if we need to increase the counter */
 	if ((pe->PredFlags & CountPredFlag)) {
 	  LOCK(pe->StatisticsForPred.lock);
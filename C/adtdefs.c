@@ -36,6 +36,7 @@ Prop	STD_PROTO(PredPropByAtom,(Atom, Term));
 #if HAVE_STRING_H
 #include <string.h>
 #endif
+#include <stdlib.h>
 
 /* this routine must be run at least having a read lock on ae */
 static Prop
@@ -155,44 +156,122 @@ SearchWideAtom(wchar_t *p, Atom a) {
   return(NIL);
 }
 
+/*
+  Atom lookup does not lock the hash chains: atoms are only added at
+  the head of a chain, and are fully initialised before they are made
+  visible, so a reader either sees the new atom or misses it and goes
+  on to the locked slow path.
+
+  Creating an atom takes the write lock for its chain, and a read lock
+  on the whole table to keep growatomtable() away.
+*/
+#if defined(YAPOR) || defined(THREADS)
+#define AtomTableAcquire() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define AtomTableRelease() __atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+#define AtomTableAcquire()
+#define AtomTableRelease()
+#endif
+
+static inline Atom
+SearchAtomTable(unsigned char *p, CELL hash)
+{
+#if defined(YAPOR) || defined(THREADS)
+  AtomHashEntry *table;
+  UInt sz, epoch;
+  Atom a;
+#ifdef THREADS
+  REGSTORE *regcache = (REGSTORE *)pthread_getspecific(Yap_yaamregs_key);
+
+  if (regcache == NULL) {
+    /* not a Prolog thread, go the slow way */
+    return NIL;
+  }
+#endif
+  /* growatomtable() makes the epoch odd while it replaces the table
+     and its size, so if the epoch is even and did not move we have a
+     matching pair. The hazard tells growatomtable() which table we are
+     reading: it will not release the table while we are there */
+  do {
+    epoch = __atomic_load_n(&AtomTableEpoch, __ATOMIC_SEQ_CST);
+    if (epoch & 1) {
+      /* the slow way waits for the new table */
+      __atomic_store_n(&LOCAL_AtomTableHazard, NULL, __ATOMIC_RELEASE);
+      return NIL;
+    }
+    sz = __atomic_load_n(&AtomHashTableSize, __ATOMIC_SEQ_CST);
+    table = __atomic_load_n(&HashChain, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&LOCAL_AtomTableHazard, table, __ATOMIC_SEQ_CST);
+  } while (epoch != __atomic_load_n(&AtomTableEpoch, __ATOMIC_SEQ_CST));
+  AtomTableAcquire();
+  a = SearchAtom(p, table[hash % sz].Entry);
+  __atomic_store_n(&LOCAL_AtomTableHazard, NULL, __ATOMIC_RELEASE);
+  return a;
+#else
+  return SearchAtom(p, HashChain[hash % AtomHashTableSize].Entry);
+#endif
+}
+
+#if !defined(YAPOR) && !defined(THREADS)
+/* at most this many atoms are remembered between atom collections */
+#define MAX_YOUNG_ATOMS (1024*1024)
+
+/* remember new atoms, so that a minor atom collection can find them */
+static void
+LogYoungAtom(Atom a)
+{
+  if (GLOBAL_n_young_atoms == GLOBAL_young_atoms_size) {
+    UInt nsz = (GLOBAL_young_atoms_size ? 2*GLOBAL_young_atoms_size : 4096);
+    Atom *nlog;
+
+    if (GLOBAL_young_atoms_overflow)
+      return;
+    if (nsz > MAX_YOUNG_ATOMS ||
+	!(nlog = (Atom *)realloc(GLOBAL_young_atoms, nsz*sizeof(Atom)))) {
+      /* the next atom collection will have to look at every atom */
+      GLOBAL_young_atoms_overflow = TRUE;
+      return;
+    }
+    GLOBAL_young_atoms = nlog;
+    GLOBAL_young_atoms_size = nsz;
+  }
+  GLOBAL_young_atoms[GLOBAL_n_young_atoms++] = a;
+}
+#endif
+
 static Atom
 LookupAtom(char *atom)
 {				/* lookup atom in atom table            */
-  register CELL hash;
-  register unsigned char *p;
+  CELL hash;
+  unsigned char *p;
   Atom a, na;
   AtomEntry *ae;
 
   /* compute hash */
   p = (unsigned char *)atom;
-  hash = HashFunction(p) % AtomHashTableSize;
-  /* we'll start by holding a read lock in order to avoid contention */
-  READ_LOCK(HashChain[hash].AERWLock);
-  a = HashChain[hash].Entry;
-  /* search atom in chain */
-  na = SearchAtom((unsigned char *)atom, a);
+  hash = HashFunction(p);
+  /* most of the time the atom is already there */
+  na = SearchAtomTable(p, hash);
   if (na != NIL) {
-    READ_UNLOCK(HashChain[hash].AERWLock);
-    return(na);
+    return na;
   }
-  READ_UNLOCK(HashChain[hash].AERWLock);
   /* we need a write lock */
+  READ_LOCK(AtomTableRWLock);
+  hash %= AtomHashTableSize;
   WRITE_LOCK(HashChain[hash].AERWLock);
-  /* concurrent version of Yap, need to take care */
-#if defined(YAPOR) || defined(THREADS)
-  if (a != HashChain[hash].Entry) {
-    a = HashChain[hash].Entry;
-    na = SearchAtom((unsigned char *)atom, a);
-    if (na != NIL) {
-      WRITE_UNLOCK(HashChain[hash].AERWLock);
-      return(na);
-    }
+  a = HashChain[hash].Entry;
+  /* somebody may have got there first, or the table may have grown */
+  na = SearchAtom(p, a);
+  if (na != NIL) {
+    WRITE_UNLOCK(HashChain[hash].AERWLock);
+    READ_UNLOCK(AtomTableRWLock);
+    return(na);
   }
-#endif  
   /* add new atom to start of chain */
   ae = (AtomEntry *) Yap_AllocAtomSpace((sizeof *ae) + strlen(atom) + 1);
   if (ae == NULL) {
     WRITE_UNLOCK(HashChain[hash].AERWLock);
+    READ_UNLOCK(AtomTableRWLock);
     return NIL;
   }
   NOfAtoms++;
@@ -201,9 +280,14 @@ LookupAtom(char *atom)
   if (ae->StrOfAE != atom)
     strcpy(ae->StrOfAE, atom);
   ae->NextOfAE = a;
-  HashChain[hash].Entry = na;
   INIT_RWLOCK(ae->ARWLock);
+  AtomTableRelease();
+  HashChain[hash].Entry = na;
   WRITE_UNLOCK(HashChain[hash].AERWLock);
+  READ_UNLOCK(AtomTableRWLock);
+#if !defined(YAPOR) && !defined(THREADS)
+  LogYoungAtom(na);
+#endif
   if (NOfAtoms > 2*AtomHashTableSize) {
     Yap_signal(YAP_CDOVF_SIGNAL);
   }
@@ -223,16 +307,12 @@ LookupWideAtom(wchar_t *atom)
   /* compute hash */
   p = atom;
   hash = WideHashFunction(p) % WideAtomHashTableSize;
-  /* we'll start by holding a read lock in order to avoid contention */
-  READ_LOCK(WideHashChain[hash].AERWLock);
+  /* the wide atom table never grows, so we can just search it */
   a = WideHashChain[hash].Entry;
-  /* search atom in chain */
   na = SearchWideAtom(atom, a);
   if (na != NIL) {
-    READ_UNLOCK(WideHashChain[hash].AERWLock);
     return(na);
   }
-  READ_UNLOCK(WideHashChain[hash].AERWLock);
   /* we need a write lock */
   WRITE_LOCK(WideHashChain[hash].AERWLock);
   /* concurrent version of Yap, need to take care */
@@ -263,8 +343,9 @@ LookupWideAtom(wchar_t *atom)
     wcscpy((wchar_t *)(ae->StrOfAE), atom);
   NOfAtoms++;
   ae->NextOfAE = a;
-  WideHashChain[hash].Entry = na;
   INIT_RWLOCK(ae->ARWLock);
+  AtomTableRelease();
+  WideHashChain[hash].Entry = na;
   WRITE_UNLOCK(WideHashChain[hash].AERWLock);
   if (NOfWideAtoms > 2*WideAtomHashTableSize) {
     Yap_signal(YAP_CDOVF_SIGNAL);
@@ -817,6 +898,7 @@ Yap_NewPredPropByFunctor(FunctorEntry *fe, Term cur_mod)
   p->cs.p_code.FirstClause = p->cs.p_code.LastClause = NULL;
   p->cs.p_code.NOfClauses = 0;
   p->PredFlags = 0L;
+  p->ExtraPredFlags = 0L;
   p->src.OwnerFile = AtomNil;
   p->OpcodeOfPred = UNDEF_OPCODE;
   p->CodeOfPred = p->cs.p_code.TrueCodeOfPred = (yamop *)(&(p->OpcodeOfPred)); 
@@ -832,9 +914,15 @@ Yap_NewPredPropByFunctor(FunctorEntry *fe, Term cur_mod)
   p->StatisticsForPred.NOfEntries = 0;
   p->StatisticsForPred.NOfHeadSuccesses = 0;
   p->StatisticsForPred.NOfRetries = 0;
+  p->IndexStatsOfPred.NOfTrees = 0;
+  p->IndexStatsOfPred.ArgsSwitched = 0;
+  p->IndexStatsOfPred.IndexBytes = 0;
 #ifdef TABLING
   p->TableOfPred = NULL;
 #endif /* TABLING */
+#ifdef TABLING_INCREMENTAL
+  p->IncrementalTimeStampOfPred = 0;
+#endif /* TABLING_INCREMENTAL */
 #ifdef BEAM
   p->beamTable = NULL;
 #endif  /* BEAM */
@@ -869,6 +957,7 @@ Yap_NewThreadPred(PredEntry *ap USES_REGS)
   p->cs.p_code.FirstClause = p->cs.p_code.LastClause = NULL;
   p->cs.p_code.NOfClauses = 0;
   p->PredFlags = ap->PredFlags & ~(IndexedPredFlag|SpiedPredFlag);
+  p->ExtraPredFlags = ap->ExtraPredFlags;
   p->src.OwnerFile = ap->src.OwnerFile;
   p->OpcodeOfPred = UNDEF_OPCODE;
   p->CodeOfPred = p->cs.p_code.TrueCodeOfPred = (yamop *)(&(p->OpcodeOfPred)); 
@@ -881,9 +970,15 @@ Yap_NewThreadPred(PredEntry *ap USES_REGS)
   p->StatisticsForPred.NOfEntries = 0;
   p->StatisticsForPred.NOfHeadSuccesses = 0;
   p->StatisticsForPred.NOfRetries = 0;
+  p->IndexStatsOfPred.NOfTrees = 0;
+  p->IndexStatsOfPred.ArgsSwitched = 0;
+  p->IndexStatsOfPred.IndexBytes = 0;
 #ifdef TABLING
   p->TableOfPred = NULL;
 #endif /* TABLING */
+#ifdef TABLING_INCREMENTAL
+  p->IncrementalTimeStampOfPred = 0;
+#endif /* TABLING_INCREMENTAL */
 #ifdef BEAM
   p->beamTable = NULL;
 #endif 
@@ -918,6 +1013,7 @@ Yap_NewPredPropByAtom(AtomEntry *ae, Term cur_mod)
   p->cs.p_code.FirstClause = p->cs.p_code.LastClause = NULL;
   p->cs.p_code.NOfClauses = 0;
   p->PredFlags = 0L;
+  p->ExtraPredFlags = 0L;
   p->src.OwnerFile = AtomNil;
   p->OpcodeOfPred = UNDEF_OPCODE;
   p->cs.p_code.ExpandCode = EXPAND_OP_CODE; 
@@ -931,11 +1027,17 @@ Yap_NewPredPropByAtom(AtomEntry *ae, Term cur_mod)
   p->StatisticsForPred.NOfEntries = 0;
   p->StatisticsForPred.NOfHeadSuccesses = 0;
   p->StatisticsForPred.NOfRetries = 0;
+  p->IndexStatsOfPred.NOfTrees = 0;
+  p->IndexStatsOfPred.ArgsSwitched = 0;
+  p->IndexStatsOfPred.IndexBytes = 0;
   p->TimeStampOfPred = 0L; 
   p->LastCallOfPred = LUCALL_ASSERT; 
 #ifdef TABLING
   p->TableOfPred = NULL;
 #endif /* TABLING */
+#ifdef TABLING_INCREMENTAL
+  p->IncrementalTimeStampOfPred = 0;
+#endif /* TABLING_INCREMENTAL */
 #ifdef BEAM
   p->beamTable = NULL;
 #endif 
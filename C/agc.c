@@ -37,12 +37,44 @@ STATIC_PROTO(void  CleanCode, (PredEntry * USES_REGS));
 
 #define AtomMarkedBit 1
 
+/* every AGC_MAJOR_PERIOD collections we also sweep the old atoms */
+#define AGC_MAJOR_PERIOD 8
+
+/*
+ * Minor collections only sweep the atoms created since the last
+ * collection. Marking is still complete, so we remember which atoms
+ * we marked and clean them up without walking the whole atom table.
+ */
+static void
+PushMarkedAtom(AtomEntry *ae)
+{
+  if (GLOBAL_n_agc_marked == GLOBAL_agc_marked_size) {
+    UInt nsz = 2*GLOBAL_agc_marked_size;
+    Atom *nstk = (Atom *)realloc(GLOBAL_agc_marked, nsz*sizeof(Atom));
+
+    if (!nstk) {
+      /* give up, we will have to do a major collection */
+      free(GLOBAL_agc_marked);
+      GLOBAL_agc_marked = NULL;
+      return;
+    }
+    GLOBAL_agc_marked = nstk;
+    GLOBAL_agc_marked_size = nsz;
+  }
+  GLOBAL_agc_marked[GLOBAL_n_agc_marked++] = AbsAtom(ae);
+}
+
 static inline void
 MarkAtomEntry(AtomEntry *ae)
 {
   CELL c = (CELL)(ae->NextOfAE);
+
+  if (c & AtomMarkedBit)
+    return;
   c |= AtomMarkedBit;
   ae->NextOfAE = (Atom)c;
+  if (GLOBAL_agc_marked)
+    PushMarkedAtom(ae);
 }
 
 static inline int
@@ -189,6 +221,8 @@ AtomAdjust(Atom a)
 
 #define RestoreSWIHash()
 
+#define RestoreExoIndex(P)
+
 #include "rheap.h"
 
 static void
@@ -461,8 +495,61 @@ clean_atoms(void)
   }
 }
 
+static int
+init_minor_agc(void)
+{
+  GLOBAL_n_agc_marked = 0;
+  GLOBAL_agc_marked_size = 4096;
+  GLOBAL_agc_marked = (Atom *)malloc(GLOBAL_agc_marked_size*sizeof(Atom));
+  return GLOBAL_agc_marked != NULL;
+}
+
+static void
+clean_young_atoms(void)
+{
+  UInt i, n = 0;
+  Atom *young = GLOBAL_young_atoms;
+
+  /* first decide, while the marks are still there */
+  for (i = 0; i < GLOBAL_n_young_atoms; i++) {
+    Atom atm = young[i];
+    AtomEntry *at = RepAtom(atm);
+
+    /* survivors are promoted, the next major collection will see them */
+    if (AtomResetMark(at) ||
+	at->PropsOfAE != NIL ||
+	(GLOBAL_AGCHook != NULL && !GLOBAL_AGCHook(atm)))
+      continue;
+    young[n++] = atm;
+  }
+  for (i = 0; i < GLOBAL_n_agc_marked; i++) {
+    AtomResetMark(RepAtom(GLOBAL_agc_marked[i]));
+  }
+  free(GLOBAL_agc_marked);
+  GLOBAL_agc_marked = NULL;
+  /* now the hash chains are clean, and we can unlink the garbage */
+  for (i = 0; i < n; i++) {
+    AtomEntry *at = RepAtom(young[i]);
+    UInt hash = HashFunction((unsigned char *)at->StrOfAE) % AtomHashTableSize;
+    Atom *patm = &(HashChain[hash].Entry);
+
+    while (*patm != NIL && *patm != young[i])
+      patm = &(RepAtom(*patm)->NextOfAE);
+    /* hidden atoms are not in the hash table */
+    if (*patm == NIL)
+      continue;
+    *patm = at->NextOfAE;
+#ifdef DEBUG_RESTORE3
+    fprintf(stderr, "Purged young %p:%s\n", at, at->StrOfAE);
+#endif
+    NOfAtoms--;
+    GLOBAL_agc_collected += sizeof(AtomEntry)+strlen(at->StrOfAE);
+    Yap_FreeCodeSpace((char *)at);
+  }
+}
+
 static void
-atom_gc(USES_REGS1)
+atom_gc(int major USES_REGS)
 {
   int		gc_verbose = Yap_is_gc_verbose();
   int           gc_trace = 0;
@@ -477,24 +564,42 @@ atom_gc(USES_REGS1)
 
   GLOBAL_agc_calls++;
   GLOBAL_agc_collected = 0;
+  if (GLOBAL_agc_calls % AGC_MAJOR_PERIOD == 0 ||
+      GLOBAL_young_atoms_overflow ||
+      NOfBlobs > NOfBlobsMax)
+    major = TRUE;
   
   if (gc_trace) {
     fprintf(GLOBAL_stderr, "%% agc:\n");
   } else if (gc_verbose) {
-    fprintf(GLOBAL_stderr, "%%   Start of atom garbage collection %d:\n", GLOBAL_agc_calls);
+    fprintf(GLOBAL_stderr, "%%   Start of %s atom garbage collection %d:\n", (major ? "major" : "minor"), GLOBAL_agc_calls);
   }
   time_start = Yap_cputime();
   /* get the number of active registers */
   YAPEnterCriticalSection();
+  if (!major && !init_minor_agc())
+    major = TRUE;
   init_reg_copies(PASS_REGS1);
   mark_stacks(PASS_REGS1);
   restore_codes();
-  clean_atoms();
-  NOfBlobsMax = NOfBlobs+(NOfBlobs/2+256< 1024 ? NOfBlobs/2+256 : 1024);
+  if (!major && !GLOBAL_agc_marked) {
+    /* we could not remember the marked atoms */
+    major = TRUE;
+  }
+  if (major) {
+    clean_atoms();
+    NOfBlobsMax = NOfBlobs+(NOfBlobs/2+256< 1024 ? NOfBlobs/2+256 : 1024);
+  } else {
+    clean_young_atoms();
+    GLOBAL_agc_minor_calls++;
+  }
+  Yap_ResetYoungAtoms();
   YAPLeaveCriticalSection();
   agc_time = Yap_cputime()-time_start;
   GLOBAL_tot_agc_time += agc_time;
   GLOBAL_tot_agc_recovered += GLOBAL_agc_collected;
+  if (agc_time > GLOBAL_agc_max_pause)
+    GLOBAL_agc_max_pause = agc_time;
   if (gc_verbose) {
 #ifdef _WIN32
     fprintf(GLOBAL_stderr, "%%   Collected %I64d bytes.\n", GLOBAL_agc_collected);
@@ -508,14 +613,22 @@ atom_gc(USES_REGS1)
 void
 Yap_atom_gc(USES_REGS1)
 {
-  atom_gc(PASS_REGS1);
+  atom_gc(FALSE PASS_REGS);
+}
+
+/* forget the atoms created so far, they are now considered old */
+void
+Yap_ResetYoungAtoms(void)
+{
+  GLOBAL_n_young_atoms = 0;
+  GLOBAL_young_atoms_overflow = FALSE;
 }
 
 static Int
 p_atom_gc(USES_REGS1)
 {
 #ifndef FIXED_STACKS
-  atom_gc(PASS_REGS1);
+  atom_gc(TRUE PASS_REGS);
 #endif  /* FIXED_STACKS */
   return TRUE;
 }
@@ -533,6 +646,17 @@ p_inform_agc(USES_REGS1)
     Yap_unify(ts, ARG3);
 }
 
+static Int
+p_inform_agc_pauses(USES_REGS1)
+{
+  Term tm = MkIntegerTerm(GLOBAL_agc_minor_calls);
+  Term tp = MkIntegerTerm(GLOBAL_agc_max_pause);
+
+  return
+    Yap_unify(tm, ARG1) &&
+    Yap_unify(tp, ARG2);
+}
+
 static Int
 p_agc_threshold(USES_REGS1)
 {
@@ -559,5 +683,6 @@ Yap_init_agc(void)
 {
   Yap_InitCPred("$atom_gc", 0, p_atom_gc, HiddenPredFlag);
   Yap_InitCPred("$inform_agc", 3, p_inform_agc, HiddenPredFlag);
+  Yap_InitCPred("$inform_agc_pauses", 2, p_inform_agc_pauses, HiddenPredFlag);
   Yap_InitCPred("$agc_threshold", 1, p_agc_threshold, HiddenPredFlag|SafePredFlag);
 }
@@ -151,13 +151,6 @@ call_malloc(unsigned long int size)
   return out;
 }
 
-char *
-Yap_AllocCodeSpace(unsigned long int size)
-{
-  size = AdjustSize(size);
-  return  call_malloc(size);
-}
-
 static inline char *
 call_realloc(char *p, unsigned long int size)
 {
@@ -186,15 +179,8 @@ call_realloc(char *p, unsigned long int size)
   return out;
 }
 
-char *
-Yap_ReallocCodeSpace(char *p, unsigned long int size)
-{
-  size = AdjustSize(size);
-  return  call_realloc(p, size);
-}
-
-void
-Yap_FreeCodeSpace(char *p)
+static void
+call_free(char *p)
 {
   CACHE_REGS
 #if USE_DL_MALLOC
@@ -213,31 +199,304 @@ Yap_FreeCodeSpace(char *p)
 #endif
 }
 
+#if THREADS
+
+/*
+  Per-thread code space caches.
+
+  Clauses, indices and atoms are all allocated as code space. Blocks
+  of up to CODE_CACHE_MAX_SIZE bytes are recycled through per-thread
+  free lists, one per size class, that need no locking, so threads
+  asserting clauses or building indices do not queue on the
+  allocator.
+
+  Each block is preceded by a tag cell saying which thread owns it
+  and its size class; large blocks also store their size. A thread
+  that frees a block owned by another thread pushes it on the owner's
+  remote list, and the owner takes the whole list back the next time
+  it runs out of blocks. When a thread exits its remote list is
+  closed, and blocks it owned are then freed straight away; the next
+  thread with that id reopens the list. All code space has this
+  header, so memory obtained in some other way, such as the scratch
+  pad, must never be released as code space.
+*/
+
+#define CODE_CACHE_GRAIN (2*sizeof(CELL))
+#define CODE_CACHE_CLASSES 32
+#define CODE_CACHE_MAX_SIZE (CODE_CACHE_GRAIN*CODE_CACHE_CLASSES)
+/* free blocks a thread keeps per size class */
+#define CODE_CACHE_DEPTH 128
+#define CODE_LARGE_CLASS 0xff
+
+#define CODE_TAG_MASK  ((CELL)0xffff << (8*sizeof(CELL)-16))
+#define CODE_TAG_MAGIC ((CELL)0xc0de << (8*sizeof(CELL)-16))
+#define CodeTag(W,C)   (CODE_TAG_MAGIC|((CELL)(W) << 8)|(C))
+#define CodeTagOwner(T) (((T) & ~CODE_TAG_MASK) >> 8)
+#define CodeTagClass(T) ((T) & 0xff)
+/* while a block is free, its first cell after the tag links it */
+#define NextCodeBlock(B) (((CELL **)(B))[1])
+/* remote list of a thread that has exited */
+#define CODE_CACHE_CLOSED ((CELL *)1)
+
+typedef struct code_cache {
+  CELL *free_blocks[CODE_CACHE_CLASSES];
+  UInt nof_free[CODE_CACHE_CLASSES];
+  /* blocks freed by other threads */
+  CELL *remote;
+  /* bytes, only updated by the owner */
+  UInt allocated, freed, cached;
+  /* bytes, updated by other threads */
+  UInt remote_freed;
+} code_cache;
+
+static code_cache code_caches[MAX_THREADS];
+
+static void
+cache_code_block(code_cache *cc, CELL *b, UInt cls)
+{
+  if (cc->nof_free[cls] < CODE_CACHE_DEPTH) {
+    NextCodeBlock(b) = cc->free_blocks[cls];
+    cc->free_blocks[cls] = b;
+    cc->nof_free[cls]++;
+    cc->cached += (cls+1)*CODE_CACHE_GRAIN;
+  } else {
+    call_free((char *)b);
+  }
+}
+
+static void
+take_remote_blocks(code_cache *cc)
+{
+  CELL *b = __atomic_exchange_n(&cc->remote, NULL, __ATOMIC_ACQUIRE);
+
+  /* first allocation by a new thread with this id */
+  if (b == CODE_CACHE_CLOSED)
+    return;
+  while (b) {
+    CELL *next = NextCodeBlock(b);
+
+    cache_code_block(cc, b, CodeTagClass(b[0]));
+    b = next;
+  }
+}
+
+static char *
+code_malloc(unsigned long int size)
+{
+  CACHE_REGS
+  code_cache *cc = code_caches+worker_id;
+  CELL *b;
+
+  if (size <= CODE_CACHE_MAX_SIZE-sizeof(CELL)) {
+    UInt cls = (size+sizeof(CELL)-1)/CODE_CACHE_GRAIN;
+    UInt bsize = (cls+1)*CODE_CACHE_GRAIN;
+
+    if (!cc->free_blocks[cls] &&
+	__atomic_load_n(&cc->remote, __ATOMIC_RELAXED))
+      take_remote_blocks(cc);
+    if ((b = cc->free_blocks[cls])) {
+      cc->free_blocks[cls] = NextCodeBlock(b);
+      cc->nof_free[cls]--;
+      cc->cached -= bsize;
+    } else if (!(b = (CELL *)call_malloc(bsize))) {
+      return NULL;
+    }
+    b[0] = CodeTag(worker_id, cls);
+    cc->allocated += bsize;
+    return (char *)(b+1);
+  }
+  if (!(b = (CELL *)call_malloc(size+2*sizeof(CELL))))
+    return NULL;
+  b[0] = size+2*sizeof(CELL);
+  b[1] = CodeTag(worker_id, CODE_LARGE_CLASS);
+  cc->allocated += b[0];
+  return (char *)(b+2);
+}
+
+static void
+code_free(char *p)
+{
+  CACHE_REGS
+  CELL tag, *b;
+  UInt owner, cls, bsize;
+
+  if (!p)
+    return;
+  tag = ((CELL *)p)[-1];
+#ifdef DEBUG
+  if ((tag & CODE_TAG_MASK) != CODE_TAG_MAGIC) {
+    Yap_Error(SYSTEM_ERROR, TermNil, "releasing memory that is not code space");
+    return;
+  }
+#endif
+  owner = CodeTagOwner(tag);
+  cls = CodeTagClass(tag);
+  if (cls == CODE_LARGE_CLASS) {
+    b = (CELL *)p-2;
+    bsize = b[0];
+  } else {
+    b = (CELL *)p-1;
+    bsize = (cls+1)*CODE_CACHE_GRAIN;
+  }
+  if (owner == worker_id) {
+    code_cache *cc = code_caches+owner;
+
+    cc->freed += bsize;
+    if (cls == CODE_LARGE_CLASS)
+      call_free((char *)b);
+    else
+      cache_code_block(cc, b, cls);
+  } else {
+    code_cache *cc = code_caches+owner;
+    CELL *head = __atomic_load_n(&cc->remote, __ATOMIC_RELAXED);
+
+    if (cls == CODE_LARGE_CLASS) {
+      if (head != CODE_CACHE_CLOSED)
+	__atomic_add_fetch(&cc->remote_freed, bsize, __ATOMIC_RELAXED);
+      call_free((char *)b);
+      return;
+    }
+    do {
+      if (head == CODE_CACHE_CLOSED) {
+	/* the owner has exited, nobody would take the block back */
+	call_free((char *)b);
+	return;
+      }
+      NextCodeBlock(b) = head;
+    } while (!__atomic_compare_exchange_n(&cc->remote, &head, b, TRUE,
+					  __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    __atomic_add_fetch(&cc->remote_freed, bsize, __ATOMIC_RELAXED);
+  }
+}
+
+static char *
+code_realloc(char *p, unsigned long int size)
+{
+  CELL tag;
+  UInt osize;
+  char *np;
+
+  if (!p)
+    return code_malloc(size);
+  tag = ((CELL *)p)[-1];
+#ifdef DEBUG
+  if ((tag & CODE_TAG_MASK) != CODE_TAG_MAGIC) {
+    Yap_Error(SYSTEM_ERROR, TermNil, "resizing memory that is not code space");
+    return NULL;
+  }
+#endif
+  if (CodeTagClass(tag) == CODE_LARGE_CLASS)
+    osize = ((CELL *)p)[-2]-2*sizeof(CELL);
+  else
+    osize = (CodeTagClass(tag)+1)*CODE_CACHE_GRAIN-sizeof(CELL);
+  if (size <= osize && 2*size > osize)
+    return p;
+  if (!(np = code_malloc(size)))
+    return NULL;
+  memcpy(np, p, (size < osize ? size : osize));
+  code_free(p);
+  return np;
+}
+
+/* give back the blocks cached by a thread that is going away */
+void
+Yap_FlushCodeCache(int wid)
+{
+  code_cache *cc = code_caches+wid;
+  CELL *b;
+  UInt cls;
+
+  for (cls = 0; cls < CODE_CACHE_CLASSES; cls++) {
+    b = cc->free_blocks[cls];
+    while (b) {
+      CELL *next = NextCodeBlock(b);
+
+      call_free((char *)b);
+      b = next;
+    }
+    cc->free_blocks[cls] = NULL;
+    cc->nof_free[cls] = 0;
+  }
+  /* from now on other threads free this thread's blocks themselves */
+  b = __atomic_exchange_n(&cc->remote, CODE_CACHE_CLOSED, __ATOMIC_ACQUIRE);
+  if (b == CODE_CACHE_CLOSED)
+    b = NULL;
+  while (b) {
+    CELL *next = NextCodeBlock(b);
+
+    call_free((char *)b);
+    b = next;
+  }
+  /* the next thread with this id starts from scratch */
+  cc->allocated = cc->freed = cc->cached = 0;
+  __atomic_store_n(&cc->remote_freed, 0, __ATOMIC_RELAXED);
+}
+
+/* code space owned by a thread: bytes in use and bytes cached */
+void
+Yap_CodeSpaceInfo(int wid, UInt *in_use, UInt *cached)
+{
+  code_cache *cc = code_caches+wid;
+  UInt released = cc->freed+
+    __atomic_load_n(&cc->remote_freed, __ATOMIC_RELAXED);
+
+  /* blocks left by an earlier thread with this id may still be freed */
+  *in_use = (cc->allocated > released ? cc->allocated-released : 0);
+  *cached = cc->cached;
+}
+
+#else
+
+#define code_malloc(size) call_malloc(size)
+#define code_realloc(p, size) call_realloc(p, size)
+#define code_free(p) call_free(p)
+
+#endif /* THREADS */
+
+char *
+Yap_AllocCodeSpace(unsigned long int size)
+{
+  size = AdjustSize(size);
+  return  code_malloc(size);
+}
+
+char *
+Yap_ReallocCodeSpace(char *p, unsigned long int size)
+{
+  size = AdjustSize(size);
+  return  code_realloc(p, size);
+}
+
+void
+Yap_FreeCodeSpace(char *p)
+{
+  code_free(p);
+}
+
 char *
 Yap_AllocAtomSpace(unsigned long int size)
 {
   size = AdjustSize(size);
-  return call_malloc(size);
+  return code_malloc(size);
 }
 
 void
 Yap_FreeAtomSpace(char *p)
 {
-  CACHE_REGS
-#if USE_DL_MALLOC
-  LOCK(DLMallocLock);
-#endif
-  LOCAL_PrologMode |= MallocMode;
-#if INSTRUMENT_MALLOC
-  p -= sizeof(CELL);
-  tmalloc -= *(CELL*)p;
-  frees++;
-#endif
-  my_free (p);
-  LOCAL_PrologMode &= ~MallocMode;
-#if USE_DL_MALLOC
-  UNLOCK(DLMallocLock);
-#endif
+  code_free(p);
+}
+
+#elif THREADS
+
+void
+Yap_FlushCodeCache(int wid)
+{
+}
+
+void
+Yap_CodeSpaceInfo(int wid, UInt *in_use, UInt *cached)
+{
+  *in_use = *cached = 0;
 }
 
 #endif
@@ -333,6 +592,174 @@ Yap_ExpandPreAllocCodeSpace(UInt sz0, void *cip, int safe)
   return ptr;
 }
 
+/************************************************************************/
+/* Stack reservations                                                   */
+/************************************************************************/
+
+/*
+  When we can, the stacks and trail of each thread live in a large
+  range of address space reserved with mmap(PROT_NONE). Pages are only
+  committed (made readable and writable) when the stacks need them,
+  so most expansions just commit more pages at the end of the area and
+  the area itself never moves. Otherwise, we fall back to malloc().
+*/
+
+#if HAVE_MMAP && HAVE_SYS_MMAN_H && SIZEOF_INT_P==8 && !defined(USE_STACK_RESERVE)
+#define USE_STACK_RESERVE 1
+#endif
+
+#if USE_STACK_RESERVE
+
+#include <sys/mman.h>
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+/* address space we reserve for each set of stacks */
+#define StackReserveSpace (8L*1024*1024*1024)
+
+typedef struct stack_reserve {
+  ADDR base;
+  UInt reserved;
+  UInt committed;
+  struct stack_reserve *next;
+} stack_reserve_t;
+
+static stack_reserve_t *stack_reserves;
+
+#if THREADS
+static pthread_mutex_t stack_reserves_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_RESERVES() pthread_mutex_lock(&stack_reserves_lock)
+#define UNLOCK_RESERVES() pthread_mutex_unlock(&stack_reserves_lock)
+#else
+#define LOCK_RESERVES()
+#define UNLOCK_RESERVES()
+#endif
+
+static UInt
+round_to_page(UInt sz)
+{
+  UInt psz = (Yap_page_size ? Yap_page_size : 4096);
+
+  return ((sz+(psz-1))/psz)*psz;
+}
+
+static stack_reserve_t *
+find_reserve(ADDR base)
+{
+  stack_reserve_t *r = stack_reserves;
+
+  while (r && r->base != base)
+    r = r->next;
+  return r;
+}
+
+static ADDR
+reserve_stacks(UInt sz)
+{
+  stack_reserve_t *r;
+  UInt reserved = StackReserveSpace;
+  void *p;
+
+  sz = round_to_page(sz);
+  if (reserved < 2*sz)
+    reserved = round_to_page(2*sz);
+  if (!(r = (stack_reserve_t *)malloc(sizeof(stack_reserve_t))))
+    return NULL;
+  p = mmap(NULL, reserved, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+  if (p == MAP_FAILED) {
+    free(r);
+    return NULL;
+  }
+  if (mprotect(p, sz, PROT_READ|PROT_WRITE) != 0) {
+    munmap(p, reserved);
+    free(r);
+    return NULL;
+  }
+  r->base = (ADDR)p;
+  r->reserved = reserved;
+  r->committed = sz;
+  LOCK_RESERVES();
+  r->next = stack_reserves;
+  stack_reserves = r;
+  UNLOCK_RESERVES();
+  return (ADDR)p;
+}
+
+/* commit pages so that the area starting at base has at least sz bytes */
+static int
+commit_stacks(ADDR base, UInt sz)
+{
+  stack_reserve_t *r;
+  int out = FALSE;
+
+  LOCK_RESERVES();
+  r = find_reserve(base);
+  if (r && sz <= r->reserved) {
+    sz = round_to_page(sz);
+    if (sz <= r->committed ||
+	mprotect(base+r->committed, sz-r->committed, PROT_READ|PROT_WRITE) == 0) {
+      if (sz > r->committed)
+	r->committed = sz;
+      out = TRUE;
+    }
+  }
+  UNLOCK_RESERVES();
+  return out;
+}
+
+static int
+is_reserved(ADDR base)
+{
+  stack_reserve_t *r;
+
+  LOCK_RESERVES();
+  r = find_reserve(base);
+  UNLOCK_RESERVES();
+  return r != NULL;
+}
+
+#endif /* USE_STACK_RESERVE */
+
+/* get sz bytes for the stacks and trail of a thread */
+ADDR
+Yap_AllocStacks(UInt sz)
+{
+#if USE_STACK_RESERVE
+  ADDR p;
+
+  if ((p = reserve_stacks(sz)))
+    return p;
+#endif
+  return (ADDR)malloc(sz);
+}
+
+void
+Yap_FreeStacks(ADDR base)
+{
+#if USE_STACK_RESERVE
+  stack_reserve_t *r, **rp;
+
+  LOCK_RESERVES();
+  rp = &stack_reserves;
+  while ((r = *rp) && r->base != base)
+    rp = &r->next;
+  if (r)
+    *rp = r->next;
+  UNLOCK_RESERVES();
+  if (r) {
+    munmap(r->base, r->reserved);
+    free(r);
+    return;
+  }
+#endif
+  free(base);
+}
+
 #if USE_SYSTEM_MALLOC
 
 struct various_codes *Yap_heap_regs;
@@ -404,7 +831,7 @@ Yap_KillStacks(int wid)
 {
   ADDR gb = REMOTE_ThreadHandle(wid).stack_address;
   if (gb) {
-    free(gb);
+    Yap_FreeStacks(gb);
     REMOTE_ThreadHandle(wid).stack_address = NULL;
   }
 }
@@ -413,7 +840,7 @@ void
 Yap_KillStacks(int wid)
 {
   if (LOCAL_GlobalBase) {
-    free(LOCAL_GlobalBase);
+    Yap_FreeStacks(LOCAL_GlobalBase);
     LOCAL_GlobalBase = NULL;
   }
 }
@@ -425,12 +852,37 @@ Yap_InitMemory(UInt Trail, UInt Heap, UInt Stack)
   InitHeap();
 }
 
+/* can we grow the stacks by s bytes without moving them? */
+int
+Yap_ExtendWorkSpaceInPlace(Int s)
+{
+#if USE_STACK_RESERVE
+  CACHE_REGS
+  UInt s0 = (char *)LOCAL_TrailTop-(char *)LOCAL_GlobalBase;
+
+  return commit_stacks(LOCAL_GlobalBase, s+s0);
+#else
+  return FALSE;
+#endif
+}
+
 int
 Yap_ExtendWorkSpace(Int s)
 {
   CACHE_REGS
   void *basebp = (void *)LOCAL_GlobalBase, *nbp;
   UInt s0 = (char *)LOCAL_TrailTop-(char *)LOCAL_GlobalBase;
+#if USE_STACK_RESERVE
+  if (is_reserved(basebp)) {
+    if (commit_stacks(basebp, s+s0))
+      return TRUE;
+    /* out of reserved space, move to a larger reservation */
+    if (!(nbp = Yap_AllocStacks(s+s0)))
+      return FALSE;
+    memcpy(nbp, basebp, s0);
+    Yap_FreeStacks(basebp);
+  } else
+#endif
   nbp = realloc(basebp, s+s0);
   if (nbp == NULL) 
     return FALSE;
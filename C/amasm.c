@@ -464,7 +464,7 @@ add_clref(CELL clause_code, int pass_no)
 {
   if (pass_no) {
     LogUpdClause *cl = ClauseCodeToLogUpdClause(clause_code);
-    cl->ClRefCount++;
+    INC_LU_CLREF(cl);
   }
 }
 
@@ -1929,7 +1929,7 @@ init_log_upd_table(LogUpdIndex *ic, union clause_obj *cl_u)
   ic->ParentIndex = (LogUpdIndex *)cl_u;
   //  INIT_LOCK(ic->ClLock);
   cl_u->lui.ChildIndex = ic;
-  cl_u->lui.ClRefCount++;
+  INC_LU_CLREF(&(cl_u->lui));
 }
 
 static void
@@ -2336,9 +2336,24 @@ a_glist(int *do_not_optimise_uatomp, yamop *code_p, int pass_no, struct intermed
 
   if (cip->cpc->rnd2 != 1 && pnext->op == unify_val_op) {
     Ventry *ve = (Ventry *) pnext->rnd1;
+    PInstr *ppnext = pnext->nextInst;
     int is_y_var;
     OPREG var_offset;
     
+    if (ve->KindOfVE != PermVar &&
+	ppnext && ppnext->op == unify_last_var_op &&
+	((Ventry *) ppnext->rnd1)->KindOfVE != PermVar) {
+      /* [X|T] where T is new: the common list recursion */
+      if (pass_no) {
+	code_p->opc = emit_op(_glist_valx_varx);
+	code_p->u.xxx.x = emit_x(cip->cpc->rnd2);
+	code_p->u.xxx.x1 = emit_xreg(Var_Ref(ve, FALSE));
+	code_p->u.xxx.x2 = emit_xreg(Var_Ref((Ventry *) ppnext->rnd1, FALSE));
+      }
+      cip->cpc = ppnext;
+      GONEXT(xxx);
+      return code_p;
+    }
     pnext->rnd2 = cip->cpc->rnd2;
     cip->cpc = pnext;
     is_y_var = (ve->KindOfVE == PermVar);
@@ -27,33 +27,68 @@ static char SccsId[] = "%W% %G%";
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#include <stdlib.h>
 
 
 
 
-STATIC_PROTO(Int p_reset_op_counters, (void));
-STATIC_PROTO(Int p_show_op_counters, (void));
-STATIC_PROTO(Int p_show_ops_by_group, (void));
+STATIC_PROTO(Int p_reset_op_counters, ( USES_REGS1 ));
+STATIC_PROTO(Int p_show_op_counters, ( USES_REGS1 ));
+STATIC_PROTO(Int p_show_ops_by_group, ( USES_REGS1 ));
+STATIC_PROTO(Int p_show_op_sequences, ( USES_REGS1 ));
+STATIC_PROTO(Int p_op_sequences, ( USES_REGS1 ));
 
 static Int 
-p_reset_op_counters()
+p_reset_op_counters( USES_REGS1 )
 {
-  int i;
+  int i, j;
 
-  for (i = 0; i <= _std_top; ++i)
-    GLOBAL_opcount[i] = 0;
+  for (i = 0; i <= _std_top; ++i) {
+    LOCAL_opcount[i] = 0;
+    for (j = 0; j <= _std_top; ++j)
+      LOCAL_opcount2[i][j] = 0;
+  }
+  for (i = 0; i < ANALYST_TRIPLES; i++)
+    LOCAL_opcount3[i][0] = LOCAL_opcount3[i][1] = 0;
   return TRUE;
 }
 
+/*
+  Triples are kept in an open hash table, as a full table would be far
+  too large. The key packs the three opcodes, plus one so that 0 marks
+  an empty slot. When the table is nearly full, new triples are
+  dropped.
+*/
+void
+Yap_count_op_triple(op_numbers op1, op_numbers op2, op_numbers op3)
+{
+  CACHE_REGS
+  YAP_ULONG_LONG key = ((((YAP_ULONG_LONG)op1 << 10) | op2) << 10 | op3)+1;
+  UInt i = (UInt)((key * 0x9e3779b97f4a7c15ULL) >> 40) & (ANALYST_TRIPLES-1);
+  int n = 0;
+
+  while (LOCAL_opcount3[i][0] != key) {
+    if (LOCAL_opcount3[i][0] == 0) {
+      LOCAL_opcount3[i][0] = key;
+      break;
+    }
+    if (++n == 64)
+      return;
+    i = (i+1) & (ANALYST_TRIPLES-1);
+  }
+  LOCAL_opcount3[i][1]++;
+}
+
 static void 
 print_instruction(int inst)
 {
+  CACHE_REGS
   int j;
 
   fprintf(GLOBAL_stderr, "%s", Yap_op_names[inst]);
   for (j = strlen(Yap_op_names[inst]); j < 25; j++)
     putc(' ', GLOBAL_stderr);
-  j = GLOBAL_opcount[inst];
+  j = LOCAL_opcount[inst];
   if (j < 100000000) {
     putc(' ', GLOBAL_stderr);
     if (j < 10000000) {
@@ -78,11 +113,11 @@ print_instruction(int inst)
       }
     }
   }
-  fprintf(GLOBAL_stderr, "%llu\n", GLOBAL_opcount[inst]);
+  fprintf(GLOBAL_stderr, "%llu\n", LOCAL_opcount[inst]);
 }
 
 static Int 
-p_show_op_counters()
+p_show_op_counters( USES_REGS1 )
 {
   int i;
   Term t1 = Deref(ARG1);
@@ -174,6 +209,7 @@ p_show_op_counters()
   print_instruction(_get_struct);
   fprintf(GLOBAL_stderr, "\n   Optimised Get Instructions\n");
   print_instruction(_glist_valx);
+  print_instruction(_glist_valx_varx);
   print_instruction(_glist_valy);
   print_instruction(_gl_void_varx);
   print_instruction(_gl_void_vary);
@@ -290,291 +326,289 @@ p_show_op_counters()
 
 typedef struct {
   int nxvar, nxval, nyvar, nyval, ncons, nlist, nstru, nmisc;
-} uGLOBAL_opcount;
+} uopcount;
 
 typedef struct {
   int ncalls, nexecs, nproceeds, ncallbips, ncuts, nallocs, ndeallocs;
-} cGLOBAL_opcount;
+} copcount;
 
 typedef struct {
   int ntries, nretries, ntrusts;
 } ccpcount;
 
 static Int 
-p_show_ops_by_group(void)
+p_show_ops_by_group( USES_REGS1 )
 {
 
-  uGLOBAL_opcount c_get, c_unify, c_put, c_write;
-  cGLOBAL_opcount c_control;
+  uopcount c_get, c_unify, c_put, c_write;
+  copcount c_control;
   ccpcount c_cp;
   int gets, unifies, puts, writes, controls, choice_pts, indexes, misc,
     total;
   Term t1;
   Atom at1;
+  char *program;
 
   t1 = Deref(ARG1);
   if (IsVarTerm(t1) || !IsAtomTerm(t1))
     return (FALSE);
   at1 = AtomOfTerm(t1);
   if (IsWideAtom(at1)) {
-    wchar_t *program;
-
-    program = RepAtom(at1)->WStrOfAE;
-    fprintf(GLOBAL_stderr, "\n Instructions Executed in %S\n", program);
+    fprintf(GLOBAL_stderr, "\n Instructions Executed in %S\n", RepAtom(at1)->WStrOfAE);
+    program = "this program";
   } else {
-    char *program;
-
     program = RepAtom(at1)->StrOfAE;
     fprintf(GLOBAL_stderr, "\n Instructions Executed in %s\n", program);
   }
 
   c_get.nxvar =
-    GLOBAL_opcount[_get_x_var];
+    LOCAL_opcount[_get_x_var];
   c_get.nyvar =
-    GLOBAL_opcount[_get_y_var];
+    LOCAL_opcount[_get_y_var];
   c_get.nxval =
-    GLOBAL_opcount[_get_x_val];
+    LOCAL_opcount[_get_x_val];
   c_get.nyval =
-    GLOBAL_opcount[_get_y_val];
+    LOCAL_opcount[_get_y_val];
   c_get.ncons =
-    GLOBAL_opcount[_get_atom]+
-    GLOBAL_opcount[_get_2atoms]+
-    GLOBAL_opcount[_get_3atoms]+
-    GLOBAL_opcount[_get_4atoms]+
-    GLOBAL_opcount[_get_5atoms]+
-    GLOBAL_opcount[_get_6atoms];
+    LOCAL_opcount[_get_atom]+
+    LOCAL_opcount[_get_2atoms]+
+    LOCAL_opcount[_get_3atoms]+
+    LOCAL_opcount[_get_4atoms]+
+    LOCAL_opcount[_get_5atoms]+
+    LOCAL_opcount[_get_6atoms];
   c_get.nlist =
-    GLOBAL_opcount[_get_list] +
-    GLOBAL_opcount[_glist_valx] +
-    GLOBAL_opcount[_glist_valy] +
-    GLOBAL_opcount[_gl_void_varx] +
-    GLOBAL_opcount[_gl_void_vary] +
-    GLOBAL_opcount[_gl_void_valx] +
-    GLOBAL_opcount[_gl_void_valy];
+    LOCAL_opcount[_get_list] +
+    LOCAL_opcount[_glist_valx] +
+    LOCAL_opcount[_glist_valx_varx] +
+    LOCAL_opcount[_glist_valy] +
+    LOCAL_opcount[_gl_void_varx] +
+    LOCAL_opcount[_gl_void_vary] +
+    LOCAL_opcount[_gl_void_valx] +
+    LOCAL_opcount[_gl_void_valy];
   c_get.nstru =
-    GLOBAL_opcount[_get_struct];
+    LOCAL_opcount[_get_struct];
 
   gets = c_get.nxvar + c_get.nyvar + c_get.nxval + c_get.nyval +
     c_get.ncons + c_get.nlist + c_get.nstru;
 
   c_unify.nxvar =
-    GLOBAL_opcount[_unify_x_var] +
-    GLOBAL_opcount[_unify_void] +
-    GLOBAL_opcount[_unify_n_voids] +
-    2 * GLOBAL_opcount[_unify_x_var2] +
-    2 * GLOBAL_opcount[_gl_void_varx] +
-    GLOBAL_opcount[_gl_void_vary] +
-    GLOBAL_opcount[_gl_void_valx] +
-    GLOBAL_opcount[_unify_l_x_var] +
-    GLOBAL_opcount[_unify_l_void] +
-    GLOBAL_opcount[_unify_l_n_voids] +
-    2 * GLOBAL_opcount[_unify_l_x_var2] +
-    GLOBAL_opcount[_unify_x_var_write] +
-    GLOBAL_opcount[_unify_void_write] +
-    GLOBAL_opcount[_unify_n_voids_write] +
-    2 * GLOBAL_opcount[_unify_x_var2_write] +
-    GLOBAL_opcount[_unify_l_x_var_write] +
-    GLOBAL_opcount[_unify_l_void_write] +
-    GLOBAL_opcount[_unify_l_n_voids_write] +
-    2 * GLOBAL_opcount[_unify_l_x_var2_write];
+    LOCAL_opcount[_unify_x_var] +
+    LOCAL_opcount[_unify_void] +
+    LOCAL_opcount[_unify_n_voids] +
+    2 * LOCAL_opcount[_unify_x_var2] +
+    2 * LOCAL_opcount[_gl_void_varx] +
+    LOCAL_opcount[_glist_valx_varx] +
+    LOCAL_opcount[_gl_void_vary] +
+    LOCAL_opcount[_gl_void_valx] +
+    LOCAL_opcount[_unify_l_x_var] +
+    LOCAL_opcount[_unify_l_void] +
+    LOCAL_opcount[_unify_l_n_voids] +
+    2 * LOCAL_opcount[_unify_l_x_var2] +
+    LOCAL_opcount[_unify_x_var_write] +
+    LOCAL_opcount[_unify_void_write] +
+    LOCAL_opcount[_unify_n_voids_write] +
+    2 * LOCAL_opcount[_unify_x_var2_write] +
+    LOCAL_opcount[_unify_l_x_var_write] +
+    LOCAL_opcount[_unify_l_void_write] +
+    LOCAL_opcount[_unify_l_n_voids_write] +
+    2 * LOCAL_opcount[_unify_l_x_var2_write];
   c_unify.nyvar =
-    GLOBAL_opcount[_unify_y_var] +
-    GLOBAL_opcount[_gl_void_vary] +
-    GLOBAL_opcount[_unify_l_y_var] +
-    GLOBAL_opcount[_unify_y_var_write] +
-    GLOBAL_opcount[_unify_l_y_var_write];
+    LOCAL_opcount[_unify_y_var] +
+    LOCAL_opcount[_gl_void_vary] +
+    LOCAL_opcount[_unify_l_y_var] +
+    LOCAL_opcount[_unify_y_var_write] +
+    LOCAL_opcount[_unify_l_y_var_write];
   c_unify.nxval =
-    GLOBAL_opcount[_unify_x_val] +
-    GLOBAL_opcount[_unify_x_loc] +
-    GLOBAL_opcount[_glist_valx] +
-    GLOBAL_opcount[_gl_void_valx] +
-    GLOBAL_opcount[_unify_l_x_val] +
-    GLOBAL_opcount[_unify_l_x_loc] +
-    GLOBAL_opcount[_unify_x_val_write] +
-    GLOBAL_opcount[_unify_x_loc_write] +
-    GLOBAL_opcount[_unify_l_x_val_write] +
-    GLOBAL_opcount[_unify_l_x_loc_write];
+    LOCAL_opcount[_unify_x_val] +
+    LOCAL_opcount[_unify_x_loc] +
+    LOCAL_opcount[_glist_valx] +
+    LOCAL_opcount[_glist_valx_varx] +
+    LOCAL_opcount[_gl_void_valx] +
+    LOCAL_opcount[_unify_l_x_val] +
+    LOCAL_opcount[_unify_l_x_loc] +
+    LOCAL_opcount[_unify_x_val_write] +
+    LOCAL_opcount[_unify_x_loc_write] +
+    LOCAL_opcount[_unify_l_x_val_write] +
+    LOCAL_opcount[_unify_l_x_loc_write];
   c_unify.nyval =
-    GLOBAL_opcount[_unify_y_val] +
-    GLOBAL_opcount[_unify_y_loc] +
-    GLOBAL_opcount[_glist_valy] +
-    GLOBAL_opcount[_gl_void_valy] +
-    GLOBAL_opcount[_unify_l_y_val] +
-    GLOBAL_opcount[_unify_l_y_loc] +
-    GLOBAL_opcount[_unify_y_val_write] +
-    GLOBAL_opcount[_unify_y_loc_write] +
-    GLOBAL_opcount[_unify_l_y_val_write] +
-    GLOBAL_opcount[_unify_l_y_loc_write];
+    LOCAL_opcount[_unify_y_val] +
+    LOCAL_opcount[_unify_y_loc] +
+    LOCAL_opcount[_glist_valy] +
+    LOCAL_opcount[_gl_void_valy] +
+    LOCAL_opcount[_unify_l_y_val] +
+    LOCAL_opcount[_unify_l_y_loc] +
+    LOCAL_opcount[_unify_y_val_write] +
+    LOCAL_opcount[_unify_y_loc_write] +
+    LOCAL_opcount[_unify_l_y_val_write] +
+    LOCAL_opcount[_unify_l_y_loc_write];
   c_unify.ncons =
-    GLOBAL_opcount[_unify_atom] +
-    GLOBAL_opcount[_unify_n_atoms] +
-    GLOBAL_opcount[_unify_l_atom] +
-    GLOBAL_opcount[_unify_atom_write] +
-    GLOBAL_opcount[_unify_n_atoms_write] +
-    GLOBAL_opcount[_unify_l_atom_write];
+    LOCAL_opcount[_unify_atom] +
+    LOCAL_opcount[_unify_n_atoms] +
+    LOCAL_opcount[_unify_l_atom] +
+    LOCAL_opcount[_unify_atom_write] +
+    LOCAL_opcount[_unify_n_atoms_write] +
+    LOCAL_opcount[_unify_l_atom_write];
   c_unify.nlist =
-    GLOBAL_opcount[_unify_list] +
-    GLOBAL_opcount[_unify_l_list] +
-    GLOBAL_opcount[_unify_list_write] +
-    GLOBAL_opcount[_unify_l_list_write];
+    LOCAL_opcount[_unify_list] +
+    LOCAL_opcount[_unify_l_list] +
+    LOCAL_opcount[_unify_list_write] +
+    LOCAL_opcount[_unify_l_list_write];
   c_unify.nstru =
-    GLOBAL_opcount[_unify_struct] +
-    GLOBAL_opcount[_unify_l_struc] +
-    GLOBAL_opcount[_unify_struct_write] +
-    GLOBAL_opcount[_unify_l_struc_write];
+    LOCAL_opcount[_unify_struct] +
+    LOCAL_opcount[_unify_l_struc] +
+    LOCAL_opcount[_unify_struct_write] +
+    LOCAL_opcount[_unify_l_struc_write];
   c_unify.nmisc =
-    GLOBAL_opcount[_pop] +
-    GLOBAL_opcount[_pop_n];
+    LOCAL_opcount[_pop] +
+    LOCAL_opcount[_pop_n];
 
   unifies = c_unify.nxvar + c_unify.nyvar + c_unify.nxval + c_unify.nyval +
     c_unify.ncons + c_unify.nlist + c_unify.nstru + c_unify.nmisc;
 
   c_put.nxvar =
-    GLOBAL_opcount[_put_x_var];
+    LOCAL_opcount[_put_x_var];
   c_put.nyvar =
-    GLOBAL_opcount[_put_y_var];
+    LOCAL_opcount[_put_y_var];
   c_put.nxval =
-    GLOBAL_opcount[_put_x_val]+
-    2*GLOBAL_opcount[_put_xx_val];
+    LOCAL_opcount[_put_x_val]+
+    2*LOCAL_opcount[_put_xx_val];
   c_put.nyval =
-    GLOBAL_opcount[_put_y_val];
+    LOCAL_opcount[_put_y_val];
   c_put.ncons =
-    GLOBAL_opcount[_put_atom];
+    LOCAL_opcount[_put_atom];
   c_put.nlist =
-    GLOBAL_opcount[_put_list];
+    LOCAL_opcount[_put_list];
   c_put.nstru =
-    GLOBAL_opcount[_put_struct];
+    LOCAL_opcount[_put_struct];
 
   puts = c_put.nxvar + c_put.nyvar + c_put.nxval + c_put.nyval +
     c_put.ncons + c_put.nlist + c_put.nstru;
 
   c_write.nxvar =
-    GLOBAL_opcount[_write_x_var] +
-    GLOBAL_opcount[_write_void] +
-    GLOBAL_opcount[_write_n_voids];
+    LOCAL_opcount[_write_x_var] +
+    LOCAL_opcount[_write_void] +
+    LOCAL_opcount[_write_n_voids];
   c_write.nyvar =
-    GLOBAL_opcount[_write_y_var];
+    LOCAL_opcount[_write_y_var];
   c_write.nxval =
-    GLOBAL_opcount[_write_x_val];
+    LOCAL_opcount[_write_x_val];
   c_write.nyval =
-    GLOBAL_opcount[_write_y_val];
+    LOCAL_opcount[_write_y_val];
   c_write.ncons =
-    GLOBAL_opcount[_write_atom];
+    LOCAL_opcount[_write_atom];
   c_write.nlist =
-    GLOBAL_opcount[_write_list];
+    LOCAL_opcount[_write_list];
   c_write.nstru =
-    GLOBAL_opcount[_write_struct];
+    LOCAL_opcount[_write_struct];
 
   writes = c_write.nxvar + c_write.nyvar + c_write.nxval + c_write.nyval +
     c_write.ncons + c_write.nlist + c_write.nstru;
 
   c_control.nexecs =
-    GLOBAL_opcount[_execute] +
-    GLOBAL_opcount[_dexecute];
+    LOCAL_opcount[_execute] +
+    LOCAL_opcount[_dexecute];
 
   c_control.ncalls =
-    GLOBAL_opcount[_call] +
-    GLOBAL_opcount[_fcall];
+    LOCAL_opcount[_call] +
+    LOCAL_opcount[_fcall];
 
   c_control.nproceeds =
-    GLOBAL_opcount[_procceed];
+    LOCAL_opcount[_procceed];
 
   c_control.ncallbips =
-    GLOBAL_opcount[_call_cpred] +
-    GLOBAL_opcount[_call_c_wfail] +
-    GLOBAL_opcount[_try_c] +
-    GLOBAL_opcount[_retry_c] +
-    GLOBAL_opcount[_op_fail] +
-    GLOBAL_opcount[_trust_fail] +
-    GLOBAL_opcount[_p_atom_x] +
-    GLOBAL_opcount[_p_atom_y] +
-    GLOBAL_opcount[_p_atomic_x] +
-    GLOBAL_opcount[_p_atomic_y] +
-    GLOBAL_opcount[_p_compound_x] +
-    GLOBAL_opcount[_p_compound_y] +
-    GLOBAL_opcount[_p_float_x] +
-    GLOBAL_opcount[_p_float_y] +
-    GLOBAL_opcount[_p_integer_x] +
-    GLOBAL_opcount[_p_integer_y] +
-    GLOBAL_opcount[_p_nonvar_x] +
-    GLOBAL_opcount[_p_nonvar_y] +
-    GLOBAL_opcount[_p_number_x] +
-    GLOBAL_opcount[_p_number_y] +
-    GLOBAL_opcount[_p_var_x] +
-    GLOBAL_opcount[_p_var_y] +
-    GLOBAL_opcount[_p_db_ref_x] +
-    GLOBAL_opcount[_p_db_ref_y] +
-    GLOBAL_opcount[_p_cut_by_x] +
-    GLOBAL_opcount[_p_cut_by_y] +
-    GLOBAL_opcount[_p_primitive_x] +
-    GLOBAL_opcount[_p_primitive_y] +
-    GLOBAL_opcount[_p_equal] +
-    GLOBAL_opcount[_p_plus_vv] +
-    GLOBAL_opcount[_p_plus_vc] +
-    GLOBAL_opcount[_p_plus_y_vv] +
-    GLOBAL_opcount[_p_plus_y_vc] +
-    GLOBAL_opcount[_p_minus_vv] +
-    GLOBAL_opcount[_p_minus_cv] +
-    GLOBAL_opcount[_p_minus_y_vv] +
-    GLOBAL_opcount[_p_minus_y_cv] +
-    GLOBAL_opcount[_p_times_vv] +
-    GLOBAL_opcount[_p_times_vc] +
-    GLOBAL_opcount[_p_times_y_vv] +
-    GLOBAL_opcount[_p_times_y_vc] +
-    GLOBAL_opcount[_p_div_vv] +
-    GLOBAL_opcount[_p_div_vc] +
-    GLOBAL_opcount[_p_div_cv] +
-    GLOBAL_opcount[_p_div_y_vv] +
-    GLOBAL_opcount[_p_div_y_vc] +
-    GLOBAL_opcount[_p_div_y_cv] +
-    GLOBAL_opcount[_p_or_vv] +
-    GLOBAL_opcount[_p_or_vc] +
-    GLOBAL_opcount[_p_or_y_vv] +
-    GLOBAL_opcount[_p_or_y_vc] +
-    GLOBAL_opcount[_p_and_vv] +
-    GLOBAL_opcount[_p_and_vc] +
-    GLOBAL_opcount[_p_and_y_vv] +
-    GLOBAL_opcount[_p_and_y_vc] +
-    GLOBAL_opcount[_p_sll_vv] +
-    GLOBAL_opcount[_p_sll_vc] +
-    GLOBAL_opcount[_p_sll_y_vv] +
-    GLOBAL_opcount[_p_sll_y_vc] +
-    GLOBAL_opcount[_p_slr_vv] +
-    GLOBAL_opcount[_p_slr_vc] +
-    GLOBAL_opcount[_p_slr_y_vv] +
-    GLOBAL_opcount[_p_slr_y_vc] +
-    GLOBAL_opcount[_p_dif] +
-    GLOBAL_opcount[_p_eq] +
-    GLOBAL_opcount[_p_arg_vv] +
-    GLOBAL_opcount[_p_arg_cv] +
-    GLOBAL_opcount[_p_arg_y_vv] +
-    GLOBAL_opcount[_p_arg_y_cv] +
-    GLOBAL_opcount[_p_functor] +
-    GLOBAL_opcount[_p_func2s_vv] +
-    GLOBAL_opcount[_p_func2s_cv] +
-    GLOBAL_opcount[_p_func2s_vc] +
-    GLOBAL_opcount[_p_func2s_y_vv] +
-    GLOBAL_opcount[_p_func2s_y_cv] +
-    GLOBAL_opcount[_p_func2s_y_vc] +
-    GLOBAL_opcount[_p_func2f_xx] +
-    GLOBAL_opcount[_p_func2f_xy] +
-    GLOBAL_opcount[_p_func2f_yx] +
-    GLOBAL_opcount[_p_func2f_yy];
+    LOCAL_opcount[_call_cpred] +
+    LOCAL_opcount[_call_c_wfail] +
+    LOCAL_opcount[_try_c] +
+    LOCAL_opcount[_retry_c] +
+    LOCAL_opcount[_op_fail] +
+    LOCAL_opcount[_trust_fail] +
+    LOCAL_opcount[_p_atom_x] +
+    LOCAL_opcount[_p_atom_y] +
+    LOCAL_opcount[_p_atomic_x] +
+    LOCAL_opcount[_p_atomic_y] +
+    LOCAL_opcount[_p_compound_x] +
+    LOCAL_opcount[_p_compound_y] +
+    LOCAL_opcount[_p_float_x] +
+    LOCAL_opcount[_p_float_y] +
+    LOCAL_opcount[_p_integer_x] +
+    LOCAL_opcount[_p_integer_y] +
+    LOCAL_opcount[_p_nonvar_x] +
+    LOCAL_opcount[_p_nonvar_y] +
+    LOCAL_opcount[_p_number_x] +
+    LOCAL_opcount[_p_number_y] +
+    LOCAL_opcount[_p_var_x] +
+    LOCAL_opcount[_p_var_y] +
+    LOCAL_opcount[_p_db_ref_x] +
+    LOCAL_opcount[_p_db_ref_y] +
+    LOCAL_opcount[_p_primitive_x] +
+    LOCAL_opcount[_p_primitive_y] +
+    LOCAL_opcount[_p_equal] +
+    LOCAL_opcount[_p_plus_vv] +
+    LOCAL_opcount[_p_plus_vc] +
+    LOCAL_opcount[_p_plus_y_vv] +
+    LOCAL_opcount[_p_plus_y_vc] +
+    LOCAL_opcount[_p_minus_vv] +
+    LOCAL_opcount[_p_minus_cv] +
+    LOCAL_opcount[_p_minus_y_vv] +
+    LOCAL_opcount[_p_minus_y_cv] +
+    LOCAL_opcount[_p_times_vv] +
+    LOCAL_opcount[_p_times_vc] +
+    LOCAL_opcount[_p_times_y_vv] +
+    LOCAL_opcount[_p_times_y_vc] +
+    LOCAL_opcount[_p_div_vv] +
+    LOCAL_opcount[_p_div_vc] +
+    LOCAL_opcount[_p_div_cv] +
+    LOCAL_opcount[_p_div_y_vv] +
+    LOCAL_opcount[_p_div_y_vc] +
+    LOCAL_opcount[_p_div_y_cv] +
+    LOCAL_opcount[_p_or_vv] +
+    LOCAL_opcount[_p_or_vc] +
+    LOCAL_opcount[_p_or_y_vv] +
+    LOCAL_opcount[_p_or_y_vc] +
+    LOCAL_opcount[_p_and_vv] +
+    LOCAL_opcount[_p_and_vc] +
+    LOCAL_opcount[_p_and_y_vv] +
+    LOCAL_opcount[_p_and_y_vc] +
+    LOCAL_opcount[_p_sll_vv] +
+    LOCAL_opcount[_p_sll_vc] +
+    LOCAL_opcount[_p_sll_y_vv] +
+    LOCAL_opcount[_p_sll_y_vc] +
+    LOCAL_opcount[_p_slr_vv] +
+    LOCAL_opcount[_p_slr_vc] +
+    LOCAL_opcount[_p_slr_y_vv] +
+    LOCAL_opcount[_p_slr_y_vc] +
+    LOCAL_opcount[_p_dif] +
+    LOCAL_opcount[_p_eq] +
+    LOCAL_opcount[_p_arg_vv] +
+    LOCAL_opcount[_p_arg_cv] +
+    LOCAL_opcount[_p_arg_y_vv] +
+    LOCAL_opcount[_p_arg_y_cv] +
+    LOCAL_opcount[_p_functor] +
+    LOCAL_opcount[_p_func2s_vv] +
+    LOCAL_opcount[_p_func2s_cv] +
+    LOCAL_opcount[_p_func2s_vc] +
+    LOCAL_opcount[_p_func2s_y_vv] +
+    LOCAL_opcount[_p_func2s_y_cv] +
+    LOCAL_opcount[_p_func2s_y_vc] +
+    LOCAL_opcount[_p_func2f_xx] +
+    LOCAL_opcount[_p_func2f_xy] +
+    LOCAL_opcount[_p_func2f_yx] +
+    LOCAL_opcount[_p_func2f_yy];
 
   c_control.ncuts =
-    GLOBAL_opcount[_cut] +
-    GLOBAL_opcount[_cut_t] +
-    GLOBAL_opcount[_cut_e] +
-    GLOBAL_opcount[_commit_b_x] +
-    GLOBAL_opcount[_commit_b_y];
+    LOCAL_opcount[_cut] +
+    LOCAL_opcount[_cut_t] +
+    LOCAL_opcount[_cut_e] +
+    LOCAL_opcount[_commit_b_x] +
+    LOCAL_opcount[_commit_b_y];
 
   c_control.nallocs =
-    GLOBAL_opcount[_allocate] +
-    GLOBAL_opcount[_fcall];
+    LOCAL_opcount[_allocate] +
+    LOCAL_opcount[_fcall];
 
   c_control.ndeallocs =
-    GLOBAL_opcount[_dexecute] +
-    GLOBAL_opcount[_deallocate];
+    LOCAL_opcount[_dexecute] +
+    LOCAL_opcount[_deallocate];
 
   controls =
     c_control.nexecs +
@@ -583,30 +617,30 @@ p_show_ops_by_group(void)
     c_control.ncuts +
     c_control.nallocs +
     c_control.ndeallocs +
-    GLOBAL_opcount[_jump] +
-    GLOBAL_opcount[_move_back] +
-    GLOBAL_opcount[_try_in];
+    LOCAL_opcount[_jump] +
+    LOCAL_opcount[_move_back] +
+    LOCAL_opcount[_try_in];
 
 
 
   c_cp.ntries =
-    GLOBAL_opcount[_try_me] +
-    GLOBAL_opcount[_try_and_mark] +
-    GLOBAL_opcount[_try_c] +
-    GLOBAL_opcount[_try_clause] +
-    GLOBAL_opcount[_either];
+    LOCAL_opcount[_try_me] +
+    LOCAL_opcount[_try_and_mark] +
+    LOCAL_opcount[_try_c] +
+    LOCAL_opcount[_try_clause] +
+    LOCAL_opcount[_either];
 
   c_cp.nretries =
-    GLOBAL_opcount[_retry_me] +
-    GLOBAL_opcount[_retry_and_mark] +
-    GLOBAL_opcount[_retry_c] +
-    GLOBAL_opcount[_retry] +
-    GLOBAL_opcount[_or_else];
+    LOCAL_opcount[_retry_me] +
+    LOCAL_opcount[_retry_and_mark] +
+    LOCAL_opcount[_retry_c] +
+    LOCAL_opcount[_retry] +
+    LOCAL_opcount[_or_else];
 
   c_cp.ntrusts =
-    GLOBAL_opcount[_trust_me] +
-    GLOBAL_opcount[_trust] +
-    GLOBAL_opcount[_or_last];
+    LOCAL_opcount[_trust_me] +
+    LOCAL_opcount[_trust] +
+    LOCAL_opcount[_or_last];
 
   choice_pts =
     c_cp.ntries +
@@ -614,40 +648,40 @@ p_show_ops_by_group(void)
     c_cp.ntrusts;
 
   indexes =
-    GLOBAL_opcount[_jump_if_var] +
-    GLOBAL_opcount[_switch_on_type] +
-    GLOBAL_opcount[_switch_list_nl] +
-    GLOBAL_opcount[_switch_on_arg_type] +
-    GLOBAL_opcount[_switch_on_sub_arg_type] +
-    GLOBAL_opcount[_switch_on_cons] +
-    GLOBAL_opcount[_go_on_cons] +
-    GLOBAL_opcount[_if_cons] +
-    GLOBAL_opcount[_switch_on_func] +
-    GLOBAL_opcount[_go_on_func] +
-    GLOBAL_opcount[_if_func] +
-    GLOBAL_opcount[_if_not_then];
+    LOCAL_opcount[_jump_if_var] +
+    LOCAL_opcount[_switch_on_type] +
+    LOCAL_opcount[_switch_list_nl] +
+    LOCAL_opcount[_switch_on_arg_type] +
+    LOCAL_opcount[_switch_on_sub_arg_type] +
+    LOCAL_opcount[_switch_on_cons] +
+    LOCAL_opcount[_go_on_cons] +
+    LOCAL_opcount[_if_cons] +
+    LOCAL_opcount[_switch_on_func] +
+    LOCAL_opcount[_go_on_func] +
+    LOCAL_opcount[_if_func] +
+    LOCAL_opcount[_if_not_then];
   misc =
     c_control.ncallbips +
-    GLOBAL_opcount[_Ystop] +
-    GLOBAL_opcount[_Nstop] +
-    GLOBAL_opcount[_index_pred] +
-    GLOBAL_opcount[_lock_pred] +
+    LOCAL_opcount[_Ystop] +
+    LOCAL_opcount[_Nstop] +
+    LOCAL_opcount[_index_pred] +
+    LOCAL_opcount[_lock_pred] +
 #if THREADS
-    GLOBAL_opcount[_thread_local] +
+    LOCAL_opcount[_thread_local] +
 #endif
-    GLOBAL_opcount[_save_b_x] +
-    GLOBAL_opcount[_save_b_y] +
-    GLOBAL_opcount[_undef_p] +
-    GLOBAL_opcount[_spy_pred] +
-    GLOBAL_opcount[_spy_or_trymark] +
-    GLOBAL_opcount[_save_pair_x] +
-    GLOBAL_opcount[_save_pair_y] +
-    GLOBAL_opcount[_save_pair_x_write] +
-    GLOBAL_opcount[_save_pair_y_write] +
-    GLOBAL_opcount[_save_appl_x] +
-    GLOBAL_opcount[_save_appl_y] +
-    GLOBAL_opcount[_save_appl_x_write] +
-    GLOBAL_opcount[_save_appl_y_write];
+    LOCAL_opcount[_save_b_x] +
+    LOCAL_opcount[_save_b_y] +
+    LOCAL_opcount[_undef_p] +
+    LOCAL_opcount[_spy_pred] +
+    LOCAL_opcount[_spy_or_trymark] +
+    LOCAL_opcount[_save_pair_x] +
+    LOCAL_opcount[_save_pair_y] +
+    LOCAL_opcount[_save_pair_x_write] +
+    LOCAL_opcount[_save_pair_y_write] +
+    LOCAL_opcount[_save_appl_x] +
+    LOCAL_opcount[_save_appl_y] +
+    LOCAL_opcount[_save_appl_x_write] +
+    LOCAL_opcount[_save_appl_y_write];
   total = gets + unifies + puts + writes + controls + choice_pts + indexes + misc;
 
   /*  for (i = 0; i <= _std_top; ++i)
@@ -800,62 +834,156 @@ p_show_ops_by_group(void)
   return TRUE;
 }
 
-static Int
-p_show_sequences(void)
+/* the n most frequent sequences of len (2 or 3) instructions */
+typedef struct op_seq {
+  YAP_ULONG_LONG count;
+  op_numbers ops[3];
+} op_seq_t;
+
+static void
+insert_seq(op_seq_t *best, int n, int *nbest, YAP_ULONG_LONG count, op_numbers op1, op_numbers op2, op_numbers op3)
 {
-  int i, j;
-  YAP_ULONG_LONG min;
-  YAP_ULONG_LONG sum = 0;
-  Term t = Deref(ARG1);
+  int i;
+
+  if (*nbest == n && best[n-1].count >= count)
+    return;
+  if (*nbest < n)
+    (*nbest)++;
+  for (i = *nbest-1; i > 0 && best[i-1].count < count; i--)
+    best[i] = best[i-1];
+  best[i].count = count;
+  best[i].ops[0] = op1;
+  best[i].ops[1] = op2;
+  best[i].ops[2] = op3;
+}
+
+static int
+top_sequences(int len, int n, op_seq_t *best USES_REGS)
+{
+  int nbest = 0, i, j;
 
-  if (IsVarTerm(t)) {
-    Yap_Error(INSTANTIATION_ERROR, t, "shows_sequences/1");
+  if (len == 2) {
+    for (i = 0; i <= _std_top; ++i)
+      for (j = 0; j <= _std_top; ++j)
+	if (LOCAL_opcount2[i][j])
+	  insert_seq(best, n, &nbest, LOCAL_opcount2[i][j], i, j, 0);
+  } else {
+    for (i = 0; i < ANALYST_TRIPLES; i++) {
+      YAP_ULONG_LONG key = LOCAL_opcount3[i][0];
+      if (key) {
+	key--;
+	insert_seq(best, n, &nbest, LOCAL_opcount3[i][1],
+		   (key >> 20) & 0x3ff, (key >> 10) & 0x3ff, key & 0x3ff);
+      }
+    }
+  }
+  return nbest;
+}
+
+static int
+get_sequence_args(Term t1, Term t2, int *lenp, int *np, char *pred)
+{
+  if (IsVarTerm(t1)) {
+    Yap_Error(INSTANTIATION_ERROR, t1, pred);
     return FALSE;
   }
-  if (!IsIntegerTerm(t)) {
-    Yap_Error(TYPE_ERROR_INTEGER, t, "shows_sequences/1");
+  if (!IsIntegerTerm(t1)) {
+    Yap_Error(TYPE_ERROR_INTEGER, t1, pred);
     return FALSE;
   }
-  min = (YAP_ULONG_LONG)IntegerOfTerm(t);
-  if (min <= 0) {
-    Yap_Error(DOMAIN_ERROR_NOT_LESS_THAN_ZERO, t, "shows_sequences/1");
+  *lenp = IntegerOfTerm(t1);
+  if (*lenp != 2 && *lenp != 3) {
+    Yap_Error(DOMAIN_ERROR_OUT_OF_RANGE, t1, pred);
     return FALSE;
   }
-  if (min <= 0) {
-    Yap_Error(DOMAIN_ERROR_NOT_LESS_THAN_ZERO, t, "shows_sequences/1");
+  if (IsVarTerm(t2)) {
+    Yap_Error(INSTANTIATION_ERROR, t2, pred);
     return FALSE;
   }
-  for (i = 0; i <= _std_top; ++i) {
-    sum += GLOBAL_opcount[i];
+  if (!IsIntegerTerm(t2)) {
+    Yap_Error(TYPE_ERROR_INTEGER, t2, pred);
+    return FALSE;
   }
-  for (i = 0; i <= _std_top; ++i) {
-    for (j = 0; j <= _std_top; ++j) {
-      YAP_ULONG_LONG seqs = Yap_2opcount[i][j];
-      if (seqs && sum/seqs <= min) {
-	/*
-	Term t[3], t0;
-	Functor f = 
-	t[0] = Yap_MkFloatTerm(((double)seqs*100.0)/sum);
-	t[1] = Yap_LookupAtom(Yap_op_names[i]);
-	t[2] = Yap_LookupAtom(Yap_op_names[j]);
-	t0 = MkApplTerm(
-	Yap_MkPairTerm(Yap_op_names[i]
-	*/
-	fprintf(stderr,"%f -> %s,%s\n",((double)seqs*100.0)/sum,Yap_op_names[i],Yap_op_names[j]);
-	/* we found one */
-      }
-    }  
+  *np = IntegerOfTerm(t2);
+  if (*np <= 0) {
+    Yap_Error(DOMAIN_ERROR_NOT_LESS_THAN_ZERO, t2, pred);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static Int
+p_show_op_sequences( USES_REGS1 )
+{
+  int len, n, nbest, i, j;
+  YAP_ULONG_LONG sum = 0;
+  op_seq_t *best;
+
+  if (!get_sequence_args(Deref(ARG1), Deref(ARG2), &len, &n, "show_op_sequences/2"))
+    return FALSE;
+  if (!(best = (op_seq_t *)malloc(n*sizeof(op_seq_t)))) {
+    Yap_Error(OUT_OF_HEAP_ERROR, TermNil, "show_op_sequences/2");
+    return FALSE;
+  }
+  for (i = 0; i <= _std_top; ++i)
+    sum += LOCAL_opcount[i];
+  nbest = top_sequences(len, n, best PASS_REGS);
+  fprintf(GLOBAL_stderr, "\n Most frequent sequences of %d instructions\n", len);
+  for (i = 0; i < nbest; i++) {
+    fprintf(GLOBAL_stderr, "%6.2f%% %12llu ",
+	    (sum ? ((double)best[i].count*100.0)/sum : 0.0), best[i].count);
+    for (j = 0; j < len; j++)
+      fprintf(GLOBAL_stderr, " %s", Yap_op_names[best[i].ops[j]]);
+    fputc('\n', GLOBAL_stderr);
   }
+  free(best);
   return TRUE;
 }
 
+/* op_sequences(+Len, +N, -Seqs): Seqs is a list of Count-[Op,...] */
+static Int
+p_op_sequences( USES_REGS1 )
+{
+  int len, n, nbest, i, j;
+  op_seq_t *best;
+  Term out = TermNil;
+
+  if (!get_sequence_args(Deref(ARG1), Deref(ARG2), &len, &n, "op_sequences/3"))
+    return FALSE;
+  if (!(best = (op_seq_t *)malloc(n*sizeof(op_seq_t)))) {
+    Yap_Error(OUT_OF_HEAP_ERROR, TermNil, "op_sequences/3");
+    return FALSE;
+  }
+  nbest = top_sequences(len, n, best PASS_REGS);
+  if (H+nbest*(2*len+5) > ASP-1024) {
+    free(best);
+    if (!Yap_gcl(nbest*(2*len+5)*sizeof(CELL), 3, ENV, gc_P(P,CP))) {
+      Yap_Error(OUT_OF_STACK_ERROR, TermNil, LOCAL_ErrorMessage);
+      return FALSE;
+    }
+    return p_op_sequences( PASS_REGS1 );
+  }
+  for (i = nbest-1; i >= 0; i--) {
+    Term ops = TermNil, ts[2];
+
+    for (j = len-1; j >= 0; j--)
+      ops = MkPairTerm(MkAtomTerm(Yap_LookupAtom(Yap_op_names[best[i].ops[j]])), ops);
+    ts[0] = MkIntegerTerm(best[i].count);
+    ts[1] = ops;
+    out = MkPairTerm(Yap_MkApplTerm(FunctorMinus, 2, ts), out);
+  }
+  free(best);
+  return Yap_unify(ARG3, out);
+}
+
 void 
 Yap_InitAnalystPreds(void)
 {
-  Yap_InitCPred("wam_profile_reset_op_counters", 0, p_reset_op_counters, SafePredFlag |SyncPredFlag);
-  Yap_InitCPred("wam_profile_show_op_counters", 1, p_show_op_counters, SafePredFlag|SyncPredFlag);
-  Yap_InitCPred("wam_profile_show_ops_by_group", 1, p_show_ops_by_group, SafePredFlag |SyncPredFlag);
-  Yap_InitCPred("wam_profile_show_sequences", 1, p_show_sequences, SafePredFlag |SyncPredFlag);
+  Yap_InitCPred("reset_op_counters", 0, p_reset_op_counters, SafePredFlag |SyncPredFlag);
+  Yap_InitCPred("show_op_counters", 1, p_show_op_counters, SafePredFlag|SyncPredFlag);
+  Yap_InitCPred("show_ops_by_group", 1, p_show_ops_by_group, SafePredFlag |SyncPredFlag);
+  Yap_InitCPred("show_op_sequences", 2, p_show_op_sequences, SafePredFlag |SyncPredFlag);
+  Yap_InitCPred("op_sequences", 3, p_op_sequences, SyncPredFlag);
 }
 
 #endif /* ANALYST */
@@ -817,7 +817,7 @@ ClearStaticArray(StaticArrayEntry *pp)
 	if (ptr->Flags & LogUpdMask) {
 	  LogUpdClause *lup = (LogUpdClause *)ptr;
 	  //	  LOCK(lup->ClLock);
-	  lup->ClRefCount--;
+	  DEC_LU_CLREF(lup);
 	  if (lup->ClRefCount == 0 &&
 	      (lup->ClFlags & ErasedMask) &&
 	      !(lup->ClFlags & InUseMask)) {
@@ -1812,7 +1812,7 @@ p_assign_static( USES_REGS1 )
 	  if (ptr->Flags & LogUpdMask) {
 	    LogUpdClause *lup = (LogUpdClause *)ptr;
 	    //	    LOCK(lup->ClLock);
-	    lup->ClRefCount--;
+	    DEC_LU_CLREF(lup);
 	    if (lup->ClRefCount == 0 &&
 		(lup->ClFlags & ErasedMask) &&
 		!(lup->ClFlags & InUseMask)) {
@@ -1834,7 +1834,7 @@ p_assign_static( USES_REGS1 )
 	if (p->Flags & LogUpdMask) {
 	  LogUpdClause *lup = (LogUpdClause *)p;
 	  //	  LOCK(lup->ClLock);
-	  lup->ClRefCount++;
+	  INC_LU_CLREF(lup);
 	  //	  UNLOCK(lup->ClLock);
 	} else {
 	  p->NOfRefsTo++;
@@ -3052,7 +3052,7 @@ YAP_Init(YAP_init_args *yap_init)
     Trail = MinTrailSpace;
   if (Stack < MinStackSpace)
     Stack = MinStackSpace;
-  if (!(LOCAL_GlobalBase = (ADDR)malloc((Trail+Stack)*1024))) {
+  if (!(LOCAL_GlobalBase = Yap_AllocStacks((Trail+Stack)*1024))) {
     yap_init->ErrorNo = RESOURCE_ERROR_MEMORY;
     yap_init->ErrorCause = "could not allocate stack space for main thread";
     return YAP_BOOT_ERROR;
@@ -520,6 +520,8 @@ STATIC_PROTO(Int  PredForCode,(yamop *, Atom *, UInt *, Term *));
 STATIC_PROTO(void  kill_first_log_iblock,(LogUpdIndex *, LogUpdIndex *, PredEntry *));
 STATIC_PROTO(LogUpdIndex *find_owner_log_index,(LogUpdIndex *, yamop *));
 STATIC_PROTO(StaticIndex *find_owner_static_index,(StaticIndex *, yamop *));
+STATIC_PROTO(UInt compute_dbcl_size,(UInt));
+STATIC_PROTO(int store_dbcl_size,(yamop *, UInt, CELL *, Term, PredEntry *));
 
 #define PredArity(p) (p->ArityOfPE)
 #define TRYCODE(G,F,N) ( (N)<5 ? (op_numbers)((int)F+(N)*3) : G)
@@ -903,14 +905,21 @@ split_megaclause(PredEntry *ap)
   MegaClause *mcl;
   yamop *ptr;
   UInt ncls = ap->cs.p_code.NOfClauses, i;
+  UInt sz;
 
   RemoveIndexation(ap);
   mcl =
     ClauseCodeToMegaClause(ap->cs.p_code.FirstClause);
+  if (mcl->ClFlags & ExoMask) {
+    /* rows are just terms, we will have to compile them */
+    sz = compute_dbcl_size(ap->ArityOfPE);
+  } else {
+    sz = mcl->ClItemSize+(UInt)NEXTOP((yamop *)NULL,p);
+  }
   for (i = 0, ptr = mcl->ClCode; i < ncls; i++) {
-    StaticClause *new = (StaticClause *)Yap_AllocCodeSpace(sizeof(StaticClause)+mcl->ClItemSize+(UInt)NEXTOP((yamop *)NULL,p));
+    StaticClause *new = (StaticClause *)Yap_AllocCodeSpace(sizeof(StaticClause)+sz);
     if (new == NULL) {
-      if (!Yap_growheap(FALSE, (sizeof(StaticClause)+mcl->ClItemSize)*(ncls-i), NULL)) {
+      if (!Yap_growheap(FALSE, (sizeof(StaticClause)+sz)*(ncls-i), NULL)) {
 	while (start) {
 	  StaticClause *cl = start;
 	  start = cl->ClNext;
@@ -927,12 +936,17 @@ split_megaclause(PredEntry *ap)
       }
       break;
     }
-    Yap_ClauseSpace += sizeof(StaticClause)+mcl->ClItemSize+(UInt)NEXTOP((yamop *)NULL,p);
+    Yap_ClauseSpace += sizeof(StaticClause)+sz;
     new->ClFlags = StaticMask|FactMask;
     new->ClSize = mcl->ClItemSize;
     new->usc.ClPred = ap;
     new->ClNext = NULL;
-    memcpy((void *)new->ClCode, (void *)ptr, mcl->ClItemSize);
+    if (mcl->ClFlags & ExoMask) {
+      new->ClSize = sizeof(StaticClause)+sz;
+      store_dbcl_size(new->ClCode, ap->ArityOfPE, (CELL *)ptr, TermNil, ap);
+    } else {
+      memcpy((void *)new->ClCode, (void *)ptr, mcl->ClItemSize);
+    }
     if (prev) {
       prev->ClNext = new;
     } else {
@@ -1008,7 +1022,7 @@ IPred(PredEntry *ap, UInt NSlots, yamop *next_pc)
     ap->cs.p_code.TrueCodeOfPred = BaseAddr;
     ap->PredFlags |= IndexedPredFlag;
   }
-  if (ap->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) {
+  if (PredIsWatched(ap)) {
     ap->OpcodeOfPred = Yap_opcode(_spy_pred);
     ap->CodeOfPred = (yamop *)(&(ap->OpcodeOfPred)); 
 #if defined(YAPOR) || defined(THREADS)
@@ -1040,7 +1054,7 @@ static void
 RemoveMainIndex(PredEntry *ap)
 {
   yamop *First = ap->cs.p_code.FirstClause;
-  int spied = ap->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag);
+  int spied = PredIsWatched(ap);
 
   ap->PredFlags &= ~IndexedPredFlag;
   if (First == NULL) {
@@ -1055,7 +1069,7 @@ RemoveMainIndex(PredEntry *ap)
 #ifdef TABLING
 	     ||ap->PredFlags & TabledPredFlag
 #endif /* TABLING */
-	     ) {
+	     || IsExoPred(ap)) {
     ap->OpcodeOfPred = INDEX_OPCODE;
     ap->CodeOfPred = ap->cs.p_code.TrueCodeOfPred = (yamop *)(&(ap->OpcodeOfPred)); 
   } else {
@@ -1077,7 +1091,7 @@ decrease_ref_counter(yamop *ptr, yamop *b, yamop *e, yamop *sc)
 {
   if (ptr != FAILCODE && ptr != sc && (ptr < b || ptr > e)) {
     LogUpdClause *cl = ClauseCodeToLogUpdClause(ptr);
-    cl->ClRefCount--;
+    DEC_LU_CLREF(cl);
     if (cl->ClFlags & ErasedMask &&
 	!(cl->ClRefCount) &&
 	!(cl->ClFlags & InUseMask)) {
@@ -1338,14 +1352,14 @@ kill_children(LogUpdIndex *c, PredEntry *ap)
 {
   LogUpdIndex *ncl;
 
-  c->ClRefCount++;
+  INC_LU_CLREF(c);
   ncl = c->ChildIndex;
   /* kill children */
   while (ncl) {
     kill_first_log_iblock(ncl, c, ap);
     ncl = c->ChildIndex;
   }
-  c->ClRefCount--;
+  DEC_LU_CLREF(c);
 }
 
 
@@ -1358,7 +1372,7 @@ kill_off_lu_block(LogUpdIndex *c, LogUpdIndex *parent, PredEntry *ap)
   if (parent != NULL) {
     /* sat bye bye */
     /* decrease refs */
-    parent->ClRefCount--;
+    DEC_LU_CLREF(parent);
     if (parent->ClFlags & ErasedMask &&
 	!(parent->ClFlags & InUseMask) &&
 	parent->ClRefCount == 0) {
@@ -1434,8 +1448,8 @@ kill_first_log_iblock(LogUpdIndex *c, LogUpdIndex *parent, PredEntry *ap)
 	parent->ClFlags & SwitchTableMask) {
     
       c->ParentIndex = parent->ParentIndex;
-      parent->ParentIndex->ClRefCount++;
-      parent->ClRefCount--;
+      INC_LU_CLREF(parent->ParentIndex);
+      DEC_LU_CLREF(parent);
     }
   }
 }
@@ -1456,11 +1470,11 @@ Yap_kill_iblock(ClauseUnion *blk, ClauseUnion *parent_blk, PredEntry *ap)
       LogUpdIndex *cl = (LogUpdIndex *)parent_blk;
 #if MULTIPLE_STACKS
       /* protect against attempts at erasing */
-      cl->ClRefCount++;
+      INC_LU_CLREF(cl);
 #endif
       kill_first_log_iblock(c, cl, ap);
 #if MULTIPLE_STACKS
-      cl->ClRefCount--;
+      DEC_LU_CLREF(cl);
 #endif
     } else {
       kill_first_log_iblock(c, NULL, ap);
@@ -1506,12 +1520,12 @@ Yap_ErLogUpdIndex(LogUpdIndex *clau)
   } else {
 #if MULTIPLE_STACKS
     /* protect against attempts at erasing */
-    clau->ClRefCount++;
+    INC_LU_CLREF(clau);
 #endif
     kill_first_log_iblock(clau, clau->ParentIndex, clau->ClPred);
 #if MULTIPLE_STACKS
     /* protect against attempts at erasing */
-    clau->ClRefCount--;
+    DEC_LU_CLREF(clau);
 #endif
   }
 }
@@ -1553,6 +1567,21 @@ Yap_RemoveIndexation(PredEntry *ap)
 #define	consult	1
 #define	asserta	2
 
+#ifdef TABLING_INCREMENTAL
+/* p is already locked: the clauses of an incremental predicate changed,
+   make sure the tables that depend on it will be evaluated again and that
+   its calls still go through the spy entry, where they are recorded */
+void
+Yap_UpdateIncrementalPred(PredEntry *p)
+{
+  p->IncrementalTimeStampOfPred = ++GLOBAL_inc_timestamp;
+  if (p->cs.p_code.FirstClause == NULL)
+    p->cs.p_code.TrueCodeOfPred = FAILCODE;
+  p->OpcodeOfPred = Yap_opcode(_spy_pred);
+  p->CodeOfPred = (yamop *)(&(p->OpcodeOfPred));
+}
+#endif /* TABLING_INCREMENTAL */
+
 /* p is already locked */
 static void 
 retract_all(PredEntry *p, int in_use)
@@ -1625,6 +1654,9 @@ retract_all(PredEntry *p, int in_use)
   p->StatisticsForPred.NOfEntries = 0;
   p->StatisticsForPred.NOfHeadSuccesses = 0;
   p->StatisticsForPred.NOfRetries = 0;
+  p->IndexStatsOfPred.NOfTrees = 0;
+  p->IndexStatsOfPred.ArgsSwitched = 0;
+  p->IndexStatsOfPred.IndexBytes = 0;
   if (PROFILING) {
     p->PredFlags |= ProfiledPredFlag;
   } else
@@ -1633,6 +1665,10 @@ retract_all(PredEntry *p, int in_use)
     p->PredFlags |= CountPredFlag;
   } else
     p->PredFlags &= ~CountPredFlag;
+#ifdef TABLING_INCREMENTAL
+  if (p->ExtraPredFlags & IncrementalPredFlag)
+    Yap_UpdateIncrementalPred(p);
+#endif /* TABLING_INCREMENTAL */
   Yap_PutValue(AtomAbol, MkAtomTerm(AtomTrue));
 }
 
@@ -1684,6 +1720,9 @@ add_first_static(PredEntry *p, yamop *cp, int spy_flag)
   p->StatisticsForPred.NOfEntries = 0;
   p->StatisticsForPred.NOfHeadSuccesses = 0;
   p->StatisticsForPred.NOfRetries = 0;
+  p->IndexStatsOfPred.NOfTrees = 0;
+  p->IndexStatsOfPred.ArgsSwitched = 0;
+  p->IndexStatsOfPred.IndexBytes = 0;
   if (PROFILING) {
     p->PredFlags |= ProfiledPredFlag;
     spy_flag = TRUE;
@@ -1718,6 +1757,9 @@ add_first_dynamic(PredEntry *p, yamop *cp, int spy_flag)
   p->StatisticsForPred.NOfEntries = 0;
   p->StatisticsForPred.NOfHeadSuccesses = 0;
   p->StatisticsForPred.NOfRetries = 0;
+  p->IndexStatsOfPred.NOfTrees = 0;
+  p->IndexStatsOfPred.ArgsSwitched = 0;
+  p->IndexStatsOfPred.IndexBytes = 0;
   if (PROFILING) {
     p->PredFlags |= ProfiledPredFlag;
     spy_flag = TRUE;
@@ -1816,7 +1858,7 @@ asserta_stat_clause(PredEntry *p, yamop *q, int spy_flag)
     clq->ClNext = clp;
     clp->ClPrev = clq;
     p->cs.p_code.FirstClause = q;
-    if (p->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) {
+    if (PredIsWatched(p)) {
       p->OpcodeOfPred = Yap_opcode(_spy_pred);
       p->CodeOfPred = (yamop *)(&(p->OpcodeOfPred)); 
     } else if (!(p->PredFlags & IndexedPredFlag)) {
@@ -1835,7 +1877,7 @@ asserta_stat_clause(PredEntry *p, yamop *q, int spy_flag)
   cl->ClNext = ClauseCodeToStaticClause(p->cs.p_code.FirstClause);
   p->cs.p_code.FirstClause = q;
   p->cs.p_code.TrueCodeOfPred = q;
-  if (p->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) {
+  if (PredIsWatched(p)) {
     p->OpcodeOfPred = Yap_opcode(_spy_pred);
     p->CodeOfPred = (yamop *)(&(p->OpcodeOfPred)); 
   } else if (!(p->PredFlags & IndexedPredFlag)) {
@@ -1905,7 +1947,7 @@ assertz_stat_clause(PredEntry *p, yamop *cp, int spy_flag)
       p->CodeOfPred = (yamop *)(&(p->OpcodeOfPred)); 
     }
 #endif
-    if (p->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) {
+    if (PredIsWatched(p)) {
       p->OpcodeOfPred = Yap_opcode(_spy_pred);
       p->CodeOfPred = (yamop *)(&(p->OpcodeOfPred)); 
     } 
@@ -1916,7 +1958,7 @@ assertz_stat_clause(PredEntry *p, yamop *cp, int spy_flag)
     cl->ClNext = ClauseCodeToStaticClause(cp);
   }
   if (p->cs.p_code.FirstClause == p->cs.p_code.LastClause) {
-    if (!(p->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag))) {
+    if (!PredIsWatched(p)) {
       p->OpcodeOfPred = INDEX_OPCODE;
       p->CodeOfPred = (yamop *)(&(p->OpcodeOfPred)); 
     }
@@ -2156,7 +2198,8 @@ addclause(Term t, yamop *cp, int mode, Term mod, Term *t4ref)
   if (pflags & IndexedPredFlag) {
     Yap_AddClauseToIndex(p, cp, mode == asserta);
   }
-  if (pflags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag))
+  if ((pflags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) ||
+      (p->ExtraPredFlags & IncrementalPredFlag))
     spy_flag = TRUE;
   if (p == PredGoalExpansion) {
     Term tg = ArgOfTerm(1, tf);
@@ -2289,14 +2332,23 @@ addclause(Term t, yamop *cp, int mode, Term mod, Term *t4ref)
     }
 #endif
   }
-  UNLOCKPE(32,p);
+#ifdef TABLING_INCREMENTAL
+  if (p->ExtraPredFlags & IncrementalPredFlag)
+    Yap_UpdateIncrementalPred(p);
+#endif /* TABLING_INCREMENTAL */
+#if MULTIPLE_STACKS
   if (pflags & LogUpdatePredFlag) {
     LogUpdClause *cl = (LogUpdClause *)ClauseCodeToLogUpdClause(cp);
-    tf = MkDBRefTerm((DBRef)cl);
-#if MULTIPLE_STACKS
+    /* take the reference before anyone else can retract the clause */
     TRAIL_CLREF(cl);		/* So that fail will erase it */
     INC_CLREF_COUNT(cl);
-#else
+  }
+#endif
+  UNLOCKPE(32,p);
+  if (pflags & LogUpdatePredFlag) {
+    LogUpdClause *cl = (LogUpdClause *)ClauseCodeToLogUpdClause(cp);
+    tf = MkDBRefTerm((DBRef)cl);
+#if !MULTIPLE_STACKS
     if (!(cl->ClFlags & InUseMask)) {
       cl->ClFlags |= InUseMask;
       TRAIL_CLREF(cl);	/* So that fail will erase it */
@@ -2408,7 +2460,7 @@ Yap_EraseStaticClause(StaticClause *cl, Term mod) {
   } else if (ap->cs.p_code.NOfClauses > 1) {
     ap->OpcodeOfPred = INDEX_OPCODE;
     ap->CodeOfPred = ap->cs.p_code.TrueCodeOfPred = (yamop *)(&(ap->OpcodeOfPred)); 
-  } else if (ap->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) {
+  } else if (PredIsWatched(ap)) {
       ap->OpcodeOfPred = Yap_opcode(_spy_pred);
       ap->CodeOfPred = ap->cs.p_code.TrueCodeOfPred = (yamop *)(&(ap->OpcodeOfPred)); 
   } else {
@@ -2792,7 +2844,8 @@ p_rmspy( USES_REGS1 )
     return TRUE;
   } 
 #endif
-  if (!(pred->PredFlags & (CountPredFlag|ProfiledPredFlag))) {
+  if (!(pred->PredFlags & (CountPredFlag|ProfiledPredFlag)) &&
+      !(pred->ExtraPredFlags & IncrementalPredFlag)) {
     if (!(pred->PredFlags & DynamicPredFlag)) {
 #if defined(YAPOR) || defined(THREADS)
       if (pred->PredFlags & LogUpdatePredFlag &&
@@ -3280,6 +3333,10 @@ search_for_static_predicate_in_use(PredEntry *p, int check_everything)
 	  LogUpdIndex *cl = ClauseCodeToLogUpdIndex(code_beg);
 	  if (find_owner_log_index(cl, code_p)) 
 	    b_ptr->cp_ap = cur_log_upd_clause(pe, b_ptr->cp_ap->u.Otapl.d);
+	} else if (IsExoPred(p)) {
+	  /* retry_exo does not point to clauses */
+	  UNLOCKPE(77,pe);
+	  return TRUE;
 	} else if (p->PredFlags & MegaClausePredFlag) {
 	  StaticIndex *cl = ClauseCodeToStaticIndex(code_beg);
 	  if (find_owner_static_index(cl, code_p)) 
@@ -5309,6 +5366,28 @@ p_static_pred_statistics( USES_REGS1 )
   return out;
 }
 
+static Int
+p_index_pred_statistics( USES_REGS1 )
+{				/* '$index_pred_statistics'(+P,+M,-Trees,-Args,-Bytes) */
+  PredEntry      *pe;
+  UInt            i, args;
+  Term            targs = TermNil;
+
+  pe = get_pred( Deref(ARG1), Deref(ARG2), "predicate_property");
+  if (EndOfPAEntr(pe))
+    return FALSE;
+  if (pe->PredFlags & (UserCPredFlag|AsmPredFlag|CPredFlag|BinaryPredFlag))
+    return FALSE;
+  args = pe->IndexStatsOfPred.ArgsSwitched;
+  for (i = 8*sizeof(UInt); i > 0; i--) {
+    if (args & ((UInt)1 << (i-1)))
+      targs = MkPairTerm(MkIntegerTerm(i), targs);
+  }
+  return Yap_unify(ARG3, MkIntegerTerm(pe->IndexStatsOfPred.NOfTrees)) &&
+    Yap_unify(ARG4, targs) &&
+    Yap_unify(ARG5, MkIntegerTerm(pe->IndexStatsOfPred.IndexBytes));
+}
+
 static Int
 p_predicate_erased_statistics( USES_REGS1 )
 {
@@ -5614,6 +5693,11 @@ p_choicepoint_info( USES_REGS1 )
       pe = ipc->u.OtapFs.p;
       t = BuildActivePred(pe, cptr->cp_args);
       break;
+    case _retry_exo:
+      ncl = ipc;
+      pe = ipc->u.Otapl.p;
+      t = BuildActivePred(pe, cptr->cp_args);
+      break;
     case _retry_profiled:
     case _count_retry:
       pe = NULL;
@@ -5687,10 +5771,9 @@ compute_dbcl_size(UInt arity)
   t = Deref(V); if(IsVarTerm(t) || !(IsAtomOrIntTerm(t))) Yap_Error(TYPE_ERROR_ATOM, t0, "load_db");
 
 static int 
-store_dbcl_size(yamop *pc, UInt arity, Term t0, PredEntry *pe)
+store_dbcl_size(yamop *pc, UInt arity, CELL *tp, Term t0, PredEntry *pe)
 {
   Term t;
-  CELL *tp = RepAppl(t0)+1;
   switch(arity) {
   case 2:
     pc->opc = Yap_opcode(_get_2atoms);
@@ -5848,7 +5931,7 @@ p_dbload_get_space( USES_REGS1 )
     mcl->ClCode;
   ap->PredFlags |= MegaClausePredFlag;
   ap->cs.p_code.NOfClauses = ncls;
-  if (ap->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) {
+  if (PredIsWatched(ap)) {
     ap->OpcodeOfPred = Yap_opcode(_spy_pred);
   } else {
     ap->OpcodeOfPred = INDEX_OPCODE;
@@ -5867,6 +5950,7 @@ p_dbassert( USES_REGS1 )
   PredEntry       *pe;
   MegaClause      *mcl;
   Int              n;
+  Term             t;
 
 
   if (IsVarTerm(thandle)  || !IsIntegerTerm(thandle)) {
@@ -5878,7 +5962,8 @@ p_dbassert( USES_REGS1 )
   }
   n = IntegerOfTerm(tn);
   pe = mcl->ClPred;
-  return store_dbcl_size((yamop *)((ADDR)mcl->ClCode+n*(mcl->ClItemSize)),pe->ArityOfPE,Deref(ARG1),pe);
+  t = Deref(ARG1);
+  return store_dbcl_size((yamop *)((ADDR)mcl->ClCode+n*(mcl->ClItemSize)),pe->ArityOfPE,RepAppl(t)+1,t,pe);
 }
 
 
@@ -5939,6 +6024,7 @@ Yap_InitCdMgr(void)
   Yap_InitCPred("$static_clause", 4, p_static_clause, SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$continue_static_clause", 5, p_continue_static_clause, SafePredFlag|SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$static_pred_statistics", 5, p_static_pred_statistics, SyncPredFlag|HiddenPredFlag);
+  Yap_InitCPred("$index_pred_statistics", 5, p_index_pred_statistics, SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$p_nth_clause", 4, p_nth_clause, SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$program_continuation", 3, p_program_continuation, SafePredFlag|SyncPredFlag|HiddenPredFlag);
   CurrentModule = HACKS_MODULE;
@@ -686,7 +686,7 @@ static CELL *MkDBTerm(register CELL *pt0, register CELL *pt0_end,
 	    if (dbentry->Flags & LogUpdMask) {
 	      LogUpdClause *cl = (LogUpdClause *)dbentry;
 
-	      cl->ClRefCount++;
+	      INC_LU_CLREF(cl);
 	    } else {
 	      dbentry->NOfRefsTo++;
 	    }
@@ -1245,7 +1245,7 @@ CreateDBWithDBRef(Term Tm, DBProp p, struct db_globs *dbg)
   }
   if (dbr->Flags & LogUpdMask) {
     LogUpdClause *cl = (LogUpdClause *)dbr;
-    cl->ClRefCount++;
+    INC_LU_CLREF(cl);
   } else {
     dbr->NOfRefsTo++;
   }
@@ -4061,7 +4061,7 @@ complete_lu_erase(LogUpdClause *clau)
     while ((ref = *--cp) != NIL) {
       if (ref->Flags & LogUpdMask) {
 	LogUpdClause *cl = (LogUpdClause *)ref;
-	cl->ClRefCount--;
+	DEC_LU_CLREF(cl);
 	if (cl->ClFlags & ErasedMask &&
 	    !(cl->ClFlags & InUseMask) &&
 	    !(cl->ClRefCount)) {
@@ -4134,7 +4134,7 @@ EraseLogUpdCl(LogUpdClause *clau)
     }
 #endif
     /* we are holding a reference to the clause */
-    clau->ClRefCount++;
+    INC_LU_CLREF(clau);
     if (ap) {
       /* mark it as erased */
       if (ap->LastCallOfPred != LUCALL_RETRACT) {
@@ -4158,9 +4158,13 @@ EraseLogUpdCl(LogUpdClause *clau)
       }
       clau->ClTimeEnd = ap->TimeStampOfPred;
       Yap_RemoveClauseFromIndex(ap, clau->ClCode);
+#ifdef TABLING_INCREMENTAL
+      if (ap->ExtraPredFlags & IncrementalPredFlag)
+	Yap_UpdateIncrementalPred(ap);
+#endif /* TABLING_INCREMENTAL */
       /* release the extra reference */
     }
-    clau->ClRefCount--;
+    DEC_LU_CLREF(clau);
   }
   complete_lu_erase(clau);
 }
@@ -4266,7 +4270,7 @@ PrepareToEraseLogUpdClause(LogUpdClause *clau, DBRef dbr)
       code_p = p->cs.p_code.FirstClause;
       code_p->u.Otapl.d = p->cs.p_code.FirstClause;
       p->cs.p_code.TrueCodeOfPred = NEXTOP(code_p, Otapl);
-      if (p->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) {
+      if (PredIsWatched(p)) {
 	p->OpcodeOfPred = Yap_opcode(_spy_pred);
 	p->CodeOfPred = (yamop *)(&(p->OpcodeOfPred)); 
 #if defined(YAPOR) || defined(THREADS)
@@ -4290,7 +4294,7 @@ PrepareToEraseLogUpdClause(LogUpdClause *clau, DBRef dbr)
       p->cs.p_code.TrueCodeOfPred = p->CodeOfPred = (yamop *)(&(p->OpcodeOfPred)); 
     }
   } else {
-    if (p->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) {
+    if (PredIsWatched(p)) {
       p->OpcodeOfPred = Yap_opcode(_spy_pred);
       p->CodeOfPred = (yamop *)(&(p->OpcodeOfPred)); 
 #if defined(YAPOR) || defined(THREADS)
@@ -4429,7 +4433,7 @@ p_increase_reference_counter( USES_REGS1 )
   }
   cl = (LogUpdClause *)DBRefOfTerm(t1);
   PELOCK(67,cl->ClPred);
-  cl->ClRefCount++;
+  INC_LU_CLREF(cl);
   UNLOCK(cl->ClPred);
   return TRUE;
 }
@@ -4452,7 +4456,7 @@ p_decrease_reference_counter( USES_REGS1 )
   cl = (LogUpdClause *)DBRefOfTerm(t1);
   PELOCK(67,cl->ClPred);
   if (cl->ClRefCount) {
-    cl->ClRefCount--;
+    DEC_LU_CLREF(cl);
     UNLOCK(cl->ClPred);
     return TRUE;
   }
@@ -4808,7 +4812,7 @@ Yap_LUInstance(LogUpdClause *cl, UInt arity)
     }
   }
 #if MULTIPLE_STACKS
-  cl->ClRefCount++;
+  INC_LU_CLREF(cl);
   TRAIL_CLREF(cl);	/* So that fail will erase it */
 #else
   if (!(cl->ClFlags & InUseMask)) {
@@ -5151,42 +5155,6 @@ p_enqueue( USES_REGS1 )
   return TRUE;
 }
 
-static Int 
-p_enqueue_unlocked( USES_REGS1 )
-{
-  Term Father = Deref(ARG1);
-  QueueEntry *x;
-  db_queue *father_key;
-
-  if (IsVarTerm(Father)) {
-    Yap_Error(INSTANTIATION_ERROR, Father, "enqueue");
-    return FALSE;
-  } else if (!IsIntegerTerm(Father)) {
-    Yap_Error(TYPE_ERROR_INTEGER, Father, "enqueue");
-    return FALSE;
-  } else
-    father_key = (db_queue *)IntegerOfTerm(Father);
-  while ((x = (QueueEntry *)AllocDBSpace(sizeof(QueueEntry))) == NULL) {
-    if (!Yap_growheap(FALSE, sizeof(QueueEntry), NULL)) {
-      Yap_Error(OUT_OF_HEAP_ERROR, TermNil, "in findall");
-      return FALSE;
-    }
-  }
-  /* Yap_LUClauseSpace += sizeof(QueueEntry); */
-  x->DBT = StoreTermInDB(Deref(ARG2), 2 PASS_REGS);
-  if (x->DBT == NULL) {
-    return FALSE;
-  }
-  x->next = NULL;
-  if (father_key->LastInQueue != NULL)
-    father_key->LastInQueue->next = x;
-  father_key->LastInQueue = x;
-  if (father_key->FirstInQueue == NULL) {
-    father_key->FirstInQueue = x;
-  }
-  return TRUE;
-}
-
 /* when reading an entry in the data base we are making it accessible from
    the outside. If the entry was removed, and this was the last pointer, the
    target entry would be immediately removed, leading to dangling pointers.
@@ -5272,107 +5240,6 @@ p_dequeue( USES_REGS1 )
 }
 
 
-static Int 
-p_dequeue_unlocked( USES_REGS1 )
-{
-  db_queue *father_key;
-  QueueEntry *cur_instance, *prev_instance;
-  Term Father = Deref(ARG1);
-
-  if (IsVarTerm(Father)) {
-    Yap_Error(INSTANTIATION_ERROR, Father, "dequeue");
-    return FALSE;
-  } else if (!IsIntegerTerm(Father)) {
-    Yap_Error(TYPE_ERROR_INTEGER, Father, "dequeue");
-    return FALSE;
-  } else
-    father_key = (db_queue *)IntegerOfTerm(Father);
-  prev_instance = NULL;
-  cur_instance = father_key->FirstInQueue;
-  while (cur_instance) {
-    Term TDB;
-    while ((TDB = GetDBTerm(cur_instance->DBT PASS_REGS)) == 0L) {
-      if (LOCAL_Error_TYPE == OUT_OF_ATTVARS_ERROR) {
-	LOCAL_Error_TYPE = YAP_NO_ERROR;
-	if (!Yap_growglobal(NULL)) {
-	  Yap_Error(OUT_OF_ATTVARS_ERROR, TermNil, LOCAL_ErrorMessage);
-	  return FALSE;
-	}
-      } else {
-	LOCAL_Error_TYPE = YAP_NO_ERROR;
-	if (!Yap_gcl(LOCAL_Error_Size, 2, ENV, gc_P(P,CP))) {
-	  Yap_Error(OUT_OF_STACK_ERROR, TermNil, LOCAL_ErrorMessage);
-	  return FALSE;
-	}
-      }
-    }
-    if (Yap_unify(ARG2, TDB)) {
-      if (prev_instance)  {
-	prev_instance->next = cur_instance->next;
-	if (father_key->LastInQueue == cur_instance)
-	  father_key->LastInQueue = prev_instance;
-      } else if (cur_instance == father_key->LastInQueue)
-	father_key->FirstInQueue = father_key->LastInQueue = NULL;
-      else
-	father_key->FirstInQueue = cur_instance->next;
-      /* release space for cur_instance */
-      keepdbrefs(cur_instance->DBT PASS_REGS);
-      ErasePendingRefs(cur_instance->DBT PASS_REGS);
-      FreeDBSpace((char *) cur_instance->DBT);
-      FreeDBSpace((char *) cur_instance);
-      return TRUE;
-    } else {
-      prev_instance = cur_instance;
-      cur_instance = cur_instance->next;
-    }
-  }
-  /* an empty queue automatically goes away */
-  return FALSE;
-}
-
-static Int 
-p_peek_queue( USES_REGS1 )
-{
-  db_queue *father_key;
-  QueueEntry *cur_instance;
-  Term Father = Deref(ARG1);
-
-  if (IsVarTerm(Father)) {
-    Yap_Error(INSTANTIATION_ERROR, Father, "dequeue");
-    return FALSE;
-  } else if (!IsIntegerTerm(Father)) {
-    Yap_Error(TYPE_ERROR_INTEGER, Father, "dequeue");
-    return FALSE;
-  } else
-    father_key = (db_queue *)IntegerOfTerm(Father);
-  cur_instance = father_key->FirstInQueue;
-  while (cur_instance) {
-    Term TDB;
-    while ((TDB = GetDBTerm(cur_instance->DBT PASS_REGS)) == 0L) {
-      if (LOCAL_Error_TYPE == OUT_OF_ATTVARS_ERROR) {
-	LOCAL_Error_TYPE = YAP_NO_ERROR;
-	if (!Yap_growglobal(NULL)) {
-	  Yap_Error(OUT_OF_ATTVARS_ERROR, TermNil, LOCAL_ErrorMessage);
-	  return FALSE;
-	}
-      } else {
-	LOCAL_Error_TYPE = YAP_NO_ERROR;
-	if (!Yap_gcl(LOCAL_Error_Size, 2, ENV, gc_P(P,CP))) {
-	  Yap_Error(OUT_OF_STACK_ERROR, TermNil, LOCAL_ErrorMessage);
-	  return FALSE;
-	}
-      }
-    }
-    if (Yap_unify(ARG2, TDB)) {
-      return TRUE;
-    }
-    cur_instance = cur_instance->next;
-  }
-  return FALSE;
-}
-
-
-
 static Int
 p_clean_queues( USES_REGS1 )
 {
@@ -5544,10 +5411,7 @@ Yap_InitDBPreds(void)
   Yap_InitCPred("$init_db_queue", 1, p_init_queue, SafePredFlag|SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$db_key", 2, p_db_key, HiddenPredFlag);
   Yap_InitCPred("$db_enqueue", 2, p_enqueue, SyncPredFlag|HiddenPredFlag);
-  Yap_InitCPred("$db_enqueue_unlocked", 2, p_enqueue_unlocked, SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$db_dequeue", 2, p_dequeue, SyncPredFlag|HiddenPredFlag);
-  Yap_InitCPred("$db_dequeue_unlocked", 2, p_dequeue_unlocked, SyncPredFlag|HiddenPredFlag);
-  Yap_InitCPred("$db_peek_queue", 2, p_peek_queue, SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$db_clean_queues", 1, p_clean_queues, SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$switch_log_upd", 1, p_slu, SafePredFlag|SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$log_upd", 1, p_lu, SafePredFlag|SyncPredFlag|HiddenPredFlag);
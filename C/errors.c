@@ -872,6 +872,20 @@ Yap_Error(yap_error_number type, Term where, char *format,...)
       serious = TRUE;
     }
     break;
+  case EXISTENCE_ERROR_MESSAGE_QUEUE:
+    {
+      int i;
+      Term ti[2];
+
+      i = strlen(tmpbuf);
+      ti[0] = MkAtomTerm(AtomMessageQueue);
+      ti[1] = where;
+      nt[0] = Yap_MkApplTerm(FunctorExistenceError, 2, ti);
+      psize -= i;
+      fun = FunctorError;
+      serious = TRUE;
+    }
+    break;
   case EXISTENCE_ERROR_SOURCE_SINK:
     {
       int i;
@@ -0,0 +1,478 @@
+/*************************************************************************
+*									 *
+*	 YAP Prolog 							 *
+*									 *
+*	Yap Prolog was developed at NCCUP - Universidade do Porto	 *
+*									 *
+* Copyright L.Damas, V.S.Costa and Universidade do Porto 1985-1997	 *
+*									 *
+**************************************************************************
+*									 *
+* File:		exo.c							 *
+* Last rev:								 *
+* mods:									 *
+* comments:	Exo compilation: tables of ground facts			 *
+*									 *
+*************************************************************************/
+
+/*
+  An exo predicate is a static predicate whose clauses are ground
+  facts over atoms and small integers. The facts are not compiled:
+  they are kept as rows of Terms in a single mega clause, ClItemSize
+  being arity cells, and the mega clause is marked with ExoMask.
+
+  The predicate is executed by the exo and retry_exo instructions,
+  stored in the main index block. Each mode of usage, given by the
+  arguments that are bound at call time, gets its own hash table,
+  built on demand and kept as a child of the main index block.  Hash
+  chains follow the order of the rows, so solutions are always found
+  in the order the facts were given.
+*/
+
+#include "Yap.h"
+#include "clause.h"
+#include "yapio.h"
+#include "eval.h"
+#include "tracer.h"
+#ifdef YAPOR
+#include "or.macros.h"
+#endif	/* YAPOR */
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+
+/* we can only remember as many bound arguments as bits in an UInt */
+#define EXO_MAX_BITS (sizeof(UInt)*8)
+
+typedef struct exo_index {
+  /* arguments used for hashing */
+  UInt bmap;
+  /* number of hash buckets, always a power of two */
+  UInt size;
+  /* first the buckets, then the links, with row numbers starting at 1 */
+  UInt key[MIN_ARRAY];
+} ExoIndex;
+
+#define ExoIndexBuckets(I) ((I)->key)
+#define ExoIndexLinks(I) ((I)->key+(I)->size)
+
+STATIC_PROTO(UInt exo_bmap, (UInt, int * CACHE_TYPE));
+STATIC_PROTO(UInt exo_hash_row, (CELL *, UInt, UInt));
+STATIC_PROTO(UInt exo_hash_call, (UInt, UInt CACHE_TYPE));
+STATIC_PROTO(void exo_fill, (ExoIndex *, CELL *, UInt, UInt));
+STATIC_PROTO(ExoIndex *exo_index, (PredEntry *, UInt));
+STATIC_PROTO(UInt exo_scan, (ExoIndex *, CELL *, UInt, UInt, UInt CACHE_TYPE));
+STATIC_PROTO(Int p_exo_get_space, ( USES_REGS1 ));
+STATIC_PROTO(Int p_exoassert, ( USES_REGS1 ));
+
+static inline UInt
+exo_hash(UInt h, Term t)
+{
+  h += ((UInt)t >> 3);
+  h += (h << 10);
+  h ^= (h >> 6);
+  return h;
+}
+
+static inline UInt
+exo_hash_end(UInt h)
+{
+  h += (h << 3);
+  h ^= (h >> 11);
+  h += (h << 15);
+  return h;
+}
+
+/*
+  dereference the arguments and find which ones are bound, we
+  can only match rows against atoms and small integers.
+*/
+static UInt
+exo_bmap(UInt arity, int *failp USES_REGS)
+{
+  UInt i, bmap = 0;
+
+  *failp = FALSE;
+  for (i = 0; i < arity; i++) {
+    Term t = Deref(XREGS[i+1]);
+
+    XREGS[i+1] = t;
+    if (!IsVarTerm(t)) {
+      if (!IsAtomOrIntTerm(t)) {
+	*failp = TRUE;
+	return 0;
+      }
+      if (i < EXO_MAX_BITS)
+	bmap |= ((UInt)1 << i);
+    }
+  }
+  return bmap;
+}
+
+static UInt
+exo_hash_row(CELL *row, UInt arity, UInt bmap)
+{
+  UInt i, h = 0;
+
+  for (i = 0; i < arity && i < EXO_MAX_BITS; i++) {
+    if (bmap & ((UInt)1 << i))
+      h = exo_hash(h, row[i]);
+  }
+  return exo_hash_end(h);
+}
+
+static UInt
+exo_hash_call(UInt arity, UInt bmap USES_REGS)
+{
+  return exo_hash_row(XREGS+1, arity, bmap);
+}
+
+static inline int
+exo_row_matches(CELL *row, UInt arity USES_REGS)
+{
+  UInt i;
+
+  for (i = 0; i < arity; i++) {
+    Term t = XREGS[i+1];
+    if (!IsVarTerm(t) && t != row[i])
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* (re)compute the hash chains for a table, last row first */
+static void
+exo_fill(ExoIndex *ix, CELL *rows, UInt arity, UInt nrows)
+{
+  UInt *buckets = ExoIndexBuckets(ix), *links = ExoIndexLinks(ix);
+  UInt r, mask = ix->size-1;
+
+  memset((void *)buckets, 0, ix->size*sizeof(UInt));
+  for (r = nrows; r > 0; r--) {
+    UInt h = exo_hash_row(rows+(r-1)*arity, arity, ix->bmap) & mask;
+
+    links[r-1] = buckets[h];
+    buckets[h] = r;
+  }
+}
+
+/*
+  find the hash table for this mode of usage, creating it if needed;
+  without a table we just go through every row.
+*/
+static ExoIndex *
+exo_index(PredEntry *ap, UInt bmap)
+{
+  StaticIndex *root = ClauseCodeToStaticIndex(ap->cs.p_code.TrueCodeOfPred);
+  StaticIndex *blk;
+  MegaClause *mcl;
+  UInt nrows, size, sz;
+  ExoIndex *ix;
+
+  if (!bmap)
+    return NULL;
+  for (blk = root->ChildIndex; blk; blk = blk->SiblingIndex) {
+    ix = (ExoIndex *)blk->ClCode;
+    if (ix->bmap == bmap)
+      return ix;
+  }
+  PELOCK(73,ap);
+  /* someone may have got here first */
+  for (blk = root->ChildIndex; blk; blk = blk->SiblingIndex) {
+    ix = (ExoIndex *)blk->ClCode;
+    if (ix->bmap == bmap) {
+      UNLOCKPE(74,ap);
+      return ix;
+    }
+  }
+  mcl = ClauseCodeToMegaClause(ap->cs.p_code.FirstClause);
+  nrows = ap->cs.p_code.NOfClauses;
+  for (size = 1; size < nrows; size <<= 1);
+  sz = (UInt)(((StaticIndex *)NULL)->ClCode)+(UInt)(((ExoIndex *)NULL)->key)+(size+nrows)*sizeof(UInt);
+  if (!(blk = (StaticIndex *)Yap_AllocCodeSpace(sz))) {
+    /* no space, we can always fall back to scanning the table */
+    UNLOCKPE(75,ap);
+    return NULL;
+  }
+  Yap_IndexSpace_SW += sz;
+  blk->ClFlags = SwitchTableMask|IndexMask|ExoMask;
+  blk->ClSize = sz;
+  blk->ClPred = ap;
+  blk->ChildIndex = NULL;
+  ix = (ExoIndex *)blk->ClCode;
+  ix->bmap = bmap;
+  ix->size = size;
+  exo_fill(ix, (CELL *)mcl->ClCode, ap->ArityOfPE, nrows);
+  blk->SiblingIndex = root->ChildIndex;
+  root->ChildIndex = blk;
+  INDEX_STAT_ADD(Yap_IndexTrees, 1);
+  INDEX_STAT_ADD(ap->IndexStatsOfPred.NOfTrees, 1);
+  INDEX_STAT_OR(ap->IndexStatsOfPred.ArgsSwitched, bmap);
+  INDEX_STAT_ADD(ap->IndexStatsOfPred.IndexBytes, sz);
+  UNLOCKPE(76,ap);
+  return ix;
+}
+
+/* first matching row from row number cand on, or 0 */
+static UInt
+exo_scan(ExoIndex *ix, CELL *rows, UInt arity, UInt nrows, UInt cand USES_REGS)
+{
+  if (ix) {
+    UInt *links = ExoIndexLinks(ix);
+
+    while (cand) {
+      if (exo_row_matches(rows+(cand-1)*arity, arity PASS_REGS))
+	return cand;
+      cand = links[cand-1];
+    }
+    return 0;
+  }
+  while (cand && cand <= nrows) {
+    if (exo_row_matches(rows+(cand-1)*arity, arity PASS_REGS))
+      return cand;
+    cand++;
+  }
+  return 0;
+}
+
+/*
+  called by the exo instruction: return the first row matching
+  the arguments, and set *nextp to the next matching row, if any.
+*/
+CELL *
+Yap_ExoFirst(PredEntry *ap, UInt *nextp USES_REGS)
+{
+  MegaClause *mcl = ClauseCodeToMegaClause(ap->cs.p_code.FirstClause);
+  CELL *rows = (CELL *)mcl->ClCode;
+  UInt arity = ap->ArityOfPE, nrows = ap->cs.p_code.NOfClauses;
+  UInt bmap, r;
+  ExoIndex *ix;
+  int fail;
+
+  bmap = exo_bmap(arity, &fail PASS_REGS);
+  if (fail)
+    return NULL;
+  if ((ix = exo_index(ap, bmap))) {
+    r = ExoIndexBuckets(ix)[exo_hash_call(arity, bmap PASS_REGS) & (ix->size-1)];
+  } else {
+    r = 1;
+  }
+  if (!(r = exo_scan(ix, rows, arity, nrows, r PASS_REGS)))
+    return NULL;
+  *nextp = exo_scan(ix, rows, arity, nrows, (ix ? ExoIndexLinks(ix)[r-1] : r+1) PASS_REGS);
+  return rows+(r-1)*arity;
+}
+
+/*
+  called by retry_exo: row r is known to match, return it and look
+  for the one after.
+*/
+CELL *
+Yap_ExoNext(PredEntry *ap, UInt r, UInt *nextp USES_REGS)
+{
+  MegaClause *mcl = ClauseCodeToMegaClause(ap->cs.p_code.FirstClause);
+  CELL *rows = (CELL *)mcl->ClCode;
+  UInt arity = ap->ArityOfPE;
+  ExoIndex *ix;
+  int fail;
+
+  ix = exo_index(ap, exo_bmap(arity, &fail PASS_REGS));
+  *nextp = exo_scan(ix, rows, arity, ap->cs.p_code.NOfClauses, (ix ? ExoIndexLinks(ix)[r-1] : r+1) PASS_REGS);
+  return rows+(r-1)*arity;
+}
+
+/*
+  build the main index block for an exo predicate: it just holds
+  the exo and retry_exo instructions, hash tables will hang from it.
+*/
+yamop *
+Yap_ExoIndexCode(PredEntry *ap)
+{
+  CACHE_REGS
+  StaticIndex *root;
+  yamop *code;
+  UInt sz = (UInt)NEXTOP(NEXTOP(NEXTOP(((StaticIndex *)NULL)->ClCode,Otapl),Otapl),l);
+
+  while (!(root = (StaticIndex *)Yap_AllocCodeSpace(sz))) {
+    if (!Yap_growheap(FALSE, sz, NULL)) {
+      Yap_Error(OUT_OF_HEAP_ERROR, TermNil, "while indexing exo predicate");
+      return NULL;
+    }
+  }
+  Yap_IndexSpace_Tree += sz;
+  root->ClFlags = IndexMask|ExoMask;
+  root->ClSize = sz;
+  root->ClPred = ap;
+  root->SiblingIndex = NULL;
+  root->ChildIndex = NULL;
+  code = root->ClCode;
+  code->opc = Yap_opcode(_exo);
+  code->u.Otapl.s = ap->ArityOfPE+1;
+  code->u.Otapl.p = ap;
+  code->u.Otapl.d = ap->cs.p_code.FirstClause;
+#ifdef TABLING
+  code->u.Otapl.te = NULL;
+#endif /* TABLING */
+#ifdef YAPOR
+  INIT_YAMOP_LTT(code, 1);
+  PUT_YAMOP_SEQ(code);
+#endif /* YAPOR */
+  code = NEXTOP(code,Otapl);
+  code->opc = Yap_opcode(_retry_exo);
+  code->u.Otapl.s = ap->ArityOfPE+1;
+  code->u.Otapl.p = ap;
+  code->u.Otapl.d = ap->cs.p_code.FirstClause;
+#ifdef TABLING
+  code->u.Otapl.te = NULL;
+#endif /* TABLING */
+#ifdef YAPOR
+  INIT_YAMOP_LTT(code, 1);
+  PUT_YAMOP_SEQ(code);
+#endif /* YAPOR */
+  code = NEXTOP(code,Otapl);
+  code->opc = Yap_opcode(_Ystop);
+  code->u.l.l = root->ClCode;
+  Yap_inform_profiler_of_clause(root, (char *)root+sz, ap, GPROF_INDEX);
+  return root->ClCode;
+}
+
+/* atoms have moved, recompute the hash tables */
+void
+Yap_ExoRehash(PredEntry *ap)
+{
+  StaticIndex *root = ClauseCodeToStaticIndex(ap->cs.p_code.TrueCodeOfPred);
+  MegaClause *mcl = ClauseCodeToMegaClause(ap->cs.p_code.FirstClause);
+  StaticIndex *blk;
+
+  for (blk = root->ChildIndex; blk; blk = blk->SiblingIndex) {
+    exo_fill((ExoIndex *)blk->ClCode, (CELL *)mcl->ClCode, ap->ArityOfPE, ap->cs.p_code.NOfClauses);
+  }
+}
+
+static Int
+p_exo_get_space( USES_REGS1 )
+{				/* exo_get_space(+Pred,+Mod,+Rows,-Handle) */
+  Term            t = Deref(ARG1);
+  Term            mod = Deref(ARG2);
+  Term            tn = Deref(ARG3);
+  UInt		  arity;
+  Prop            pe;
+  PredEntry      *ap;
+  MegaClause     *mcl;
+  UInt            ncls;
+  UInt            required;
+
+  if (IsVarTerm(mod)  || !IsAtomTerm(mod)) {
+    return FALSE;
+  }
+  if (IsApplTerm(t)) {
+    Functor f = FunctorOfTerm(t);
+    arity = ArityOfFunctor(f);
+    pe = PredPropByFunc(f, mod);
+  } else {
+    Yap_Error(TYPE_ERROR_COMPOUND,t,"load_exo/1");
+    return FALSE;
+  }
+  if (EndOfPAEntr(pe))
+    return FALSE;
+  ap = RepPredProp(pe);
+  if (ap->PredFlags & (DynamicPredFlag|LogUpdatePredFlag
+#ifdef TABLING
+		       |TabledPredFlag
+#endif /* TABLING */
+		       |UDIPredFlag)) {
+    Yap_Error(PERMISSION_ERROR_MODIFY_STATIC_PROCEDURE,t,"exo_get_space/4");
+    return FALSE;
+  }
+  if (IsVarTerm(tn)  || !IsIntegerTerm(tn)) {
+    return FALSE;
+  }
+  ncls = IntegerOfTerm(tn);
+  if (ncls < 1) {
+    return FALSE;
+  }
+  if (ap->cs.p_code.NOfClauses) {
+    Yap_Abolish(ap);
+  }
+  required = ncls*arity*sizeof(CELL)+(UInt)(((MegaClause *)NULL)->ClCode);
+  while (!(mcl = (MegaClause *)Yap_AllocCodeSpace(required))) {
+    if (!Yap_growheap(FALSE, required, NULL)) {
+      /* just fail, the system will keep on going */
+      return FALSE;
+    }
+  }
+  Yap_ClauseSpace += required;
+  mcl->ClFlags = MegaMask|ExoMask;
+  mcl->ClSize = required;
+  mcl->ClPred = ap;
+  mcl->ClItemSize = arity*sizeof(CELL);
+  mcl->ClNext = NULL;
+  ap->cs.p_code.FirstClause =
+    ap->cs.p_code.LastClause =
+    mcl->ClCode;
+  ap->PredFlags |= (MegaClausePredFlag|CompiledPredFlag);
+  ap->cs.p_code.NOfClauses = ncls;
+  ap->IndexStatsOfPred.NOfTrees = 0;
+  ap->IndexStatsOfPred.ArgsSwitched = 0;
+  ap->IndexStatsOfPred.IndexBytes = 0;
+  if (ap->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) {
+    ap->OpcodeOfPred = Yap_opcode(_spy_pred);
+  } else {
+    ap->OpcodeOfPred = INDEX_OPCODE;
+  }
+  ap->CodeOfPred = ap->cs.p_code.TrueCodeOfPred = (yamop *)(&(ap->OpcodeOfPred));
+  Yap_inform_profiler_of_clause(mcl, (char *)mcl+required, ap, GPROF_MEGA);
+  return Yap_unify(ARG4, MkIntegerTerm((Int)mcl));
+}
+
+static Int
+p_exoassert( USES_REGS1 )
+{				/* exoassert(+Fact,+Handle,+Row) */
+  Term            thandle = Deref(ARG2);
+  Term            tn = Deref(ARG3);
+  Term            t0 = Deref(ARG1);
+  MegaClause      *mcl;
+  UInt             n, arity, i;
+  CELL            *row, *tp;
+
+  if (IsVarTerm(thandle)  || !IsIntegerTerm(thandle)) {
+    return FALSE;
+  }
+  mcl = (MegaClause *)IntegerOfTerm(thandle);
+  if (IsVarTerm(tn)  || !IsIntegerTerm(tn)) {
+    return FALSE;
+  }
+  n = IntegerOfTerm(tn);
+  arity = mcl->ClPred->ArityOfPE;
+  if (n >= mcl->ClPred->cs.p_code.NOfClauses) {
+    return FALSE;
+  }
+  row = (CELL *)mcl->ClCode+n*arity;
+  tp = RepAppl(t0)+1;
+  for (i = 0; i < arity; i++) {
+    Term t = Deref(tp[i]);
+
+    if (IsVarTerm(t)) {
+      Yap_Error(INSTANTIATION_ERROR, t0, "load_exo");
+      return FALSE;
+    }
+    if (!IsAtomOrIntTerm(t)) {
+      Yap_Error(TYPE_ERROR_ATOMIC, t0, "load_exo");
+      return FALSE;
+    }
+    row[i] = t;
+  }
+  return TRUE;
+}
+
+void
+Yap_InitExoPreds(void)
+{
+  CACHE_REGS
+  Term cm = CurrentModule;
+
+  CurrentModule = DBLOAD_MODULE;
+  Yap_InitCPred("exo_get_space", 4, p_exo_get_space, 0L);
+  Yap_InitCPred("exoassert", 3, p_exoassert, 0L);
+  CurrentModule = cm;
+}
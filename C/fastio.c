@@ -0,0 +1,1192 @@
+/*************************************************************************
+*									 *
+*	 YAP Prolog 							 *
+*									 *
+*	Yap Prolog was developed at NCCUP - Universidade do Porto	 *
+*									 *
+* Copyright L.Damas, V.S.Costa and Universidade do Porto 1985-1997	 *
+*									 *
+**************************************************************************
+*									 *
+* File:		fastio.c						 *
+* Last rev:								 *
+* mods:									 *
+* comments:	binary term reader and writer				 *
+*									 *
+*************************************************************************/
+
+/*
+  fast_write/2 and fast_read/2 exchange terms in a binary form that
+  depends neither on the word size nor on the byte order of the
+  machine, so that YAP processes can pass terms around without
+  printing and parsing them.
+
+  Each term is a record of its own:
+
+    'Y' 'B' version
+    body length in bytes
+    number of atoms, functors, variables and compound terms in the body
+    body
+
+  Counts and lengths are unsigned LEB128 numbers: seven bits per byte,
+  least significant group first, the top bit set on all bytes but the
+  last. The body gives the term in prefix order, as a tag byte per
+  node followed by its data:
+
+    FW_VAR n		variable n; n is the next number for a new one
+    FW_NIL		[]
+    FW_ATOM n		atom n of this record
+    FW_ATOM_NEW text	the next atom: byte length and UTF-8 text
+    FW_INT z		a 32 bit integer, zig-zag encoded
+    FW_BIGINT s m	any other integer: sign byte, then byte length
+			and magnitude, most significant byte first
+    FW_RATIONAL s m m	a rational: sign, numerator and denominator
+    FW_FLOAT b		IEEE double, least significant byte first
+    FW_STRING text	a string, as for FW_ATOM_NEW
+    FW_LIST h t		a list cell, followed by head and tail
+    FW_APPL n a..	a term with functor n of this record, then args
+    FW_APPL_NEW a k a..	the next functor: an FW_ATOM or FW_ATOM_NEW
+			for the name and the arity, then args
+    FW_REF n		compound term n, lists included
+
+  Compound terms are numbered in the order they are met, so a subterm
+  shared by several terms is only written once, and cyclic terms can
+  be written. Attributes of variables are not written. Readers reject
+  records from a version they do not know.
+*/
+
+#include <SWI-Stream.h>
+#include "Yap.h"
+#include "Yatom.h"
+#include "YapHeap.h"
+#include "yapio.h"
+#include "eval.h"
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+#if HAVE_WCHAR_H
+#include <wchar.h>
+#endif
+
+#define FW_VERSION 1
+
+typedef enum {
+  FW_VAR = 1,
+  FW_NIL = 2,
+  FW_ATOM = 3,
+  FW_ATOM_NEW = 4,
+  FW_INT = 5,
+  FW_BIGINT = 6,
+  FW_RATIONAL = 7,
+  FW_FLOAT = 8,
+  FW_STRING = 9,
+  FW_LIST = 10,
+  FW_APPL = 11,
+  FW_APPL_NEW = 12,
+  FW_REF = 13
+} fw_tag_t;
+
+/* the largest header: magic, version and five numbers */
+#define FW_HEADER_SIZE (3+5*(sizeof(UInt)*8/7+1))
+
+/* keys in the writer's table: compound terms go by address */
+#define FW_VAR_KEY(P)     ((CELL)(P)|1)
+#define FW_ATOM_KEY(A)    ((CELL)(A)|2)
+#define FW_FUNCTOR_KEY(F) ((CELL)(F)|3)
+
+typedef struct fw_entry {
+  CELL key;
+  UInt val;
+} fw_entry_t;
+
+typedef struct fw_frame {
+  CELL *pt, *end;
+} fw_frame_t;
+
+typedef struct fast_writer {
+  unsigned char *buf;
+  size_t len, size;
+  fw_entry_t *table;
+  UInt table_size, table_count;
+  fw_frame_t *stack;
+  UInt stack_size;
+  UInt natoms, nfunctors, nvars, nterms;
+  yap_error_number error;
+  Term culprit;
+  char *msg;
+} fast_writer_t;
+
+typedef struct fast_reader {
+  unsigned char *cur, *end;
+  Atom *atoms;
+  Functor *functors;
+  CELL **vars;
+  Term *terms;
+  UInt natoms, nfunctors, nvars, nterms;
+  UInt atoms_seen, functors_seen, vars_seen, terms_seen;
+  fw_frame_t *stack;
+  UInt stack_size;
+  wchar_t *text;
+  size_t text_size;
+} fast_reader_t;
+
+/* results of fr_term */
+#define FR_OK        0
+#define FR_OVERFLOW  1
+#define FR_BAD       2
+#define FR_NO_MEMORY 3
+#define FR_NO_HEAP   4	/* no space for an atom or functor, grow the heap */
+
+STATIC_PROTO(Int p_fast_write, ( USES_REGS1 ));
+STATIC_PROTO(Int p_fast_read, ( USES_REGS1 ));
+
+
+		 /*******************************
+		 *	      WRITING		*
+		 *******************************/
+
+static int
+fw_error(fast_writer_t *w, yap_error_number err, Term culprit, char *msg)
+{
+  w->error = err;
+  w->culprit = culprit;
+  w->msg = msg;
+  return FALSE;
+}
+
+static int
+fw_ensure(fast_writer_t *w, size_t n)
+{
+  if (w->len+n > w->size) {
+    size_t nsize = 2*w->size;
+    unsigned char *nbuf;
+
+    if (nsize < w->len+n+256)
+      nsize = w->len+n+256;
+    if (!(nbuf = realloc(w->buf, nsize)))
+      return fw_error(w, RESOURCE_ERROR_MEMORY, TermNil, "fast_write/2");
+    w->buf = nbuf;
+    w->size = nsize;
+  }
+  return TRUE;
+}
+
+static inline int
+fw_put_byte(fast_writer_t *w, int c)
+{
+  if (w->len == w->size && !fw_ensure(w, 1))
+    return FALSE;
+  w->buf[w->len++] = c;
+  return TRUE;
+}
+
+static size_t
+put_uint(unsigned char *p, UInt v)
+{
+  size_t n = 0;
+
+  while (v >= 0x80) {
+    p[n++] = (v & 0x7f) | 0x80;
+    v >>= 7;
+  }
+  p[n++] = v;
+  return n;
+}
+
+static inline int
+fw_put_uint(fast_writer_t *w, UInt v)
+{
+  if (!fw_ensure(w, sizeof(UInt)*8/7+1))
+    return FALSE;
+  w->len += put_uint(w->buf+w->len, v);
+  return TRUE;
+}
+
+static inline int
+fw_put_tag_uint(fast_writer_t *w, fw_tag_t tag, UInt v)
+{
+  if (!fw_ensure(w, 1+sizeof(UInt)*8/7+1))
+    return FALSE;
+  w->buf[w->len++] = tag;
+  w->len += put_uint(w->buf+w->len, v);
+  return TRUE;
+}
+
+static inline size_t
+utf8_size(UInt c)
+{
+  if (c < 0x80)
+    return 1;
+  if (c < 0x800)
+    return 2;
+  if (c < 0x10000)
+    return 3;
+  return 4;
+}
+
+static inline unsigned char *
+utf8_put(unsigned char *p, UInt c)
+{
+  if (c < 0x80) {
+    *p++ = c;
+  } else if (c < 0x800) {
+    *p++ = 0xc0|(c>>6);
+    *p++ = 0x80|(c&0x3f);
+  } else if (c < 0x10000) {
+    *p++ = 0xe0|(c>>12);
+    *p++ = 0x80|((c>>6)&0x3f);
+    *p++ = 0x80|(c&0x3f);
+  } else {
+    *p++ = 0xf0|((c>>18)&0x07);
+    *p++ = 0x80|((c>>12)&0x3f);
+    *p++ = 0x80|((c>>6)&0x3f);
+    *p++ = 0x80|(c&0x3f);
+  }
+  return p;
+}
+
+/* ISO-Latin-1 text, as in atoms that are not wide */
+static int
+fw_put_text(fast_writer_t *w, const unsigned char *s)
+{
+  size_t n = strlen((char *)s), sz = n, i;
+  unsigned char *p;
+
+  for (i = 0; i < n; i++)
+    if (s[i] >= 0x80)
+      sz++;
+  if (!fw_put_uint(w, sz) || !fw_ensure(w, sz))
+    return FALSE;
+  p = w->buf+w->len;
+  if (sz == n) {
+    memcpy(p, s, n);
+  } else {
+    for (i = 0; i < n; i++)
+      p = utf8_put(p, s[i]);
+  }
+  w->len += sz;
+  return TRUE;
+}
+
+static int
+fw_put_wide_text(fast_writer_t *w, const wchar_t *s)
+{
+  size_t sz = 0;
+  const wchar_t *q;
+  unsigned char *p;
+
+  for (q = s; *q; q++) {
+    if ((UInt)*q > 0x1fffff)
+      return fw_error(w, REPRESENTATION_ERROR_CHARACTER_CODE, MkIntegerTerm(*q), "fast_write/2");
+    sz += utf8_size(*q);
+  }
+  if (!fw_put_uint(w, sz) || !fw_ensure(w, sz))
+    return FALSE;
+  p = w->buf+w->len;
+  for (q = s; *q; q++)
+    p = utf8_put(p, *q);
+  w->len += sz;
+  return TRUE;
+}
+
+static int
+fw_grow_table(fast_writer_t *w)
+{
+  UInt osize = w->table_size, nsize = (osize ? 2*osize : 64), i;
+  fw_entry_t *otable = w->table, *ntable;
+
+  if (!(ntable = (fw_entry_t *)calloc(nsize, sizeof(fw_entry_t))))
+    return fw_error(w, RESOURCE_ERROR_MEMORY, TermNil, "fast_write/2");
+  for (i = 0; i < osize; i++) {
+    if (otable[i].key) {
+      UInt j = ((otable[i].key >> 2)*2654435761UL) & (nsize-1);
+
+      while (ntable[j].key)
+	j = (j+1) & (nsize-1);
+      ntable[j] = otable[i];
+    }
+  }
+  free(otable);
+  w->table = ntable;
+  w->table_size = nsize;
+  return TRUE;
+}
+
+/* find the entry for key, or make a new one with val set to -1 */
+static inline fw_entry_t *
+fw_lookup(fast_writer_t *w, CELL key)
+{
+  UInt mask, i;
+  fw_entry_t *e;
+
+  if (2*(w->table_count+1) > w->table_size && !fw_grow_table(w))
+    return NULL;
+  mask = w->table_size-1;
+  i = ((key >> 2)*2654435761UL) & mask;
+  while ((e = w->table+i)->key) {
+    if (e->key == key)
+      return e;
+    i = (i+1) & mask;
+  }
+  e->key = key;
+  e->val = (UInt)-1;
+  w->table_count++;
+  return e;
+}
+
+static int
+fw_put_atom(fast_writer_t *w, Atom at)
+{
+  fw_entry_t *e;
+
+  if (IsBlob(at))
+    return fw_error(w, SYSTEM_ERROR, MkAtomTerm(at), "fast_write/2: cannot write blobs");
+  if (!(e = fw_lookup(w, FW_ATOM_KEY(at))))
+    return FALSE;
+  if (e->val != (UInt)-1)
+    return fw_put_tag_uint(w, FW_ATOM, e->val);
+  e->val = w->natoms++;
+  if (!fw_put_byte(w, FW_ATOM_NEW))
+    return FALSE;
+  if (IsWideAtom(at))
+    return fw_put_wide_text(w, RepAtom(at)->WStrOfAE);
+  return fw_put_text(w, (unsigned char *)RepAtom(at)->StrOfAE);
+}
+
+static int
+fw_put_functor(fast_writer_t *w, Functor f)
+{
+  fw_entry_t *e;
+
+  if (!(e = fw_lookup(w, FW_FUNCTOR_KEY(f))))
+    return FALSE;
+  if (e->val != (UInt)-1)
+    return fw_put_tag_uint(w, FW_APPL, e->val);
+  e->val = w->nfunctors++;
+  return
+    fw_put_byte(w, FW_APPL_NEW) &&
+    fw_put_atom(w, NameOfFunctor(f)) &&
+    fw_put_uint(w, ArityOfFunctor(f));
+}
+
+static int
+fw_put_int(fast_writer_t *w, Int i)
+{
+  UInt mag;
+  size_t n = 0;
+  unsigned char bytes[sizeof(UInt)];
+
+  if (i >= -(Int)0x80000000L && i <= (Int)0x7fffffffL)
+    return fw_put_tag_uint(w, FW_INT, ((UInt)i << 1) ^ (i < 0 ? (UInt)-1 : 0));
+  mag = (i < 0 ? (UInt)0-(UInt)i : (UInt)i);
+  while (mag) {
+    bytes[sizeof(UInt)-1-n++] = mag & 0xff;
+    mag >>= 8;
+  }
+  if (!fw_ensure(w, 3+n))
+    return FALSE;
+  w->buf[w->len++] = FW_BIGINT;
+  w->buf[w->len++] = (i < 0);
+  w->buf[w->len++] = n;
+  memcpy(w->buf+w->len, bytes+sizeof(UInt)-n, n);
+  w->len += n;
+  return TRUE;
+}
+
+#ifdef USE_GMP
+static int
+fw_put_mpz(fast_writer_t *w, MP_INT *z, int with_sign)
+{
+  size_t n = (mpz_sgn(z) ? (mpz_sizeinbase(z, 2)+7)/8 : 0), count;
+
+  if ((with_sign && !fw_put_byte(w, mpz_sgn(z) < 0)) ||
+      !fw_put_uint(w, n) ||
+      !fw_ensure(w, n))
+    return FALSE;
+  mpz_export(w->buf+w->len, &count, 1, 1, 1, 0, z);
+  w->len += n;
+  return TRUE;
+}
+#endif
+
+static int
+fw_put_float(fast_writer_t *w, Float f)
+{
+  union {
+    double d;
+    unsigned char c[sizeof(double)];
+  } u;
+
+  if (!fw_ensure(w, 1+sizeof(double)))
+    return FALSE;
+  u.d = f;
+  w->buf[w->len++] = FW_FLOAT;
+#ifdef WORDS_BIGENDIAN
+  {
+    int i;
+
+    for (i = 0; i < sizeof(double); i++)
+      w->buf[w->len++] = u.c[sizeof(double)-1-i];
+  }
+#else
+  memcpy(w->buf+w->len, u.c, sizeof(double));
+  w->len += sizeof(double);
+#endif
+  return TRUE;
+}
+
+/* numbers, strings, and the other terms with an extension functor */
+static int
+fw_put_special(fast_writer_t *w, Term t, Functor f)
+{
+  if (f == FunctorDouble)
+    return fw_put_float(w, FloatOfTerm(t));
+  if (f == FunctorLongInt)
+    return fw_put_int(w, LongIntOfTerm(t));
+  if (f == FunctorBigInt) {
+    switch (RepAppl(t)[1]) {
+#ifdef USE_GMP
+    case BIG_INT:
+      return
+	fw_put_byte(w, FW_BIGINT) &&
+	fw_put_mpz(w, Yap_BigIntOfTerm(t), TRUE);
+    case BIG_RATIONAL:
+      {
+	MP_RAT *q = Yap_BigRatOfTerm(t);
+
+	return
+	  fw_put_byte(w, FW_RATIONAL) &&
+	  fw_put_mpz(w, mpq_numref(q), TRUE) &&
+	  fw_put_mpz(w, mpq_denref(q), FALSE);
+      }
+#endif
+    case BLOB_STRING:
+      return
+	fw_put_byte(w, FW_STRING) &&
+	fw_put_text(w, (unsigned char *)Yap_BlobStringOfTerm(t));
+    case BLOB_WIDE_STRING:
+      return
+	fw_put_byte(w, FW_STRING) &&
+	fw_put_wide_text(w, Yap_BlobWideStringOfTerm(t));
+    }
+  }
+  return fw_error(w, SYSTEM_ERROR, t, "fast_write/2: cannot write this term");
+}
+
+static int
+fw_push(fast_writer_t *w, fw_frame_t **spp, CELL *pt, CELL *end)
+{
+  fw_frame_t *sp = *spp;
+
+  if (sp == w->stack+w->stack_size) {
+    UInt nsize = 2*w->stack_size;
+    fw_frame_t *nstack;
+
+    if (!(nstack = (fw_frame_t *)realloc(w->stack, nsize*sizeof(fw_frame_t))))
+      return fw_error(w, RESOURCE_ERROR_MEMORY, TermNil, "fast_write/2");
+    sp = nstack+(sp-w->stack);
+    w->stack = nstack;
+    w->stack_size = nsize;
+  }
+  sp->pt = pt;
+  sp->end = end;
+  *spp = sp+1;
+  return TRUE;
+}
+
+/* walk the term in prefix order; the last argument of each term
+   replaces its parent on the stack, so long lists take no space */
+static int
+fw_term(fast_writer_t *w, Term inp)
+{
+  CELL root[1];
+  fw_frame_t *sp = w->stack;
+
+  root[0] = inp;
+  sp->pt = root;
+  sp->end = root+1;
+  sp++;
+  while (sp > w->stack) {
+    fw_frame_t *top = sp-1;
+    Term t = Deref(*top->pt++);
+    fw_entry_t *e;
+
+    if (top->pt == top->end)
+      sp--;
+    if (IsVarTerm(t)) {
+      if (!(e = fw_lookup(w, FW_VAR_KEY(t))))
+	return FALSE;
+      if (e->val == (UInt)-1)
+	e->val = w->nvars++;
+      if (!fw_put_tag_uint(w, FW_VAR, e->val))
+	return FALSE;
+    } else if (IsAtomTerm(t)) {
+      if (t == TermNil) {
+	if (!fw_put_byte(w, FW_NIL))
+	  return FALSE;
+      } else if (!fw_put_atom(w, AtomOfTerm(t))) {
+	return FALSE;
+      }
+    } else if (IsIntTerm(t)) {
+      if (!fw_put_int(w, IntOfTerm(t)))
+	return FALSE;
+    } else if (IsPairTerm(t)) {
+      CELL *ap = RepPair(t);
+
+      if (!(e = fw_lookup(w, (CELL)ap)))
+	return FALSE;
+      if (e->val != (UInt)-1) {
+	if (!fw_put_tag_uint(w, FW_REF, e->val))
+	  return FALSE;
+	continue;
+      }
+      e->val = w->nterms++;
+      if (!fw_put_byte(w, FW_LIST) ||
+	  !fw_push(w, &sp, ap, ap+2))
+	return FALSE;
+    } else {
+      CELL *ap = RepAppl(t);
+      Functor f = FunctorOfTerm(t);
+
+      if (IsExtensionFunctor(f)) {
+	if (!fw_put_special(w, t, f))
+	  return FALSE;
+	continue;
+      }
+      if (!(e = fw_lookup(w, (CELL)ap)))
+	return FALSE;
+      if (e->val != (UInt)-1) {
+	if (!fw_put_tag_uint(w, FW_REF, e->val))
+	  return FALSE;
+	continue;
+      }
+      e->val = w->nterms++;
+      if (!fw_put_functor(w, f) ||
+	  !fw_push(w, &sp, ap+1, ap+1+ArityOfFunctor(f)))
+	return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+static int
+fast_write(IOSTREAM *s, Term t)
+{
+  fast_writer_t w;
+  unsigned char header[FW_HEADER_SIZE];
+  size_t hlen = 0;
+  int ok;
+
+  memset(&w, 0, sizeof(w));
+  w.stack_size = 64;
+  if (!(w.stack = (fw_frame_t *)malloc(w.stack_size*sizeof(fw_frame_t)))) {
+    Yap_Error(RESOURCE_ERROR_MEMORY, TermNil, "fast_write/2");
+    return FALSE;
+  }
+  ok = fw_term(&w, t);
+  if (ok) {
+    header[hlen++] = 'Y';
+    header[hlen++] = 'B';
+    header[hlen++] = FW_VERSION;
+    hlen += put_uint(header+hlen, w.len);
+    hlen += put_uint(header+hlen, w.natoms);
+    hlen += put_uint(header+hlen, w.nfunctors);
+    hlen += put_uint(header+hlen, w.nvars);
+    hlen += put_uint(header+hlen, w.nterms);
+    if (Sfwrite(header, 1, hlen, s) != hlen ||
+	Sfwrite(w.buf, 1, w.len, s) != w.len) {
+      ok = FALSE;
+      w.error = SYSTEM_ERROR;
+      w.culprit = TermNil;
+      w.msg = "fast_write/2: could not write to stream";
+    }
+  }
+  free(w.buf);
+  free(w.table);
+  free(w.stack);
+  if (!ok)
+    Yap_Error(w.error, w.culprit, w.msg);
+  return ok;
+}
+
+
+		 /*******************************
+		 *	      READING		*
+		 *******************************/
+
+static inline int
+fr_get_uint(fast_reader_t *r, UInt *vp)
+{
+  UInt v = 0;
+  int shift = 0;
+
+  while (r->cur < r->end) {
+    int c = *r->cur++;
+
+    if (shift >= sizeof(UInt)*8)
+      return FALSE;
+    v |= (UInt)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      *vp = v;
+      return TRUE;
+    }
+    shift += 7;
+  }
+  return FALSE;
+}
+
+/* decode UTF-8 text into r->text, NUL terminated */
+static int
+fr_get_text(fast_reader_t *r, size_t *lenp, UInt *maxp)
+{
+  UInt sz, max = 0;
+  size_t n = 0;
+  unsigned char *p, *end;
+
+  if (!fr_get_uint(r, &sz) || sz > (UInt)(r->end-r->cur))
+    return FALSE;
+  if (sz+1 > r->text_size) {
+    wchar_t *ntext;
+
+    if (!(ntext = (wchar_t *)realloc(r->text, (sz+1)*sizeof(wchar_t))))
+      return FALSE;
+    r->text = ntext;
+    r->text_size = sz+1;
+  }
+  p = r->cur;
+  end = p+sz;
+  while (p < end) {
+    UInt c = *p++;
+
+    if (c >= 0x80) {
+      int more;
+
+      if ((c & 0xe0) == 0xc0) {
+	c &= 0x1f;
+	more = 1;
+      } else if ((c & 0xf0) == 0xe0) {
+	c &= 0x0f;
+	more = 2;
+      } else if ((c & 0xf8) == 0xf0) {
+	c &= 0x07;
+	more = 3;
+      } else {
+	return FALSE;
+      }
+      if (end-p < more)
+	return FALSE;
+      while (more--) {
+	if ((*p & 0xc0) != 0x80)
+	  return FALSE;
+	c = (c << 6)|(*p++ & 0x3f);
+      }
+    }
+    if (!c)
+      return FALSE;
+    if (c > max)
+      max = c;
+    r->text[n++] = c;
+  }
+  r->text[n] = '\0';
+  r->cur = end;
+  *lenp = n;
+  *maxp = max;
+  return TRUE;
+}
+
+static int
+fr_get_atom(fast_reader_t *r, Atom *atp)
+{
+  size_t n;
+  UInt max, idx;
+  Atom at;
+
+  switch (r->cur < r->end ? *r->cur++ : 0) {
+  case FW_ATOM:
+    if (!fr_get_uint(r, &idx) || idx >= r->atoms_seen)
+      return FR_BAD;
+    *atp = r->atoms[idx];
+    return FR_OK;
+  case FW_ATOM_NEW:
+    if (r->atoms_seen == r->natoms || !fr_get_text(r, &n, &max))
+      return FR_BAD;
+    if (max < 0x80) {
+      /* plain ASCII, pack it in place */
+      char *s = (char *)r->text;
+      size_t i;
+
+      for (i = 0; i <= n; i++)
+	s[i] = r->text[i];
+      at = Yap_LookupAtom(s);
+    } else {
+      at = Yap_LookupMaybeWideAtom(r->text);
+    }
+    if (!at)
+      return FR_NO_HEAP;
+    *atp = r->atoms[r->atoms_seen++] = at;
+    return FR_OK;
+  default:
+    return FR_BAD;
+  }
+}
+
+static int
+fr_get_bytes(fast_reader_t *r, unsigned char **bp, UInt *np)
+{
+  if (!fr_get_uint(r, np) || *np > (UInt)(r->end-r->cur))
+    return FALSE;
+  *bp = r->cur;
+  r->cur += *np;
+  return TRUE;
+}
+
+#ifdef USE_GMP
+static int
+fr_get_mpz(fast_reader_t *r, MP_INT *z, int with_sign)
+{
+  int neg = FALSE;
+  unsigned char *b;
+  UInt n;
+
+  if (with_sign) {
+    if (r->cur == r->end)
+      return FALSE;
+    neg = *r->cur++;
+  }
+  if (!fr_get_bytes(r, &b, &n))
+    return FALSE;
+  mpz_import(z, n, 1, 1, 1, 0, b);
+  if (neg)
+    mpz_neg(z, z);
+  return TRUE;
+}
+#endif
+
+static int
+fr_get_bigint(fast_reader_t *r, Term *tp USES_REGS)
+{
+  unsigned char *b;
+  UInt n, mag = 0, i;
+  int neg;
+
+  if (r->cur == r->end)
+    return FR_BAD;
+  neg = *r->cur++;
+  if (!fr_get_bytes(r, &b, &n))
+    return FR_BAD;
+  if (n <= sizeof(UInt)) {
+    for (i = 0; i < n; i++)
+      mag = (mag << 8)|b[i];
+    if (!neg && mag <= (((UInt)1 << (sizeof(Int)*8-1))-1)) {
+      *tp = MkIntegerTerm((Int)mag);
+      return FR_OK;
+    }
+    if (neg && mag <= ((UInt)1 << (sizeof(Int)*8-1))) {
+      *tp = MkIntegerTerm((Int)((UInt)0-mag));
+      return FR_OK;
+    }
+  }
+#ifdef USE_GMP
+  {
+    MP_INT z;
+
+    if (H+n/sizeof(CELL)+16 > ASP-1024)
+      return FR_OVERFLOW;
+    mpz_init(&z);
+    mpz_import(&z, n, 1, 1, 1, 0, b);
+    if (neg)
+      mpz_neg(&z, &z);
+    *tp = Yap_MkBigIntTerm(&z);
+    mpz_clear(&z);
+    return (*tp == TermNil ? FR_OVERFLOW : FR_OK);
+  }
+#else
+  return FR_BAD;
+#endif
+}
+
+static int
+fr_get_rational(fast_reader_t *r, Term *tp USES_REGS)
+{
+#ifdef USE_GMP
+  MP_RAT q;
+  int ok;
+
+  mpq_init(&q);
+  ok = fr_get_mpz(r, mpq_numref(&q), TRUE) &&
+    fr_get_mpz(r, mpq_denref(&q), FALSE) &&
+    mpz_sgn(mpq_denref(&q)) != 0;
+  if (!ok) {
+    mpq_clear(&q);
+    return FR_BAD;
+  }
+  mpq_canonicalize(&q);
+  if (H+(mpz_size(mpq_numref(&q))+mpz_size(mpq_denref(&q)))*sizeof(mp_limb_t)/sizeof(CELL)+32 > ASP-1024) {
+    mpq_clear(&q);
+    return FR_OVERFLOW;
+  }
+  *tp = Yap_MkBigRatTerm(&q);
+  mpq_clear(&q);
+  return (*tp == TermNil ? FR_OVERFLOW : FR_OK);
+#else
+  return FR_BAD;
+#endif
+}
+
+static int
+fr_get_string(fast_reader_t *r, Term *tp USES_REGS)
+{
+  size_t n;
+  UInt max;
+
+  if (!fr_get_text(r, &n, &max))
+    return FR_BAD;
+  if (H+(n+1)*sizeof(wchar_t)/sizeof(CELL)+16 > ASP-1024)
+    return FR_OVERFLOW;
+  *tp = Yap_MkBlobWideStringTerm(r->text, n);
+  return (*tp == TermNil ? FR_OVERFLOW : FR_OK);
+}
+
+static Float
+fr_get_float(unsigned char *b)
+{
+  union {
+    double d;
+    unsigned char c[sizeof(double)];
+  } u;
+
+#ifdef WORDS_BIGENDIAN
+  int i;
+
+  for (i = 0; i < sizeof(double); i++)
+    u.c[i] = b[sizeof(double)-1-i];
+#else
+  memcpy(u.c, b, sizeof(double));
+#endif
+  return u.d;
+}
+
+static int
+fr_push(fast_reader_t *r, fw_frame_t **spp, CELL *pt, CELL *end)
+{
+  fw_frame_t *sp = *spp;
+
+  if (sp == r->stack+r->stack_size) {
+    UInt nsize = 2*r->stack_size;
+    fw_frame_t *nstack;
+
+    if (!(nstack = (fw_frame_t *)realloc(r->stack, nsize*sizeof(fw_frame_t))))
+      return FALSE;
+    sp = nstack+(sp-r->stack);
+    r->stack = nstack;
+    r->stack_size = nsize;
+  }
+  sp->pt = pt;
+  sp->end = end;
+  *spp = sp+1;
+  return TRUE;
+}
+
+/* build the term on the global stack: each hole is filled as its
+   tag is read, and compound terms push the holes for their arguments */
+static int
+fr_term(fast_reader_t *r, Term *tp USES_REGS)
+{
+  CELL *root = H;
+  fw_frame_t *sp = r->stack;
+
+  RESET_VARIABLE(root);
+  H++;
+  sp->pt = root;
+  sp->end = root+1;
+  sp++;
+  while (sp > r->stack) {
+    fw_frame_t *top = sp-1;
+    CELL *hole = top->pt++;
+    UInt n;
+    int rc;
+
+    if (top->pt == top->end)
+      sp--;
+    if (H > ASP-1024)
+      return FR_OVERFLOW;
+    if (r->cur == r->end)
+      return FR_BAD;
+    switch (*r->cur++) {
+    case FW_VAR:
+      if (!fr_get_uint(r, &n) || n > r->vars_seen || n >= r->nvars)
+	return FR_BAD;
+      if (n == r->vars_seen) {
+	RESET_VARIABLE(hole);
+	r->vars[r->vars_seen++] = hole;
+      } else {
+	*hole = (CELL)r->vars[n];
+      }
+      break;
+    case FW_NIL:
+      *hole = TermNil;
+      break;
+    case FW_ATOM:
+    case FW_ATOM_NEW:
+      {
+	Atom at;
+
+	r->cur--;
+	if ((rc = fr_get_atom(r, &at)) != FR_OK)
+	  return rc;
+	*hole = MkAtomTerm(at);
+      }
+      break;
+    case FW_INT:
+      if (!fr_get_uint(r, &n))
+	return FR_BAD;
+      *hole = MkIntegerTerm((Int)(n >> 1) ^ -(Int)(n & 1));
+      break;
+    case FW_BIGINT:
+      if ((rc = fr_get_bigint(r, hole PASS_REGS)) != FR_OK)
+	return rc;
+      break;
+    case FW_RATIONAL:
+      if ((rc = fr_get_rational(r, hole PASS_REGS)) != FR_OK)
+	return rc;
+      break;
+    case FW_FLOAT:
+      if (r->end-r->cur < sizeof(double))
+	return FR_BAD;
+      *hole = MkFloatTerm(fr_get_float(r->cur));
+      r->cur += sizeof(double);
+      break;
+    case FW_STRING:
+      if ((rc = fr_get_string(r, hole PASS_REGS)) != FR_OK)
+	return rc;
+      break;
+    case FW_LIST:
+      {
+	CELL *pt = H;
+
+	if (r->terms_seen == r->nterms)
+	  return FR_BAD;
+	H += 2;
+	*hole = r->terms[r->terms_seen++] = AbsPair(pt);
+	if (!fr_push(r, &sp, pt, pt+2))
+	  return FR_NO_MEMORY;
+      }
+      break;
+    case FW_APPL:
+    case FW_APPL_NEW:
+      {
+	Functor f;
+	UInt arity;
+	CELL *pt = H;
+
+	if (r->cur[-1] == FW_APPL) {
+	  if (!fr_get_uint(r, &n) || n >= r->functors_seen)
+	    return FR_BAD;
+	  f = r->functors[n];
+	} else {
+	  Atom name;
+
+	  if (r->functors_seen == r->nfunctors)
+	    return FR_BAD;
+	  if ((rc = fr_get_atom(r, &name)) != FR_OK)
+	    return rc;
+	  if (!fr_get_uint(r, &arity) ||
+	      arity == 0 ||
+	      arity > (UInt)(r->end-r->cur))
+	    return FR_BAD;
+	  if (!(f = Yap_MkFunctor(name, arity)))
+	    return FR_NO_HEAP;
+	  r->functors[r->functors_seen++] = f;
+	}
+	arity = ArityOfFunctor(f);
+	if (r->terms_seen == r->nterms)
+	  return FR_BAD;
+	if (H+1+arity > ASP-1024)
+	  return FR_OVERFLOW;
+	H += 1+arity;
+	pt[0] = (CELL)f;
+	*hole = r->terms[r->terms_seen++] = AbsAppl(pt);
+	if (!fr_push(r, &sp, pt+1, pt+1+arity))
+	  return FR_NO_MEMORY;
+      }
+      break;
+    case FW_REF:
+      if (!fr_get_uint(r, &n) || n >= r->terms_seen)
+	return FR_BAD;
+      *hole = r->terms[n];
+      break;
+    default:
+      return FR_BAD;
+    }
+  }
+  if (r->cur != r->end)
+    return FR_BAD;
+  *tp = *root;
+  return FR_OK;
+}
+
+static int
+fr_get_stream_uint(IOSTREAM *s, UInt *vp)
+{
+  UInt v = 0;
+  int shift = 0, c;
+
+  while ((c = Sgetc(s)) != EOF) {
+    if (shift >= sizeof(UInt)*8)
+      return FALSE;
+    v |= (UInt)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      *vp = v;
+      return TRUE;
+    }
+    shift += 7;
+  }
+  return FALSE;
+}
+
+static Int
+fast_read(IOSTREAM *s, Term *tp USES_REGS)
+{
+  fast_reader_t r;
+  unsigned char *buf;
+  UInt len;
+  int c, rc;
+  CELL *Hi;
+
+  if ((c = Sgetc(s)) == EOF) {
+    *tp = MkAtomTerm(AtomEof);
+    return TRUE;
+  }
+  if (c != 'Y' || Sgetc(s) != 'B') {
+    Yap_Error(SYSTEM_ERROR, TermNil, "fast_read/2: not a binary term");
+    return FALSE;
+  }
+  if ((c = Sgetc(s)) != FW_VERSION) {
+    Yap_Error(SYSTEM_ERROR, MkIntTerm(c), "fast_read/2: unknown binary term version");
+    return FALSE;
+  }
+  memset(&r, 0, sizeof(r));
+  if (!fr_get_stream_uint(s, &len) ||
+      !fr_get_stream_uint(s, &r.natoms) ||
+      !fr_get_stream_uint(s, &r.nfunctors) ||
+      !fr_get_stream_uint(s, &r.nvars) ||
+      !fr_get_stream_uint(s, &r.nterms)) {
+    Yap_Error(PERMISSION_ERROR_INPUT_PAST_END_OF_STREAM, TermNil, "fast_read/2");
+    return FALSE;
+  }
+  /* every entry takes at least a byte of the body */
+  if (r.natoms > len || r.nfunctors > len || r.nvars > len || r.nterms > len) {
+    Yap_Error(SYSTEM_ERROR, TermNil, "fast_read/2: bad binary term");
+    return FALSE;
+  }
+  r.stack_size = 64;
+  buf = (unsigned char *)malloc(len+1);
+  r.atoms = (Atom *)malloc((r.natoms+1)*sizeof(Atom));
+  r.functors = (Functor *)malloc((r.nfunctors+1)*sizeof(Functor));
+  r.vars = (CELL **)malloc((r.nvars+1)*sizeof(CELL *));
+  r.terms = (Term *)malloc((r.nterms+1)*sizeof(Term));
+  r.stack = (fw_frame_t *)malloc(r.stack_size*sizeof(fw_frame_t));
+  if (!buf || !r.atoms || !r.functors || !r.vars || !r.terms || !r.stack) {
+    Yap_Error(RESOURCE_ERROR_MEMORY, TermNil, "fast_read/2");
+    rc = FR_NO_MEMORY;
+  } else if (Sfread(buf, 1, len, s) != len) {
+    Yap_Error(PERMISSION_ERROR_INPUT_PAST_END_OF_STREAM, TermNil, "fast_read/2");
+    rc = FR_BAD;
+  } else {
+    UInt need = len, used = 0;
+
+    rc = FR_OK;
+    do {
+      if (H+need > ASP-1024 &&
+	  !Yap_gcl(need*sizeof(CELL), 2, ENV, gc_P(P,CP))) {
+	Yap_Error(OUT_OF_STACK_ERROR, TermNil, LOCAL_ErrorMessage);
+	rc = FR_NO_MEMORY;
+	break;
+      }
+      /* stacks that cannot grow would overflow at the same place again */
+      if (rc == FR_OVERFLOW && H+used >= ASP-1024) {
+	Yap_Error(OUT_OF_STACK_ERROR, TermNil, "fast_read/2");
+	rc = FR_NO_MEMORY;
+	break;
+      }
+      Hi = H;
+      r.cur = buf;
+      r.end = buf+len;
+      r.atoms_seen = r.functors_seen = r.vars_seen = r.terms_seen = 0;
+      if ((rc = fr_term(&r, tp PASS_REGS)) != FR_OK) {
+	used = H-Hi;
+	need = 2*used+len;
+	H = Hi;
+      }
+      /* the partial term is gone, so the heap can move */
+      if (rc == FR_NO_HEAP && !Yap_growheap(FALSE, 0, NULL)) {
+	Yap_Error(OUT_OF_HEAP_ERROR, TermNil, "fast_read/2: %s", LOCAL_ErrorMessage);
+	rc = FR_NO_MEMORY;
+	break;
+      }
+    } while (rc == FR_OVERFLOW || rc == FR_NO_HEAP);
+    if (rc == FR_BAD)
+      Yap_Error(SYSTEM_ERROR, TermNil, "fast_read/2: bad binary term");
+    else if (rc == FR_NO_MEMORY && !LOCAL_Error_TYPE)
+      Yap_Error(RESOURCE_ERROR_MEMORY, TermNil, "fast_read/2");
+  }
+  free(buf);
+  free(r.atoms);
+  free(r.functors);
+  free(r.vars);
+  free(r.terms);
+  free(r.stack);
+  free(r.text);
+  return rc == FR_OK;
+}
+
+static Int
+p_fast_write( USES_REGS1 )
+{				/* fast_write(+Stream,+Term)	 */
+  IOSTREAM *s;
+  Term t1 = Deref(ARG1);
+  Int out;
+
+  if (IsVarTerm(t1)) {
+    Yap_Error(INSTANTIATION_ERROR,t1,"fast_write/2");
+    return FALSE;
+  }
+  if (!IsAtomTerm(t1)) {
+    Yap_Error(DOMAIN_ERROR_STREAM_OR_ALIAS,t1,"fast_write/2");
+    return FALSE;
+  }
+  if (!(s = Yap_GetOutputStream(AtomOfTerm(t1))))
+    return FALSE;
+  out = fast_write(s, ARG2);
+  Yap_ReleaseStream(s);
+  return out;
+}
+
+static Int
+p_fast_read( USES_REGS1 )
+{				/* fast_read(+Stream,-Term)	 */
+  IOSTREAM *s;
+  Term t1 = Deref(ARG1), t = TermNil;
+  Int out;
+
+  if (IsVarTerm(t1)) {
+    Yap_Error(INSTANTIATION_ERROR,t1,"fast_read/2");
+    return FALSE;
+  }
+  if (!IsAtomTerm(t1)) {
+    Yap_Error(DOMAIN_ERROR_STREAM_OR_ALIAS,t1,"fast_read/2");
+    return FALSE;
+  }
+  if (!(s = Yap_GetInputStream(AtomOfTerm(t1))))
+    return FALSE;
+  out = fast_read(s, &t PASS_REGS);
+  Yap_ReleaseStream(s);
+  return out && Yap_unify(ARG2, t);
+}
+
+void
+Yap_InitFastIO(void)
+{
+  Yap_InitCPred("fast_write", 2, p_fast_write, SyncPredFlag);
+  Yap_InitCPred("fast_read", 2, p_fast_read, SyncPredFlag);
+}
@@ -1649,6 +1649,87 @@ p_nb_queue_enqueue( USES_REGS1 )
   return TRUE;
 }
 
+/*
+  findall/3 and friends: copy the answer and the list cell that holds it
+  in a single pass over the queue arena, so that nb_queue_close/3 only
+  has to splice the list into the global stack.
+*/
+static Int
+p_findall_bag_add( USES_REGS1 )
+{
+  CELL *qd = GetQueue(ARG1,"findall"), *oldH, *oldHB, *oldASP, *ptf;
+  CELL tp[2];
+  Term arena, t;
+  UInt old_sz, qsize;
+  int res;
+
+  if (!qd)
+    return FALSE;
+ restart:
+  arena = qd[QUEUE_ARENA];
+  old_sz = ArenaSz(arena);
+  oldH = H;
+  oldHB = HB;
+  oldASP = ASP;
+  H = HB = ArenaPt(arena);
+  ASP = ArenaLimit(arena);
+  /* the list cell goes first, the answer follows */
+  ptf = H;
+  H += 2;
+  t = Deref(ARG2);
+  if (IsAtomOrIntTerm(t)) {
+    ptf[0] = t;
+    res = 0;
+  } else {
+    tp[1] = t;
+    res = copy_complex_term(tp, tp+1, FALSE, TRUE, ptf, ptf PASS_REGS);
+  }
+  if (res == 0 && H > ASP - MIN_ARENA_SIZE) {
+    /* keep some room for the next answer */
+    res = -1;
+  }
+  if (res < 0) {
+    UInt gsiz;
+
+    H = ptf;
+    CloseArena(oldH, oldHB, oldASP, qd+QUEUE_ARENA, old_sz PASS_REGS);
+    if (res == -1) {
+      /*
+	 growing an arena that is not at the top of the global stack
+	 means shifting everything above it, so grow geometrically:
+	 each step makes room for twice the answers we already have.
+      */
+      if (IsPairTerm(qd[QUEUE_HEAD]))
+	gsiz = 2*(ArenaPt(qd[QUEUE_ARENA])-RepPair(qd[QUEUE_HEAD]));
+      else
+	gsiz = 0;
+      if (gsiz < 1024)
+	gsiz = 1024;
+      arena = qd[QUEUE_ARENA];
+      if (!GrowArena(arena, ArenaLimit(arena), ArenaSz(arena), gsiz, 2 PASS_REGS)) {
+	Yap_Error(OUT_OF_STACK_ERROR, arena, LOCAL_ErrorMessage);
+	return FALSE;
+      }
+    } else if (!Yap_ExpandPreAllocCodeSpace(0,NULL,TRUE)) {
+      Yap_Error(OUT_OF_AUXSPACE_ERROR, TermNil, LOCAL_ErrorMessage);
+      return FALSE;
+    }
+    qd = RepAppl(Deref(ARG1))+1;
+    goto restart;
+  }
+  RESET_VARIABLE(ptf+1);
+  qsize = IntegerOfTerm(qd[QUEUE_SIZE]);
+  if (qsize == 0) {
+    qd[QUEUE_HEAD] = AbsPair(ptf);
+  } else {
+    *VarOfTerm(qd[QUEUE_TAIL]) = AbsPair(ptf);
+  }
+  qd[QUEUE_TAIL] = (CELL)(ptf+1);
+  qd[QUEUE_SIZE] = Global_MkIntegerTerm(qsize+1);
+  CloseArena(oldH, oldHB, oldASP, qd+QUEUE_ARENA, old_sz PASS_REGS);
+  return TRUE;
+}
+
 static Int
 p_nb_queue_dequeue( USES_REGS1 )
 {
@@ -2588,6 +2669,9 @@ void Yap_InitGlobals(void)
   Yap_InitCPred("nb_create", 3, p_nb_create, 0L);
   Yap_InitCPred("nb_create", 4, p_nb_create2, 0L);
   Yap_InitCPredBack("$nb_current", 1, 1, init_current_nb, cont_current_nb, SafePredFlag);
+  Yap_InitCPred("$findall_bag", 1, p_nb_queue, 0L);
+  Yap_InitCPred("$findall_bag_add", 2, p_findall_bag_add, 0L);
+  Yap_InitCPred("$findall_bag_close", 3, p_nb_queue_close, SafePredFlag);
   CurrentModule = GLOBALS_MODULE;
   Yap_InitCPred("nb_queue", 1, p_nb_queue, 0L);
   Yap_InitCPred("nb_queue", 2, p_nb_queue_sized, 0L);
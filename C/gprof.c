@@ -1074,6 +1074,9 @@ static Int start_profilers(int msec)
   if (LOCAL_ProfilerOn!=-1) {
     return FALSE; /* have to go through profinit */
   }
+  if (GLOBAL_ProfSampling) {
+    return FALSE; /* SIGPROF is taken by the sampling profiler */
+  }
   sa.sa_sigaction=prof_alrm;
   sigemptyset(&sa.sa_mask);
   sa.sa_flags=SA_SIGINFO;
@@ -1172,6 +1175,334 @@ static Int profres0( USES_REGS1 ) {
   return(showprofres( PASS_REGS1 ));
 }
 
+/*
+  Sampling profiler.
+
+  SIGPROF only raises a YAP signal, so the stack is actually sampled
+  at the next predicate call, where the environment chain is known to
+  be consistent. The sample is the predicate being called plus the
+  predicate owning every environment up the chain. Identical stacks
+  are counted in a hash table, and dumped as folded stacks, one line
+  per stack, root first, as expected by flame graph tools.
+*/
+
+#define SAMPLE_MAX_DEPTH 256
+#define SAMPLE_DEFAULT_HZ 100
+
+typedef struct prof_stack {
+  struct prof_stack *next;
+  UInt hash;
+  UInt count;
+  UInt depth;
+  PredEntry *frames[1];		/* leaf first */
+} prof_stack;
+
+static void
+prof_sample_alrm(int signo)
+{ 
+  Yap_signal(YAP_PROF_SIGNAL);
+}
+
+static int
+grow_sample_table(void)
+{
+  UInt i, nsize = (GLOBAL_ProfStacksSize ? 2*GLOBAL_ProfStacksSize : 4096);
+  prof_stack **ntable;
+
+  if (!(ntable = (prof_stack **)calloc(nsize, sizeof(prof_stack *))))
+    return FALSE;
+  for (i = 0; i < GLOBAL_ProfStacksSize; i++) {
+    prof_stack *ps = GLOBAL_ProfStacks[i];
+
+    while (ps) {
+      prof_stack *next = ps->next;
+      UInt j = ps->hash & (nsize-1);
+
+      ps->next = ntable[j];
+      ntable[j] = ps;
+      ps = next;
+    }
+  }
+  if (GLOBAL_ProfStacks)
+    free(GLOBAL_ProfStacks);
+  GLOBAL_ProfStacks = ntable;
+  GLOBAL_ProfStacksSize = nsize;
+  return TRUE;
+}
+
+static void
+add_sample(PredEntry **frames, UInt depth)
+{
+  UInt i, hash = depth;
+  prof_stack *ps;
+
+  for (i = 0; i < depth; i++)
+    hash = (hash ^ ((CELL)frames[i] >> 3)) * 0x9e3779b1;
+#if THREADS
+  LOCK(GLOBAL_ProfSamplesLock);
+#endif
+  GLOBAL_ProfSamples++;
+  if (GLOBAL_ProfStacksInUse >= GLOBAL_ProfStacksSize &&
+      !grow_sample_table() &&
+      !GLOBAL_ProfStacksSize) {
+#if THREADS
+    UNLOCK(GLOBAL_ProfSamplesLock);
+#endif
+    return;
+  }
+  ps = GLOBAL_ProfStacks[hash & (GLOBAL_ProfStacksSize-1)];
+  while (ps) {
+    if (ps->hash == hash && ps->depth == depth &&
+	!memcmp(ps->frames, frames, depth*sizeof(PredEntry *))) {
+      ps->count++;
+#if THREADS
+      UNLOCK(GLOBAL_ProfSamplesLock);
+#endif
+      return;
+    }
+    ps = ps->next;
+  }
+  if ((ps = (prof_stack *)malloc(sizeof(prof_stack)+depth*sizeof(PredEntry *)))) {
+    ps->hash = hash;
+    ps->count = 1;
+    ps->depth = depth;
+    memcpy(ps->frames, frames, depth*sizeof(PredEntry *));
+    i = hash & (GLOBAL_ProfStacksSize-1);
+    ps->next = GLOBAL_ProfStacks[i];
+    GLOBAL_ProfStacks[i] = ps;
+    GLOBAL_ProfStacksInUse++;
+  }
+#if THREADS
+  UNLOCK(GLOBAL_ProfSamplesLock);
+#endif
+}
+
+/* '$sample_stack'(+Mod, +Goal): called from the signal handler */
+static Int
+p_sample_stack( USES_REGS1 )
+{
+  PredEntry *frames[SAMPLE_MAX_DEPTH], *creep_pe, *signal_pe;
+  Term tmod = Deref(ARG1), tg = Deref(ARG2);
+  CELL *ep = ENV;
+  UInt depth = 0;
+  Prop p = NIL;
+
+  if (!GLOBAL_ProfSampling)
+    return TRUE;
+  if (IsVarTerm(tmod) || !IsAtomTerm(tmod))
+    tmod = CurrentModule;
+  if (IsAtomTerm(tg)) {
+    p = Yap_GetPredPropByAtom(AtomOfTerm(tg), tmod);
+  } else if (IsApplTerm(tg)) {
+    p = Yap_GetPredPropByFunc(FunctorOfTerm(tg), tmod);
+  }
+  if (p != NIL)
+    frames[depth++] = RepPredProp(p);
+  /* the frames for the signal handler itself are not interesting */
+  creep_pe = CreepCode;
+  signal_pe = EnvPreg(CP);
+  while (ep && depth < SAMPLE_MAX_DEPTH) {
+    yamop *cp = (yamop *)ep[E_CP];
+    PredEntry *pe;
+
+    if (!cp || Unsigned(ep) & (sizeof(CELL)-1))
+      break;
+    pe = EnvPreg(cp);
+    if (pe && pe != creep_pe && pe != signal_pe && pe != PredFail)
+      frames[depth++] = pe;
+    if ((CELL *)ep[E_E] <= ep)
+      break;
+    ep = (CELL *)ep[E_E];
+  }
+  add_sample(frames, depth);
+  return TRUE;
+}
+
+static Int
+sampling_profile_on( USES_REGS1 )
+{
+  Term t = Deref(ARG1);
+  Int hz;
+  struct itimerval it;
+  struct sigaction sa;
+
+  if (IsVarTerm(t)) {
+    Yap_Error(INSTANTIATION_ERROR, t, "sampling_profile_on/1");
+    return FALSE;
+  }
+  if (!IsIntegerTerm(t)) {
+    Yap_Error(TYPE_ERROR_INTEGER, t, "sampling_profile_on/1");
+    return FALSE;
+  }
+  hz = IntegerOfTerm(t);
+  if (hz <= 0 || hz > 1000000) {
+    Yap_Error(DOMAIN_ERROR_OUT_OF_RANGE, t, "sampling_profile_on/1");
+    return FALSE;
+  }
+  if (LOCAL_ProfilerOn > 0)
+    return FALSE; /* SIGPROF is taken by the tick profiler */
+  sa.sa_handler = prof_sample_alrm;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  if (sigaction(SIGPROF,&sa,NULL) == -1)
+    return FALSE;
+  it.it_interval.tv_sec = 0;
+  it.it_interval.tv_usec = 1000000/hz;
+  if (hz == 1) {
+    it.it_interval.tv_sec = 1;
+    it.it_interval.tv_usec = 0;
+  }
+  it.it_value = it.it_interval;
+  GLOBAL_ProfSampling = hz;
+  setitimer(ITIMER_PROF,&it,NULL);
+  return TRUE;
+}
+
+static Int
+sampling_profile_on0( USES_REGS1 )
+{
+  ARG1 = MkIntTerm(SAMPLE_DEFAULT_HZ);
+  return sampling_profile_on( PASS_REGS1 );
+}
+
+static Int
+sampling_profile_off( USES_REGS1 )
+{
+  if (!GLOBAL_ProfSampling)
+    return FALSE;
+  setitimer(ITIMER_PROF,NULL,NULL);
+  GLOBAL_ProfSampling = 0;
+  return TRUE;
+}
+
+static Int
+sampling_profile_reset( USES_REGS1 )
+{
+  UInt i;
+
+#if THREADS
+  LOCK(GLOBAL_ProfSamplesLock);
+#endif
+  for (i = 0; i < GLOBAL_ProfStacksSize; i++) {
+    prof_stack *ps = GLOBAL_ProfStacks[i];
+
+    while (ps) {
+      prof_stack *next = ps->next;
+      free(ps);
+      ps = next;
+    }
+    GLOBAL_ProfStacks[i] = NULL;
+  }
+  GLOBAL_ProfStacksInUse = 0;
+  GLOBAL_ProfSamples = 0;
+#if THREADS
+  UNLOCK(GLOBAL_ProfSamplesLock);
+#endif
+  return TRUE;
+}
+
+/* frames are separated by ; and the count by a space, so avoid both */
+static void
+write_frame_name(FILE *f, Atom at)
+{
+  if (IsWideAtom(at)) {
+    fprintf(f, "%S", RepAtom(at)->WStrOfAE);
+  } else {
+    char *s = RepAtom(at)->StrOfAE;
+    int ch;
+
+    while ((ch = *s++)) {
+      if (ch == ';' || ch == ' ' || ch == '\n' || ch == '\t')
+	ch = '_';
+      putc(ch, f);
+    }
+  }
+}
+
+static void
+write_frame(FILE *f, PredEntry *pe)
+{
+  Term mod = pe->ModuleOfPred;
+
+  if (!mod)
+    mod = TermProlog;
+  write_frame_name(f, AtomOfTerm(mod));
+  putc(':', f);
+  if (pe->ModuleOfPred == IDB_MODULE) {
+    if (pe->PredFlags & NumberDBPredFlag) {
+      fprintf(f, Int_FORMAT "/0", pe->src.IndxId);
+    } else  if (pe->PredFlags & AtomDBPredFlag) {
+      write_frame_name(f, (Atom)pe->FunctorOfPred);
+      fputs("/0", f);
+    } else {
+      write_frame_name(f, NameOfFunctor(pe->FunctorOfPred));
+      fprintf(f, "/" UInt_FORMAT, (UInt)ArityOfFunctor(pe->FunctorOfPred));
+    }
+  } else if (pe->ArityOfPE) {
+    write_frame_name(f, NameOfFunctor(pe->FunctorOfPred));
+    fprintf(f, "/" UInt_FORMAT, (UInt)pe->ArityOfPE);
+  } else {
+    write_frame_name(f, (Atom)pe->FunctorOfPred);
+    fputs("/0", f);
+  }
+}
+
+/* sampling_profile_write(+File): dump folded stacks */
+static Int
+sampling_profile_write( USES_REGS1 )
+{
+  Term t = Deref(ARG1);
+  char *file;
+  FILE *f;
+  UInt i;
+
+  if (IsVarTerm(t)) {
+    Yap_Error(INSTANTIATION_ERROR, t, "sampling_profile_write/1");
+    return FALSE;
+  }
+  if (!IsAtomTerm(t)) {
+    Yap_Error(TYPE_ERROR_ATOM, t, "sampling_profile_write/1");
+    return FALSE;
+  }
+  file = RepAtom(AtomOfTerm(t))->StrOfAE;
+  if (!Yap_TrueFileName(file, LOCAL_FileNameBuf, FALSE) ||
+      !(f = fopen(LOCAL_FileNameBuf, "w"))) {
+    Yap_Error(PERMISSION_ERROR_OUTPUT_STREAM, t, "sampling_profile_write/1");
+    return FALSE;
+  }
+#if THREADS
+  LOCK(GLOBAL_ProfSamplesLock);
+#endif
+  for (i = 0; i < GLOBAL_ProfStacksSize; i++) {
+    prof_stack *ps = GLOBAL_ProfStacks[i];
+
+    while (ps) {
+      UInt j = ps->depth;
+
+      if (j == SAMPLE_MAX_DEPTH)
+	fputs("[truncated];", f);
+      while (j > 0) {
+	write_frame(f, ps->frames[--j]);
+	if (j)
+	  putc(';', f);
+      }
+      fprintf(f, " " UInt_FORMAT "\n", ps->count);
+      ps = ps->next;
+    }
+  }
+#if THREADS
+  UNLOCK(GLOBAL_ProfSamplesLock);
+#endif
+  fclose(f);
+  return TRUE;
+}
+
+static Int
+sampling_profile_samples( USES_REGS1 )
+{
+  return Yap_unify(ARG1, MkIntegerTerm(GLOBAL_ProfSamples));
+}
+
 #endif /* LOW_PROF */
 
 void
@@ -1193,5 +1524,12 @@ Yap_InitLowProf(void)
   Yap_InitCPred("$profison",0 , profison, SafePredFlag);
   Yap_InitCPred("$get_pred_pinfo", 4, getpredinfo, SafePredFlag);
   Yap_InitCPred("showprofres", 4, getpredinfo, SafePredFlag);
+  Yap_InitCPred("sampling_profile_on", 0, sampling_profile_on0, SafePredFlag);
+  Yap_InitCPred("sampling_profile_on", 1, sampling_profile_on, SafePredFlag);
+  Yap_InitCPred("sampling_profile_off", 0, sampling_profile_off, SafePredFlag);
+  Yap_InitCPred("sampling_profile_reset", 0, sampling_profile_reset, SafePredFlag);
+  Yap_InitCPred("sampling_profile_write", 1, sampling_profile_write, SafePredFlag|SyncPredFlag);
+  Yap_InitCPred("sampling_profile_samples", 1, sampling_profile_samples, SafePredFlag);
+  Yap_InitCPred("$sample_stack", 2, p_sample_stack, SafePredFlag);
 #endif
 }
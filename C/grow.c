@@ -28,6 +28,9 @@
 #if HAVE_STRING_H
 #include <string.h>
 #endif
+#if defined(YAPOR) || defined(THREADS)
+#include <sched.h>
+#endif
 #if YAPOR_THREADS
 #include "opt.mavar.h"
 #endif /* YAPOR_THREADS */
@@ -49,6 +52,7 @@ STATIC_PROTO(Int p_growstack, ( USES_REGS1 ));
 STATIC_PROTO(Int p_inform_trail_overflows, ( USES_REGS1 ));
 STATIC_PROTO(Int p_inform_heap_overflows, ( USES_REGS1 ));
 STATIC_PROTO(Int p_inform_stack_overflows, ( USES_REGS1 ));
+STATIC_PROTO(Int p_inform_in_place_expansions, ( USES_REGS1 ));
 
 /* #define undf7  */
 /* #define undf5 */
@@ -1352,12 +1356,10 @@ cp_atom_table(AtomHashEntry *ntb, UInt nsize)
 static int
 growatomtable( USES_REGS1 )
 {
-  AtomHashEntry *ntb;
-  UInt nsize = 3*AtomHashTableSize-1;
+  AtomHashEntry *ntb, *otb;
+  UInt nsize;
   UInt start_growth_time = Yap_cputime(), growth_time;
   int gc_verbose = Yap_is_gc_verbose();
-  if (nsize -AtomHashTableSize  > 4*1024*1024)
-    nsize =  AtomHashTableSize+4*1024*1024+7919;
 
   LOCK(LOCAL_SignalLock);
   if (LOCAL_ActiveSignals == YAP_CDOVF_SIGNAL) {
@@ -1365,12 +1367,27 @@ growatomtable( USES_REGS1 )
   }
   LOCAL_ActiveSignals &= ~YAP_CDOVF_SIGNAL;
   UNLOCK(LOCAL_SignalLock);
+  /* threads that create atoms wait here, lookups go on using the old table */
+  WRITE_LOCK(AtomTableRWLock);
+#if defined(YAPOR) || defined(THREADS)
+  if (NOfAtoms <= 2*AtomHashTableSize) {
+    /* another thread did the job for us */
+    WRITE_UNLOCK(AtomTableRWLock);
+    return TRUE;
+  }
+#endif
+  nsize = 3*AtomHashTableSize-1;
+  if (nsize -AtomHashTableSize  > 4*1024*1024)
+    nsize =  AtomHashTableSize+4*1024*1024+7919;
   while ((ntb = (AtomHashEntry *)Yap_AllocCodeSpace(nsize*sizeof(AtomHashEntry))) == NULL) {
     /* leave for next time */
 #if !USE_SYSTEM_MALLOC
     if (!do_growheap(FALSE, nsize*sizeof(AtomHashEntry), NULL, NULL, NULL, NULL))
 #endif
-      return FALSE;
+      {
+	WRITE_UNLOCK(AtomTableRWLock);
+	return FALSE;
+      }
   }
   LOCAL_atom_table_overflows ++;
   if (gc_verbose) {
@@ -1383,10 +1400,39 @@ growatomtable( USES_REGS1 )
   YAPEnterCriticalSection();
   init_new_table(ntb, nsize);
   cp_atom_table(ntb, nsize);
-  Yap_FreeCodeSpace((char *)HashChain);
+  otb = HashChain;
+#if defined(YAPOR) || defined(THREADS)
+  /* an odd epoch tells readers the table and its size do not match,
+     see SearchAtomTable() */
+  __atomic_add_fetch(&AtomTableEpoch, 1, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&HashChain, ntb, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&AtomHashTableSize, nsize, __ATOMIC_SEQ_CST);
+  __atomic_add_fetch(&AtomTableEpoch, 1, __ATOMIC_SEQ_CST);
+  /* wait until nobody is searching the old table */
+  {
+    int wid;
+
+#if THREADS
+    for (wid = 0; wid < MAX_THREADS; wid++) {
+      if (!Yap_local[wid])
+	continue;
+      while (__atomic_load_n(&REMOTE_AtomTableHazard(wid), __ATOMIC_SEQ_CST) == otb)
+	sched_yield();
+    }
+#else
+    for (wid = 0; wid < GLOBAL_number_workers; wid++) {
+      while (__atomic_load_n(&REMOTE_AtomTableHazard(wid), __ATOMIC_SEQ_CST) == otb)
+	sched_yield();
+    }
+#endif
+  }
+#else
   HashChain = ntb;
   AtomHashTableSize = nsize;
+#endif
+  Yap_FreeCodeSpace((char *)otb);
   YAPLeaveCriticalSection();
+  WRITE_UNLOCK(AtomTableRWLock);
   growth_time = Yap_cputime()-start_growth_time;
   LOCAL_total_atom_table_overflow_time += growth_time;
   if (gc_verbose) {
@@ -1542,6 +1588,9 @@ execute_growstack(long size0, int from_trail, int in_parser, tr_fr_ptr *old_trp,
       LOCAL_GlobalBase=old_LOCAL_GlobalBase;
     } else {
       LOCAL_GDiff = LOCAL_BaseDiff = LOCAL_DelayDiff = 0;
+      /* the global stack stays where it is */
+      LOCAL_in_place_expansions++;
+      LOCAL_in_place_bytes += (ADDR)H-LOCAL_GlobalBase;
     }
   }
   LOCAL_XDiff = LOCAL_HDiff = 0;
@@ -1698,10 +1747,6 @@ static int do_growtrail(long size, int contiguous_only, int in_parser, tr_fr_ptr
   int gc_verbose = Yap_is_gc_verbose();
   long size0 = size;
 
-#if USE_SYSTEM_MALLOC
-  if (contiguous_only)
-    return FALSE;
-#endif
   /* at least 64K for trail */
   if (!size) 
     size = ((ADDR)TR-LOCAL_TrailBase);
@@ -1733,11 +1778,14 @@ static int do_growtrail(long size, int contiguous_only, int in_parser, tr_fr_ptr
     LOCAL_ErrorMessage = "Trail Overflow";
     return FALSE;
   }
+  YAPEnterCriticalSection();
 #if USE_SYSTEM_MALLOC
-  execute_growstack(size, TRUE, in_parser, old_trp, tksp, vep PASS_REGS);
+  /* the trail is at the end of the stacks, so we can only grow it
+     in place if the stacks are in reserved address space */
+  if (!Yap_ExtendWorkSpaceInPlace(size)) {
 #else
-  YAPEnterCriticalSection();
   if (!Yap_ExtendWorkSpace(size)) {
+#endif
     YAPLeaveCriticalSection();
     LOCAL_ErrorMessage = NULL;
     if (contiguous_only) {
@@ -1753,9 +1801,10 @@ static int do_growtrail(long size, int contiguous_only, int in_parser, tr_fr_ptr
     }
     LOCAL_TrailTop += size;
     CurrentTrailTop = (tr_fr_ptr)(LOCAL_TrailTop-MinTrailGap);
+    LOCAL_in_place_expansions++;
+    LOCAL_in_place_bytes += LOCAL_TrailTop-LOCAL_GlobalBase;
     YAPLeaveCriticalSection();
   }
-#endif
   growth_time = Yap_cputime()-start_growth_time;
   LOCAL_total_trail_overflow_time += growth_time;
   if (gc_verbose) {
@@ -1968,6 +2017,17 @@ p_inform_stack_overflows( USES_REGS1 )
 
 }
 
+/* expansions that did not move the global stack, and the bytes they
+   did not have to relocate */
+static Int
+p_inform_in_place_expansions( USES_REGS1 )
+{
+  Term tn = MkIntTerm(LOCAL_in_place_expansions);
+  Term tb = MkIntegerTerm(LOCAL_in_place_bytes);
+ 
+  return(Yap_unify(tn, ARG1) && Yap_unify(tb, ARG2));
+}
+
 Int
 Yap_total_stack_shift_time(void)
 {
@@ -1985,6 +2045,7 @@ Yap_InitGrowPreds(void)
   Yap_InitCPred("$inform_trail_overflows", 2, p_inform_trail_overflows, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$inform_heap_overflows", 2, p_inform_heap_overflows, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$inform_stack_overflows", 2, p_inform_stack_overflows, SafePredFlag|HiddenPredFlag);
+  Yap_InitCPred("$inform_in_place_expansions", 2, p_inform_in_place_expansions, SafePredFlag|HiddenPredFlag);
   Yap_init_gc();
   Yap_init_agc();
 }
@@ -37,6 +37,7 @@ static char     SccsId[] = "%W% %G%";
 
 STATIC_PROTO(Int  p_inform_gc, ( CACHE_TYPE1 ));
 STATIC_PROTO(Int  p_gc, ( CACHE_TYPE1 ));
+STATIC_PROTO(Int  p_gc_threads, ( CACHE_TYPE1 ));
 STATIC_PROTO(void marking_phase, (tr_fr_ptr, CELL *, yamop * CACHE_TYPE));
 STATIC_PROTO(void compaction_phase, (tr_fr_ptr, CELL *, yamop * CACHE_TYPE));
 STATIC_PROTO(void init_dbtable, (tr_fr_ptr CACHE_TYPE));
@@ -1135,6 +1136,43 @@ check_global(void) {
 #define check_global()
 #endif /* CHECK_GLOBAL */
 
+/* cells from the functor of a number or blob to its end marker, 0 if unknown */
+static inline UInt
+extension_size(CELL_PTR next, CELL cnext)
+{
+  switch (cnext) {
+  case (CELL)FunctorLongInt:
+    return 2;
+  case (CELL)FunctorDouble:
+    return 1+SIZEOF_DOUBLE/SIZEOF_LONG_INT;
+  case (CELL)FunctorBigInt:
+    return (sizeof(MP_INT)+CellSize+
+	    ((MP_INT *)(next+2))->_mp_alloc*sizeof(mp_limb_t))/CellSize+1;
+  default:
+    return 0;
+  }
+}
+
+/* current points to a clause or to a db reference: keep it alive */
+static void
+mark_code_term(CELL_PTR current, CELL ccur, CELL_PTR next USES_REGS)
+{
+  if (IsPairTerm(ccur)) {
+    mark_db_fixed(next PASS_REGS);
+  } else if ((Functor)*next == FunctorDBRef) {
+    DBRef tref = DBRefOfTerm(ccur);
+
+    /* make sure the reference is marked as in use */
+    if ((tref->Flags & (ErasedMask|LogUpdMask)) == (ErasedMask|LogUpdMask)) {
+      *current = MkDBRefTerm((DBRef)LogDBErasedMarker);
+    } else {
+      mark_ref_in_use(tref PASS_REGS);
+    }
+  } else {
+    mark_db_fixed(next PASS_REGS);
+  }
+}
+
 /* mark a heap object and all heap objects accessible from it */
 
 static void 
@@ -1294,7 +1332,7 @@ mark_variable(CELL_PTR current USES_REGS)
 	goto begin;
       }
     } else if (ONCODE(next)) {
-      mark_db_fixed(RepPair(ccur) PASS_REGS);
+      mark_code_term(current, ccur, next PASS_REGS);
     }
     POP_CONTINUATION();
   } else if (IsApplTerm(ccur)) {
@@ -1307,19 +1345,7 @@ mark_variable(CELL_PTR current USES_REGS)
       inc_vars_of_type(current,gc_num);
 #endif
     if (ONCODE(next)) {
-      if ((Functor)cnext == FunctorDBRef) {
-	DBRef tref = DBRefOfTerm(ccur);
-
-	/* make sure the reference is marked as in use */
-	if ((tref->Flags & (ErasedMask|LogUpdMask)) == (ErasedMask|LogUpdMask)) {
-	  *current = MkDBRefTerm((DBRef)LogDBErasedMarker);
-	  MARK(current);
-	} else {
-	  mark_ref_in_use(tref PASS_REGS);
-	}
-      } else {
-	mark_db_fixed(next PASS_REGS);
-      }
+      mark_code_term(current, ccur, next PASS_REGS);
       POP_CONTINUATION();
     }
     if ( MARKED_PTR(next) || !ONHEAP(next) )
@@ -1327,83 +1353,50 @@ mark_variable(CELL_PTR current USES_REGS)
     
     if (next < H0) POP_CONTINUATION();
     if (IsExtensionFunctor((Functor)cnext)) {
-      switch (cnext) {
-      case (CELL)FunctorLongInt:
-	MARK(next);
-	MARK(next+2);
-	if (next < LOCAL_HGEN) {
-	  LOCAL_total_oldies+=3;
-	} else {
-	  DEBUG_printf0("%p 1\n", next);
-	  DEBUG_printf0("%p 3\n", next);
-	}
-	LOCAL_total_marked += 3;
-	PUSH_POINTER(next PASS_REGS);
-	PUSH_POINTER(next+2 PASS_REGS);
+      UInt sz = extension_size(next, cnext);
+
+      if (!sz)
 	POP_CONTINUATION();
-      case (CELL)FunctorDouble:
-	MARK(next);
-	PUSH_POINTER(next PASS_REGS);
-	{
-	  UInt sz = 1+SIZEOF_DOUBLE/SIZEOF_LONG_INT;
-	  if (next < LOCAL_HGEN) {
-	    LOCAL_total_oldies+= 1+sz;
-	  } else {
-	    DEBUG_printf0("%p 1\n", next);
-	    DEBUG_printf1("%p %ld\n", next, (long int)(sz+1));
+      MARK(next);
+      if ((Functor)cnext == FunctorBigInt) {
+	Opaque_CallOnGCMark f;
+	Term t = AbsAppl(next);
+
+	if ( (f = Yap_blob_gc_mark_handler(t)) ) {
+	  Int n = (f)(Yap_BlobTag(t), Yap_BlobInfo(t), LOCAL_extra_gc_cells, LOCAL_extra_gc_cells_top - (LOCAL_extra_gc_cells+2));
+	  if (n < 0) {
+	    /* error: we don't have enough room */
+	    /* could not find more trail */
+	    save_machine_regs();
+	    siglongjmp(LOCAL_gc_restore, 3);
+	  } else if (n > 0) {
+	    CELL *ptr = LOCAL_extra_gc_cells;
+
+	    LOCAL_extra_gc_cells += n+2;      
+	    PUSH_CONTINUATION(ptr, n+1 PASS_REGS);
+	    ptr += n;
+	    ptr[0] = t;
+	    ptr[1] = n+1;
 	  }
-	  LOCAL_total_marked += 1+sz;
-	  PUSH_POINTER(next+sz PASS_REGS);
-	  MARK(next+sz);
 	}
-	POP_CONTINUATION();
-      case (CELL)FunctorBigInt:
-	{
-	  Opaque_CallOnGCMark f;
-	  Term t = AbsAppl(next);
-	  UInt sz = (sizeof(MP_INT)+CellSize+
-		     ((MP_INT *)(next+2))->_mp_alloc*sizeof(mp_limb_t))/CellSize;
-
-	  MARK(next);
-	  if ( (f = Yap_blob_gc_mark_handler(t)) ) {
-	    Int n = (f)(Yap_BlobTag(t), Yap_BlobInfo(t), LOCAL_extra_gc_cells, LOCAL_extra_gc_cells_top - (LOCAL_extra_gc_cells+2));
-	    if (n < 0) {
-	      /* error: we don't have enough room */
-	      /* could not find more trail */
-	      save_machine_regs();
-	      siglongjmp(LOCAL_gc_restore, 3);
-	    } else if (n > 0) {
-	      CELL *ptr = LOCAL_extra_gc_cells;
-
-	      LOCAL_extra_gc_cells += n+2;      
-	      PUSH_CONTINUATION(ptr, n+1 PASS_REGS);
-	      ptr += n;
-	      ptr[0] = t;
-	      ptr[1] = n+1;
-	    }
-	  }
-
-	  /* size is given by functor + friends */
-	  if (next < LOCAL_HGEN) {
-	    LOCAL_total_oldies += 2+sz;
-	  } else {
-	    DEBUG_printf0("%p 1\n", next);
-	    DEBUG_printf1("%p %ld\n", next, (long int)(sz+2));
-	  }
-	  LOCAL_total_marked += 2+sz;
-	  PUSH_POINTER(next PASS_REGS);
-	  sz++;
 #if DEBUG
-	  if (next[sz] != EndSpecials)  {
-	    fprintf(stderr,"[ Error: could not find EndSpecials at blob %p type " UInt_FORMAT " ]\n", next, next[1]);
+	if (next[sz] != EndSpecials)  {
+	  fprintf(stderr,"[ Error: could not find EndSpecials at blob %p type " UInt_FORMAT " ]\n", next, next[1]);
 	}
 #endif
- 	  MARK(next+sz);
-	  PUSH_POINTER(next+sz PASS_REGS);
-	}
-      default:
-	POP_CONTINUATION();
       }
+      /* size is given by functor + friends */
+      if (next < LOCAL_HGEN) {
+	LOCAL_total_oldies += 1+sz;
+      } else {
+	DEBUG_printf0("%p 1\n", next);
+	DEBUG_printf1("%p %ld\n", next, (long int)(sz+1));
+      }
+      LOCAL_total_marked += 1+sz;
+      PUSH_POINTER(next PASS_REGS);
+      MARK(next+sz);
+      PUSH_POINTER(next+sz PASS_REGS);
+      POP_CONTINUATION();
     }
     if (next < H0) POP_CONTINUATION();
 #ifdef INSTRUMENT_GC
@@ -2291,6 +2284,7 @@ mark_choicepoints(register choiceptr gc_B, tr_fr_ptr saved_TR, int very_verbose
       case _count_trust_me:
       case _retry:
       case _trust:
+      case _retry_exo:
 	if (IN_BETWEEN(H0,(CELL *)(gc_B->cp_ap),H)) {
 	  fprintf(stderr,"OOPS in GC: gc not supported in this case!!!\n");
 	  exit(1);
@@ -3398,6 +3392,12 @@ compact_heap( USES_REGS1 )
       dest--;
     } else {
       in_garbage++;
+      /* skip dead cells a word of mark bytes at a time */
+      while (current-sizeof(CELL) >= start_from &&
+	     !MARKED_WORD(current-sizeof(CELL))) {
+	current -= sizeof(CELL);
+	in_garbage += sizeof(CELL);
+      }
     }
   }
   if (in_garbage)
@@ -3689,6 +3689,559 @@ set_conditionals(tr_fr_ptr str USES_REGS) {
 #endif
 
 
+#if THREADS
+
+/*
+ * Parallel marking.
+ *
+ * The roots reached from the slots, from the registers we dumped on
+ * the trail and from the current chain of environments can be marked
+ * in any order, so we give them to GLOBAL_GcThreads workers. Every
+ * worker has a private stack of continuations and gives the older
+ * half away whenever another worker is idle. Mark bits are set with an
+ * atomic test-and-set, so only one worker ever follows a cell.
+ *
+ * The choice-points and the trail are still marked sequentially, as
+ * the trail optimisations depend on the order we visit them.
+ */
+
+/* do not bother with small stacks */
+#define GC_PAR_MIN_CELLS   (256*1024)
+#define GC_PAR_MAX_THREADS 64
+#define GC_PAR_CHUNK       64
+#define GC_PAR_STACK       1024
+
+struct gc_par_marker;
+
+typedef struct gc_par_worker {
+  struct gc_par_marker *par;
+  cont *stk;
+  UInt sp, sz;
+  /* heap cells marked, for the hybrid compactor */
+  CELL_PTR *ptrs;
+  UInt nptrs, ptrs_sz;
+  int ptrs_overflow;
+  /* blobs with a mark handler, left to the main thread */
+  CELL_PTR *blobs;
+  UInt nblobs, blobs_sz;
+  Int marked, oldies;
+  pthread_t tid;
+} gc_par_worker;
+
+typedef struct gc_par_marker {
+  struct regstore_t *regcache;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  /* the table of live clauses and references is not thread-safe */
+  pthread_mutex_t db_lock;
+  cont *pool;
+  UInt npool, pool_sz;
+  int nworkers, nalloc;
+  int idle;
+  int done;
+  volatile int error;
+  gc_par_worker *workers;
+} gc_par_marker;
+
+/* TRUE if the cell was already marked */
+#define PAR_UNMARKED_MARK(P)  ((__atomic_load_n(&mcell(P), __ATOMIC_RELAXED) & MARK_BIT) || \
+			       (__atomic_fetch_or(&mcell(P), MARK_BIT, __ATOMIC_RELAXED) & MARK_BIT))
+#define PAR_MARK(P)           __atomic_fetch_or(&mcell(P), MARK_BIT, __ATOMIC_RELAXED)
+
+static int
+par_add_root(gc_par_marker *par, CELL *v, int nof)
+{
+  if (par->npool && par->pool[par->npool-1].v+par->pool[par->npool-1].nof == v) {
+    par->pool[par->npool-1].nof += nof;
+    return TRUE;
+  }
+  if (par->npool == par->pool_sz) {
+    cont *pool = (cont *)realloc(par->pool, 2*par->pool_sz*sizeof(cont));
+    if (!pool)
+      return FALSE;
+    par->pool = pool;
+    par->pool_sz *= 2;
+  }
+  par->pool[par->npool].v = v;
+  par->pool[par->npool].nof = nof;
+  par->npool++;
+  return TRUE;
+}
+
+/* same walk as mark_environments, but we only collect the variables */
+static int
+par_collect_roots(gc_par_marker *par, tr_fr_ptr old_TR, CELL_PTR gc_ENV, OPREG size, CELL *pvbmap USES_REGS)
+{
+  Int curslot = CurSlot;
+  tr_fr_ptr trail_ptr;
+  CELL_PTR saved_var;
+
+  while (curslot) {
+    CELL *ptr = LCL0-curslot;
+    Int ns = IntegerOfTerm(*ptr);
+
+    if (ns > 0 && !par_add_root(par, ptr+1, ns))
+      return FALSE;
+    curslot = IntegerOfTerm(ptr[ns+1]);
+  }
+  for (trail_ptr = old_TR; trail_ptr < TR; trail_ptr++) {
+    if (!par_add_root(par, &TrailTerm(trail_ptr), 1))
+      return FALSE;
+  }
+  while (gc_ENV != NULL) {
+    Int bmap = 0;
+    int currv = 0;
+
+    mark_db_fixed((CELL *)gc_ENV[E_CP] PASS_REGS);
+    if (size > EnvSizeInCells) {
+      int tsize = size - EnvSizeInCells;
+
+      currv = sizeof(CELL)*8-tsize%(sizeof(CELL)*8);
+      if (pvbmap != NULL) {
+	pvbmap += tsize/(sizeof(CELL)*8);
+	bmap = *pvbmap;
+      } else {
+	bmap = ((CELL)-1);
+      }
+      bmap = (Int)(((CELL)bmap) << currv);
+    }
+    for (saved_var = gc_ENV - size; saved_var < gc_ENV - EnvSizeInCells; saved_var++) {
+      if (currv == sizeof(CELL)*8) {
+	if (pvbmap) {
+	  pvbmap--;
+	  bmap = *pvbmap;
+	} else {
+	  bmap = ((CELL)-1);
+	}
+	currv = 0;
+      }
+      if (bmap < 0 && !par_add_root(par, saved_var, 1))
+	return FALSE;
+      bmap <<= 1;
+      currv++;
+    }
+    if (MARKED_PTR(gc_ENV+E_CB))
+      return TRUE;
+    MARK(gc_ENV+E_CB);
+    size = EnvSize((yamop *) (gc_ENV[E_CP]));
+    pvbmap = EnvBMap((yamop *) (gc_ENV[E_CP]));
+    gc_ENV = (CELL_PTR) gc_ENV[E_E];
+  }
+  return TRUE;
+}
+
+static int
+par_push_cont(gc_par_worker *w, CELL *v, int nof)
+{
+  if (w->sp == w->sz) {
+    cont *stk = (cont *)realloc(w->stk, 2*w->sz*sizeof(cont));
+    if (!stk) {
+      w->par->error = TRUE;
+      return FALSE;
+    }
+    w->stk = stk;
+    w->sz *= 2;
+  }
+  w->stk[w->sp].v = v;
+  w->stk[w->sp].nof = nof;
+  w->sp++;
+  return TRUE;
+}
+
+static void
+par_push_pointer(gc_par_worker *w, CELL *v)
+{
+  if (w->ptrs_overflow)
+    return;
+  if (w->nptrs == w->ptrs_sz) {
+    CELL_PTR *ptrs = (CELL_PTR *)realloc(w->ptrs, 2*w->ptrs_sz*sizeof(CELL_PTR));
+    if (!ptrs) {
+      /* just give up on the hybrid compactor */
+      w->ptrs_overflow = TRUE;
+      return;
+    }
+    w->ptrs = ptrs;
+    w->ptrs_sz *= 2;
+  }
+  w->ptrs[w->nptrs++] = v;
+}
+
+static void
+par_count(gc_par_worker *w, CELL *pt, Int n USES_REGS)
+{
+  w->marked += n;
+  if (pt < LOCAL_HGEN)
+    w->oldies += n;
+}
+
+/* hand the older half of our work to the idle workers */
+static void
+par_share(gc_par_worker *w)
+{
+  gc_par_marker *par = w->par;
+  UInt n = w->sp/2;
+
+  pthread_mutex_lock(&par->lock);
+  while (par->npool+n+1 > par->pool_sz) {
+    cont *pool = (cont *)realloc(par->pool, 2*par->pool_sz*sizeof(cont));
+    if (!pool) {
+      pthread_mutex_unlock(&par->lock);
+      return;
+    }
+    par->pool = pool;
+    par->pool_sz *= 2;
+  }
+  if (n) {
+    memcpy(par->pool+par->npool, w->stk, n*sizeof(cont));
+    memmove(w->stk, w->stk+n, (w->sp-n)*sizeof(cont));
+    par->npool += n;
+    w->sp -= n;
+  } else {
+    /* a single long vector: split it */
+    cont *x = w->stk;
+    int half = x->nof/2;
+
+    par->pool[par->npool].v = x->v+(x->nof-half);
+    par->pool[par->npool].nof = half;
+    par->npool++;
+    x->nof -= half;
+  }
+  pthread_cond_broadcast(&par->cond);
+  pthread_mutex_unlock(&par->lock);
+}
+
+static int
+par_get_work(gc_par_worker *w)
+{
+  gc_par_marker *par = w->par;
+  int ok = FALSE;
+
+  pthread_mutex_lock(&par->lock);
+  par->idle++;
+  while (!par->npool && !par->done && !par->error) {
+    if (par->idle == par->nworkers) {
+      par->done = TRUE;
+      pthread_cond_broadcast(&par->cond);
+    } else {
+      pthread_cond_wait(&par->cond, &par->lock);
+    }
+  }
+  if (par->npool && !par->error) {
+    UInt n = par->npool/par->nworkers+1;
+
+    if (n > GC_PAR_CHUNK)
+      n = GC_PAR_CHUNK;
+    par->npool -= n;
+    memcpy(w->stk, par->pool+par->npool, n*sizeof(cont));
+    w->sp = n;
+    par->idle--;
+    ok = TRUE;
+  } else if (par->error) {
+    /* wake up everyone waiting for work */
+    pthread_cond_broadcast(&par->cond);
+  }
+  pthread_mutex_unlock(&par->lock);
+  return ok;
+}
+
+static void
+par_mark_code_term(gc_par_worker *w, CELL_PTR current, CELL ccur, CELL_PTR next USES_REGS)
+{
+  pthread_mutex_lock(&w->par->db_lock);
+  mark_code_term(current, ccur, next PASS_REGS);
+  pthread_mutex_unlock(&w->par->db_lock);
+}
+
+/* mark_variable, for a worker */
+static void
+par_mark(gc_par_worker *w USES_REGS)
+{
+  gc_par_marker *par = w->par;
+  CELL_PTR current, next;
+  CELL ccur;
+  unsigned int arity;
+
+  while (w->sp) {
+    cont *x = w->stk+(w->sp-1);
+
+    if (par->error)
+      return;
+    if (__atomic_load_n(&par->idle, __ATOMIC_RELAXED) &&
+	!__atomic_load_n(&par->npool, __ATOMIC_RELAXED) &&
+	(w->sp > 1 || x->nof > 1)) {
+      par_share(w);
+      x = w->stk+(w->sp-1);
+    }
+    current = x->v;
+    if (x->nof == 1) {
+      w->sp--;
+    } else {
+      x->nof--;
+      x->v = current+1;
+    }
+  begin:
+    if (PAR_UNMARKED_MARK(current))
+      continue;
+    if (current >= H0 && current < H) {
+      par_count(w, current, 1 PASS_REGS);
+      par_push_pointer(w, current);
+    }
+    ccur = *current;
+    next = GET_NEXT(ccur);
+
+    if (IsVarTerm(ccur)) {
+      if (IN_BETWEEN(LOCAL_GlobalBase,current,H) && GlobalIsAttVar(current) && current==next) {
+	if (next < H0)
+	  continue;
+	if (!PAR_UNMARKED_MARK(next-1)) {
+	  par_count(w, next-1, 1 PASS_REGS);
+	  par_push_pointer(w, next-1);
+	}
+	if (!par_push_cont(w, next+1, 2))
+	  return;
+      } else if (ONHEAP(next)) {
+	current = next;
+	goto begin;
+      }
+      continue;
+    } else if (IsAtomOrIntTerm(ccur)) {
+      continue;
+    } else if (IsPairTerm(ccur)) {
+      if (ONHEAP(next)) {
+	if (IsAtomOrIntTerm(*next)) {
+	  if (!PAR_UNMARKED_MARK(next)) {
+	    par_count(w, next, 1 PASS_REGS);
+	    par_push_pointer(w, next);
+	  }
+	} else if (!par_push_cont(w, next, 1)) {
+	  return;
+	}
+	current = next+1;
+	goto begin;
+      } else if (ONCODE(next)) {
+	par_mark_code_term(w, current, ccur, next PASS_REGS);
+      }
+      continue;
+    } else if (IsApplTerm(ccur)) {
+      CELL cnext = *next;
+
+      if (ONCODE(next)) {
+	par_mark_code_term(w, current, ccur, next PASS_REGS);
+	continue;
+      }
+      if (!ONHEAP(next))
+	continue;
+      if (IsExtensionFunctor((Functor)cnext)) {
+	UInt sz = extension_size(next, cnext);
+
+	if (!sz || PAR_UNMARKED_MARK(next))
+	  continue;
+	PAR_MARK(next+sz);
+	par_count(w, next, sz+1 PASS_REGS);
+	par_push_pointer(w, next);
+	par_push_pointer(w, next+sz);
+	if ((Functor)cnext == FunctorBigInt &&
+	    Yap_blob_gc_mark_handler(AbsAppl(next))) {
+	  if (w->nblobs == w->blobs_sz) {
+	    UInt bsz = (w->blobs_sz ? 2*w->blobs_sz : 16);
+	    CELL_PTR *blobs = (CELL_PTR *)realloc(w->blobs, bsz*sizeof(CELL_PTR));
+
+	    if (!blobs) {
+	      par->error = TRUE;
+	      return;
+	    }
+	    w->blobs = blobs;
+	    w->blobs_sz = bsz;
+	  }
+	  w->blobs[w->nblobs++] = next;
+	}
+	continue;
+      }
+      if (PAR_UNMARKED_MARK(next))
+	continue;
+      arity = ArityOfFunctor((Functor)(cnext));
+      par_count(w, next, 1 PASS_REGS);
+      par_push_pointer(w, next);
+      next++;
+      /* speedup for leaves */
+      while (arity && IsAtomOrIntTerm(*next)) {
+	if (!PAR_UNMARKED_MARK(next)) {
+	  par_count(w, next, 1 PASS_REGS);
+	  par_push_pointer(w, next);
+	}
+	next++;
+	arity--;
+      }
+      if (!arity)
+	continue;
+      current = next;
+      if (arity > 1 && !par_push_cont(w, current+1, arity-1))
+	return;
+      goto begin;
+    }
+  }
+}
+
+static void *
+par_mark_worker(void *arg)
+{
+  gc_par_worker *w = (gc_par_worker *)arg;
+  struct regstore_t *regcache = w->par->regcache;
+
+  while (par_get_work(w)) {
+    par_mark(w PASS_REGS);
+  }
+  return NULL;
+}
+
+static void
+par_free(gc_par_marker *par)
+{
+  int i;
+
+  for (i = 0; i < par->nalloc; i++) {
+    gc_par_worker *w = par->workers+i;
+
+    free(w->stk);
+    free(w->ptrs);
+    free(w->blobs);
+  }
+  free(par->workers);
+  free(par->pool);
+}
+
+/* the main thread runs the mark handlers for the blobs the workers found */
+static int
+par_mark_blobs(gc_par_worker *w USES_REGS)
+{
+  UInt i;
+
+  for (i = 0; i < w->nblobs; i++) {
+    Term t = AbsAppl(w->blobs[i]);
+    Opaque_CallOnGCMark f = Yap_blob_gc_mark_handler(t);
+    Int n = (f)(Yap_BlobTag(t), Yap_BlobInfo(t), LOCAL_extra_gc_cells, LOCAL_extra_gc_cells_top - (LOCAL_extra_gc_cells+2));
+
+    if (n < 0) {
+      return FALSE;
+    } else if (n > 0) {
+      CELL *ptr = LOCAL_extra_gc_cells;
+      Int j;
+
+      LOCAL_extra_gc_cells += n+2;
+      ptr[n] = t;
+      ptr[n+1] = n+1;
+      for (j = 0; j <= n; j++)
+	mark_variable(ptr+j PASS_REGS);
+    }
+  }
+  return TRUE;
+}
+
+/*
+  mark the slots, the registers and the current environments with
+  several threads. Returns FALSE if the caller should do it instead.
+*/
+static int
+par_mark_roots(tr_fr_ptr old_TR, CELL_PTR gc_ENV, OPREG size, CELL *pvbmap USES_REGS)
+{
+  gc_par_marker par;
+  UInt nptrs = 0;
+  int i, overflow = FALSE, blob_overflow = FALSE;
+
+  if (GLOBAL_GcThreads <= 1 || H-H0 < GC_PAR_MIN_CELLS)
+    return FALSE;
+  memset(&par, 0, sizeof(par));
+  par.regcache = regcache;
+  par.nworkers = GLOBAL_GcThreads;
+  if (par.nworkers > GC_PAR_MAX_THREADS)
+    par.nworkers = GC_PAR_MAX_THREADS;
+  par.pool_sz = GC_PAR_STACK;
+  par.pool = (cont *)malloc(par.pool_sz*sizeof(cont));
+  par.workers = (gc_par_worker *)calloc(par.nworkers, sizeof(gc_par_worker));
+  if (!par.pool || !par.workers) {
+    par_free(&par);
+    return FALSE;
+  }
+  par.nalloc = par.nworkers;
+  for (i = 0; i < par.nworkers; i++) {
+    gc_par_worker *w = par.workers+i;
+
+    w->par = &par;
+    w->sz = GC_PAR_STACK;
+    w->stk = (cont *)malloc(w->sz*sizeof(cont));
+    w->ptrs_sz = GC_PAR_STACK;
+    w->ptrs = (CELL_PTR *)malloc(w->ptrs_sz*sizeof(CELL_PTR));
+    if (!w->stk || !w->ptrs) {
+      par_free(&par);
+      return FALSE;
+    }
+  }
+  if (!par_collect_roots(&par, old_TR, gc_ENV, size, pvbmap PASS_REGS)) {
+    par_free(&par);
+    /* forget the environments we have seen */
+    memset((void *)LOCAL_bp, 0, (CELL *)TR-(CELL *)LOCAL_GlobalBase);
+    return FALSE;
+  }
+  pthread_mutex_init(&par.lock, NULL);
+  pthread_mutex_init(&par.db_lock, NULL);
+  pthread_cond_init(&par.cond, NULL);
+  /* nobody may leave before we know how many we are */
+  pthread_mutex_lock(&par.lock);
+  for (i = 1; i < par.nworkers; i++) {
+    gc_par_worker *w = par.workers+i;
+
+    if (pthread_create(&w->tid, NULL, par_mark_worker, (void *)w) != 0)
+      break;
+  }
+  par.nworkers = i;
+  pthread_mutex_unlock(&par.lock);
+  par_mark_worker(par.workers);
+  for (i = 1; i < par.nworkers; i++) {
+    pthread_join(par.workers[i].tid, NULL);
+  }
+  pthread_cond_destroy(&par.cond);
+  pthread_mutex_destroy(&par.db_lock);
+  pthread_mutex_destroy(&par.lock);
+  if (par.error) {
+    par_free(&par);
+    memset((void *)LOCAL_bp, 0, (CELL *)TR-(CELL *)LOCAL_GlobalBase);
+    return FALSE;
+  }
+  for (i = 0; i < par.nworkers; i++) {
+    gc_par_worker *w = par.workers+i;
+
+    LOCAL_total_marked += w->marked;
+    LOCAL_total_oldies += w->oldies;
+    nptrs += w->nptrs;
+    overflow |= w->ptrs_overflow;
+  }
+#ifdef HYBRID_SCHEME
+  if (overflow || LOCAL_iptop+nptrs >= (CELL_PTR *)ASP) {
+    LOCAL_iptop = (CELL_PTR *)ASP;
+  } else {
+    for (i = 0; i < par.nworkers; i++) {
+      gc_par_worker *w = par.workers+i;
+
+      memcpy(LOCAL_iptop, w->ptrs, w->nptrs*sizeof(CELL_PTR));
+      LOCAL_iptop += w->nptrs;
+    }
+  }
+#endif
+  for (i = 0; i < par.nworkers && !blob_overflow; i++) {
+    blob_overflow = !par_mark_blobs(par.workers+i PASS_REGS);
+  }
+  par_free(&par);
+  if (blob_overflow) {
+    /* error: we don't have enough room */
+    save_machine_regs();
+    siglongjmp(LOCAL_gc_restore, 3);
+  }
+  return TRUE;
+}
+
+#endif /* THREADS */
+
+
 /*
  * mark all objects on the heap that are accessible from active registers,
  * the trail, environments, and choicepoints 
@@ -3713,10 +4266,15 @@ marking_phase(tr_fr_ptr old_TR, CELL *current_env, yamop *curp USES_REGS)
   LOCAL_cont_top = (cont *)LOCAL_db_vec;
   /* These two must be marked first so that our trail optimisation won't lose
      values */
-  mark_slots( PASS_REGS1 );
-  mark_regs(old_TR PASS_REGS);		/* active registers & trail */
-  /* active environments */
-  mark_environments(current_env, EnvSize(curp), EnvBMap(curp) PASS_REGS);
+#if THREADS
+  if (!par_mark_roots(old_TR, current_env, EnvSize(curp), EnvBMap(curp) PASS_REGS))
+#endif
+  {
+    mark_slots( PASS_REGS1 );
+    mark_regs(old_TR PASS_REGS);		/* active registers & trail */
+    /* active environments */
+    mark_environments(current_env, EnvSize(curp), EnvBMap(curp) PASS_REGS);
+  }
   mark_choicepoints(B, old_TR, is_gc_very_verbose() PASS_REGS);	/* choicepoints, and environs  */
 #ifdef EASY_SHUNTING
   set_conditionals(LOCAL_sTR PASS_REGS);
@@ -4123,6 +4681,12 @@ call_gc(UInt gc_lim, Int predarity, CELL *current_env, yamop *nextop USES_REGS)
       while (gc_margin < (H-H0)/sizeof(CELL)) 
 	gc_margin <<= 1;
     }
+    /* we only compacted the new generation: the live data is long lived,
+       so make sure the next generation is large enough that we do not
+       have to mark it over and over again */
+    if (LOCAL_HGEN != H0 && !gc_t &&
+	gc_margin < 2*(H-H0)*sizeof(CELL))
+      gc_margin = 2*(H-H0)*sizeof(CELL);
   } else {
     effectiveness = 0;
   }
@@ -4198,11 +4762,37 @@ p_gc( USES_REGS1 )
   return res;
 }
 
+static Int
+p_gc_threads( USES_REGS1 )
+{
+  Term t = Deref(ARG1);
+
+  if (IsVarTerm(t)) {
+#if THREADS
+    return Yap_unify(t, MkIntegerTerm(GLOBAL_GcThreads));
+#else
+    return Yap_unify(t, MkIntTerm(1));
+#endif
+  }
+  if (!IsIntegerTerm(t))
+    return FALSE;
+#if THREADS
+  if (IntegerOfTerm(t) < 1)
+    return FALSE;
+  GLOBAL_GcThreads = IntegerOfTerm(t);
+  return TRUE;
+#else
+  /* we always mark with a single thread */
+  return IntegerOfTerm(t) == 1;
+#endif
+}
+
 void 
 Yap_init_gc(void)
 {
   Yap_InitCPred("$gc", 0, p_gc, HiddenPredFlag);
   Yap_InitCPred("$inform_gc", 3, p_inform_gc, HiddenPredFlag);
+  Yap_InitCPred("$gc_threads", 1, p_gc_threads, SafePredFlag|HiddenPredFlag);
 }
 
 void
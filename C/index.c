@@ -569,7 +569,7 @@ recover_from_failed_susp_on_cls(struct intermediates *cint, UInt sz)
 	while (first) {
 	  yamop *next = first->u.OtaLl.n;
 	  LogUpdClause *cl = first->u.OtaLl.d;
-	  cl->ClRefCount--;
+	  DEC_LU_CLREF(cl);
 	  Yap_FreeCodeSpace((char *)first);
 	  if (first == last) 
 	    break;
@@ -989,6 +989,7 @@ move_next(ClauseDef *clause, UInt regno)
     }	
     return;
   case _glist_valx:
+  case _glist_valx_varx:
   case _gl_void_vary:
   case _gl_void_valy:
   case _gl_void_varx:
@@ -1046,6 +1047,7 @@ add_arg_info(ClauseDef *clause, PredEntry *ap, UInt argno)
       argno--;
       cl = NEXTOP(cl,xx);
       break;
+    case _glist_valx_varx:
     case _gl_void_vary:
     case _gl_void_valy:
     case _gl_void_varx:
@@ -1588,6 +1590,7 @@ emit_switch_space(UInt n, UInt item_size, struct intermediates *cint, CELL func_
       siglongjmp(cint->CompilerBotch,2);
     }
     Yap_LUIndexSpace_SW += sz;
+    cint->index_bytes += sz;
     cl->ClFlags = SwitchTableMask|LogUpdMask|func_mask;
     cl->ClSize = sz;
     cl->ClPred = cint->CurrentPred;
@@ -1604,6 +1607,7 @@ emit_switch_space(UInt n, UInt item_size, struct intermediates *cint, CELL func_
       siglongjmp(cint->CompilerBotch,2);
     }
     Yap_IndexSpace_SW += sz;
+    cint->index_bytes += sz;
     cl->ClFlags = SwitchTableMask;
     cl->ClSize = sz;
     cl->ClPred = cint->CurrentPred;
@@ -1924,6 +1928,7 @@ suspend_indexing(ClauseDef *min, ClauseDef *max, PredEntry *ap, struct intermedi
     } else {
       Yap_IndexSpace_EXT += sz;
     }
+    cint->index_bytes += sz;
     Yap_inform_profiler_of_clause(ncode, (CODEADDR)ncode+sz, ap, GPROF_NEW_EXPAND_BLOCK); 
     /* create an expand_block */
     ncode->opc = Yap_opcode(_expand_clauses);
@@ -2264,6 +2269,16 @@ do_nonvar_group(GroupDef *grp, Term t, UInt compound_term, CELL *sreg, UInt arit
     if (grp->LastClause < grp->FirstClause) { /* only tests */
       return NULL;
     }
+    if (compound_term) {
+      cint->sub_arg_switches++;
+    } else if (argno == 1) {
+      cint->first_arg_switches++;
+    } else {
+      cint->other_arg_switches++;
+    }
+    if (argno <= 8*sizeof(UInt)) {
+      cint->args_switched |= (UInt)1 << (argno-1);
+    }
     type_sw = emit_type_switch(switch_on_type_op, cint);
     /* have these first so that we will have something initialised here */
     type_sw->ConstEntry = 
@@ -2776,6 +2791,40 @@ compile_index(struct intermediates *cint)
   return res;
 }
 
+static void
+reset_index_stats(struct intermediates *cint)
+{
+  cint->first_arg_switches = 
+    cint->other_arg_switches = 
+    cint->sub_arg_switches = 
+    cint->args_switched = 
+    cint->index_bytes = 0;
+}
+
+/*
+  only called once the new block, if any, has been assembled: the
+  totals are kept both for the whole system and for the predicate.
+*/
+static void
+commit_index_stats(struct intermediates *cint, yamop *indx)
+{
+  PredEntry *ap = cint->CurrentPred;
+  UInt sz = cint->index_bytes;
+
+  INDEX_STAT_ADD(Yap_IndexFirstArgSwitches, cint->first_arg_switches);
+  INDEX_STAT_ADD(Yap_IndexOtherArgSwitches, cint->other_arg_switches);
+  INDEX_STAT_ADD(Yap_IndexSubArgSwitches, cint->sub_arg_switches);
+  if (indx) {
+    if (ap->PredFlags & LogUpdatePredFlag)
+      sz += ClauseCodeToLogUpdIndex(indx)->ClSize;
+    else
+      sz += ClauseCodeToStaticIndex(indx)->ClSize;
+    INDEX_STAT_ADD(ap->IndexStatsOfPred.NOfTrees, 1);
+  }
+  INDEX_STAT_OR(ap->IndexStatsOfPred.ArgsSwitched, cint->args_switched);
+  INDEX_STAT_ADD(ap->IndexStatsOfPred.IndexBytes, sz);
+}
+
 static void
 CleanCls(struct intermediates *cint)
 {
@@ -2796,6 +2845,12 @@ Yap_PredIsIndexable(PredEntry *ap, UInt NSlots, yamop *next_pc)
   struct intermediates cint;
 
 
+  if (IsExoPred(ap)) {
+    /* exo code does its own hashing */
+    if ((indx_out = Yap_ExoIndexCode(ap)) == NULL)
+      return FAILCODE;
+    return indx_out;
+  }
   cint.CurrentPred = ap;
   cint.code_addr = NULL;
   cint.blks = NULL;
@@ -2842,6 +2897,7 @@ Yap_PredIsIndexable(PredEntry *ap, UInt NSlots, yamop *next_pc)
   cint.label_offset = NULL;
   LOCAL_ErrorMessage = NULL;
   cint.term_depth = cint.last_index_new_depth = cint.last_depth_size = 0L;
+  reset_index_stats(&cint);
   if (compile_index(&cint) == (UInt)FAILCODE) {
     Yap_ReleaseCMem(&cint);
     CleanCls(&cint);
@@ -2871,6 +2927,8 @@ Yap_PredIsIndexable(PredEntry *ap, UInt NSlots, yamop *next_pc)
   }
   Yap_ReleaseCMem(&cint);
   CleanCls(&cint);
+  INDEX_STAT_ADD(Yap_IndexTrees, 1);
+  commit_index_stats(&cint, indx_out);
   if (ap->PredFlags & LogUpdatePredFlag) {
     LogUpdIndex *cl = ClauseCodeToLogUpdIndex(indx_out);
     cl->ClFlags |= SwitchRootMask;
@@ -3984,6 +4042,7 @@ ExpandIndex(PredEntry *ap, int ExtraArgs, yamop *nextop USES_REGS) {
  restart_index:
   cint.CodeStart = cint.cpc = cint.BlobsStart = cint.icpc = NIL;
   cint.CurrentPred = ap;
+  reset_index_stats(&cint);
   LOCAL_ErrorMessage = NULL;
   LOCAL_Error_Size = 0;
   if (P->opc == Yap_opcode(_expand_clauses)) {
@@ -4091,6 +4150,8 @@ ExpandIndex(PredEntry *ap, int ExtraArgs, yamop *nextop USES_REGS) {
   }
   Yap_ReleaseCMem(&cint);
   CleanCls(&cint);
+  INDEX_STAT_ADD(Yap_IndexExpansions, 1);
+  commit_index_stats(&cint, indx_out);
   *labp = indx_out;
   if (ap->PredFlags & LogUpdatePredFlag) {
     /* add to head of current code children */
@@ -4107,7 +4168,7 @@ ExpandIndex(PredEntry *ap, int ExtraArgs, yamop *nextop USES_REGS) {
     nic->ParentIndex = ic;
     nic->ClFlags &= ~SwitchRootMask;
     ic->ChildIndex = nic;
-    ic->ClRefCount++;
+    INC_LU_CLREF(ic);
   } else {
     /* add to head of current code children */
     StaticIndex *ic = cint.current_cl.si,
@@ -4455,7 +4516,7 @@ expand_ftable(yamop *pc, ClauseUnion *blk, struct intermediates *cint, Functor f
 static void
 clean_ref_to_clause(LogUpdClause *tgl)
 {
-  tgl->ClRefCount--;
+  DEC_LU_CLREF(tgl);
   if ((tgl->ClFlags & ErasedMask) &&
       !(tgl->ClRefCount) &&
       !(tgl->ClFlags & InUseMask)) {
@@ -4950,7 +5011,7 @@ add_try(PredEntry *ap, ClauseDef *cls, yamop *next, struct intermediates *cint)
   newcp->u.OtaLl.s = ap->ArityOfPE;
   newcp->u.OtaLl.n = next;
   newcp->u.OtaLl.d = lcl;
-  lcl->ClRefCount++;
+  INC_LU_CLREF(lcl);
   return newcp;
 }
 
@@ -4981,7 +5042,7 @@ add_trust(LogUpdIndex *icl, ClauseDef *cls, struct intermediates *cint)
   newcp->u.OtILl.block = icl;
   newcp->u.OtILl.n = NULL;
   newcp->u.OtILl.d = lcl;
-  lcl->ClRefCount++;
+  INC_LU_CLREF(lcl);
   return newcp;
 }
 
@@ -5444,6 +5505,7 @@ Yap_AddClauseToIndex(PredEntry *ap, yamop *beg, int first) {
   cint.expand_block = NULL;
   cint.CodeStart = cint.BlobsStart = cint.cpc = cint.icpc = NIL;
   cint.term_depth = cint.last_index_new_depth = cint.last_depth_size = 0L;
+  reset_index_stats(&cint);
   if ((cb = sigsetjmp(cint.CompilerBotch, 0)) == 3) {
     restore_machine_regs();
     Yap_gcl(LOCAL_Error_Size, ap->ArityOfPE, ENV, CP);
@@ -5503,6 +5565,8 @@ Yap_AddClauseToIndex(PredEntry *ap, yamop *beg, int first) {
   cl.Code =  cl.CurrentCode = beg;
   sp = push_path(stack, NULL, &cl, &cint);
   add_to_index(&cint, first, sp, &cl); 
+  INDEX_STAT_ADD(Yap_IndexUpdates, 1);
+  commit_index_stats(&cint, NULL);
 }
 		 
 
@@ -5545,7 +5609,7 @@ remove_from_index(PredEntry *ap, path_stack_entry *sp, ClauseDef *cls, yamop *bg
       return;
     }
     ap->cs.p_code.TrueCodeOfPred = ap->cs.p_code.FirstClause;
-    if (ap->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) {
+    if (PredIsWatched(ap)) {
       ap->OpcodeOfPred = Yap_opcode(_spy_pred);
       ap->CodeOfPred = (yamop *)(&(ap->OpcodeOfPred)); 
 #if defined(YAPOR) || defined(THREADS)
@@ -5912,6 +5976,7 @@ Yap_RemoveClauseFromIndex(PredEntry *ap, yamop *beg) {
   if (ap->PredFlags & MegaClausePredFlag) {
     return;
   }
+  cint.CurrentPred = ap;
   cint.expand_block = NULL;
   cint.CodeStart = cint.BlobsStart = cint.cpc = cint.icpc = NULL;
   if ((cb = sigsetjmp(cint.CompilerBotch, 0)) == 3) {
@@ -5930,6 +5995,7 @@ Yap_RemoveClauseFromIndex(PredEntry *ap, yamop *beg) {
   LOCAL_Error_Size = 0;
   LOCAL_ErrorMessage = NULL;
   cint.term_depth = cint.last_index_new_depth = cint.last_depth_size = 0L;
+  reset_index_stats(&cint);
   if (cb) {
     /* cannot rely on the code */
     if (ap->PredFlags & LogUpdatePredFlag) {
@@ -6007,6 +6073,8 @@ Yap_RemoveClauseFromIndex(PredEntry *ap, yamop *beg) {
     ap->OpcodeOfPred = Yap_opcode(_op_fail);
   } else if (ap->PredFlags & IndexedPredFlag)  {
     remove_from_index(ap, sp, &cl, beg, last, &cint); 
+    INDEX_STAT_ADD(Yap_IndexUpdates, 1);
+    commit_index_stats(&cint, NULL);
   }
 }
 	     
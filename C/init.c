@@ -1023,6 +1023,7 @@ InitAtoms(void)
     INIT_RWLOCK(HashChain[i].AERWLock);
     HashChain[i].Entry = NIL;
   }
+  INIT_RWLOCK(AtomTableRWLock);
   NOfAtoms = 0;
 #if THREADS
   SF_STORE->AtFoundVar = Yap_LookupAtom("**");
@@ -1172,7 +1173,10 @@ void
 Yap_CloseScratchPad(void)
 {
   CACHE_REGS
-  Yap_FreeCodeSpace(LOCAL_ScratchPad.ptr);
+  /* the scratch pad comes from malloc(), it is not code space */
+  if (LOCAL_ScratchPad.ptr)
+    free(LOCAL_ScratchPad.ptr);
+  LOCAL_ScratchPad.ptr = NULL;
   LOCAL_ScratchPad.sz = SCRATCH_START_SIZE;
   LOCAL_ScratchPad.msz = SCRATCH_START_SIZE;
 }
@@ -26,6 +26,15 @@
 #if HAVE_STRING_H
 #include <string.h>
 #endif
+#if HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#if HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
 
 #include "qly.h"
 
@@ -47,6 +56,29 @@ typedef enum {
   BAD_READ = 11
 } qlfr_err_t;
 
+/* what loading costs us, times in microseconds */
+static UInt qly_files, qly_symbols_time, qly_clauses_time;
+
+#define QLY_STAT_ADD(V, N) __atomic_add_fetch(&(V), (N), __ATOMIC_RELAXED)
+
+typedef struct qlyr_input {
+  IOSTREAM *stream;
+  char *base, *cur, *end;	/* the file, if we could buffer it */
+} qlyr_input_t;
+
+static UInt
+qly_usec(void)
+{
+#if HAVE_GETTIMEOFDAY
+  struct timeval tp;
+
+  gettimeofday(&tp, NULL);
+  return (UInt)tp.tv_sec*1000000+tp.tv_usec;
+#else
+  return Yap_walltime()*1000;
+#endif
+}
+
 static char *
 Yap_AlwaysAllocCodeSpace(UInt size)
 {
@@ -277,9 +309,13 @@ static LogUpdClause *
 LookupMayFailDBRef(DBRef dbr)
 {
   CACHE_REGS
-  CELL hash = (CELL)(dbr) % LOCAL_ImportDBRefHashTableSize;
+  CELL hash;
   import_dbref_hash_entry_t *p;
 
+  /* a module may well have no references */
+  if (!LOCAL_ImportDBRefHashTableSize)
+    return NULL;
+  hash = (CELL)(dbr) % LOCAL_ImportDBRefHashTableSize;
   p = LOCAL_ImportDBRefHashChain[hash];
   while (p) {
     if (p->oval == dbr) {
@@ -391,6 +427,37 @@ CloseHash(void)
   LOCAL_ImportDBRefHashChain = NULL;
 }
 
+/*
+ * Read the rest of a regular file into a buffer, and parse it from
+ * there rather than through the stream. The buffer goes as soon as
+ * the file is loaded.
+ */
+static void
+BufferInput(qlyr_input_t *in)
+{
+  IOSTREAM *stream = in->stream;
+  struct stat st;
+  int64_t pos;
+  size_t size, got;
+  char *base;
+  int fd;
+
+  if (!(stream->flags & SIO_FILE) ||
+      (fd = Sfileno(stream)) < 0 ||
+      fstat(fd, &st) < 0 ||
+      !S_ISREG(st.st_mode) ||
+      (pos = Stell64(stream)) < 0 ||
+      pos >= st.st_size)
+    return;
+  size = st.st_size-pos;
+  if (!(base = malloc(size)))
+    return;
+  /* if the file shrank meanwhile, read_bytes() reports BAD_READ */
+  got = Sfread(base, 1, size, stream);
+  in->base = in->cur = base;
+  in->end = base+got;
+}
+
 static inline Atom
 AtomAdjust(Atom a)
 {
@@ -607,6 +674,8 @@ XAdjust__ (wamreg reg USES_REGS)
 
 #define RestoreSWIHash()
 
+#define RestoreExoIndex(P)
+
 #define Yap_op_from_opcode(OP) OpcodeID(OP)
 
 #include "rheap.h"
@@ -623,19 +692,31 @@ RestoreAtomList(Atom atm USES_REGS)
 }
 
 static size_t
-read_bytes(IOSTREAM *stream, void *ptr, size_t sz)
+read_bytes(qlyr_input_t *stream, void *ptr, size_t sz)
 {
-  return Sfread(ptr, sz, 1, stream);
+  if (stream->cur) {
+    if ((size_t)(stream->end-stream->cur) < sz)
+      QLYR_ERROR(BAD_READ);
+    memcpy(ptr, stream->cur, sz);
+    stream->cur += sz;
+    return 1;
+  }
+  return Sfread(ptr, sz, 1, stream->stream);
 }
 
 static unsigned char
-read_byte(IOSTREAM *stream)
+read_byte(qlyr_input_t *stream)
 {
-  return  Sgetc(stream);
+  if (stream->cur) {
+    if (stream->cur == stream->end)
+      QLYR_ERROR(BAD_READ);
+    return *(unsigned char *)stream->cur++;
+  }
+  return  Sgetc(stream->stream);
 }
 
 static BITS16
-read_bits16(IOSTREAM *stream)
+read_bits16(qlyr_input_t *stream)
 {
   BITS16 v;
   read_bytes(stream, &v, sizeof(BITS16));
@@ -643,7 +724,7 @@ read_bits16(IOSTREAM *stream)
 }
 
 static UInt
-read_uint(IOSTREAM *stream)
+read_uint(qlyr_input_t *stream)
 {
   UInt v;
   read_bytes(stream, &v, sizeof(UInt));
@@ -651,7 +732,7 @@ read_uint(IOSTREAM *stream)
 }
 
 static int
-read_int(IOSTREAM *stream)
+read_int(qlyr_input_t *stream)
 {
   int v;
   read_bytes(stream, &v, sizeof(int));
@@ -659,24 +740,77 @@ read_int(IOSTREAM *stream)
 }
 
 static qlf_tag_t
-read_tag(IOSTREAM *stream)
+read_tag(qlyr_input_t *stream)
 {
   int ch = read_byte(stream);
   return ch;
 }
 
 static void
-read_header(IOSTREAM *stream)
+read_header(qlyr_input_t *stream)
 {
   int ch;
   while ((ch = read_byte(stream)));
 }
 
+/*
+ * Yap_FullLookupAtom() walks the chain of hidden atoms for every new
+ * atom, and the boot code hides many atoms: index them once instead.
+ */
+static Atom *
+HashInvisibleAtoms(UInt *sizep)
+{
+  AtomEntry *chain;
+  Atom *table = NULL;
+  UInt n = 0, size;
+
+  READ_LOCK(INVISIBLECHAIN.AERWLock);
+  chain = RepAtom(INVISIBLECHAIN.Entry);
+  while (!EndOfPAEntr(chain)) {
+    n++;
+    chain = RepAtom(chain->NextOfAE);
+  }
+  size = 2*n+1;
+  if ((table = (Atom *)calloc(size, sizeof(Atom)))) {
+    chain = RepAtom(INVISIBLECHAIN.Entry);
+    while (!EndOfPAEntr(chain)) {
+      if (!IsWideAtom(AbsAtom(chain))) {
+	UInt h = HashFunction((unsigned char *)chain->StrOfAE) % size;
+
+	while (table[h])
+	  h = (h+1) % size;
+	table[h] = AbsAtom(chain);
+      }
+      chain = RepAtom(chain->NextOfAE);
+    }
+  }
+  READ_UNLOCK(INVISIBLECHAIN.AERWLock);
+  *sizep = size;
+  return table;
+}
+
+static Atom
+LookupImportedAtom(char *rep, Atom *hidden, UInt size)
+{
+  UInt h;
+
+  if (!hidden)
+    return Yap_FullLookupAtom(rep);
+  h = HashFunction((unsigned char *)rep) % size;
+  while (hidden[h]) {
+    if (!strcmp(RepAtom(hidden[h])->StrOfAE, rep))
+      return hidden[h];
+    h = (h+1) % size;
+  }
+  return Yap_LookupAtom(rep);
+}
+
 static void
-ReadHash(IOSTREAM *stream)
+ReadHash(qlyr_input_t *stream)
 {
   CACHE_REGS
-  UInt i;
+  UInt i, hidden_size;
+  Atom *hidden;
   RCHECK(read_tag(stream) == QLY_START_X);
   LOCAL_XDiff = (char *)(&ARG1) - (char *)read_uint(stream);
   RCHECK(read_tag(stream) == QLY_START_OPCODES);
@@ -688,6 +822,7 @@ ReadHash(IOSTREAM *stream)
   LOCAL_ImportAtomHashTableNum = read_uint(stream);
   LOCAL_ImportAtomHashTableSize = LOCAL_ImportAtomHashTableNum*2;
   LOCAL_ImportAtomHashChain = (import_atom_hash_entry_t **)calloc(LOCAL_ImportAtomHashTableSize, sizeof(import_atom_hash_entry_t *));
+  hidden = HashInvisibleAtoms(&hidden_size);
   for (i = 0; i < LOCAL_ImportAtomHashTableNum; i++) {
     Atom oat = (Atom)read_uint(stream);
     Atom at;
@@ -713,7 +848,7 @@ ReadHash(IOSTREAM *stream)
       len = read_uint(stream);
       if (!EnoughTempSpace(len)) QLYR_ERROR(OUT_OF_TEMP_SPACE);
       read_bytes(stream, rep, (len+1)*sizeof(char));
-      while (!(at = Yap_FullLookupAtom(rep))) {
+      while (!(at = LookupImportedAtom(rep, hidden, hidden_size))) {
 	if (!Yap_growheap(FALSE, 0, NULL)) {
 	  exit(1);
 	}
@@ -725,6 +860,7 @@ ReadHash(IOSTREAM *stream)
     }
     InsertAtom(oat, at);
   }
+  free(hidden);
   /* functors */
   RCHECK(read_tag(stream) == QLY_START_FUNCTORS);
   LOCAL_ImportFunctorHashTableNum = read_uint(stream);
@@ -812,7 +948,7 @@ ReadHash(IOSTREAM *stream)
 }
 
 static void
-read_clauses(IOSTREAM *stream, PredEntry *pp, UInt nclauses, UInt flags) {
+read_clauses(qlyr_input_t *stream, PredEntry *pp, UInt nclauses, UInt flags) {
   CACHE_REGS
   if (pp->PredFlags & LogUpdatePredFlag) {
     /* first, clean up whatever was there */
@@ -907,7 +1043,7 @@ read_clauses(IOSTREAM *stream, PredEntry *pp, UInt nclauses, UInt flags) {
 }
 
 static void
-read_pred(IOSTREAM *stream, Term mod) {
+read_pred(qlyr_input_t *stream, Term mod) {
   UInt flags;
   UInt nclauses, fl1;
   PredEntry *ap;
@@ -915,7 +1051,11 @@ read_pred(IOSTREAM *stream, Term mod) {
   ap = LookupPredEntry((PredEntry *)read_uint(stream));
   flags = read_uint(stream);
   nclauses = read_uint(stream);
-  if (ap->PredFlags & IndexedPredFlag) {
+  /* drop the old clauses while the flags still say what they are:
+     indexing may have turned them into a mega clause meanwhile */
+  if (!(ap->PredFlags & SYSTEM_PRED_FLAGS)) {
+    Yap_Abolish(ap);
+  } else if (ap->PredFlags & IndexedPredFlag) {
     Yap_RemoveIndexation(ap);
   }
   fl1 = flags & STATIC_PRED_FLAGS;
@@ -937,7 +1077,7 @@ read_pred(IOSTREAM *stream, Term mod) {
 }
 
 static void
-read_ops(IOSTREAM *stream)  {
+read_ops(qlyr_input_t *stream)  {
   Int x;
   while ((x = read_tag(stream)) != QLY_END_OPS) {
     Atom at = (Atom)read_uint(stream);
@@ -957,13 +1097,18 @@ read_ops(IOSTREAM *stream)  {
 
 
 static void
-read_module(IOSTREAM *stream) {
-  CACHE_REGS
+read_module(IOSTREAM *s) {
   qlf_tag_t x;
+  qlyr_input_t input, *stream = &input;
+  UInt t0 = qly_usec(), t1;
 
+  input.stream = s;
+  input.base = input.cur = input.end = NULL;
+  BufferInput(stream);
   InitHash();
   read_header(stream);
   ReadHash(stream);
+  t1 = qly_usec();
   while ((x = read_tag(stream)) == QLY_START_MODULE) {
     Term mod = (Term)read_uint(stream);
 
@@ -974,7 +1119,12 @@ read_module(IOSTREAM *stream) {
     }
   }
   read_ops(stream);
+  QLY_STAT_ADD(qly_files, 1);
+  QLY_STAT_ADD(qly_symbols_time, t1-t0);
+  QLY_STAT_ADD(qly_clauses_time, qly_usec()-t1);
   CloseHash();
+  if (stream->base)
+    free(stream->base);
 }
 
 static Int
@@ -998,6 +1148,15 @@ p_read_module_preds( USES_REGS1 )
   return TRUE;
 }
 
+static Int
+p_qload_statistics( USES_REGS1 )
+{
+  return
+    Yap_unify(ARG1, MkIntegerTerm(qly_files)) &&
+    Yap_unify(ARG2, MkIntegerTerm(qly_symbols_time)) &&
+    Yap_unify(ARG3, MkIntegerTerm(qly_clauses_time));
+}
+
 static void
 ReInitProlog(void)
 {
@@ -1056,6 +1215,7 @@ void Yap_InitQLYR(void)
 {
   Yap_InitCPred("$qload_module_preds", 1, p_read_module_preds, SyncPredFlag|HiddenPredFlag|UserCPredFlag);
   Yap_InitCPred("$qload_program", 1, p_read_program, SyncPredFlag|HiddenPredFlag|UserCPredFlag);
+  Yap_InitCPred("$qload_statistics", 3, p_qload_statistics, SafePredFlag|HiddenPredFlag);
   if (FALSE) {
     restore_codes();
   }
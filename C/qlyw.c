@@ -507,6 +507,8 @@ DBRefAdjust__ (DBRef dbt USES_REGS)
 
 #define RestoreSWIHash()
 
+#define RestoreExoIndex(P)
+
 #include "rheap.h"
 
 static void
@@ -763,11 +765,22 @@ save_ops(IOSTREAM *stream, Term mod) {
   return 1;
 }
 
+static int
+save_header(IOSTREAM *stream)
+{
+  char     msg[256];
+
+  sprintf(msg, "#!/bin/sh\nexec_dir=${YAPBINDIR:-%s}\nexec $exec_dir/yap $0 \"$@\"\n%s", YAP_BINDIR, YAP_SVERSION);
+  return save_bytes(stream, msg, strlen(msg)+1);
+}
+
 static size_t
 save_module(IOSTREAM *stream, Term mod) {
   CACHE_REGS
   PredEntry *ap = Yap_ModulePred(mod);
   InitHash();
+  /* the loader always expects a header */
+  save_header( stream );
   ModuleAdjust(mod);
   while (ap) {
     ap = PredEntryAdjust(ap);
@@ -792,15 +805,6 @@ save_module(IOSTREAM *stream, Term mod) {
   return 1;
 }
 
-static int
-save_header(IOSTREAM *stream)
-{
-  char     msg[256];
-
-  sprintf(msg, "#!/bin/sh\nexec_dir=${YAPBINDIR:-%s}\nexec $exec_dir/yap $0 \"$@\"\n%s", YAP_BINDIR, YAP_SVERSION);
-  return save_bytes(stream, msg, strlen(msg)+1);
-}
-
 static size_t
 save_program(IOSTREAM *stream) {
   CACHE_REGS
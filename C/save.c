@@ -1200,6 +1200,12 @@ RestoreSWIHash(void)
   Yap_InitSWIHash();
 }
 
+static void
+RestoreExoIndex(PredEntry *ap)
+{
+  Yap_ExoRehash(ap);
+}
+
 
 #include "rheap.h"
 
@@ -1329,6 +1335,8 @@ restore_heap(void)
 {
   restore_codes();
   RestoreIOStructures();
+  /* the atoms we knew about were in the old heap */
+  Yap_ResetYoungAtoms();
 }
 
 
@@ -15,11 +15,27 @@
 *									 *
 *************************************************************************/
 
-/* for the moment, follow Prolog's traditional mergesort */
+/*
+  Generic lists follow Prolog's traditional mergesort. Lists whose keys
+  are all small integers, all floats or all atoms are sorted by a
+  specialised engine: radix sort for integers, and a merge sort with a
+  direct comparison for floats and atoms, that runs over several
+  threads for large lists.
+*/
 
 #include "Yap.h"
 #include "Yatom.h"
 #include "YapHeap.h"
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+#include <stdlib.h>
+#if THREADS
+#include <pthread.h>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#endif
 #ifndef NULL
 #define NULL (void *)0
 #endif
@@ -31,11 +47,14 @@
 STATIC_PROTO(Int build_new_list, (CELL *, Term CACHE_TYPE));
 STATIC_PROTO(void simple_mergesort, (CELL *, Int, int));
 STATIC_PROTO(Int compact_mergesort, (CELL *, Int, int));
-STATIC_PROTO(int key_mergesort, (CELL *, Int, int, Functor));
+STATIC_PROTO(int key_mergesort, (CELL *, Int, int, Functor, Int (*)(Term, Term)));
+STATIC_PROTO(Int compare_bagof_keys, (Term, Term));
 STATIC_PROTO(void adjust_vector, (CELL *, Int));
 STATIC_PROTO(Int p_sort, ( USES_REGS1 ));
 STATIC_PROTO(Int p_msort, ( USES_REGS1 ));
 STATIC_PROTO(Int p_ksort, ( USES_REGS1 ));
+STATIC_PROTO(Int p_bagof_groups, ( USES_REGS1 ));
+STATIC_PROTO(Int p_sort4, ( USES_REGS1 ));
 
 /* copy to a new list of terms */
 static Int
@@ -144,7 +163,7 @@ void simple_mergesort(CELL *pt, Int size, int my_p)
 
 /* copy to a new list of terms */
 static
-int key_mergesort(CELL *pt, Int size, int my_p, Functor FuncDMinus)
+int key_mergesort(CELL *pt, Int size, int my_p, Functor FuncDMinus, Int (*cmp)(Term, Term))
 {
 
   if (size > 2) {
@@ -155,9 +174,9 @@ int key_mergesort(CELL *pt, Int size, int my_p, Functor FuncDMinus)
     pt_right = pt + half_size*2;
     left_p = my_p^1;
     right_p = my_p;
-    if (!key_mergesort(pt, half_size, left_p, FuncDMinus))
+    if (!key_mergesort(pt, half_size, left_p, FuncDMinus, cmp))
       return(FALSE);
-    if (!key_mergesort(pt_right, size-half_size, right_p, FuncDMinus))
+    if (!key_mergesort(pt_right, size-half_size, right_p, FuncDMinus, cmp))
       return(FALSE);
     /* now implement a simple merge routine */
     
@@ -181,7 +200,7 @@ int key_mergesort(CELL *pt, Int size, int my_p, Functor FuncDMinus)
       if (IsVarTerm(t1) || !IsApplTerm(t1) || FunctorOfTerm(t1) != FuncDMinus)
 	return(FALSE);
       t1 = ArgOfTerm(1,t1);
-      if (Yap_compare_terms(t0, t1) <= 0) {
+      if (cmp(t0, t1) <= 0) {
 	/* copy the one to the left */
 	pt[0] = pt_left[0];
 	/* and avance the two pointers */
@@ -218,7 +237,7 @@ int key_mergesort(CELL *pt, Int size, int my_p, Functor FuncDMinus)
       if (IsVarTerm(t1) || !IsApplTerm(t1) || FunctorOfTerm(t1) != FuncDMinus)
 	return(FALSE);
       t1 = ArgOfTerm(1,t1);
-      if (Yap_compare_terms(t0,t1) > 0) {
+      if (cmp(t0,t1) > 0) {
 	CELL t = pt[2];
 	pt[2+my_p] = pt[0];
 	pt[my_p] = t;
@@ -328,6 +347,395 @@ Int compact_mergesort(CELL *pt, Int size, int my_p)
   }
 }
 
+/* what the sorting engine knows about the keys */
+#define SORT_KEY_INT   0
+#define SORT_KEY_FLOAT 1
+#define SORT_KEY_ATOM  2
+#define SORT_KEY_ANY   3
+
+/* return codes for engine_sort */
+#define SORT_GENERIC     (-1)
+#define SORT_BAD_ELEMENT (-2)
+#define SORT_NO_MEMORY   (-3)
+
+/* below this size the traditional mergesorts are just as good */
+#define SORT_ENGINE_MIN   16
+/* runs sorted by insertion before merging */
+#define SORT_RUN          16
+#if THREADS
+/* each worker thread gets at least this many elements */
+#define SORT_PARALLEL_MIN (32*1024)
+#define SORT_MAX_WORKERS  8
+#endif
+
+typedef struct sort_item {
+  union {
+    Int i;
+    Float f;
+    char *s;
+    Term t;
+  } key;
+  CELL val;
+} sort_item;
+
+typedef Int (*sort_cmp)(const sort_item *, const sort_item *);
+
+static Int
+cmp_int_items(const sort_item *a, const sort_item *b)
+{
+  return (a->key.i > b->key.i) - (a->key.i < b->key.i);
+}
+
+static Int
+cmp_float_items(const sort_item *a, const sort_item *b)
+{
+  /* same as compare/3 */
+  Float dif = a->key.f - b->key.f;
+  return (dif > 0.0 ? 1 : (dif == 0.0 ? 0 : -1));
+}
+
+static Int
+cmp_atom_items(const sort_item *a, const sort_item *b)
+{
+  return strcmp(a->key.s, b->key.s);
+}
+
+static Int
+cmp_any_items(const sort_item *a, const sort_item *b)
+{
+  return Yap_compare_terms(a->key.t, b->key.t);
+}
+
+/* merge two sorted runs, taking from the left on ties */
+static void
+merge_items(sort_item *l, Int nl, sort_item *r, Int nr, sort_item *out, sort_cmp cmp, int desc)
+{
+  sort_item *lend = l+nl, *rend = r+nr;
+
+  while (l < lend && r < rend) {
+    Int c = cmp(l, r);
+    if (desc)
+      c = -c;
+    if (c <= 0)
+      *out++ = *l++;
+    else
+      *out++ = *r++;
+  }
+  while (l < lend)
+    *out++ = *l++;
+  while (r < rend)
+    *out++ = *r++;
+}
+
+/* stable bottom-up merge sort, tmp must hold n items */
+static void
+mergesort_items(sort_item *a, sort_item *tmp, Int n, sort_cmp cmp, int desc)
+{
+  sort_item *src = a, *dst = tmp;
+  Int i, width;
+
+  for (i = 0; i < n; i += SORT_RUN) {
+    Int j, end = (i+SORT_RUN < n ? i+SORT_RUN : n);
+
+    for (j = i+1; j < end; j++) {
+      sort_item x = a[j];
+      Int k = j;
+
+      while (k > i) {
+	Int c = cmp(a+k-1, &x);
+	if (desc)
+	  c = -c;
+	if (c <= 0)
+	  break;
+	a[k] = a[k-1];
+	k--;
+      }
+      a[k] = x;
+    }
+  }
+  for (width = SORT_RUN; width < n; width *= 2) {
+    for (i = 0; i < n; i += 2*width) {
+      Int nl = (i+width < n ? width : n-i);
+      Int nr = (i+2*width < n ? width : n-i-nl);
+      merge_items(src+i, nl, src+i+nl, nr, dst+i, cmp, desc);
+    }
+    src = dst;
+    dst = (src == a ? tmp : a);
+  }
+  if (src != a)
+    memcpy(a, src, n*sizeof(sort_item));
+}
+
+/* digits of the radix sort */
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+/*
+  stable LSD radix sort of the integer keys, taken as offsets from the
+  smallest (largest, if descending) key, so that only the digits that
+  actually vary need a pass
+*/
+static void
+radixsort_items(sort_item *a, sort_item *tmp, Int n, int desc)
+{
+  UInt count[RADIX_SIZE];
+  sort_item *src = a, *dst = tmp;
+  Int i, min = a[0].key.i, max = a[0].key.i;
+  UInt range;
+  unsigned int shift;
+
+  for (i = 1; i < n; i++) {
+    Int k = a[i].key.i;
+    if (k < min)
+      min = k;
+    else if (k > max)
+      max = k;
+  }
+  range = (UInt)max-(UInt)min;
+  for (shift = 0; shift < 8*sizeof(UInt) && (range >> shift); shift += RADIX_BITS) {
+    UInt acc = 0;
+    unsigned int b;
+
+    memset(count, 0, sizeof(count));
+    for (i = 0; i < n; i++) {
+      UInt u = (desc ? (UInt)max-(UInt)src[i].key.i : (UInt)src[i].key.i-(UInt)min);
+      count[(u >> shift) & (RADIX_SIZE-1)]++;
+    }
+    for (b = 0; b < RADIX_SIZE; b++) {
+      UInt c = count[b];
+      count[b] = acc;
+      acc += c;
+    }
+    for (i = 0; i < n; i++) {
+      UInt u = (desc ? (UInt)max-(UInt)src[i].key.i : (UInt)src[i].key.i-(UInt)min);
+      dst[count[(u >> shift) & (RADIX_SIZE-1)]++] = src[i];
+    }
+    src = dst;
+    dst = (src == a ? tmp : a);
+  }
+  if (src != a)
+    memcpy(a, src, n*sizeof(sort_item));
+}
+
+#if THREADS
+
+typedef struct sort_job {
+  sort_item *a, *tmp, *r, *out;
+  Int n, nr;
+  sort_cmp cmp;
+  int desc;
+} sort_job;
+
+static void *
+sort_worker(void *arg)
+{
+  sort_job *job = (sort_job *)arg;
+
+  mergesort_items(job->a, job->tmp, job->n, job->cmp, job->desc);
+  return NULL;
+}
+
+static void *
+merge_worker(void *arg)
+{
+  sort_job *job = (sort_job *)arg;
+
+  merge_items(job->a, job->n, job->r, job->nr, job->out, job->cmp, job->desc);
+  return NULL;
+}
+
+/* run one job per thread, doing the work here if no thread is available */
+static void
+run_sort_jobs(void *(*worker)(void *), sort_job *jobs, int njobs)
+{
+  pthread_t tids[SORT_MAX_WORKERS];
+  int started[SORT_MAX_WORKERS];
+  int i;
+
+  for (i = 1; i < njobs; i++)
+    started[i] = (pthread_create(tids+i, NULL, worker, jobs+i) == 0);
+  worker(jobs);
+  for (i = 1; i < njobs; i++) {
+    if (started[i])
+      pthread_join(tids[i], NULL);
+    else
+      worker(jobs+i);
+  }
+}
+
+static int
+sort_workers(Int n)
+{
+  long ncpus = 1;
+  int nw;
+
+#ifdef _SC_NPROCESSORS_ONLN
+  ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  nw = (ncpus > SORT_MAX_WORKERS ? SORT_MAX_WORKERS : (ncpus < 1 ? 1 : (int)ncpus));
+  while (nw > 1 && n/nw < SORT_PARALLEL_MIN)
+    nw--;
+  return nw;
+}
+
+/* sort chunks in parallel, then merge them pairwise, also in parallel */
+static void
+parallel_mergesort_items(sort_item *a, sort_item *tmp, Int n, sort_cmp cmp, int desc)
+{
+  sort_job jobs[SORT_MAX_WORKERS];
+  Int bounds[SORT_MAX_WORKERS+1];
+  sort_item *src = a, *dst = tmp;
+  int nw = sort_workers(n), i;
+
+  if (nw < 2) {
+    mergesort_items(a, tmp, n, cmp, desc);
+    return;
+  }
+  for (i = 0; i <= nw; i++)
+    bounds[i] = (n/nw)*i;
+  bounds[nw] = n;
+  for (i = 0; i < nw; i++) {
+    jobs[i].a = a+bounds[i];
+    jobs[i].tmp = tmp+bounds[i];
+    jobs[i].n = bounds[i+1]-bounds[i];
+    jobs[i].cmp = cmp;
+    jobs[i].desc = desc;
+  }
+  run_sort_jobs(sort_worker, jobs, nw);
+  while (nw > 1) {
+    int nj = 0;
+
+    for (i = 0; i+1 < nw; i += 2) {
+      jobs[nj].a = src+bounds[i];
+      jobs[nj].n = bounds[i+1]-bounds[i];
+      jobs[nj].r = src+bounds[i+1];
+      jobs[nj].nr = bounds[i+2]-bounds[i+1];
+      jobs[nj].out = dst+bounds[i];
+      jobs[nj].cmp = cmp;
+      jobs[nj].desc = desc;
+      bounds[nj] = bounds[i];
+      nj++;
+    }
+    if (i < nw) {
+      /* odd run out, just move it along */
+      memcpy(dst+bounds[i], src+bounds[i], (bounds[i+1]-bounds[i])*sizeof(sort_item));
+      bounds[nj] = bounds[i];
+      nw = nj+1;
+    } else {
+      nw = nj;
+    }
+    bounds[nw] = n;
+    run_sort_jobs(merge_worker, jobs, nj);
+    src = dst;
+    dst = (src == a ? tmp : a);
+  }
+  if (src != a)
+    memcpy(a, src, n*sizeof(sort_item));
+}
+
+#endif /* THREADS */
+
+/*
+  The engine: sort the size elements at the even positions of pt by
+  their key, the whole element if key_arg is 0, or else argument key_arg
+  (of a key_f term, if key_f is given). Leaves the result at the even
+  positions and returns the new size. Unless any_key is set, it only
+  takes lists whose keys are all small integers, all floats, or all
+  atoms, and returns SORT_GENERIC otherwise.
+*/
+static Int
+engine_sort(CELL *pt, Int size, UInt key_arg, Functor key_f, int desc, int dedup, int any_key, Term *bad)
+{
+  sort_item *items, *tmp;
+  sort_cmp cmp;
+  int kind = -1;
+  Int i, n;
+
+  for (i = 0; i < size; i++) {
+    Term t = Deref(pt[2*i]), k = t;
+    int kk;
+
+    if (key_arg) {
+      if (IsVarTerm(t) || !IsApplTerm(t) ||
+	  (key_f && FunctorOfTerm(t) != key_f) ||
+	  IsExtensionFunctor(FunctorOfTerm(t)) ||
+	  ArityOfFunctor(FunctorOfTerm(t)) < key_arg) {
+	*bad = t;
+	return SORT_BAD_ELEMENT;
+      }
+      k = Deref(ArgOfTerm(key_arg, t));
+    }
+    if (IsIntTerm(k))
+      kk = SORT_KEY_INT;
+    else if (IsFloatTerm(k))
+      kk = SORT_KEY_FLOAT;
+    else if (IsAtomTerm(k) && !IsWideAtom(AtomOfTerm(k)))
+      kk = SORT_KEY_ATOM;
+    else
+      kk = SORT_KEY_ANY;
+    if (kind < 0)
+      kind = kk;
+    else if (kind != kk)
+      kind = SORT_KEY_ANY;
+    if (kind == SORT_KEY_ANY && !any_key)
+      return SORT_GENERIC;
+  }
+  if (kind < 0)
+    return 0;
+  items = (sort_item *)malloc(2*size*sizeof(sort_item));
+  if (!items)
+    return SORT_NO_MEMORY;
+  tmp = items+size;
+  for (i = 0; i < size; i++) {
+    Term t = pt[2*i], k = Deref(t);
+
+    if (key_arg)
+      k = Deref(ArgOfTerm(key_arg, k));
+    switch (kind) {
+    case SORT_KEY_INT:
+      items[i].key.i = IntOfTerm(k);
+      break;
+    case SORT_KEY_FLOAT:
+      items[i].key.f = FloatOfTerm(k);
+      break;
+    case SORT_KEY_ATOM:
+      items[i].key.s = RepAtom(AtomOfTerm(k))->StrOfAE;
+      break;
+    default:
+      items[i].key.t = k;
+    }
+    items[i].val = t;
+  }
+  switch (kind) {
+  case SORT_KEY_INT:
+    cmp = cmp_int_items;
+    radixsort_items(items, tmp, size, desc);
+    break;
+  case SORT_KEY_FLOAT:
+  case SORT_KEY_ATOM:
+    cmp = (kind == SORT_KEY_FLOAT ? cmp_float_items : cmp_atom_items);
+#if THREADS
+    parallel_mergesort_items(items, tmp, size, cmp, desc);
+#else
+    mergesort_items(items, tmp, size, cmp, desc);
+#endif
+    break;
+  default:
+    /* Yap_compare_terms uses the worker's scratch space, stay sequential */
+    cmp = cmp_any_items;
+    mergesort_items(items, tmp, size, cmp, desc);
+  }
+  for (i = 0, n = 0; i < size; i++) {
+    if (dedup && n && cmp(items+i, tmp+n-1) == 0)
+      continue;
+    tmp[n] = items[i];
+    pt[2*n] = items[i].val;
+    n++;
+  }
+  free(items);
+  return n;
+}
+
 static void
 adjust_vector(CELL *pt, Int size)
 {
@@ -347,9 +755,9 @@ p_sort( USES_REGS1 )
 {
   /* use the heap to build a new list */
   CELL *pt = H;
-  Term out;
+  Term out, bad;
   /* list size */
-  Int size;
+  Int size, nsize;
   size = build_new_list(pt, Deref(ARG1) PASS_REGS);
   if (size < 0)
     return(FALSE);
@@ -359,7 +767,10 @@ p_sort( USES_REGS1 )
   /* make sure no one writes on our temp data structure */
   H += size*2;
   /* reserve the necessary space */
-  size = compact_mergesort(pt, size, M_EVEN);
+  if (size < SORT_ENGINE_MIN ||
+      (nsize = engine_sort(pt, size, 0, NULL, FALSE, TRUE, FALSE, &bad)) < 0)
+    nsize = compact_mergesort(pt, size, M_EVEN);
+  size = nsize;
   /* reajust space */
   H = pt+size*2;
   adjust_vector(pt, size);
@@ -372,7 +783,7 @@ p_msort( USES_REGS1 )
 {
   /* use the heap to build a new list */
   CELL *pt = H;
-  Term out;
+  Term out, bad;
   /* list size */
   Int size;
   size = build_new_list(pt, Deref(ARG1) PASS_REGS);
@@ -383,7 +794,9 @@ p_msort( USES_REGS1 )
   pt = H;            /* because of possible garbage collection */
   /* reserve the necessary space */
   H += size*2;
-  simple_mergesort(pt, size, M_EVEN);
+  if (size < SORT_ENGINE_MIN ||
+      engine_sort(pt, size, 0, NULL, FALSE, FALSE, FALSE, &bad) < 0)
+    simple_mergesort(pt, size, M_EVEN);
   adjust_vector(pt, size);
   out = AbsPair(pt);
   return(Yap_unify(out, ARG2));
@@ -394,9 +807,9 @@ p_ksort( USES_REGS1 )
 {
   /* use the heap to build a new list */
   CELL *pt = H;
-  Term out;
+  Term out, bad;
   /* list size */
-  Int size;
+  Int size, nsize = SORT_GENERIC;
   size = build_new_list(pt, Deref(ARG1) PASS_REGS);
   if (size < 0)
     return(FALSE);
@@ -405,17 +818,153 @@ p_ksort( USES_REGS1 )
   /* reserve the necessary space */
   pt = H;            /* because of possible garbage collection */
   H += size*2;
-  if (!key_mergesort(pt, size, M_EVEN, FunctorMinus))
+  if (size >= SORT_ENGINE_MIN) {
+    nsize = engine_sort(pt, size, 1, FunctorMinus, FALSE, FALSE, FALSE, &bad);
+    if (nsize == SORT_BAD_ELEMENT)
+      return(FALSE);
+  }
+  if (nsize < 0 &&
+      !key_mergesort(pt, size, M_EVEN, FunctorMinus, Yap_compare_terms))
     return(FALSE);
   adjust_vector(pt, size);
   out = AbsPair(pt);
   return(Yap_unify(out, ARG2));
 }
 
+/*
+  bagof/3 keys are all '$'(V1,...,Vn): going through the standard order
+  for compound terms costs more than the arguments themselves, so just
+  compare the arguments.
+*/
+static Int
+compare_bagof_keys(Term t0, Term t1)
+{
+  t0 = Deref(t0);
+  t1 = Deref(t1);
+  if (IsApplTerm(t0) && IsApplTerm(t1) &&
+      FunctorOfTerm(t0) == FunctorOfTerm(t1) &&
+      !IsExtensionFunctor(FunctorOfTerm(t0))) {
+    UInt i, arity = ArityOfFunctor(FunctorOfTerm(t0));
+
+    for (i = 1; i <= arity; i++) {
+      Int out = Yap_compare_terms(ArgOfTerm(i,t0), ArgOfTerm(i,t1));
+      if (out)
+	return out;
+    }
+    return 0;
+  }
+  return Yap_compare_terms(t0, t1);
+}
+
+/*
+  bagof/3 support: keysort a list of Key-Value pairs and split it into
+  the list of Key-Bag groups, where Bag collects the values of
+  consecutive identical keys in order. The bags are built in place over
+  the sorting vector, only the group cells are new.
+*/
+static Int
+p_bagof_groups( USES_REGS1 )
+{
+  CELL *pt, *ptf, *end, *last = NULL;
+  Term groups = TermNil;
+  Int size;
+
+ restart:
+  pt = H;
+  size = build_new_list(pt, Deref(ARG1) PASS_REGS);
+  if (size < 0)
+    return(FALSE);
+  if (size == 0)
+    return(Yap_unify(ARG2, TermNil));
+  pt = H;            /* because of possible garbage collection */
+  /* two cells per pair for sorting, at most five per group */
+  if (pt+7*size > ASP-4096) {
+    if (!Yap_gcl(7*size*sizeof(CELL), 2, ENV, gc_P(P,CP))) {
+      Yap_Error(OUT_OF_STACK_ERROR, TermNil, LOCAL_ErrorMessage);
+      return(FALSE);
+    }
+    goto restart;
+  }
+  H += size*2;
+  if (size > 1 && !key_mergesort(pt, size, M_EVEN, FunctorMinus, compare_bagof_keys))
+    return(FALSE);
+  ptf = pt;
+  end = pt+2*size;
+  while (ptf < end) {
+    Term t = ptf[0], k;
+    CELL *bag = ptf;
+
+    if (IsVarTerm(t) || !IsApplTerm(t) || FunctorOfTerm(t) != FunctorMinus)
+      return(FALSE);
+    k = ArgOfTerm(1,t);
+    ptf[0] = ArgOfTerm(2,t);
+    ptf += 2;
+    while (ptf < end && compare_bagof_keys(k, ArgOfTerm(1,ptf[0])) == 0) {
+      ptf[-1] = AbsPair(ptf);
+      ptf[0] = ArgOfTerm(2,ptf[0]);
+      ptf += 2;
+    }
+    ptf[-1] = TermNil;
+    /* Key-Bag, followed by its list cell */
+    H[0] = (CELL)FunctorMinus;
+    H[1] = k;
+    H[2] = AbsPair(bag);
+    H[3] = AbsAppl(H);
+    H[4] = TermNil;
+    if (last)
+      last[0] = AbsPair(H+3);
+    else
+      groups = AbsPair(H+3);
+    last = H+4;
+    H += 5;
+  }
+  return(Yap_unify(groups, ARG2));
+}
+
+/*
+  '$sort'(+Key, +Order, +List, -Sorted) for sort/4: Order is 0 for @<,
+  1 for @=<, 2 for @> and 3 for @>=.
+*/
+static Int
+p_sort4( USES_REGS1 )
+{
+  CELL *pt = H;
+  Term out, bad;
+  Int size, key, order;
+
+  key = IntegerOfTerm(Deref(ARG1));
+  order = IntegerOfTerm(Deref(ARG2));
+  size = build_new_list(pt, Deref(ARG3) PASS_REGS);
+  if (size < 0)
+    return(FALSE);
+  if (size == 0)
+    return(Yap_unify(ARG3, ARG4));
+  pt = H;            /* because of possible garbage collection */
+  H += size*2;
+  size = engine_sort(pt, size, key, NULL, order >= 2, !(order & 1), TRUE, &bad);
+  if (size < 0) {
+    H = pt;
+    if (size == SORT_NO_MEMORY) {
+      Yap_Error(RESOURCE_ERROR_MEMORY, ARG3, "sort/4");
+    } else if (IsVarTerm(bad)) {
+      Yap_Error(INSTANTIATION_ERROR, bad, "sort/4");
+    } else {
+      Yap_Error(TYPE_ERROR_COMPOUND, bad, "sort/4");
+    }
+    return(FALSE);
+  }
+  H = pt+size*2;
+  adjust_vector(pt, size);
+  out = AbsPair(pt);
+  return(Yap_unify(out, ARG4));
+}
+
 void 
 Yap_InitSortPreds(void)
 {
   Yap_InitCPred("$sort", 2, p_sort, HiddenPredFlag);
   Yap_InitCPred("$msort", 2, p_msort, HiddenPredFlag);
   Yap_InitCPred("$keysort", 2, p_ksort, HiddenPredFlag);
+  Yap_InitCPred("$bagof_groups", 2, p_bagof_groups, HiddenPredFlag);
+  Yap_InitCPred("$sort", 4, p_sort4, HiddenPredFlag);
 }
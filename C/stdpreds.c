@@ -3841,7 +3841,7 @@ p_statistics_atom_info( USES_REGS1 )
       if (ncatom != NIL) {
 	READ_LOCK(RepAtom(ncatom)->ARWLock);
       }
-      READ_UNLOCK(RepAtom(ncatom)->ARWLock);
+      READ_UNLOCK(RepAtom(catom)->ARWLock);
       catom = ncatom;
     }
   }
@@ -3862,7 +3862,7 @@ p_statistics_atom_info( USES_REGS1 )
       if (ncatom != NIL) {
 	READ_LOCK(RepAtom(ncatom)->ARWLock);
       }
-      READ_UNLOCK(RepAtom(ncatom)->ARWLock);
+      READ_UNLOCK(RepAtom(catom)->ARWLock);
       catom = ncatom;
     }
   }
@@ -3904,6 +3904,25 @@ p_statistics_lu_db_size( USES_REGS1 )
     Yap_unify(tix, ARG5);
 }
 
+static Int 
+p_statistics_index_info( USES_REGS1 )
+{
+  Term tt = MkIntegerTerm(Yap_IndexTrees);
+  Term tx = MkIntegerTerm(Yap_IndexExpansions);
+  Term tu = MkIntegerTerm(Yap_IndexUpdates);
+  Term tf = MkIntegerTerm(Yap_IndexFirstArgSwitches);
+  Term to = MkIntegerTerm(Yap_IndexOtherArgSwitches);
+  Term ts = MkIntegerTerm(Yap_IndexSubArgSwitches);
+
+  return
+    Yap_unify(tt, ARG1) &&
+    Yap_unify(tx, ARG2) &&
+    Yap_unify(tu, ARG3) &&
+    Yap_unify(tf, ARG4) &&
+    Yap_unify(to, ARG5) &&
+    Yap_unify(ts, ARG6);
+}
+
 
 
 static Term
@@ -3984,6 +4003,10 @@ p_access_yap_flags( USES_REGS1 )
 #ifdef TABLING
   if (flag == TABLING_MODE_FLAG) {
     tout = TermNil;
+    if (IsMode_Variant(yap_flags[flag]))
+      tout = MkPairTerm(MkAtomTerm(AtomVariant), tout);
+    else if (IsMode_Subsumptive(yap_flags[flag]))
+      tout = MkPairTerm(MkAtomTerm(AtomSubsumptive), tout);
     if (IsMode_LocalTrie(yap_flags[flag]))
       tout = MkPairTerm(MkAtomTerm(AtomLocalTrie), tout);
     else if (IsMode_GlobalTrie(yap_flags[flag]))
@@ -4168,6 +4191,22 @@ p_set_yap_flags( USES_REGS1 )
 	tab_ent = TabEnt_next(tab_ent);
       }
       SetMode_GlobalTrie(yap_flags[TABLING_MODE_FLAG]);
+    } else if (value == 7) {  /* variant */
+      tab_ent_ptr tab_ent = GLOBAL_root_tab_ent;
+      while(tab_ent) {
+	SetMode_Variant(TabEnt_mode(tab_ent));
+	tab_ent = TabEnt_next(tab_ent);
+      }
+      SetMode_Variant(yap_flags[TABLING_MODE_FLAG]);
+#ifdef TABLING_CALL_SUBSUMPTION
+    } else if (value == 8) {  /* subsumptive */
+      tab_ent_ptr tab_ent = GLOBAL_root_tab_ent;
+      while(tab_ent) {
+	SetMode_Subsumptive(TabEnt_mode(tab_ent));
+	tab_ent = TabEnt_next(tab_ent);
+      }
+      SetMode_Subsumptive(yap_flags[TABLING_MODE_FLAG]);
+#endif /* TABLING_CALL_SUBSUMPTION */
     } 
     break;
 #endif /* TABLING */
@@ -4435,6 +4474,7 @@ Yap_InitCPreds(void)
   Yap_InitCPred("$statistics_atom_info", 2, p_statistics_atom_info, SafePredFlag|SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$statistics_db_size", 4, p_statistics_db_size, SafePredFlag|SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$statistics_lu_db_size", 5, p_statistics_lu_db_size, SafePredFlag|SyncPredFlag|HiddenPredFlag);
+  Yap_InitCPred("$statistics_index_info", 6, p_statistics_index_info, SafePredFlag|SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$argv", 1, p_argv, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$executable", 1, p_executable, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$runtime", 2, p_runtime, SafePredFlag|SyncPredFlag|HiddenPredFlag);
@@ -4504,6 +4544,8 @@ Yap_InitCPreds(void)
   Yap_InitCoroutPreds();
   Yap_InitDBPreds();
   Yap_InitExecFs();
+  Yap_InitExoPreds();
+  Yap_InitFastIO();
   Yap_InitGlobals();
   Yap_InitInlines();
   Yap_InitIOPreds();
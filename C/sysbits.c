@@ -2819,6 +2819,14 @@ p_first_signal( USES_REGS1 )
     UNLOCK(LOCAL_SignalLock);
     return Yap_unify(ARG1, MkAtomTerm(AtomSigVTAlarm));
   }
+  if (LOCAL_ActiveSignals & YAP_PROF_SIGNAL) {
+    LOCAL_ActiveSignals &= ~YAP_PROF_SIGNAL;
+#ifdef THREADS
+    pthread_mutex_unlock(&(LOCAL_ThreadHandle.tlock));
+#endif  
+    UNLOCK(LOCAL_SignalLock);
+    return Yap_unify(ARG1, MkAtomTerm(AtomSigProf));
+  }
   if (LOCAL_ActiveSignals & YAP_DELAY_CREEP_SIGNAL) {
     LOCAL_ActiveSignals &= ~(YAP_CREEP_SIGNAL|YAP_DELAY_CREEP_SIGNAL);
 #ifdef THREADS
@@ -2915,6 +2923,9 @@ p_continue_signals( USES_REGS1 )
   if (LOCAL_ActiveSignals & YAP_VTALARM_SIGNAL) {
     Yap_signal(YAP_VTALARM_SIGNAL);
   }
+  if (LOCAL_ActiveSignals & YAP_PROF_SIGNAL) {
+    Yap_signal(YAP_PROF_SIGNAL);
+  }
   if (LOCAL_ActiveSignals & YAP_CREEP_SIGNAL) {
     Yap_signal(YAP_CREEP_SIGNAL);
   }
@@ -98,7 +98,7 @@ store_specs(int new_worker_id, UInt ssize, UInt tsize, UInt sysize, Term *tpgoal
   REMOTE_c_output_stream(new_worker_id) = LOCAL_c_output_stream;
   REMOTE_c_error_stream(new_worker_id) = LOCAL_c_error_stream;
   pm = (ssize + tsize)*1024;
-  if (!(REMOTE_ThreadHandle(new_worker_id).stack_address = malloc(pm))) {
+  if (!(REMOTE_ThreadHandle(new_worker_id).stack_address = Yap_AllocStacks(pm))) {
     return FALSE;
   }
   REMOTE_ThreadHandle(new_worker_id).tgoal =
@@ -160,6 +160,7 @@ kill_thread_engine (int wid, int always_die)
   if (REMOTE_ThreadHandle(wid).texit) {
     Yap_FreeCodeSpace((ADDR)REMOTE_ThreadHandle(wid).texit);
   }
+  Yap_FlushCodeCache(wid);
   /* FreeCodeSpace requires LOCAL requires yaam_regs */
   free(REMOTE_ThreadHandle(wid).default_yaam_regs);
   REMOTE_ThreadHandle(wid).default_yaam_regs = NULL;
@@ -810,6 +811,711 @@ p_cond_wait( USES_REGS1 )
   return TRUE;
 }
 
+/* Message Queues */
+
+/*
+ * Queues live in C and are found through a small hash table keyed on
+ * the queue id, the queue alias, or the alias of the thread owning the
+ * queue. Messages are stored as database terms, so that senders never
+ * touch the receiver's stacks. The table holds one reference to every
+ * queue, and each operation takes one more for as long as it runs: a
+ * queue destroyed while a thread is blocked on it only goes away after
+ * that thread wakes up.
+ */
+
+typedef struct mq_entry {
+  struct mq_entry *next;
+  DBTerm *msg;
+  UInt seq;			/* value of serial when it was queued */
+} MQEntry;
+
+typedef struct message_queue {
+  Int id;			/* thread id, or a negative number */
+  Atom alias;			/* NULL for anonymous queues */
+  pthread_mutex_t lock;
+  pthread_cond_t nonempty;	/* receivers wait here */
+  pthread_cond_t nonfull;	/* senders wait here on a full queue */
+  MQEntry *first, *last;
+  UInt size;
+  UInt max_size;		/* 0 if unbounded */
+  UInt spin;			/* polls before a receiver blocks */
+  UInt waiting, waiting_senders;
+  UInt serial;			/* bumped by every message sent */
+  UInt refs;
+  int destroyed;
+} MessageQueue;
+
+typedef struct mq_key {
+  struct mq_key *next;
+  Term key;
+  MessageQueue *q;
+} MQKey;
+
+#define MQ_TABLE_SIZE 256
+#define MQ_HASH(T) ((((CELL)(T)) >> 3 ^ ((CELL)(T)) >> 11) & (MQ_TABLE_SIZE-1))
+
+#if defined(__i386__) || defined(__x86_64__)
+#define MQ_RELAX() __asm__ __volatile__("pause")
+#else
+#define MQ_RELAX()
+#endif
+
+static MQKey *mq_table[MQ_TABLE_SIZE];
+static rwlock_t mq_table_lock;
+static Int mq_last_id;
+
+/* call with mq_table_lock held */
+static MQKey **
+mq_slot(Term t)
+{
+  MQKey **kp = mq_table+MQ_HASH(t);
+
+  while (*kp && (*kp)->key != t)
+    kp = &((*kp)->next);
+  return kp;
+}
+
+static int
+mq_add_key(Term t, MessageQueue *q)
+{
+  MQKey **kp = mq_slot(t), *k;
+
+  if (*kp)
+    return FALSE;
+  if (!(k = (MQKey *)Yap_AllocCodeSpace(sizeof(MQKey)))) {
+    Yap_Error(OUT_OF_HEAP_ERROR, t, "message queue");
+    return FALSE;
+  }
+  k->next = NULL;
+  k->key = t;
+  k->q = q;
+  *kp = k;
+  if (IsAtomTerm(t))
+    Yap_AtomIncreaseHold(AtomOfTerm(t));
+  return TRUE;
+}
+
+static void
+mq_del_key(MQKey **kp)
+{
+  MQKey *k = *kp;
+
+  *kp = k->next;
+  if (IsAtomTerm(k->key))
+    Yap_AtomDecreaseHold(AtomOfTerm(k->key));
+  Yap_FreeCodeSpace((char *)k);
+}
+
+/* drop every key for q; if all is false keep its id and its own alias */
+static void
+mq_del_keys(MessageQueue *q, int all)
+{
+  int i;
+
+  WRITE_LOCK(mq_table_lock);
+  for (i = 0; i < MQ_TABLE_SIZE; i++) {
+    MQKey **kp = mq_table+i;
+
+    while (*kp) {
+      MQKey *k = *kp;
+      if (k->q == q &&
+	  (all ||
+	   (k->key != MkIntTerm(q->id) &&
+	    (!q->alias || k->key != MkAtomTerm(q->alias)))))
+	mq_del_key(kp);
+      else
+	kp = &(k->next);
+    }
+  }
+  WRITE_UNLOCK(mq_table_lock);
+}
+
+static MessageQueue *
+mq_get(Term t)
+{
+  MQKey *k;
+  MessageQueue *q = NULL;
+
+  if (!IsAtomTerm(t) && !IsIntTerm(t))
+    return NULL;
+  READ_LOCK(mq_table_lock);
+  if ((k = *mq_slot(t)) != NULL) {
+    q = k->q;
+    __atomic_add_fetch(&q->refs, 1, __ATOMIC_SEQ_CST);
+  }
+  READ_UNLOCK(mq_table_lock);
+  return q;
+}
+
+static MessageQueue *
+mq_lookup(Term t, char *where)
+{
+  MessageQueue *q;
+
+  if (IsVarTerm(t)) {
+    Yap_Error(INSTANTIATION_ERROR, t, where);
+    return NULL;
+  }
+  if (!(q = mq_get(t)))
+    Yap_Error(EXISTENCE_ERROR_MESSAGE_QUEUE, t, where);
+  return q;
+}
+
+static void
+mq_free_entries(MQEntry *e)
+{
+  while (e) {
+    MQEntry *next = e->next;
+
+    Yap_ReleaseTermFromDB(e->msg);
+    Yap_FreeCodeSpace((char *)e);
+    e = next;
+  }
+}
+
+static void
+mq_free(MessageQueue *q)
+{
+  mq_free_entries(q->first);
+  pthread_cond_destroy(&q->nonempty);
+  pthread_cond_destroy(&q->nonfull);
+  pthread_mutex_destroy(&q->lock);
+  Yap_FreeCodeSpace((char *)q);
+}
+
+static void
+mq_release(MessageQueue *q)
+{
+  if (__atomic_sub_fetch(&q->refs, 1, __ATOMIC_SEQ_CST) == 0)
+    mq_free(q);
+}
+
+static MQEntry *
+mq_new_entry(Term t, int arity USES_REGS)
+{
+  MQEntry *e;
+
+  if (!(e = (MQEntry *)Yap_AllocCodeSpace(sizeof(MQEntry)))) {
+    Yap_Error(OUT_OF_HEAP_ERROR, TermNil, "thread_send_message/2");
+    return NULL;
+  }
+  if (!(e->msg = Yap_StoreTermInDB(t, arity))) {
+    Yap_FreeCodeSpace((char *)e);
+    return NULL;
+  }
+  e->next = NULL;
+  return e;
+}
+
+/* make room for a term that could not be fetched from the database */
+static int
+mq_recover(int arity USES_REGS)
+{
+  if (LOCAL_Error_TYPE == OUT_OF_ATTVARS_ERROR) {
+    LOCAL_Error_TYPE = YAP_NO_ERROR;
+    if (!Yap_growglobal(NULL)) {
+      Yap_Error(OUT_OF_ATTVARS_ERROR, TermNil, LOCAL_ErrorMessage);
+      return FALSE;
+    }
+  } else {
+    LOCAL_Error_TYPE = YAP_NO_ERROR;
+    if (!Yap_gcl(LOCAL_Error_Size, arity, ENV, gc_P(P,CP))) {
+      Yap_Error(OUT_OF_STACK_ERROR, TermNil, LOCAL_ErrorMessage);
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/* append a chain of entries, blocking while a bounded queue is full */
+static int
+mq_send(MessageQueue *q, MQEntry *e)
+{
+  pthread_mutex_lock(&q->lock);
+  while (e) {
+    while (q->max_size && q->size >= q->max_size && !q->destroyed) {
+      q->waiting_senders++;
+      pthread_cond_wait(&q->nonfull, &q->lock);
+      q->waiting_senders--;
+    }
+    if (q->destroyed)
+      break;
+    do {
+      MQEntry *next = e->next;
+
+      e->next = NULL;
+      e->seq = q->serial+1;
+      if (q->last)
+	q->last->next = e;
+      else
+	q->first = e;
+      q->last = e;
+      q->size++;
+      __atomic_store_n(&q->serial, e->seq, __ATOMIC_RELEASE);
+      e = next;
+    } while (e && (!q->max_size || q->size < q->max_size));
+    if (q->waiting)
+      pthread_cond_broadcast(&q->nonempty);
+  }
+  pthread_mutex_unlock(&q->lock);
+  if (e) {
+    mq_free_entries(e);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* called and returns with q->lock held */
+static void
+mq_wait(MessageQueue *q)
+{
+  if (q->spin) {
+    UInt serial = q->serial, i;
+
+    pthread_mutex_unlock(&q->lock);
+    for (i = 0; i < q->spin; i++) {
+      if (__atomic_load_n(&q->serial, __ATOMIC_ACQUIRE) != serial)
+	break;
+      MQ_RELAX();
+    }
+    pthread_mutex_lock(&q->lock);
+    if (q->serial != serial || q->destroyed)
+      return;
+  }
+  q->waiting++;
+  pthread_cond_wait(&q->nonempty, &q->lock);
+  q->waiting--;
+}
+
+/* unlink e, which follows prev; call with q->lock held */
+static void
+mq_unlink(MessageQueue *q, MQEntry *prev, MQEntry *e)
+{
+  if (prev)
+    prev->next = e->next;
+  else
+    q->first = e->next;
+  if (q->last == e)
+    q->last = prev;
+  e->next = NULL;
+  q->size--;
+  if (q->waiting_senders)
+    pthread_cond_broadcast(&q->nonfull);
+}
+
+/*
+ * Copy the message in e to the stacks and unify it with ARG2. All
+ * bindings are trailed, so that a failed match leaves the stacks as
+ * they were. Returns -1 if there is no room for the copy.
+ */
+static int
+mq_match(MQEntry *e USES_REGS)
+{
+  CELL *saved_H = H, *saved_HB = HB;
+  Term t;
+  int ok;
+
+  if ((t = Yap_FetchTermFromDB(e->msg)) == 0L)
+    return -1;
+  HB = saved_H;
+  ok = Yap_unify(ARG2, t);
+  HB = saved_HB;
+  if (!ok)
+    H = saved_H;
+  return ok;
+}
+
+/*
+ * Take up to max messages off the front of the queue, blocking while
+ * it is empty, and return them as a list. The entries are ours once
+ * they are unlinked, so the terms are copied to the stacks without
+ * holding the queue lock. The list is built from the back, so that only
+ * its head, kept in X4, has to survive a garbage collection.
+ */
+static Term
+mq_take(MessageQueue *q, UInt max, char *where USES_REGS)
+{
+  MQEntry *e, *rev = NULL;
+  Term l = TermNil;
+
+  pthread_mutex_lock(&q->lock);
+  while (!q->first && !q->destroyed)
+    mq_wait(q);
+  if (q->destroyed) {
+    pthread_mutex_unlock(&q->lock);
+    Yap_Error(EXISTENCE_ERROR_MESSAGE_QUEUE, Deref(ARG1), where);
+    return 0L;
+  }
+  while (max-- && (e = q->first)) {
+    mq_unlink(q, NULL, e);
+    e->next = rev;
+    rev = e;
+  }
+  pthread_mutex_unlock(&q->lock);
+  XREGS[4] = TermNil;
+  while ((e = rev) != NULL) {
+    Term t;
+
+    while ((t = Yap_FetchTermFromDB(e->msg)) == 0L) {
+      if (!mq_recover(4 PASS_REGS)) {
+	mq_free_entries(rev);
+	return 0L;
+      }
+    }
+    l = MkPairTerm(t, Deref(XREGS[4]));
+    XREGS[4] = l;
+    rev = e->next;
+    e->next = NULL;
+    mq_free_entries(e);
+  }
+  return l;
+}
+
+static Int
+p_message_queue_create( USES_REGS1 )
+{				/* '$message_queue_create'(?Id, ?Alias, +MaxSize, +Spin) */
+  Term tid = Deref(ARG1), talias = Deref(ARG2);
+  MessageQueue *q;
+  Int id;
+
+  if (!(q = (MessageQueue *)Yap_AllocCodeSpace(sizeof(MessageQueue)))) {
+    Yap_Error(OUT_OF_HEAP_ERROR, TermNil, "message_queue_create/2");
+    return FALSE;
+  }
+  q->alias = NULL;
+  pthread_mutex_init(&q->lock, NULL);
+  pthread_cond_init(&q->nonempty, NULL);
+  pthread_cond_init(&q->nonfull, NULL);
+  q->first = q->last = NULL;
+  q->size = 0;
+  q->max_size = IntegerOfTerm(Deref(ARG3));
+  q->spin = IntegerOfTerm(Deref(ARG4));
+  q->waiting = q->waiting_senders = 0;
+  q->serial = 0;
+  q->refs = 1;
+  q->destroyed = FALSE;
+  WRITE_LOCK(mq_table_lock);
+  if (IsVarTerm(tid)) {
+    do {
+      id = --mq_last_id;
+    } while (*mq_slot(MkIntTerm(id)));
+  } else {
+    id = IntOfTerm(tid);
+  }
+  q->id = id;
+  if (!mq_add_key(MkIntTerm(id), q)) {
+    WRITE_UNLOCK(mq_table_lock);
+    mq_free(q);
+    return FALSE;
+  }
+  if (!IsVarTerm(talias)) {
+    if (!mq_add_key(talias, q)) {
+      mq_del_key(mq_slot(MkIntTerm(id)));
+      WRITE_UNLOCK(mq_table_lock);
+      mq_free(q);
+      return FALSE;
+    }
+    q->alias = AtomOfTerm(talias);
+  }
+  WRITE_UNLOCK(mq_table_lock);
+  return Yap_unify(ARG1, MkIntTerm(id));
+}
+
+static Int
+p_message_queue_add_alias( USES_REGS1 )
+{				/* '$message_queue_add_alias'(+Id, +ThreadAlias) */
+  MessageQueue *q;
+  int ok;
+
+  if (!(q = mq_get(Deref(ARG1))))
+    return FALSE;
+  WRITE_LOCK(mq_table_lock);
+  {
+    MQKey *k = *mq_slot(Deref(ARG2));
+
+    ok = (k ? k->q == q : mq_add_key(Deref(ARG2), q));
+  }
+  WRITE_UNLOCK(mq_table_lock);
+  mq_release(q);
+  return ok;
+}
+
+static Int
+p_message_queue_reset( USES_REGS1 )
+{				/* '$message_queue_reset'(+ThreadId) */
+  MessageQueue *q;
+  MQEntry *e;
+
+  if (!(q = mq_get(Deref(ARG1))))
+    return TRUE;
+  mq_del_keys(q, FALSE);
+  pthread_mutex_lock(&q->lock);
+  e = q->first;
+  q->first = q->last = NULL;
+  q->size = 0;
+  if (q->waiting_senders)
+    pthread_cond_broadcast(&q->nonfull);
+  pthread_mutex_unlock(&q->lock);
+  mq_free_entries(e);
+  mq_release(q);
+  return TRUE;
+}
+
+static Int
+p_message_queue_destroy( USES_REGS1 )
+{				/* '$message_queue_destroy'(+Queue) */
+  MessageQueue *q;
+  int first;
+
+  if (!(q = mq_lookup(Deref(ARG1), "message_queue_destroy/1")))
+    return FALSE;
+  mq_del_keys(q, TRUE);
+  pthread_mutex_lock(&q->lock);
+  first = !q->destroyed;
+  q->destroyed = TRUE;
+  pthread_cond_broadcast(&q->nonempty);
+  pthread_cond_broadcast(&q->nonfull);
+  pthread_mutex_unlock(&q->lock);
+  if (first)
+    mq_release(q);
+  mq_release(q);
+  return TRUE;
+}
+
+static Int
+p_message_queue_send( USES_REGS1 )
+{				/* '$message_queue_send'(+Queue, +Term) */
+  MessageQueue *q;
+  MQEntry *e;
+  int ok;
+
+  if (!(q = mq_get(Deref(ARG1))))
+    return FALSE;
+  if (!(e = mq_new_entry(Deref(ARG2), 2 PASS_REGS))) {
+    mq_release(q);
+    return FALSE;
+  }
+  ok = mq_send(q, e);
+  mq_release(q);
+  return ok;
+}
+
+static Int
+p_message_queue_send_list( USES_REGS1 )
+{				/* '$message_queue_send_list'(+Queue, +Terms) */
+  MessageQueue *q;
+  MQEntry *first = NULL, *last = NULL;
+  Term l = Deref(ARG2);
+  int ok;
+
+  while (IsPairTerm(l))
+    l = Deref(TailOfTerm(l));
+  if (IsVarTerm(l)) {
+    Yap_Error(INSTANTIATION_ERROR, l, "thread_send_messages/2");
+    return FALSE;
+  }
+  if (l != TermNil) {
+    Yap_Error(TYPE_ERROR_LIST, Deref(ARG2), "thread_send_messages/2");
+    return FALSE;
+  }
+  if (!(q = mq_get(Deref(ARG1))))
+    return FALSE;
+  /* serialize everything first, so that the queue is locked only once */
+  l = Deref(ARG2);
+  while (IsPairTerm(l)) {
+    MQEntry *e;
+
+    XREGS[2] = TailOfTerm(l);
+    if (!(e = mq_new_entry(Deref(HeadOfTerm(l)), 2 PASS_REGS))) {
+      mq_free_entries(first);
+      mq_release(q);
+      return FALSE;
+    }
+    if (last)
+      last->next = e;
+    else
+      first = e;
+    last = e;
+    l = Deref(XREGS[2]);
+  }
+  ok = (first == NULL || mq_send(q, first));
+  mq_release(q);
+  return ok;
+}
+
+static Int
+p_message_queue_get( USES_REGS1 )
+{				/* '$message_queue_get'(+Queue, ?Term) */
+  MessageQueue *q;
+  UInt seen = 0;		/* messages up to this one do not match */
+
+  if (!(q = mq_lookup(Deref(ARG1), "thread_get_message/2")))
+    return FALSE;
+  if (IsVarTerm(Deref(ARG2))) {
+    /* anything will do: take the first message */
+    Term l = mq_take(q, 1, "thread_get_message/2" PASS_REGS);
+
+    mq_release(q);
+    if (l == 0L)
+      return FALSE;
+    return Yap_unify(ARG2, HeadOfTerm(l));
+  }
+  pthread_mutex_lock(&q->lock);
+  while (TRUE) {
+    MQEntry *e, *prev = NULL;
+    int ok = FALSE;
+
+    if (q->destroyed) {
+      pthread_mutex_unlock(&q->lock);
+      mq_release(q);
+      Yap_Error(EXISTENCE_ERROR_MESSAGE_QUEUE, Deref(ARG1), "thread_get_message/2");
+      return FALSE;
+    }
+    /* the pattern does not change, so each message is tried only once */
+    for (e = q->first; e; prev = e, e = e->next) {
+      if (e->seq <= seen)
+	continue;
+      if ((ok = mq_match(e PASS_REGS)))
+	break;
+      seen = e->seq;
+    }
+    if (ok > 0) {
+      mq_unlink(q, prev, e);
+      pthread_mutex_unlock(&q->lock);
+      mq_free_entries(e);
+      mq_release(q);
+      return TRUE;
+    }
+    if (ok < 0) {
+      pthread_mutex_unlock(&q->lock);
+      if (!mq_recover(2 PASS_REGS)) {
+	mq_release(q);
+	return FALSE;
+      }
+      pthread_mutex_lock(&q->lock);
+      continue;
+    }
+    mq_wait(q);
+  }
+}
+
+static Int
+p_message_queue_get_list( USES_REGS1 )
+{				/* '$message_queue_get_list'(+Queue, +Max, -Terms) */
+  MessageQueue *q;
+  Term l;
+
+  if (!(q = mq_lookup(Deref(ARG1), "thread_get_messages/3")))
+    return FALSE;
+  l = mq_take(q, IntegerOfTerm(Deref(ARG2)), "thread_get_messages/3" PASS_REGS);
+  mq_release(q);
+  if (l == 0L)
+    return FALSE;
+  return Yap_unify(ARG3, l);
+}
+
+static Int
+p_message_queue_peek( USES_REGS1 )
+{				/* '$message_queue_peek'(+Queue, ?Term) */
+  MessageQueue *q;
+  MQEntry *e;
+  int ok = FALSE;
+
+  if (!(q = mq_lookup(Deref(ARG1), "thread_peek_message/2")))
+    return FALSE;
+  pthread_mutex_lock(&q->lock);
+  e = q->first;
+  while (e) {
+    if ((ok = mq_match(e PASS_REGS)) < 0) {
+      pthread_mutex_unlock(&q->lock);
+      if (!mq_recover(2 PASS_REGS)) {
+	mq_release(q);
+	return FALSE;
+      }
+      pthread_mutex_lock(&q->lock);
+      e = q->first;
+      continue;
+    }
+    if (ok)
+      break;
+    e = e->next;
+  }
+  pthread_mutex_unlock(&q->lock);
+  mq_release(q);
+  return e != NULL;
+}
+
+static Int
+p_message_queue_info( USES_REGS1 )
+{				/* '$message_queue_info'(+Queue, -Id, -Alias, -Size, -MaxSize, -Spin) */
+  MessageQueue *q;
+  Int status = TRUE;
+
+  if (!(q = mq_get(Deref(ARG1))))
+    return FALSE;
+  status &= Yap_unify(ARG2, MkIntTerm(q->id));
+  if (q->alias)
+    status &= Yap_unify(ARG3, MkAtomTerm(q->alias));
+  status &= Yap_unify(ARG4, MkIntegerTerm(q->size));
+  status &= Yap_unify(ARG5, MkIntegerTerm(q->max_size));
+  status &= Yap_unify(ARG6, MkIntegerTerm(q->spin));
+  mq_release(q);
+  return status;
+}
+
+static Int
+p_message_queue_set( USES_REGS1 )
+{				/* '$message_queue_set'(+Queue, +MaxSize, +Spin) */
+  MessageQueue *q;
+
+  if (!(q = mq_lookup(Deref(ARG1), "message_queue_set/2")))
+    return FALSE;
+  pthread_mutex_lock(&q->lock);
+  q->max_size = IntegerOfTerm(Deref(ARG2));
+  q->spin = IntegerOfTerm(Deref(ARG3));
+  if (q->waiting_senders)
+    pthread_cond_broadcast(&q->nonfull);
+  pthread_mutex_unlock(&q->lock);
+  mq_release(q);
+  return TRUE;
+}
+
+static Int
+p_message_queues( USES_REGS1 )
+{				/* '$message_queues'(-Queues) */
+  Term l = TermNil;
+  UInt n = 0;
+  int i;
+
+  READ_LOCK(mq_table_lock);
+  for (i = 0; i < MQ_TABLE_SIZE; i++) {
+    MQKey *k;
+    for (k = mq_table[i]; k; k = k->next)
+      n++;
+  }
+  READ_UNLOCK(mq_table_lock);
+  if ((UInt)(ASP-H) < 2*n+1024) {
+    if (!Yap_gcl(2*n*sizeof(CELL), 1, ENV, gc_P(P,CP))) {
+      Yap_Error(OUT_OF_STACK_ERROR, TermNil, LOCAL_ErrorMessage);
+      return FALSE;
+    }
+  }
+  READ_LOCK(mq_table_lock);
+  for (i = 0; i < MQ_TABLE_SIZE && n; i++) {
+    MQKey *k;
+    for (k = mq_table[i]; k && n; k = k->next) {
+      MessageQueue *q = k->q;
+
+      if (k->key == MkIntTerm(q->id)) {
+	l = MkPairTerm(q->alias ? MkAtomTerm(q->alias) : k->key, l);
+	n--;
+      }
+    }
+  }
+  READ_UNLOCK(mq_table_lock);
+  return Yap_unify(ARG1, l);
+}
+
 static Int 
 p_thread_stacks( USES_REGS1 )
 {				/* '$thread_signal'(+P)	 */
@@ -829,6 +1535,24 @@ p_thread_stacks( USES_REGS1 )
   return status;
 }
 
+static Int
+p_thread_code_space( USES_REGS1 )
+{				/* '$thread_code_space'(+Id, -InUse, -Cached) */
+  Int tid = IntegerOfTerm(Deref(ARG1));
+  UInt in_use, cached;
+
+  LOCK(GLOBAL_ThreadHandlesLock);
+  if (!Yap_local[tid] || 
+      (!REMOTE_ThreadHandle(tid).in_use && !REMOTE_ThreadHandle(tid).zombie)) {
+    UNLOCK(GLOBAL_ThreadHandlesLock);
+    return FALSE;
+  }
+  Yap_CodeSpaceInfo(tid, &in_use, &cached);
+  UNLOCK(GLOBAL_ThreadHandlesLock);
+  return Yap_unify(ARG2,MkIntegerTerm(in_use)) &&
+    Yap_unify(ARG3,MkIntegerTerm(cached));
+}
+
 static Int 
 p_thread_atexit( USES_REGS1 )
 {				/* '$thread_signal'(+P)	 */
@@ -949,6 +1673,7 @@ p_thread_unlock( USES_REGS1 )
 
 void Yap_InitThreadPreds(void)
 {
+  INIT_RWLOCK(mq_table_lock);
   Yap_InitCPred("$no_threads", 0, p_no_threads, HiddenPredFlag);
   Yap_InitCPred("$max_workers", 1, p_max_workers, HiddenPredFlag);
   Yap_InitCPred("$max_threads", 1, p_max_threads, HiddenPredFlag);
@@ -978,7 +1703,20 @@ void Yap_InitThreadPreds(void)
   Yap_InitCPred("$cond_signal", 1, p_cond_signal, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$cond_broadcast", 1, p_cond_broadcast, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$cond_wait", 2, p_cond_wait, SafePredFlag|HiddenPredFlag);
+  Yap_InitCPred("$message_queue_create", 4, p_message_queue_create, SafePredFlag|HiddenPredFlag);
+  Yap_InitCPred("$message_queue_add_alias", 2, p_message_queue_add_alias, SafePredFlag|HiddenPredFlag);
+  Yap_InitCPred("$message_queue_reset", 1, p_message_queue_reset, SafePredFlag|HiddenPredFlag);
+  Yap_InitCPred("$message_queue_destroy", 1, p_message_queue_destroy, SafePredFlag|HiddenPredFlag);
+  Yap_InitCPred("$message_queue_send", 2, p_message_queue_send, HiddenPredFlag);
+  Yap_InitCPred("$message_queue_send_list", 2, p_message_queue_send_list, HiddenPredFlag);
+  Yap_InitCPred("$message_queue_get", 2, p_message_queue_get, HiddenPredFlag);
+  Yap_InitCPred("$message_queue_get_list", 3, p_message_queue_get_list, HiddenPredFlag);
+  Yap_InitCPred("$message_queue_peek", 2, p_message_queue_peek, HiddenPredFlag);
+  Yap_InitCPred("$message_queue_info", 6, p_message_queue_info, SafePredFlag|HiddenPredFlag);
+  Yap_InitCPred("$message_queue_set", 3, p_message_queue_set, SafePredFlag|HiddenPredFlag);
+  Yap_InitCPred("$message_queues", 1, p_message_queues, HiddenPredFlag);
   Yap_InitCPred("$thread_stacks", 4, p_thread_stacks, SafePredFlag|HiddenPredFlag);
+  Yap_InitCPred("$thread_code_space", 3, p_thread_code_space, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$signal_thread", 1, p_thread_signal, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$nof_threads", 1, p_nof_threads, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$nof_threads_created", 1, p_nof_threads_created, SafePredFlag|HiddenPredFlag);
@@ -1033,6 +1771,12 @@ p_thread_stacks(void)
   return FALSE;
 }
 
+static Int
+p_thread_code_space(void)
+{				/* '$thread_code_space'(+Id, -InUse, -Cached) */
+  return FALSE;
+}
+
 static Int 
 p_thread_unlock(void)
 {				/* '$thread_runtime'(+P)	 */
@@ -1054,6 +1798,7 @@ void Yap_InitThreadPreds(void)
   Yap_InitCPred("$nof_threads", 1, p_nof_threads, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$nof_threads_created", 1, p_nof_threads_created, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$thread_stacks", 4, p_thread_stacks, SafePredFlag|HiddenPredFlag);
+  Yap_InitCPred("$thread_code_space", 3, p_thread_code_space, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$thread_runtime", 1, p_thread_runtime, SafePredFlag|HiddenPredFlag);
   Yap_InitCPred("$thread_unlock", 1, p_thread_unlock, SafePredFlag);
 }
@@ -3295,102 +3295,126 @@ p_var_in_term( USES_REGS1 )
 
 /* This code with max_depth == -1 will loop for infinite trees */
 
-
-//-----------------------------------------------------------------------------
-// MurmurHash2, by Austin Appleby
-
-// Note - This code makes a few assumptions about how your machine behaves -
-
-// 1. We can read a 4-byte value from any address without crashing
-// 2. sizeof(int) == 4
-
-// And it has a few limitations -
-
-// 1. It will not work incrementally.
-// 2. It will not produce the same results on little-endian and big-endian
-//    machines.
-
-static unsigned int
-MurmurHashNeutral2 ( const void * key, int len, unsigned int seed )
+/*
+  Terms are hashed while they are walked: every atom name, number and
+  functor is folded into a 64-bit state with the MurmurHash64A mixing
+  step, so we never build a flat copy of the term on the global
+  stack. The only memory used is the visit stack in the auxiliary
+  area, plus two cells per variable in variant mode.
+
+  Atom names are folded byte by byte in little-endian order, so hash
+  values do not depend on the endianness of the host.
+*/
+
+#define TERM_HASH_SEED  0x1a3be34aL
+#define TERM_HASH_M     0xc6a4a7935bd1e995ULL
+#define TERM_HASH_R     47
+
+/* each cell is folded as its tag followed by its contents, so that
+   cells of different kinds never hash alike */
+#define TERM_HASH_ATOM  0x1
+#define TERM_HASH_FLOAT 0x2
+#define TERM_HASH_BIG   0x3
+#define TERM_HASH_VAR   0x4
+#define TERM_HASH_PAIR  0x5
+/* small and long integers share a tag, as they never share a value */
+#define TERM_HASH_INT   0x6
+#define TERM_HASH_APPL  0x7
+#define TERM_HASH_DBREF 0x8
+
+/* what to do with unbound variables, see YAP_TermHash() */
+#define TERM_HASH_GROUND    0
+#define TERM_HASH_SKIP_VARS 1
+#define TERM_HASH_VARIANT   2
+
+typedef YAP_ULONG_LONG term_hash_t;
+
+static inline term_hash_t
+hash_mix(term_hash_t h, term_hash_t k)
 {
-	const unsigned int m = 0x5bd1e995;
-	const int r = 24;
-
-	unsigned int h = seed ^ len;
-
-	const unsigned char * data = (const unsigned char *)key;
-
-	while(len >= 4)
-	{
-		unsigned int k;
-
-		k  = data[0];
-		k |= data[1] << 8;
-		k |= data[2] << 16;
-		k |= data[3] << 24;
-
-		k *= m; 
-		k ^= k >> r; 
-		k *= m;
-
-		h *= m;
-		h ^= k;
-
-		data += 4;
-		len -= 4;
-	}
-	
-	switch(len)
-	{
-	case 3: h ^= data[2] << 16;
-	case 2: h ^= data[1] << 8;
-	case 1: h ^= data[0];
-	        h *= m;
-	};
-
-	h ^= h >> 13;
-	h *= m;
-	h ^= h >> 15;
-
-	return h;
-} 
+  k *= TERM_HASH_M;
+  k ^= k >> TERM_HASH_R;
+  k *= TERM_HASH_M;
+  h ^= k;
+  h *= TERM_HASH_M;
+  return h;
+}
 
-static CELL *
-AddAtomToHash(CELL *st, Atom at)
+static inline term_hash_t
+hash_final(term_hash_t h)
 {
-  unsigned int len;
+  h ^= h >> TERM_HASH_R;
+  h *= TERM_HASH_M;
+  h ^= h >> TERM_HASH_R;
+  return h;
+}
 
+static term_hash_t
+AddAtomToHash(term_hash_t h, Atom at, UInt arity)
+{
   if (IsWideAtom(at)) {
     wchar_t *c = RepAtom(at)->WStrOfAE;
-    int ulen = wcslen(c);
-    len = ulen*sizeof(wchar_t);
-    if (len % CellSize == 0) {
-      len /= CellSize;
-    } else {
-      len /= CellSize;
-      len++;
+    UInt len = wcslen(c);
+
+    h = hash_mix(h, (term_hash_t)len << 8 | arity);
+    while (len >= 2) {
+      h = hash_mix(h, (term_hash_t)(UInt)c[0] | ((term_hash_t)(UInt)c[1] << 32));
+      c += 2;
+      len -= 2;
     }
-    st[len-1] = 0L;
-    wcsncpy((wchar_t *)st, c, ulen);
+    if (len)
+      h = hash_mix(h, (term_hash_t)(UInt)c[0]);
   } else {
-    char *c = RepAtom(at)->StrOfAE;
-    int ulen = strlen(c);
-    /* fix hashing over empty atom */
-    if (!ulen) {
-      return st;
+    unsigned char *c = (unsigned char *)RepAtom(at)->StrOfAE;
+    UInt len = strlen((char *)c);
+    term_hash_t k;
+
+    h = hash_mix(h, (term_hash_t)len << 8 | arity);
+    while (len >= 8) {
+      k  = (term_hash_t)c[0];
+      k |= (term_hash_t)c[1] << 8;
+      k |= (term_hash_t)c[2] << 16;
+      k |= (term_hash_t)c[3] << 24;
+      k |= (term_hash_t)c[4] << 32;
+      k |= (term_hash_t)c[5] << 40;
+      k |= (term_hash_t)c[6] << 48;
+      k |= (term_hash_t)c[7] << 56;
+      h = hash_mix(h, k);
+      c += 8;
+      len -= 8;
     }
-    if (ulen % CellSize == 0) {
-      len = ulen/CellSize;
-    } else {
-      len = ulen/CellSize;
-      len++;
+    if (len) {
+      k = 0;
+      switch(len) {
+      case 7: k |= (term_hash_t)c[6] << 48;
+      case 6: k |= (term_hash_t)c[5] << 40;
+      case 5: k |= (term_hash_t)c[4] << 32;
+      case 4: k |= (term_hash_t)c[3] << 24;
+      case 3: k |= (term_hash_t)c[2] << 16;
+      case 2: k |= (term_hash_t)c[1] << 8;
+      case 1: k |= (term_hash_t)c[0];
+      }
+      h = hash_mix(h, k);
     }
-    st[len-1] = 0L;
-    strncpy((char *)st, c, ulen);
   }
-  return st+len;
+  return h;
 }
 
+#ifdef USE_GMP
+static term_hash_t
+AddLimbsToHash(term_hash_t h, MP_INT *m, mp_limb_t *l)
+{
+  Int i, n = m->_mp_size;
+
+  h = hash_mix(h, (term_hash_t)n);
+  if (n < 0)
+    n = -n;
+  for (i = 0; i < n; i++)
+    h = hash_mix(h, (term_hash_t)l[i]);
+  return h;
+}
+#endif
+
 typedef struct visited {
   CELL *start;
   CELL  *end;
@@ -3398,14 +3422,27 @@ typedef struct visited {
   UInt vdepth;
 } visited_t;
 
-static CELL *
+/*
+  Walk the term and fold it into *hp. The variant argument says what
+  to do with unbound variables: TERM_HASH_GROUND gives up (returns 0),
+  TERM_HASH_SKIP_VARS ignores them, and TERM_HASH_VARIANT numbers them
+  in order of first occurrence, so that variant terms get the same
+  hash. Numbering binds each new variable to a self-referencing cell
+  allocated from the top of the auxiliary area; the bindings are
+  undone before returning, so the trail is not touched. Returns -1 if
+  the auxiliary area overflows.
+*/
+static int
 hash_complex_term(register CELL *pt0,
 		  register CELL *pt0_end,
 		  Int depth,
-		  CELL *st,
-		  int variant USES_REGS)
+		  int variant,
+		  term_hash_t *hp USES_REGS)
 {
   register visited_t *to_visit0, *to_visit = (visited_t *)Yap_PreAllocCodeSpace();
+  CELL *vars0 = (CELL *)AuxSp, *vars = vars0;
+  term_hash_t h = *hp;
+  int out = 1;
 
   to_visit0 = to_visit;
  loop:
@@ -3418,23 +3455,22 @@ hash_complex_term(register CELL *pt0,
     deref_head(d0, hash_complex_unk);
   hash_complex_nvar:
     {
-      if (st + 1024 >= ASP) {
-	goto global_overflow;
-      }
       if (IsAtomOrIntTerm(d0)) {
 	if (d0 != TermFoundVar) {
 	  if (IsAtomTerm(d0)) {
-	    st = AddAtomToHash(st, AtomOfTerm(d0));
+	    h = hash_mix(h, TERM_HASH_ATOM);
+	    h = AddAtomToHash(h, AtomOfTerm(d0), 0);
 	  } else {
-	    *st++ = IntOfTerm(d0);
+	    h = hash_mix(h, TERM_HASH_INT);
+	    h = hash_mix(h, (term_hash_t)IntOfTerm(d0));
 	  }
 	}
 	continue;
       } else if (IsPairTerm(d0)) {
-	st = AddAtomToHash(st, AtomDot);
+	h = hash_mix(h, TERM_HASH_PAIR);
 	if (depth == 1)
 	  continue;
-	if (to_visit + 256 >= (visited_t *)AuxSp) {
+	if (to_visit + 256 >= (visited_t *)vars) {
 	  goto aux_overflow;
 	}
 	to_visit->start = pt0;
@@ -3460,44 +3496,55 @@ hash_complex_term(register CELL *pt0,
 	  switch(fc) {
 	    
 	  case (CELL)FunctorDBRef:
-	    *st++ = fc;
+	    h = hash_mix(h, TERM_HASH_DBREF);
 	    break;
 	  case (CELL)FunctorLongInt:
-	    *st++ = LongIntOfTerm(d0);
+	    h = hash_mix(h, TERM_HASH_INT);
+	    h = hash_mix(h, (term_hash_t)LongIntOfTerm(d0));
 	    break;
 #ifdef USE_GMP
 	  case (CELL)FunctorBigInt:
 	    {
 	      CELL *pt = RepAppl(d0);
-	      Int sz = 
-		sizeof(MP_INT)+1+
-		(((MP_INT *)(pt+2))->_mp_alloc*sizeof(mp_limb_t));
-
-	      if (st + (1024 + sz/CellSize) >= ASP) {
-		goto global_overflow;
+	      MP_INT *m = (MP_INT *)(pt+2);
+
+	      h = hash_mix(h, TERM_HASH_BIG);
+	      h = hash_mix(h, (term_hash_t)pt[1]);
+	      if (pt[1] == BIG_INT) {
+		h = AddLimbsToHash(h, m, (mp_limb_t *)(m+1));
+	      } else if (pt[1] == BIG_RATIONAL) {
+		MP_RAT *rat = (MP_RAT *)(m+1);
+		mp_limb_t *nt = (mp_limb_t *)(rat+1);
+
+		h = AddLimbsToHash(h, &rat->_mp_num, nt);
+		h = AddLimbsToHash(h, &rat->_mp_den, nt+rat->_mp_num._mp_alloc);
+	      } else {
+		CELL *pt1 = (CELL *)(m+1), *pt1_end = pt1+m->_mp_alloc;
+
+		while (pt1 < pt1_end)
+		  h = hash_mix(h, (term_hash_t)*pt1++);
 	      }
-	      /* then the actual number */
-	      memcpy((void *)(st+1), (void *)(pt+1), sz);
-	      st = st+sz/CellSize;
 	    }
 	    break;
 #endif
 	  case (CELL)FunctorDouble:
 	    {
 	      CELL *pt = RepAppl(d0);
-	      *st++ = pt[1];
+	      h = hash_mix(h, TERM_HASH_FLOAT);
+	      h = hash_mix(h, (term_hash_t)pt[1]);
 #if  SIZEOF_DOUBLE == 2*SIZEOF_LONG_INT
-	      *st++ = pt[2];
+	      h = hash_mix(h, (term_hash_t)pt[2]);
 #endif
 	      break;
 	    }
 	  }
 	  continue;
 	}
-	st = AddAtomToHash(st, NameOfFunctor(f));
+	h = hash_mix(h, TERM_HASH_APPL);
+	h = AddAtomToHash(h, NameOfFunctor(f), ArityOfFunctor(f));
 	if (depth == 1)
 	  continue;
-	if (to_visit + 1024 >= (visited_t *)AuxSp) {
+	if (to_visit + 1024 >= (visited_t *)vars) {
 	  goto aux_overflow;
 	}
 	to_visit->start = pt0;
@@ -3516,10 +3563,26 @@ hash_complex_term(register CELL *pt0,
     
 
     deref_body(d0, ptd0, hash_complex_unk, hash_complex_nvar);
-    if (!variant)
-      return NULL;
-    else
-      continue;
+    if (variant == TERM_HASH_GROUND) {
+      out = 0;
+      goto restore;
+    } else if (variant == TERM_HASH_VARIANT) {
+      if (ptd0 >= vars && ptd0 < vars0) {
+	/* seen before: it is one of our markers */
+	h = hash_mix(h, TERM_HASH_VAR);
+	h = hash_mix(h, (term_hash_t)((vars0-ptd0)/2));
+      } else {
+	if ((visited_t *)(vars-2) <= to_visit + 1024) {
+	  goto aux_overflow;
+	}
+	vars -= 2;
+	vars[0] = (CELL)vars;
+	vars[1] = (CELL)ptd0;
+	*ptd0 = (CELL)vars;
+	h = hash_mix(h, TERM_HASH_VAR);
+	h = hash_mix(h, (term_hash_t)((vars0-vars)/2));
+      }
+    }
   }
   /* Do we still have compound terms to visit */
   if (to_visit > to_visit0) {
@@ -3530,75 +3593,80 @@ hash_complex_term(register CELL *pt0,
     depth = to_visit->vdepth;
     goto loop;
   }
-  return st;
+  goto reset_vars;
 
  aux_overflow:
+  out = -1;
+ restore:
   /* unwind stack */
   while (to_visit > to_visit0) {
     to_visit --;
     pt0 = to_visit->start;
     *pt0 = to_visit->old;
   }
-  return (CELL *)-1;
-
- global_overflow:
-  /* unwind stack */
-  while (to_visit > to_visit0) {
-    to_visit --;
-    pt0 = to_visit->start;
-    *pt0 = to_visit->old;
+ reset_vars:
+  while (vars < vars0) {
+    CELL *var = (CELL *)vars[1];
+    *var = (CELL)var;
+    vars += 2;
   }
-  return (CELL *) -2;
+  *hp = h;
+  return out;
 }
- 
-Int
-Yap_TermHash(Term t, Int size, Int depth, int variant)
-{
-  CACHE_REGS
-  unsigned int i1;
-  Term t1 = Deref(t);
 
+/*
+  Hash t into [0,size). Returns TRUE on success, FALSE if a variable
+  was found in TERM_HASH_GROUND mode or if we ran out of memory, in
+  which case the error has already been set.
+*/
+static int
+term_hash(Term t, Int depth, Int size, int variant, Int *out USES_REGS)
+{
   while (TRUE) {
-    CELL *ar = hash_complex_term(&t1-1, &t1, depth, H, FALSE PASS_REGS);
-    if (ar == (CELL *)-1) {
+    term_hash_t h = TERM_HASH_SEED;
+    int res = hash_complex_term(&t-1, &t, depth, variant, &h PASS_REGS);
+
+    if (res < 0) {
       if (!Yap_ExpandPreAllocCodeSpace(0, NULL, TRUE)) {
-	Yap_Error(OUT_OF_AUXSPACE_ERROR, ARG1, "overflow in term_hash");
-	return FALSE;
-      } 
-      t1 = Deref(ARG1);
-    } else if(ar == (CELL *)-2) {
-      if (!Yap_gcl((ASP-H)*sizeof(CELL), 0, ENV, gc_P(P,CP))) {
-	Yap_Error(OUT_OF_STACK_ERROR, TermNil, "in term_hash");
+	Yap_Error(OUT_OF_AUXSPACE_ERROR, t, "overflow in term_hash");
 	return FALSE;
       }
-      t1 = Deref(ARG1);
-    } else if (ar == NULL) {
+    } else if (res == 0) {
       return FALSE;
     } else {
-      i1 = MurmurHashNeutral2((const void *)H, CellSize*(ar-H),0x1a3be34a);
-      break;
+      *out = (Int)(hash_final(h) % (term_hash_t)size);
+      return TRUE;
     }
   }
-  /* got the seed and hash from SWI-Prolog */
-  return i1 % size;
+}
+ 
+Int
+Yap_TermHash(Term t, Int size, Int depth, int variant)
+{
+  CACHE_REGS
+  Int out;
+
+  if (variant && variant != TERM_HASH_VARIANT)
+    variant = TERM_HASH_SKIP_VARS;
+  if (!term_hash(Deref(t), depth, size, variant, &out PASS_REGS))
+    return FALSE;
+  return out;
 }
 
 static Int
-p_term_hash( USES_REGS1 )
+term_hash4(int variant, char *name USES_REGS)
 {
-  unsigned int i1;
   Term t1 = Deref(ARG1);
   Term t2 = Deref(ARG2);
   Term t3 = Deref(ARG3);
-  Term result;
-  Int size, depth;
+  Int size, depth, out;
 
   if (IsVarTerm(t2)) {
-    Yap_Error(INSTANTIATION_ERROR,t2,"term_hash/4");
+    Yap_Error(INSTANTIATION_ERROR,t2,name);
     return(FALSE);
   }
   if (!IsIntegerTerm(t2)) {
-    Yap_Error(TYPE_ERROR_INTEGER,t2,"term_hash/4");
+    Yap_Error(TYPE_ERROR_INTEGER,t2,name);
     return(FALSE);
   }
   depth = IntegerOfTerm(t2);
@@ -3607,96 +3675,35 @@ p_term_hash( USES_REGS1 )
     return(Yap_unify(ARG4,MkIntTerm(0)));
   }
   if (IsVarTerm(t3)) {
-    Yap_Error(INSTANTIATION_ERROR,t3,"term_hash/4");
+    Yap_Error(INSTANTIATION_ERROR,t3,name);
     return(FALSE);
   }
   if (!IsIntegerTerm(t3)) {
-    Yap_Error(TYPE_ERROR_INTEGER,t3,"term_hash/4");
+    Yap_Error(TYPE_ERROR_INTEGER,t3,name);
     return(FALSE);
   }
   size = IntegerOfTerm(t3);
-  while (TRUE) {
-    CELL *ar = hash_complex_term(&t1-1, &t1, depth, H, FALSE PASS_REGS);
-    if (ar == (CELL *)-1) {
-      if (!Yap_ExpandPreAllocCodeSpace(0, NULL, TRUE)) {
-	Yap_Error(OUT_OF_AUXSPACE_ERROR, ARG1, "overflow in term_hash");
-	return FALSE;
-      } 
-      t1 = Deref(ARG1);
-    } else if(ar == (CELL *)-2) {
-      if (!Yap_gcl((ASP-H)*sizeof(CELL), 4, ENV, gc_P(P,CP))) {
-	Yap_Error(OUT_OF_STACK_ERROR, TermNil, "in term_hash");
-	return FALSE;
-      }
-      t1 = Deref(ARG1);
-    } else if (ar == NULL) {
-      return FALSE;
-    } else {
-      i1 = MurmurHashNeutral2((const void *)H, CellSize*(ar-H),0x1a3be34a);
-      break;
-    }
-  }
-  /* got the seed and hash from SWI-Prolog */
-  result = MkIntegerTerm(i1 % size);
-  return Yap_unify(ARG4,result);
+  if (!term_hash(t1, depth, size, variant, &out PASS_REGS))
+    return FALSE;
+  return Yap_unify(ARG4,MkIntegerTerm(out));
+}
+
+static Int
+p_term_hash( USES_REGS1 )
+{
+  return term_hash4(TERM_HASH_GROUND, "term_hash/4" PASS_REGS);
 }
 
 static Int
 p_instantiated_term_hash( USES_REGS1 )
 {
-  unsigned int i1;
-  Term t1 = Deref(ARG1);
-  Term t2 = Deref(ARG2);
-  Term t3 = Deref(ARG3);
-  Term result;
-  Int size, depth;
+  return term_hash4(TERM_HASH_SKIP_VARS, "instantiated_term_hash/4" PASS_REGS);
+}
 
-  if (IsVarTerm(t2)) {
-    Yap_Error(INSTANTIATION_ERROR,t2,"term_hash/4");
-    return(FALSE);
-  }
-  if (!IsIntegerTerm(t2)) {
-    Yap_Error(TYPE_ERROR_INTEGER,t2,"term_hash/4");
-    return(FALSE);
-  }
-  depth = IntegerOfTerm(t2);
-  if (depth == 0) {
-    if (IsVarTerm(t1)) return(TRUE);
-    return(Yap_unify(ARG4,MkIntTerm(0)));
-  }
-  if (IsVarTerm(t3)) {
-    Yap_Error(INSTANTIATION_ERROR,t3,"term_hash/4");
-    return(FALSE);
-  }
-  if (!IsIntegerTerm(t3)) {
-    Yap_Error(TYPE_ERROR_INTEGER,t3,"term_hash/4");
-    return(FALSE);
-  }
-  size = IntegerOfTerm(t3);
-  while (TRUE) {
-    CELL *ar = hash_complex_term(&t1-1, &t1, depth, H, TRUE PASS_REGS);
-    if (ar == (CELL *)-1) {
-      if (!Yap_ExpandPreAllocCodeSpace(0, NULL, TRUE)) {
-	Yap_Error(OUT_OF_AUXSPACE_ERROR, ARG1, "overflow in term_hash");
-	return FALSE;
-      } 
-      t1 = Deref(ARG1);
-    } else if(ar == (CELL *)-2) {
-      if (!Yap_gcl((ASP-H)*sizeof(CELL), 4, ENV, gc_P(P,CP))) {
-	Yap_Error(OUT_OF_STACK_ERROR, TermNil, "in term_hash");
-	return FALSE;
-      }
-      t1 = Deref(ARG1);
-    } else if (ar == NULL) {
-      return FALSE;
-    } else {
-      i1 = MurmurHashNeutral2((const void *)H, CellSize*(ar-H),0x1a3be34a);
-      break;
-    }
-  }
-  /* got the seed and hash from SWI-Prolog */
-  result = MkIntegerTerm(i1 % size);
-  return Yap_unify(ARG4,result);
+static Int
+p_variant_term_hash( USES_REGS1 )
+{
+  return term_hash4(TERM_HASH_VARIANT, "variant_term_hash/4" PASS_REGS);
 }
 
 static int variant_complex(register CELL *pt0, register CELL *pt0_end, register
@@ -5214,6 +5221,7 @@ void Yap_InitUtilCPreds(void)
   Yap_InitCPred("variable_in_term", 2, p_var_in_term, 0);
   Yap_InitCPred("term_hash", 4, p_term_hash, 0);
   Yap_InitCPred("instantiated_term_hash", 4, p_instantiated_term_hash, 0);
+  Yap_InitCPred("variant_term_hash", 4, p_variant_term_hash, 0);
   Yap_InitCPred("variant", 2, p_variant, 0);
   Yap_InitCPred("subsumes", 2, p_subsumes, 0);
   Yap_InitCPred("term_subsumer", 3, p_term_subsumer, 0);
@@ -366,6 +366,7 @@ typedef enum
   EVALUATION_ERROR_ZERO_DIVISOR,
   EXISTENCE_ERROR_ARRAY,
   EXISTENCE_ERROR_KEY,
+  EXISTENCE_ERROR_MESSAGE_QUEUE,
   EXISTENCE_ERROR_SOURCE_SINK,
   EXISTENCE_ERROR_STREAM,
   EXISTENCE_ERROR_VARIABLE,
@@ -500,7 +501,8 @@ typedef enum
   YAP_AGC_SIGNAL = 0x20000,	/* call atom garbage collector asap */
   YAP_PIPE_SIGNAL = 0x40000,	/* call atom garbage collector asap */
   YAP_VTALARM_SIGNAL = 0x80000,	/* received SIGVTALARM */
-  YAP_FAIL_SIGNAL = 0x100000	/* P = FAILCODE */
+  YAP_FAIL_SIGNAL = 0x100000,	/* P = FAILCODE */
+  YAP_PROF_SIGNAL = 0x200000	/* sample the stack for the profiler */
 } yap_signals;
 
 typedef enum
@@ -7,6 +7,8 @@
   OPCODE(try_me                     ,Otapl),
   OPCODE(retry_me                   ,Otapl),
   OPCODE(trust_me                   ,Otapl),
+  OPCODE(exo                        ,Otapl),
+  OPCODE(retry_exo                  ,Otapl),
   OPCODE(enter_profiling            ,p),
   OPCODE(retry_profiled             ,p),
   OPCODE(profiled_retry_me          ,Otapl),
@@ -70,6 +72,7 @@
   OPCODE(get_bigint                 ,xN),
   OPCODE(get_dbterm                 ,xD),
   OPCODE(glist_valx                 ,xx),
+  OPCODE(glist_valx_varx            ,xxx),
   OPCODE(glist_valy                 ,yx),
   OPCODE(gl_void_varx               ,xx),
   OPCODE(gl_void_vary               ,yx),
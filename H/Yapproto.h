@@ -79,6 +79,7 @@ Prop	STD_PROTO(Yap_GetExpPropHavingLock,(AtomEntry *,unsigned int));
 
 /* agc.c */
 void    STD_PROTO(Yap_atom_gc, (CACHE_TYPE1));
+void    STD_PROTO(Yap_ResetYoungAtoms, (void));
 void    STD_PROTO(Yap_init_agc, (void));
 
 /* alloc.c */
@@ -88,10 +89,17 @@ char   *STD_PROTO(Yap_AllocCodeSpace,(unsigned long int));
 char   *STD_PROTO(Yap_ReallocCodeSpace,(char *,unsigned long int));
 ADDR	STD_PROTO(Yap_AllocFromForeignArea,(Int));
 int     STD_PROTO(Yap_ExtendWorkSpace,(Int));
+int     STD_PROTO(Yap_ExtendWorkSpaceInPlace,(Int));
+ADDR	STD_PROTO(Yap_AllocStacks,(UInt));
+void	STD_PROTO(Yap_FreeStacks,(ADDR));
 void	STD_PROTO(Yap_FreeAtomSpace,(char *));
 int     STD_PROTO(Yap_FreeWorkSpace, (void));
 void	STD_PROTO(Yap_InitMemory,(UInt,UInt,UInt));
 void	STD_PROTO(Yap_InitExStacks,(int,int));
+#if THREADS
+void	STD_PROTO(Yap_FlushCodeCache,(int));
+void	STD_PROTO(Yap_CodeSpaceInfo,(int,UInt *,UInt *));
+#endif
 
 /* amasm.c */
 OPCODE	STD_PROTO(Yap_opcode,(op_numbers));
@@ -99,6 +107,7 @@ OPCODE	STD_PROTO(Yap_opcode,(op_numbers));
 /* analyst.c */
 #ifdef ANALYST
 void   STD_PROTO(Yap_InitAnalystPreds,(void));
+void   STD_PROTO(Yap_count_op_triple,(op_numbers, op_numbers, op_numbers));
 #endif /* ANALYST */
 
 /* arrays.c */
@@ -137,6 +146,9 @@ void	STD_PROTO(Yap_BuildMegaClause,(struct pred_entry *));
 void	STD_PROTO(Yap_EraseMegaClause,(yamop *,struct pred_entry *));
 void	STD_PROTO(Yap_ResetConsultStack,(void));
 void	STD_PROTO(Yap_AssertzClause,(struct pred_entry *, yamop *));
+#ifdef TABLING_INCREMENTAL
+void	STD_PROTO(Yap_UpdateIncrementalPred,(struct pred_entry *));
+#endif /* TABLING_INCREMENTAL */
 
 
 /* cmppreds.c */
@@ -182,6 +194,12 @@ Int	STD_PROTO(Yap_exec_absmi,(int));
 void	STD_PROTO(Yap_trust_last,(void));
 Term	STD_PROTO(Yap_GetException,(void));
 
+/* exo.c */
+void	STD_PROTO(Yap_InitExoPreds,(void));
+
+/* fastio.c */
+void	STD_PROTO(Yap_InitFastIO,(void));
+
 /* gprof.c */
 void	STD_PROTO(Yap_InitLowProf,(void));
 #if  LOW_PROF
@@ -262,6 +280,7 @@ void	STD_PROTO(Yap_InitIOPreds,(void));
 void   *Yap_GetStreamHandle(Atom at);
 void   *Yap_GetInputStream(Atom at);
 void   *Yap_GetOutputStream(Atom at);
+void    Yap_ReleaseStream(void *s);
 #ifdef DEBUG
 extern void Yap_DebugPlWrite (Term t);
 extern void Yap_DebugErrorPutc (int n);
@@ -680,6 +680,17 @@ typedef enum
   UDIPredFlag = 0x00000001L	/* User Defined Indexing */
 } pred_flag;
 
+/* PredFlags is full, further flags go in ExtraPredFlags */
+typedef enum
+{
+  IncrementalPredFlag = 0x00000001L	/* calls seen by incremental tabling */
+} extra_pred_flag;
+
+/* calls must go through the spy_pred entry point */
+#define PredIsWatched(pe) \
+  (((pe)->PredFlags & (SpiedPredFlag|CountPredFlag|ProfiledPredFlag)) || \
+   ((pe)->ExtraPredFlags & IncrementalPredFlag))
+
 /* profile data */
 typedef struct
 {
@@ -692,6 +703,14 @@ typedef struct
 #endif
 } profile_data;
 
+/* just-in-time indexing activity, see index.c and exo.c */
+typedef struct
+{
+  UInt NOfTrees;		/* nbr of index trees built or expanded */
+  UInt ArgsSwitched;		/* bit i is set if argument i+1 was switched on */
+  UInt IndexBytes;		/* bytes of indexing code built */
+} index_data;
+
 typedef enum {
   LUCALL_EXEC,
   LUCALL_ASSERT,
@@ -708,6 +727,7 @@ typedef struct pred_entry
   struct yami *CodeOfPred;
   OPCODE OpcodeOfPred;		/* undefcode, indexcode, spycode, ....  */
   CELL PredFlags;
+  CELL ExtraPredFlags;
   UInt ArityOfPE;		/* arity of property                    */
   union
   {
@@ -734,6 +754,9 @@ typedef struct pred_entry
 #ifdef TABLING
   tab_ent_ptr TableOfPred;
 #endif				/* TABLING */
+#ifdef TABLING_INCREMENTAL
+  UInt IncrementalTimeStampOfPred; /* last update seen by incremental tables */
+#endif				/* TABLING_INCREMENTAL */
 #ifdef BEAM
   struct Predicates *beamTable;
 #endif
@@ -743,6 +766,7 @@ typedef struct pred_entry
   /* This must be at an odd number of cells, otherwise it
      will not be aligned on RISC machines */
   profile_data StatisticsForPred;	/* enable profiling for predicate  */
+  index_data IndexStatsOfPred;	/* what the indexer did for the predicate */
   struct pred_entry *NextPredOfModule;	/* next pred for same module   */
 } PredEntry;
 #define PEProp   ((PropFlags)(0x0000))
@@ -806,6 +830,7 @@ IsPredProperty (int flags)
 /* There are several flags for code and data base entries */
 typedef enum
 {
+  ExoMask = 0x1000000,		/* exo code */
   FuncSwitchMask = 0x800000,	/* is a switch of functors */
   HasDBTMask = 0x400000,	/* includes a pointer to a DBTerm */
   MegaMask = 0x200000,		/* mega clause */
@@ -153,6 +153,11 @@ typedef enum {
 extern char *Yap_op_names[_std_top + 1];
 #endif
 
+#ifdef ANALYST
+/* size of the hash table used to count sequences of three instructions */
+#define ANALYST_TRIPLES 0x10000
+#endif
+
 typedef enum {
   _atom,
   _atomic,
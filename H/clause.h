@@ -174,6 +174,13 @@ typedef struct dbterm_list {
 #define ClauseCodeToLogUpdIndex(p)    ((LogUpdIndex *)((CODEADDR)(p)-(CELL)(((LogUpdIndex *)NULL)->ClCode)))
 #define ClauseCodeToStaticIndex(p)    ((StaticIndex *)((CODEADDR)(p)-(CELL)(((StaticIndex *)NULL)->ClCode)))
 
+/* a table of ground facts, see exo.c */
+#define IsExoPred(ap)  (((ap)->PredFlags & MegaClausePredFlag) && (ClauseCodeToMegaClause((ap)->cs.p_code.FirstClause)->ClFlags & ExoMask))
+
+/* indexing statistics, several threads may be indexing different predicates at once */
+#define INDEX_STAT_ADD(V, N) __atomic_add_fetch(&(V), (N), __ATOMIC_RELAXED)
+#define INDEX_STAT_OR(V, N) __atomic_or_fetch(&(V), (N), __ATOMIC_RELAXED)
+
 #define ClauseFlagsToDynamicClause(p)    ((DynamicClause *)(p))
 #define ClauseFlagsToLogUpdClause(p)     ((LogUpdClause *)((CODEADDR)(p)-(CELL)(&(((LogUpdClause *)NULL)->ClFlags))))
 #define ClauseFlagsToLogUpdIndex(p)      ((LogUpdIndex *)((CODEADDR)(p)-(CELL)(&(((LogUpdIndex *)NULL)->ClFlags))))
@@ -183,16 +190,55 @@ typedef struct dbterm_list {
 
 #define DynamicLock(X)		(ClauseCodeToDynamicClause(X)->ClLock)
 
-#if MULTIPLE_STACKS
+#if THREADS
+/*
+  References to logical update clauses and indices are dropped without
+  the predicate lock (see drop_clref_unless_last()), so every update to
+  the count must be atomic, even when done holding the lock.
+*/
+#define INIT_CLREF_COUNT(X) (X)->ClRefCount = 0
+#define  INC_CLREF_COUNT(X) __atomic_add_fetch(&(X)->ClRefCount, 1, __ATOMIC_SEQ_CST)
+#define  DEC_CLREF_COUNT(X) __atomic_sub_fetch(&(X)->ClRefCount, 1, __ATOMIC_SEQ_CST)
+#define     INC_LU_CLREF(X) INC_CLREF_COUNT(X)
+#define     DEC_LU_CLREF(X) DEC_CLREF_COUNT(X)
+
+#define        CL_IN_USE(X) ((X)->ClRefCount)
+
+INLINE_ONLY inline EXTERN int drop_clref_unless_last(UInt *);
+
+/*
+  Drop a reference, unless it is the last one: releasing the last
+  reference may free the clause or index, and that must be done
+  holding the predicate lock. As the last reference is always dropped
+  with the lock, the count never reaches zero behind the back of a
+  thread that holds the lock.
+*/
+INLINE_ONLY inline EXTERN int
+drop_clref_unless_last(UInt *refp)
+{
+  UInt refs = __atomic_load_n(refp, __ATOMIC_RELAXED);
+
+  while (refs > 1) {
+    if (__atomic_compare_exchange_n(refp, &refs, refs-1, FALSE,
+				    __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+      return TRUE;
+  }
+  return FALSE;
+}
+#elif MULTIPLE_STACKS
 #define INIT_CLREF_COUNT(X) (X)->ClRefCount = 0
 #define  INC_CLREF_COUNT(X) (X)->ClRefCount++
 #define  DEC_CLREF_COUNT(X) (X)->ClRefCount--
+#define     INC_LU_CLREF(X) (X)->ClRefCount++
+#define     DEC_LU_CLREF(X) (X)->ClRefCount--
 
 #define        CL_IN_USE(X) ((X)->ClRefCount)
 #else
 #define INIT_CLREF_COUNT(X)
 #define  INC_CLREF_COUNT(X) 
 #define  DEC_CLREF_COUNT(X) 
+#define     INC_LU_CLREF(X) (X)->ClRefCount++
+#define     DEC_LU_CLREF(X) (X)->ClRefCount--
 #define        CL_IN_USE(X) ((X)->ClFlags & InUseMask || (X)->ClRefCount)
 #endif
 
@@ -228,6 +274,12 @@ void     STD_PROTO(Yap_RemoveClauseFromIndex,(PredEntry *,yamop *));
 LogUpdClause  *STD_PROTO(Yap_NthClause,(PredEntry *,Int));
 LogUpdClause  *STD_PROTO(Yap_FollowIndexingCode,(PredEntry *,yamop *, Term *, yamop *,yamop *));
 
+/* exo.c */
+yamop   *STD_PROTO(Yap_ExoIndexCode,(PredEntry *));
+CELL    *STD_PROTO(Yap_ExoFirst,(PredEntry *, UInt * CACHE_TYPE));
+CELL    *STD_PROTO(Yap_ExoNext,(PredEntry *, UInt, UInt * CACHE_TYPE));
+void     STD_PROTO(Yap_ExoRehash,(PredEntry *));
+
 #if USE_THREADED_CODE
 
 #define OP_HASH_SIZE 2048
@@ -275,6 +275,9 @@ typedef struct intermediates {
   int clause_has_cut;
   UInt term_depth, last_index_at_depth;
   UInt last_index_new_depth, last_depth_size;
+  /* switches generated while building this index block */
+  UInt first_arg_switches, other_arg_switches, sub_arg_switches;
+  UInt args_switched, index_bytes;
   /* for expanding code */
   union { 
     struct static_index *si;
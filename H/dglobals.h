@@ -44,6 +44,8 @@
 #define GLOBAL_ThreadsTotalTime Yap_global->ThreadsTotalTime_
 
 #define GLOBAL_ThreadHandlesLock Yap_global->ThreadHandlesLock_
+
+#define GLOBAL_GcThreads Yap_global->GcThreads_
 #endif	
 #if defined(YAPOR) || defined(THREADS)
 
@@ -77,6 +79,18 @@
 
 #define GLOBAL_tot_agc_recovered Yap_global->tot_agc_recovered_
 
+#define GLOBAL_agc_minor_calls Yap_global->agc_minor_calls_
+#define GLOBAL_agc_max_pause Yap_global->agc_max_pause_
+
+#define GLOBAL_young_atoms Yap_global->young_atoms_
+#define GLOBAL_n_young_atoms Yap_global->n_young_atoms_
+#define GLOBAL_young_atoms_size Yap_global->young_atoms_size_
+#define GLOBAL_young_atoms_overflow Yap_global->young_atoms_overflow_
+
+#define GLOBAL_agc_marked Yap_global->agc_marked_
+#define GLOBAL_n_agc_marked Yap_global->n_agc_marked_
+#define GLOBAL_agc_marked_size Yap_global->agc_marked_size_
+
 #if HAVE_MMAP
 #define GLOBAL_mmap_arrays Yap_global->mmap_arrays_
 #endif
@@ -93,6 +107,18 @@
 #endif
 #define GLOBAL_OpaqueHandlersCount Yap_global->OpaqueHandlersCount_
 #define GLOBAL_OpaqueHandlers Yap_global->OpaqueHandlers_
+
+
+#if LOW_PROF
+#define GLOBAL_ProfStacks Yap_global->ProfStacks_
+#define GLOBAL_ProfStacksSize Yap_global->ProfStacksSize_
+#define GLOBAL_ProfStacksInUse Yap_global->ProfStacksInUse_
+#define GLOBAL_ProfSamples Yap_global->ProfSamples_
+#define GLOBAL_ProfSampling Yap_global->ProfSampling_
+#if THREADS
+#define GLOBAL_ProfSamplesLock Yap_global->ProfSamplesLock_
+#endif
+#endif
 #if  __simplescalar__
 #define GLOBAL_pwd Yap_global->pwd_
 #endif
@@ -79,6 +79,10 @@
 #define INVISIBLECHAIN Yap_heap_regs->invisiblechain
 #define WideHashChain Yap_heap_regs->wide_hash_chain
 #define HashChain Yap_heap_regs->hash_chain
+#if defined(YAPOR) || defined(THREADS)
+#define AtomTableRWLock Yap_heap_regs->atom_table_rw_lock
+#define AtomTableEpoch Yap_heap_regs->atom_table_epoch
+#endif
 
 
 #ifdef EUROTRA
@@ -159,6 +163,13 @@
 #define Yap_LUIndexSpace_EXT Yap_heap_regs->lu_index_space_EXT
 #define Yap_LUIndexSpace_SW Yap_heap_regs->lu_index_space_SW
 
+#define Yap_IndexTrees Yap_heap_regs->index_trees
+#define Yap_IndexExpansions Yap_heap_regs->index_expansions
+#define Yap_IndexUpdates Yap_heap_regs->index_updates
+#define Yap_IndexFirstArgSwitches Yap_heap_regs->index_first_arg_sw
+#define Yap_IndexOtherArgSwitches Yap_heap_regs->index_other_arg_sw
+#define Yap_IndexSubArgSwitches Yap_heap_regs->index_sub_arg_sw
+
 #define COMMA_CODE Yap_heap_regs->comma_code
 #define DUMMYCODE Yap_heap_regs->dummycode
 #define FAILCODE Yap_heap_regs->failcode
@@ -239,6 +239,11 @@
 #define LOCAL_SignalLock LOCAL->SignalLock_
 #define REMOTE_SignalLock(wid) REMOTE(wid)->SignalLock_
 #endif
+#if defined(YAPOR) || defined(THREADS)
+
+#define LOCAL_AtomTableHazard LOCAL->AtomTableHazard_
+#define REMOTE_AtomTableHazard(wid) REMOTE(wid)->AtomTableHazard_
+#endif
 
 #define LOCAL_LocalBase LOCAL->LocalBase_
 #define REMOTE_LocalBase(wid) REMOTE(wid)->LocalBase_
@@ -301,8 +306,10 @@
 #ifdef ANALYST
 #define LOCAL_opcount LOCAL->opcount_
 #define REMOTE_opcount(wid) REMOTE(wid)->opcount_
-#define LOCAL_2opcount LOCAL->2opcount_
-#define REMOTE_2opcount(wid) REMOTE(wid)->2opcount_
+#define LOCAL_opcount2 LOCAL->opcount2_
+#define REMOTE_opcount2(wid) REMOTE(wid)->opcount2_
+#define LOCAL_opcount3 LOCAL->opcount3_
+#define REMOTE_opcount3(wid) REMOTE(wid)->opcount3_
 #endif /* ANALYST */
 
 #define LOCAL_s_dbg LOCAL->s_dbg_
@@ -327,6 +334,10 @@
 #define REMOTE_trail_overflows(wid) REMOTE(wid)->trail_overflows_
 #define LOCAL_total_trail_overflow_time LOCAL->total_trail_overflow_time_
 #define REMOTE_total_trail_overflow_time(wid) REMOTE(wid)->total_trail_overflow_time_
+#define LOCAL_in_place_expansions LOCAL->in_place_expansions_
+#define REMOTE_in_place_expansions(wid) REMOTE(wid)->in_place_expansions_
+#define LOCAL_in_place_bytes LOCAL->in_place_bytes_
+#define REMOTE_in_place_bytes(wid) REMOTE(wid)->in_place_bytes_
 #define LOCAL_atom_table_overflows LOCAL->atom_table_overflows_
 #define REMOTE_atom_table_overflows(wid) REMOTE(wid)->atom_table_overflows_
 #define LOCAL_total_atom_table_overflow_time LOCAL->total_atom_table_overflow_time_
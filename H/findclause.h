@@ -1014,6 +1014,18 @@
       }
       cl = NEXTOP(cl,xxn);
       break;
+    case _glist_valx_varx:
+      if (is_regcopy(myregs, nofregs, cl->u.xxx.x)) {
+	clause->Tag = AbsPair(NULL);
+	clause->u.WorkPC = cl;
+	return;
+      }
+      if (!(nofregs = delete_regcopy(myregs, nofregs, cl->u.xxx.x2))) {
+	clause->Tag = (CELL)NULL;
+	return;
+      }
+      cl = NEXTOP(cl,xxx);
+      break;
     case _p_and_vv:
       if (!(nofregs = delete_regcopy(myregs, nofregs, cl->u.xxx.x))) {
 	clause->Tag = (CELL)NULL;
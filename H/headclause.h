@@ -702,6 +702,18 @@
       }
       cl = NEXTOP(cl,xx);
       break;
+    case _glist_valx_varx:
+      if (iarg == cl->u.xxx.x) {
+	clause->Tag = AbsPair(NULL);
+	clause->u.WorkPC = cl;
+	return;
+      }
+      if (iarg == cl->u.xxx.x2) {
+	clause->Tag = (CELL)NULL;
+	return;
+      }
+      cl = NEXTOP(cl,xxx);
+      break;
     case _put_xx_val:
       if (cl->u.xxxx.xl1 == iarg ||
         cl->u.xxxx.xr1 == iarg) {
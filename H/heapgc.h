@@ -16,6 +16,9 @@
 *************************************************************************/
 
 
+#if HAVE_STRING_H
+#include <string.h>
+#endif
 
 /* macros used by garbage collection */
 
@@ -96,6 +99,18 @@ MARKED_PTR__(CELL* ptr USES_REGS)
   return mcell(ptr) & MARK_BIT;
 }
 
+/* is any of the sizeof(CELL) cells starting at ptr marked? */
+#define MARKED_WORD(P) MARKED_WORD__(P PASS_REGS) 
+
+static inline Int
+MARKED_WORD__(CELL* ptr USES_REGS)
+{
+  CELL w;
+
+  memcpy(&w, &mcell(ptr), sizeof(CELL));
+  return w & ((~(CELL)0)/0xff)*MARK_BIT;
+}
+
 static inline Int
 UNMARKED_MARK__(CELL* ptr, char *bp USES_REGS)
 {
@@ -44,6 +44,8 @@ typedef struct global_data {
   UInt  ThreadsTotalTime_;
 
   lockvar  ThreadHandlesLock_;
+
+  UInt  GcThreads_;
 #endif	
 #if defined(YAPOR) || defined(THREADS)
 
@@ -77,6 +79,18 @@ typedef struct global_data {
 
   Int  tot_agc_recovered_;
 
+  int  agc_minor_calls_;
+  Int  agc_max_pause_;
+
+  Atom*  young_atoms_;
+  UInt  n_young_atoms_;
+  UInt  young_atoms_size_;
+  int  young_atoms_overflow_;
+
+  Atom*  agc_marked_;
+  UInt  n_agc_marked_;
+  UInt  agc_marked_size_;
+
 #if HAVE_MMAP
   struct MMAP_ARRAY_BLOCK*  mmap_arrays_;
 #endif
@@ -93,6 +107,18 @@ typedef struct global_data {
 #endif
   int  OpaqueHandlersCount_;
   struct opaque_handler_struct*  OpaqueHandlers_;
+
+
+#if LOW_PROF
+  struct prof_stack**  ProfStacks_;
+  UInt  ProfStacksSize_;
+  UInt  ProfStacksInUse_;
+  UInt  ProfSamples_;
+  UInt  ProfSampling_;
+#if THREADS
+  lockvar  ProfSamplesLock_;
+#endif
+#endif
 #if  __simplescalar__
   char  pwd_[YAP_FILENAME_MAX];
 #endif
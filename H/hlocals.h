@@ -135,6 +135,10 @@ typedef struct worker_local {
 #if defined(YAPOR) || defined(THREADS)
   lockvar  SignalLock_;
 #endif
+#if defined(YAPOR) || defined(THREADS)
+
+  struct atom_hash_entry*  AtomTableHazard_;
+#endif
 
   ADDR  LocalBase_;
   ADDR  GlobalBase_;
@@ -170,7 +174,8 @@ typedef struct worker_local {
 
 #ifdef ANALYST
   YAP_ULONG_LONG  opcount_[_std_top+1];
-  YAP_ULONG_LONG  2opcount[_std_top+1][_std_top+1]_;
+  YAP_ULONG_LONG  opcount2_[_std_top+1][_std_top+1];
+  YAP_ULONG_LONG  opcount3_[ANALYST_TRIPLES][2];
 #endif /* ANALYST */
 
   struct db_globs*  s_dbg_;
@@ -185,6 +190,8 @@ typedef struct worker_local {
   Int  total_delay_overflow_time_;
   int  trail_overflows_;
   Int  total_trail_overflow_time_;
+  int  in_place_expansions_;
+  Int  in_place_bytes_;
   int  atom_table_overflows_;
   Int  total_atom_table_overflow_time_;
 
@@ -79,6 +79,10 @@
   AtomHashEntry  invisiblechain;
   AtomHashEntry  *wide_hash_chain;
   AtomHashEntry  *hash_chain;
+#if defined(YAPOR) || defined(THREADS)
+  rwlock_t  atom_table_rw_lock;
+  UInt  atom_table_epoch;
+#endif
 
 #include "tatoms.h"
 #ifdef EUROTRA
@@ -159,6 +163,13 @@
   UInt  lu_index_space_EXT;
   UInt  lu_index_space_SW;
 
+  UInt  index_trees;
+  UInt  index_expansions;
+  UInt  index_updates;
+  UInt  index_first_arg_sw;
+  UInt  index_other_arg_sw;
+  UInt  index_sub_arg_sw;
+
   yamop  comma_code[5];
   yamop  dummycode[1];
   yamop  failcode[1];
@@ -133,6 +133,7 @@
   AtomIDB = Yap_LookupAtom("idb");
   AtomIOMode = Yap_LookupAtom("io_mode");
   AtomId = Yap_LookupAtom("id");
+  AtomIncremental = Yap_LookupAtom("incremental");
   AtomInf = Yap_LookupAtom("inf");
   AtomInitGoal = Yap_FullLookupAtom("$init_goal");
   AtomInitProlog = Yap_FullLookupAtom("$init_prolog");
@@ -161,6 +162,7 @@
   AtomMaxArity = Yap_LookupAtom("max_arity");
   AtomMaxFiles = Yap_LookupAtom("max_files");
   AtomMegaClause = Yap_FullLookupAtom("$mega_clause");
+  AtomMessageQueue = Yap_LookupAtom("message_queue");
   AtomMetaCall = Yap_FullLookupAtom("$call");
   AtomMfClause = Yap_FullLookupAtom("$mf_clause");
   AtomMinus = Yap_LookupAtom("-");
@@ -181,6 +183,7 @@
   AtomNoMemory = Yap_LookupAtom("no_memory");
   AtomNone = Yap_LookupAtom("none");
   AtomNonEmptyList = Yap_LookupAtom("non_empty_list");
+  AtomNonIncremental = Yap_LookupAtom("non_incremental");
   AtomNot = Yap_LookupAtom("\\+");
   AtomNotImplemented = Yap_LookupAtom("not_implemented");
   AtomNotLessThanZero = Yap_LookupAtom("not_less_than_zero");
@@ -256,6 +259,7 @@
   AtomSigIti = Yap_LookupAtom("sig_iti");
   AtomSigPending = Yap_FullLookupAtom("$sig_pending");
   AtomSigPipe = Yap_LookupAtom("sig_pipe");
+  AtomSigProf = Yap_LookupAtom("sig_prof");
   AtomSigStackDump = Yap_LookupAtom("sig_stack_dump");
   AtomSigStatistics = Yap_LookupAtom("sig_statistics");
   AtomSigTrace = Yap_LookupAtom("sig_trace");
@@ -280,6 +284,7 @@
   AtomStreamPos = Yap_FullLookupAtom("$stream_position");
   AtomStreamPosition = Yap_LookupAtom("stream_position");
   AtomString = Yap_LookupAtom("string");
+  AtomSubsumptive = Yap_LookupAtom("subsumptive");
   AtomSwi = Yap_LookupAtom("swi");
   AtomSyntaxError = Yap_LookupAtom("syntax_error");
   AtomSyntaxErrorHandler = Yap_LookupAtom("syntax_error_handler");
@@ -312,6 +317,7 @@
   AtomUserOut = Yap_LookupAtom("user_output");
   AtomVBar = Yap_LookupAtom("|");
   AtomVar = Yap_FullLookupAtom("$VAR");
+  AtomVariant = Yap_LookupAtom("variant");
   AtomHiddenVar = Yap_FullLookupAtom("$V");
   AtomVariable = Yap_LookupAtom("variable");
   AtomVersionNumber = Yap_FullLookupAtom("$version_name");
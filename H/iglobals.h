@@ -44,6 +44,8 @@ static void InitGlobal(void) {
   GLOBAL_ThreadsTotalTime = 0L;
 
   INIT_LOCK(GLOBAL_ThreadHandlesLock);
+
+  GLOBAL_GcThreads = 1;
 #endif	
 #if defined(YAPOR) || defined(THREADS)
 
@@ -77,6 +79,18 @@ static void InitGlobal(void) {
 
   GLOBAL_tot_agc_recovered = 0;
 
+  GLOBAL_agc_minor_calls = 0;
+  GLOBAL_agc_max_pause = 0;
+
+  GLOBAL_young_atoms = NULL;
+  GLOBAL_n_young_atoms = 0;
+  GLOBAL_young_atoms_size = 0;
+  GLOBAL_young_atoms_overflow = FALSE;
+
+  GLOBAL_agc_marked = NULL;
+  GLOBAL_n_agc_marked = 0;
+  GLOBAL_agc_marked_size = 0;
+
 #if HAVE_MMAP
   GLOBAL_mmap_arrays = NULL;
 #endif
@@ -93,6 +107,18 @@ static void InitGlobal(void) {
 #endif
   GLOBAL_OpaqueHandlersCount = 0;
   GLOBAL_OpaqueHandlers = NULL;
+
+
+#if LOW_PROF
+  GLOBAL_ProfStacks = NULL;
+  GLOBAL_ProfStacksSize = 0;
+  GLOBAL_ProfStacksInUse = 0;
+  GLOBAL_ProfSamples = 0;
+  GLOBAL_ProfSampling = 0;
+#if THREADS
+  INIT_LOCK(GLOBAL_ProfSamplesLock);
+#endif
+#endif
 #if  __simplescalar__
 
 #endif
@@ -79,6 +79,10 @@
   InitInvisibleAtoms();
   InitWideAtoms();
   InitAtoms();
+#if defined(YAPOR) || defined(THREADS)
+
+  AtomTableEpoch = 0;
+#endif
 
 #include "iatoms.h"
 #ifdef EUROTRA
@@ -159,6 +163,13 @@
   Yap_LUIndexSpace_EXT = 0;
   Yap_LUIndexSpace_SW = 0;
 
+  Yap_IndexTrees = 0;
+  Yap_IndexExpansions = 0;
+  Yap_IndexUpdates = 0;
+  Yap_IndexFirstArgSwitches = 0;
+  Yap_IndexOtherArgSwitches = 0;
+  Yap_IndexSubArgSwitches = 0;
+
 
   DUMMYCODE->opc = Yap_opcode(_op_fail);
   FAILCODE->opc = Yap_opcode(_op_fail);
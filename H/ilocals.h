@@ -135,6 +135,10 @@ static void InitWorker(int wid) {
 #if defined(YAPOR) || defined(THREADS)
   INIT_LOCK(REMOTE_SignalLock(wid));
 #endif
+#if defined(YAPOR) || defined(THREADS)
+
+  REMOTE_AtomTableHazard(wid) = NULL;
+#endif
 
 
 
@@ -185,6 +189,8 @@ static void InitWorker(int wid) {
   REMOTE_total_delay_overflow_time(wid) = 0;
   REMOTE_trail_overflows(wid) = 0;
   REMOTE_total_trail_overflow_time(wid) = 0;
+  REMOTE_in_place_expansions(wid) = 0;
+  REMOTE_in_place_bytes(wid) = 0;
   REMOTE_atom_table_overflows(wid) = 0;
   REMOTE_total_atom_table_overflow_time(wid) = 0;
 
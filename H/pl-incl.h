@@ -904,4 +904,5 @@ extern const PL_extension PL_predicates_from_tai[];
 extern const PL_extension PL_predicates_from_write[];
 extern const PL_extension PL_predicates_from_prologflag[];
 extern const PL_extension PL_predicates_from_win[];
+extern const PL_extension PL_predicates_from_readutil[];
 
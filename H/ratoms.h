@@ -133,6 +133,7 @@
   AtomIDB = AtomAdjust(AtomIDB);
   AtomIOMode = AtomAdjust(AtomIOMode);
   AtomId = AtomAdjust(AtomId);
+  AtomIncremental = AtomAdjust(AtomIncremental);
   AtomInf = AtomAdjust(AtomInf);
   AtomInitGoal = AtomAdjust(AtomInitGoal);
   AtomInitProlog = AtomAdjust(AtomInitProlog);
@@ -161,6 +162,7 @@
   AtomMaxArity = AtomAdjust(AtomMaxArity);
   AtomMaxFiles = AtomAdjust(AtomMaxFiles);
   AtomMegaClause = AtomAdjust(AtomMegaClause);
+  AtomMessageQueue = AtomAdjust(AtomMessageQueue);
   AtomMetaCall = AtomAdjust(AtomMetaCall);
   AtomMfClause = AtomAdjust(AtomMfClause);
   AtomMinus = AtomAdjust(AtomMinus);
@@ -181,6 +183,7 @@
   AtomNoMemory = AtomAdjust(AtomNoMemory);
   AtomNone = AtomAdjust(AtomNone);
   AtomNonEmptyList = AtomAdjust(AtomNonEmptyList);
+  AtomNonIncremental = AtomAdjust(AtomNonIncremental);
   AtomNot = AtomAdjust(AtomNot);
   AtomNotImplemented = AtomAdjust(AtomNotImplemented);
   AtomNotLessThanZero = AtomAdjust(AtomNotLessThanZero);
@@ -256,6 +259,7 @@
   AtomSigIti = AtomAdjust(AtomSigIti);
   AtomSigPending = AtomAdjust(AtomSigPending);
   AtomSigPipe = AtomAdjust(AtomSigPipe);
+  AtomSigProf = AtomAdjust(AtomSigProf);
   AtomSigStackDump = AtomAdjust(AtomSigStackDump);
   AtomSigStatistics = AtomAdjust(AtomSigStatistics);
   AtomSigTrace = AtomAdjust(AtomSigTrace);
@@ -280,6 +284,7 @@
   AtomStreamPos = AtomAdjust(AtomStreamPos);
   AtomStreamPosition = AtomAdjust(AtomStreamPosition);
   AtomString = AtomAdjust(AtomString);
+  AtomSubsumptive = AtomAdjust(AtomSubsumptive);
   AtomSwi = AtomAdjust(AtomSwi);
   AtomSyntaxError = AtomAdjust(AtomSyntaxError);
   AtomSyntaxErrorHandler = AtomAdjust(AtomSyntaxErrorHandler);
@@ -312,6 +317,7 @@
   AtomUserOut = AtomAdjust(AtomUserOut);
   AtomVBar = AtomAdjust(AtomVBar);
   AtomVar = AtomAdjust(AtomVar);
+  AtomVariant = AtomAdjust(AtomVariant);
   AtomHiddenVar = AtomAdjust(AtomHiddenVar);
   AtomVariable = AtomAdjust(AtomVariable);
   AtomVersionNumber = AtomAdjust(AtomVersionNumber);
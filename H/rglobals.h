@@ -44,6 +44,8 @@ static void RestoreGlobal(void) {
 
 
   REINIT_LOCK(GLOBAL_ThreadHandlesLock);
+
+
 #endif	
 #if defined(YAPOR) || defined(THREADS)
 
@@ -77,6 +79,18 @@ static void RestoreGlobal(void) {
 
 
 
+
+
+
+
+
+
+
+
+
+
+
+
 #if HAVE_MMAP
 
 #endif
@@ -93,6 +107,18 @@ static void RestoreGlobal(void) {
 #endif
 
 
+
+
+#if LOW_PROF
+
+
+
+
+
+#if THREADS
+  REINIT_LOCK(GLOBAL_ProfSamplesLock);
+#endif
+#endif
 #if  __simplescalar__
 
 #endif
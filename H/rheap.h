@@ -429,6 +429,7 @@ RestoreAtoms__( USES_REGS1 )
     RestoreAtomList(HashPtr->Entry PASS_REGS);
     HashPtr++;
   }  
+  REINIT_RWLOCK(AtomTableRWLock);
 }
 
 static void
@@ -587,6 +588,18 @@ RestoreMegaClause(MegaClause *cl USES_REGS)
   }
   max = (yamop *)((CODEADDR)cl+cl->ClSize);
 
+  if (cl->ClFlags & ExoMask) {
+    /* rows of atoms and small integers */
+    CELL *pt = (CELL *)cl->ClCode;
+
+    while (pt < (CELL *)max) {
+      Term t = *pt;
+      if (IsAtomTerm(t))
+	*pt = AtomTermAdjust(t);
+      pt++;
+    }
+    return;
+  }
   for (ptr = cl->ClCode; ptr < max; ) {
     nextptr = (yamop *)((char *)ptr + cl->ClItemSize);
     restore_opcodes(ptr, nextptr PASS_REGS);
@@ -1389,6 +1402,10 @@ CleanCode(PredEntry *pp USES_REGS)
 	CleanLUIndex(ClauseCodeToLogUpdIndex(pp->cs.p_code.TrueCodeOfPred), TRUE PASS_REGS);
       } else {
 	CleanSIndex(ClauseCodeToStaticIndex(pp->cs.p_code.TrueCodeOfPred), TRUE PASS_REGS);
+	if (IsExoPred(pp)) {
+	  /* hash tables depend on where atoms are */
+	  RestoreExoIndex(pp);
+	}
       } 
     } else if (flag & DynamicPredFlag) {
 #ifdef	DEBUG_RESTORE2
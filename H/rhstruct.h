@@ -79,6 +79,10 @@
   RestoreInvisibleAtoms();
   RestoreWideAtoms();
   RestoreAtoms();
+#if defined(YAPOR) || defined(THREADS)
+
+
+#endif
 
 #include "ratoms.h"
 #ifdef EUROTRA
@@ -135,6 +135,10 @@ static void RestoreWorker(int wid USES_REGS) {
 #if defined(YAPOR) || defined(THREADS)
   REINIT_LOCK(REMOTE_SignalLock(wid));
 #endif
+#if defined(YAPOR) || defined(THREADS)
+
+
+#endif
 
 
 
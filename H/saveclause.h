@@ -143,11 +143,13 @@
     case _count_retry_and_mark:
     case _count_retry_me:
     case _count_trust_me:
+    case _exo:
     case _profiled_retry_and_mark:
     case _profiled_retry_me:
     case _profiled_trust_me:
     case _retry:
     case _retry_and_mark:
+    case _retry_exo:
     case _retry_me:
     case _spy_or_trymark:
     case _trust:
@@ -682,6 +684,7 @@
       pc = NEXTOP(pc,xxn);
       break;
       /* instructions type xxx */
+    case _glist_valx_varx:
     case _p_and_vv:
     case _p_arg_vv:
     case _p_div_vv:
@@ -829,6 +829,7 @@ TermToGlobalOrAtomAdjust__ (Term t USES_REGS)
   return t;
 }
 
+#if USE_THREADED_CODE
 INLINE_ONLY inline EXTERN opentry *OpRTableAdjust__ (opentry * CACHE_TYPE);
 
 INLINE_ONLY inline EXTERN opentry *
@@ -836,6 +837,7 @@ OpRTableAdjust__ (opentry * ptr USES_REGS)
 {
   return (opentry *) (((opentry *) (CharP (ptr) + LOCAL_HDiff)));
 }
+#endif
 
 INLINE_ONLY inline EXTERN OpEntry *OpEntryAdjust__ (OpEntry * CACHE_TYPE);
 
@@ -264,6 +264,8 @@
 #define AtomIOMode Yap_heap_regs->AtomIOMode_
   Atom AtomId_;
 #define AtomId Yap_heap_regs->AtomId_
+  Atom AtomIncremental_;
+#define AtomIncremental Yap_heap_regs->AtomIncremental_
   Atom AtomInf_;
 #define AtomInf Yap_heap_regs->AtomInf_
   Atom AtomInitGoal_;
@@ -320,6 +322,8 @@
 #define AtomMaxFiles Yap_heap_regs->AtomMaxFiles_
   Atom AtomMegaClause_;
 #define AtomMegaClause Yap_heap_regs->AtomMegaClause_
+  Atom AtomMessageQueue_;
+#define AtomMessageQueue Yap_heap_regs->AtomMessageQueue_
   Atom AtomMetaCall_;
 #define AtomMetaCall Yap_heap_regs->AtomMetaCall_
   Atom AtomMfClause_;
@@ -360,6 +364,8 @@
 #define AtomNone Yap_heap_regs->AtomNone_
   Atom AtomNonEmptyList_;
 #define AtomNonEmptyList Yap_heap_regs->AtomNonEmptyList_
+  Atom AtomNonIncremental_;
+#define AtomNonIncremental Yap_heap_regs->AtomNonIncremental_
   Atom AtomNot_;
 #define AtomNot Yap_heap_regs->AtomNot_
   Atom AtomNotImplemented_;
@@ -510,6 +516,8 @@
 #define AtomSigPending Yap_heap_regs->AtomSigPending_
   Atom AtomSigPipe_;
 #define AtomSigPipe Yap_heap_regs->AtomSigPipe_
+  Atom AtomSigProf_;
+#define AtomSigProf Yap_heap_regs->AtomSigProf_
   Atom AtomSigStackDump_;
 #define AtomSigStackDump Yap_heap_regs->AtomSigStackDump_
   Atom AtomSigStatistics_;
@@ -558,6 +566,8 @@
 #define AtomStreamPosition Yap_heap_regs->AtomStreamPosition_
   Atom AtomString_;
 #define AtomString Yap_heap_regs->AtomString_
+  Atom AtomSubsumptive_;
+#define AtomSubsumptive Yap_heap_regs->AtomSubsumptive_
   Atom AtomSwi_;
 #define AtomSwi Yap_heap_regs->AtomSwi_
   Atom AtomSyntaxError_;
@@ -622,6 +632,8 @@
 #define AtomVBar Yap_heap_regs->AtomVBar_
   Atom AtomVar_;
 #define AtomVar Yap_heap_regs->AtomVar_
+  Atom AtomVariant_;
+#define AtomVariant Yap_heap_regs->AtomVariant_
   Atom AtomHiddenVar_;
 #define AtomHiddenVar Yap_heap_regs->AtomHiddenVar_
   Atom AtomVariable_;
@@ -40,19 +40,27 @@
 	    PredEntry *ap = cl->ClPred;
 #endif
 	    
-	    LOCK(ap->PELock);
-	    DEC_CLREF_COUNT(cl);
-	    cl->ClFlags &= ~InUseMask;
-	    erase = (cl->ClFlags & (ErasedMask|DirtyMask)) && !(cl->ClRefCount);
-	    if (erase) {
-	      /* at this point, we are the only ones accessing the clause,
-		 hence we don't need to have a lock it */
-	      if (cl->ClFlags & ErasedMask) 
-		Yap_ErLogUpdIndex(cl);
-	      else
-		Yap_CleanUpIndex(cl);
+#if THREADS
+	    if (!(cl->ClFlags & (ErasedMask|DirtyMask)) &&
+		drop_clref_unless_last(&cl->ClRefCount))
+	      erase = FALSE;
+	    else
+#endif
+	    {
+	      LOCK(ap->PELock);
+	      DEC_CLREF_COUNT(cl);
+	      cl->ClFlags &= ~InUseMask;
+	      erase = (cl->ClFlags & (ErasedMask|DirtyMask)) && !(cl->ClRefCount);
+	      if (erase) {
+		/* at this point, we are the only ones accessing the clause,
+		   hence we don't need to have a lock it */
+		if (cl->ClFlags & ErasedMask) 
+		  Yap_ErLogUpdIndex(cl);
+		else
+		  Yap_CleanUpIndex(cl);
+	      }
+	      UNLOCK(ap->PELock);
 	    }
-	    UNLOCK(ap->PELock);
 	  } else {
 	    TrailTerm(pt0) = d1;
 	    TrailVal(pt0) = TrailVal(pt1);
@@ -141,19 +149,27 @@
 #endif
 	  int erase;
 
-	  LOCK(ap->PELock);
-	  DEC_CLREF_COUNT(cl);
-	  cl->ClFlags &= ~InUseMask;
-	  erase = (cl->ClFlags & (DirtyMask|ErasedMask)) && !(cl->ClRefCount);
-	  if (erase) {
-	    /* at this point, we are the only ones accessing the clause,
-	       hence we don't need to have a lock it */
-	    if (cl->ClFlags & ErasedMask) 
-	      Yap_ErLogUpdIndex(cl);
-	    else
-	      Yap_CleanUpIndex(cl);
+#if THREADS
+	  if (!(cl->ClFlags & (DirtyMask|ErasedMask)) &&
+	      drop_clref_unless_last(&cl->ClRefCount))
+	    erase = FALSE;
+	  else
+#endif
+	  {
+	    LOCK(ap->PELock);
+	    DEC_CLREF_COUNT(cl);
+	    cl->ClFlags &= ~InUseMask;
+	    erase = (cl->ClFlags & (DirtyMask|ErasedMask)) && !(cl->ClRefCount);
+	    if (erase) {
+	      /* at this point, we are the only ones accessing the clause,
+		 hence we don't need to have a lock it */
+	      if (cl->ClFlags & ErasedMask) 
+		Yap_ErLogUpdIndex(cl);
+	      else
+		Yap_CleanUpIndex(cl);
+	    }
+	    UNLOCK(ap->PELock);
 	  }
-	  UNLOCK(ap->PELock);
 	} else {
 	  TrailTerm(pt0) = d1;
 	  pt0++;
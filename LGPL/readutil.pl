@@ -50,12 +50,8 @@ link  the  foreign  code  at  runtime    and   fallback  to  the  Prolog
 implementation if the shared object cannot be found.
 */
 
-:- volatile
-	read_line_to_codes/2,
-	read_line_to_codes/3,
-	read_stream_to_codes/2,
-	read_stream_to_codes/3.
-
+link_foreign :-			% YAP: built into the stream layer
+	predicate_property(read_line_to_codes(_,_), built_in), !.
 link_foreign :-
 	catch(load_foreign_library(foreign(readutil)), _, fail), !.
 link_foreign :-
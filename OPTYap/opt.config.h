@@ -48,10 +48,12 @@
 /************************************************************************
 **      multithreading design for tabling (mandatory, define one)      **
 ************************************************************************/
+#if !defined(THREADS_NO_SHARING) && !defined(THREADS_SUBGOAL_SHARING) && !defined(THREADS_FULL_SHARING) && !defined(THREADS_CONSUMER_SHARING)
 #define THREADS_NO_SHARING 1
 /* #define THREADS_SUBGOAL_SHARING 1 */
 /* #define THREADS_FULL_SHARING 1 */
 /* #define THREADS_CONSUMER_SHARING 1 */
+#endif
 
 /*************************************************************************
 **      tries locking scheme (mandatory, define one per trie type)      **
@@ -68,20 +70,29 @@
 ** only locks a table data structure when it is going to update it. You **
 ** can use (TRIE_TYPE)_ALLOC_BEFORE_CHECK with this scheme to allocate  **
 ** a node before checking if it will be necessary.                      **
+**                                                                      **
+** The (TRIE_TYPE)_INSERT_WITH_CAS option turns the write level scheme  **
+** into a lock-free one: new nodes are linked with a compare-and-swap   **
+** operation and hash tables are created and expanded without locking  **
+** the parent node, so concurrent insertions do not serialize. It needs **
+** (TRIE_TYPE)_LOCK_AT_WRITE_LEVEL and is ignored with other schemes.   **
 *************************************************************************/
 /* #define SUBGOAL_TRIE_LOCK_AT_ENTRY_LEVEL 1 */
-#define SUBGOAL_TRIE_LOCK_AT_NODE_LEVEL  1
-/* #define SUBGOAL_TRIE_LOCK_AT_WRITE_LEVEL 1 */
+/* #define SUBGOAL_TRIE_LOCK_AT_NODE_LEVEL  1 */
+#define SUBGOAL_TRIE_LOCK_AT_WRITE_LEVEL 1
 /* #define SUBGOAL_TRIE_ALLOC_BEFORE_CHECK  1 */
+#define SUBGOAL_TRIE_INSERT_WITH_CAS     1
 
 /* #define ANSWER_TRIE_LOCK_AT_ENTRY_LEVEL 1 */
-#define ANSWER_TRIE_LOCK_AT_NODE_LEVEL  1
-/* #define ANSWER_TRIE_LOCK_AT_WRITE_LEVEL 1 */
+/* #define ANSWER_TRIE_LOCK_AT_NODE_LEVEL  1 */
+#define ANSWER_TRIE_LOCK_AT_WRITE_LEVEL 1
 /* #define ANSWER_TRIE_ALLOC_BEFORE_CHECK  1 */
+#define ANSWER_TRIE_INSERT_WITH_CAS     1
 
-#define GLOBAL_TRIE_LOCK_AT_NODE_LEVEL  1
-/* #define GLOBAL_TRIE_LOCK_AT_WRITE_LEVEL 1 */
+/* #define GLOBAL_TRIE_LOCK_AT_NODE_LEVEL  1 */
+#define GLOBAL_TRIE_LOCK_AT_WRITE_LEVEL 1
 /* #define GLOBAL_TRIE_ALLOC_BEFORE_CHECK  1 */
+#define GLOBAL_TRIE_INSERT_WITH_CAS     1
 
 /*******************************************************************
 **      tries locking data structure (mandatory, define one)      **
@@ -107,6 +118,16 @@
 ******************************************************/
 #define TRIE_COMPACT_PAIRS 1
 
+/************************************************************
+**      support call subsumptive tabling ? (optional)      **
+************************************************************/
+#define TABLING_CALL_SUBSUMPTION 1
+
+/*******************************************************
+**      support incremental tabling ? (optional)      **
+*******************************************************/
+#define TABLING_INCREMENTAL 1
+
 /************************************************************
 **      support global trie for subterms ? (optional)      **
 ************************************************************/
@@ -186,6 +207,8 @@
 #undef MODE_DIRECTED_TABLING
 #undef TABLING_EARLY_COMPLETION
 #undef TRIE_COMPACT_PAIRS
+#undef TABLING_CALL_SUBSUMPTION
+#undef TABLING_INCREMENTAL
 #undef GLOBAL_TRIE_FOR_SUBTERMS
 #undef INCOMPLETE_TABLING
 #undef LIMIT_TABLING
@@ -209,6 +232,10 @@
 #endif
 #ifndef SUBGOAL_TRIE_LOCK_AT_WRITE_LEVEL
 #undef SUBGOAL_TRIE_ALLOC_BEFORE_CHECK
+#undef SUBGOAL_TRIE_INSERT_WITH_CAS
+#endif
+#ifdef SUBGOAL_TRIE_INSERT_WITH_CAS
+#undef SUBGOAL_TRIE_ALLOC_BEFORE_CHECK
 #endif 
 /* ANSWER_TRIE_LOCK_LEVEL */
 #if !defined(ANSWER_TRIE_LOCK_AT_ENTRY_LEVEL) && !defined(ANSWER_TRIE_LOCK_AT_NODE_LEVEL) && !defined(ANSWER_TRIE_LOCK_AT_WRITE_LEVEL)
@@ -225,6 +252,10 @@
 #endif
 #ifndef ANSWER_TRIE_LOCK_AT_WRITE_LEVEL
 #undef ANSWER_TRIE_ALLOC_BEFORE_CHECK
+#undef ANSWER_TRIE_INSERT_WITH_CAS
+#endif
+#ifdef ANSWER_TRIE_INSERT_WITH_CAS
+#undef ANSWER_TRIE_ALLOC_BEFORE_CHECK
 #endif 
 /* GLOBAL_TRIE_LOCK_LEVEL */
 #if !defined(GLOBAL_TRIE_LOCK_AT_NODE_LEVEL) && !defined(GLOBAL_TRIE_LOCK_AT_WRITE_LEVEL)
@@ -235,6 +266,10 @@
 #endif
 #ifndef GLOBAL_TRIE_LOCK_AT_WRITE_LEVEL
 #undef GLOBAL_TRIE_ALLOC_BEFORE_CHECK
+#undef GLOBAL_TRIE_INSERT_WITH_CAS
+#endif
+#ifdef GLOBAL_TRIE_INSERT_WITH_CAS
+#undef GLOBAL_TRIE_ALLOC_BEFORE_CHECK
 #endif
 /* TRIE_LOCK_USING */
 #if !defined(TRIE_LOCK_USING_NODE_FIELD) && !defined(TRIE_LOCK_USING_GLOBAL_ARRAY)
@@ -248,13 +283,16 @@
 #undef SUBGOAL_TRIE_LOCK_AT_NODE_LEVEL
 #undef SUBGOAL_TRIE_LOCK_AT_WRITE_LEVEL
 #undef SUBGOAL_TRIE_ALLOC_BEFORE_CHECK
+#undef SUBGOAL_TRIE_INSERT_WITH_CAS
 #undef ANSWER_TRIE_LOCK_AT_ENTRY_LEVEL
 #undef ANSWER_TRIE_LOCK_AT_NODE_LEVEL
 #undef ANSWER_TRIE_LOCK_AT_WRITE_LEVEL
 #undef ANSWER_TRIE_ALLOC_BEFORE_CHECK
+#undef ANSWER_TRIE_INSERT_WITH_CAS
 #undef GLOBAL_TRIE_LOCK_AT_NODE_LEVEL
 #undef GLOBAL_TRIE_LOCK_AT_WRITE_LEVEL
 #undef GLOBAL_TRIE_ALLOC_BEFORE_CHECK
+#undef GLOBAL_TRIE_INSERT_WITH_CAS
 #undef TRIE_LOCK_USING_NODE_FIELD
 #undef TRIE_LOCK_USING_GLOBAL_ARRAY
 #endif /* TABLING && (YAPOR || THREADS) */
@@ -286,12 +324,14 @@
 #undef SUBGOAL_TRIE_LOCK_AT_NODE_LEVEL
 #undef SUBGOAL_TRIE_LOCK_AT_WRITE_LEVEL
 #undef SUBGOAL_TRIE_ALLOC_BEFORE_CHECK
+#undef SUBGOAL_TRIE_INSERT_WITH_CAS
 #endif
 #if defined(THREADS_NO_SHARING) || defined(THREADS_SUBGOAL_SHARING)
 #undef ANSWER_TRIE_LOCK_AT_ENTRY_LEVEL
 #undef ANSWER_TRIE_LOCK_AT_NODE_LEVEL
 #undef ANSWER_TRIE_LOCK_AT_WRITE_LEVEL
 #undef ANSWER_TRIE_ALLOC_BEFORE_CHECK
+#undef ANSWER_TRIE_INSERT_WITH_CAS
 #endif
 #else /* ! TABLING || ! THREADS */
 #undef THREADS_NO_SHARING
@@ -343,6 +383,14 @@
 #undef TABLING_EARLY_COMPLETION
 #endif
 
+#if defined(YAPOR) || defined(THREADS_SUBGOAL_SHARING) || defined(THREADS_FULL_SHARING) || defined(THREADS_CONSUMER_SHARING) || defined(LIMIT_TABLING)
+#undef TABLING_CALL_SUBSUMPTION
+#endif
+
+#if defined(YAPOR) || defined(THREADS) || defined(LIMIT_TABLING)
+#undef TABLING_INCREMENTAL
+#endif
+
 #if defined(YAPOR) || defined(THREADS)
 #undef INCOMPLETE_TABLING
 #undef LIMIT_TABLING
@@ -155,6 +155,10 @@ void Yap_init_global_optyap_data(int max_table_size, int n_workers, int sch_loop
   GLOBAL_last_sg_fr = NULL;
   GLOBAL_check_sg_fr = NULL;
 #endif /* LIMIT_TABLING */
+#ifdef TABLING_INCREMENTAL
+  GLOBAL_inc_timestamp = 0;
+  GLOBAL_inc_retired_sg_fr = NULL;
+#endif /* TABLING_INCREMENTAL */
 #ifdef YAPOR
   new_dependency_frame(GLOBAL_root_dep_fr, FALSE, NULL, NULL, NULL, NULL, FALSE, NULL);
 #endif /* YAPOR */
@@ -40,6 +40,12 @@ static Int p_abolish_frozen_choice_points_until( USES_REGS1 );
 static Int p_abolish_frozen_choice_points_all( USES_REGS1 );
 static Int p_table( USES_REGS1 );
 static Int p_tabling_mode( USES_REGS1 );
+#ifdef TABLING_INCREMENTAL
+static Int p_incremental( USES_REGS1 );
+#endif /* TABLING_INCREMENTAL */
+#ifdef TABLING_CALL_SUBSUMPTION
+static Int p_call_subsumption( USES_REGS1 );
+#endif /* TABLING_CALL_SUBSUMPTION */
 static Int p_abolish_table( USES_REGS1 );
 static Int p_abolish_all_tables( USES_REGS1 );
 static Int p_show_tabled_predicates( USES_REGS1 );
@@ -206,6 +212,12 @@ void Yap_init_optyap_preds(void) {
   Yap_InitCPred("abolish_frozen_choice_points", 0, p_abolish_frozen_choice_points_all, SafePredFlag|SyncPredFlag);
   Yap_InitCPred("$c_table", 3, p_table, SafePredFlag|SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("$c_tabling_mode", 3, p_tabling_mode, SafePredFlag|SyncPredFlag|HiddenPredFlag);
+#ifdef TABLING_INCREMENTAL
+  Yap_InitCPred("$c_incremental", 2, p_incremental, SafePredFlag|SyncPredFlag|HiddenPredFlag);
+#endif /* TABLING_INCREMENTAL */
+#ifdef TABLING_CALL_SUBSUMPTION
+  Yap_InitCPred("$c_call_subsumption", 0, p_call_subsumption, SafePredFlag|SyncPredFlag|HiddenPredFlag);
+#endif /* TABLING_CALL_SUBSUMPTION */
   Yap_InitCPred("$c_abolish_table", 2, p_abolish_table, SafePredFlag|SyncPredFlag|HiddenPredFlag);
   Yap_InitCPred("abolish_all_tables", 0, p_abolish_all_tables, SafePredFlag|SyncPredFlag);
   Yap_InitCPred("show_tabled_predicates", 1, p_show_tabled_predicates, SafePredFlag|SyncPredFlag);
@@ -392,6 +404,16 @@ static Int p_tabling_mode( USES_REGS1 ) {
   tvalue = Deref(ARG3);
   if (IsVarTerm(tvalue)) {
     t = TermNil;
+#ifdef TABLING_INCREMENTAL
+    if (IsMode_Incremental(TabEnt_flags(tab_ent)))
+      t = MkPairTerm(MkAtomTerm(AtomIncremental), t);
+    else if (IsMode_NonIncremental(TabEnt_flags(tab_ent)))
+      t = MkPairTerm(MkAtomTerm(AtomNonIncremental), t);
+#endif /* TABLING_INCREMENTAL */
+    if (IsMode_Variant(TabEnt_flags(tab_ent)))
+      t = MkPairTerm(MkAtomTerm(AtomVariant), t);
+    else if (IsMode_Subsumptive(TabEnt_flags(tab_ent)))
+      t = MkPairTerm(MkAtomTerm(AtomSubsumptive), t);
     if (IsMode_LocalTrie(TabEnt_flags(tab_ent)))
       t = MkPairTerm(MkAtomTerm(AtomLocalTrie), t);
     else if (IsMode_GlobalTrie(TabEnt_flags(tab_ent)))
@@ -406,6 +428,16 @@ static Int p_tabling_mode( USES_REGS1 ) {
       t = MkPairTerm(MkAtomTerm(AtomLocal), t);
     t = MkPairTerm(MkAtomTerm(AtomDefault), t);
     t = MkPairTerm(t, TermNil);
+#ifdef TABLING_INCREMENTAL
+    if (IsMode_Incremental(TabEnt_mode(tab_ent)))
+      t = MkPairTerm(MkAtomTerm(AtomIncremental), t);
+    else if (IsMode_NonIncremental(TabEnt_mode(tab_ent)))
+      t = MkPairTerm(MkAtomTerm(AtomNonIncremental), t);
+#endif /* TABLING_INCREMENTAL */
+    if (IsMode_Variant(TabEnt_mode(tab_ent)))
+      t = MkPairTerm(MkAtomTerm(AtomVariant), t);
+    else if (IsMode_Subsumptive(TabEnt_mode(tab_ent)))
+      t = MkPairTerm(MkAtomTerm(AtomSubsumptive), t);
     if (IsMode_LocalTrie(TabEnt_mode(tab_ent)))
       t = MkPairTerm(MkAtomTerm(AtomLocalTrie), t);
     else if (IsMode_GlobalTrie(TabEnt_mode(tab_ent)))
@@ -458,12 +490,69 @@ static Int p_tabling_mode( USES_REGS1 ) {
 	SetMode_GlobalTrie(TabEnt_mode(tab_ent));
 	return(TRUE);
       }
+    } else if (value == 7) {  /* variant */
+      SetMode_Variant(TabEnt_flags(tab_ent));
+      if (! IsMode_Subsumptive(yap_flags[TABLING_MODE_FLAG])) {
+	SetMode_Variant(TabEnt_mode(tab_ent));
+	return(TRUE);
+      }
+#ifdef TABLING_CALL_SUBSUMPTION
+    } else if (value == 8) {  /* subsumptive */
+      SetMode_Subsumptive(TabEnt_flags(tab_ent));
+      if (! IsMode_Variant(yap_flags[TABLING_MODE_FLAG])) {
+	SetMode_Subsumptive(TabEnt_mode(tab_ent));
+	return(TRUE);
+      }
+#endif /* TABLING_CALL_SUBSUMPTION */
+#ifdef TABLING_INCREMENTAL
+    } else if (value == 9) {  /* incremental */
+      SetMode_Incremental(TabEnt_flags(tab_ent));
+      SetMode_Incremental(TabEnt_mode(tab_ent));
+      return(TRUE);
+    } else if (value == 10) {  /* non_incremental */
+      SetMode_NonIncremental(TabEnt_flags(tab_ent));
+      SetMode_NonIncremental(TabEnt_mode(tab_ent));
+      return(TRUE);
+#endif /* TABLING_INCREMENTAL */
     }    
   }
   return (FALSE);
 }
 
 
+#ifdef TABLING_INCREMENTAL
+static Int p_incremental( USES_REGS1 ) {
+  Term mod, t;
+  PredEntry *pe;
+
+  mod = Deref(ARG1);
+  t = Deref(ARG2);
+  if (IsAtomTerm(t))
+    pe = RepPredProp(PredPropByAtom(AtomOfTerm(t), mod));
+  else if (IsApplTerm(t))
+    pe = RepPredProp(PredPropByFunc(FunctorOfTerm(t), mod));
+  else
+    return (FALSE);
+  /* only logical update predicates, their calls go through the spy entry */
+  if (!(pe->PredFlags & LogUpdatePredFlag))
+    return (FALSE);
+  PELOCK(101,pe);
+  pe->ExtraPredFlags |= IncrementalPredFlag;
+  Yap_UpdateIncrementalPred(pe);
+  UNLOCKPE(101,pe);
+  return (TRUE);
+}
+#endif /* TABLING_INCREMENTAL */
+
+
+#ifdef TABLING_CALL_SUBSUMPTION
+static Int p_call_subsumption( USES_REGS1 ) {
+  /* only defined when subsumptive tabling is compiled in */
+  return (TRUE);
+}
+#endif /* TABLING_CALL_SUBSUMPTION */
+
+
 static Int p_abolish_table( USES_REGS1 ) {
   Term mod, t;
   tab_ent_ptr tab_ent;
@@ -57,6 +57,9 @@ void free_answer_hash_chain(ans_hash_ptr);
 void abolish_table(tab_ent_ptr);
 void show_table(tab_ent_ptr, int, IOSTREAM *);
 void show_global_trie(int, IOSTREAM *);
+#ifdef TABLING_INCREMENTAL
+void add_incremental_dependency(struct pred_entry *);
+#endif /* TABLING_INCREMENTAL */
 #endif /* TABLING */
 
 
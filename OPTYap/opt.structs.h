@@ -329,6 +329,10 @@ struct global_optyap_data {
   struct subgoal_frame *last_subgoal_frame;
   struct subgoal_frame *check_subgoal_frame;
 #endif /* LIMIT_TABLING */
+#ifdef TABLING_INCREMENTAL
+  UInt incremental_timestamp;
+  struct subgoal_frame *incremental_retired_subgoal_frames;
+#endif /* TABLING_INCREMENTAL */
 #ifdef YAPOR
   struct dependency_frame *root_dependency_frame;
 #endif /* YAPOR */
@@ -405,6 +409,8 @@ struct global_optyap_data {
 #define GLOBAL_first_sg_fr                      (GLOBAL_optyap_data.first_subgoal_frame)
 #define GLOBAL_last_sg_fr                       (GLOBAL_optyap_data.last_subgoal_frame)
 #define GLOBAL_check_sg_fr                      (GLOBAL_optyap_data.check_subgoal_frame)
+#define GLOBAL_inc_timestamp                    (GLOBAL_optyap_data.incremental_timestamp)
+#define GLOBAL_inc_retired_sg_fr                (GLOBAL_optyap_data.incremental_retired_subgoal_frames)
 #define GLOBAL_root_dep_fr                      (GLOBAL_optyap_data.root_dependency_frame)
 #define GLOBAL_th_dep_fr(wid)                   (GLOBAL_optyap_data.threads_dependency_frame[wid])
 #define GLOBAL_table_var_enumerator(index)      (GLOBAL_optyap_data.table_var_enumerator[index])
@@ -488,6 +488,7 @@
 #ifdef THREADS_CONSUMER_SHARING
     if (SgFr_state(sg_fr) == ready_external) {
       init_subgoal_frame(sg_fr);
+      UNLOCK_SG_FR(sg_fr);
       store_generator_consumer_node(tab_ent, sg_fr, TRUE, PREG->u.Otapl.s);
       PREFETCH_OP(PREG);
       allocate_environment();
@@ -1270,10 +1271,9 @@
 	  }
 	}
       }
-#else
+#endif /* THREADS_FULL_SHARING */
       UNLOCK_ANSWER_NODE(ans_node);
       UNLOCK_ANSWER_TRIE(sg_fr);
-#endif /* THREADS_FULL_SHARING */
 #if defined(THREADS_FULL_SHARING) || defined(THREADS_CONSUMER_SHARING)
       INFO_THREADS("new      answer(rep)  sgfr=%p ans_node=%p",SgFr_sg_ent(sg_fr),ans_node);
 #else
@@ -1989,7 +1989,10 @@ answer_resolution_completion:
 	 }
 
 	 sg_fr_ptr sg_fr = GEN_CP(B)->cp_sg_fr;
-	 if (SgFr_sg_ent_state(sg_fr) < complete || (SgFr_sg_ent_state(sg_fr) >= complete && TrNode_child(ans_node)!= NULL))
+	 /* the generator stores its answers before it marks the subgoal complete, **
+	 ** so read the state first and only then look again for new answers      */
+	 if (__atomic_load_n(&SgFr_sg_ent_state(sg_fr), __ATOMIC_ACQUIRE) < complete ||
+	     __atomic_load_n(&TrNode_child(ans_node), __ATOMIC_RELAXED) != NULL)
 	   do_not_complete_tables = 1; 
 
        } else {   /* using the B->cp_ap == ANSWER_RESOLUTION_COMPLETION to distinguish gen_cons nodes from gen */
@@ -2053,7 +2056,8 @@ answer_resolution_completion:
 
 	 if (DepFr_external(dep_fr) == TRUE){
 	   sg_fr_ptr sg_fr = GEN_CP(DepFr_cons_cp(dep_fr))->cp_sg_fr;
-	   if (SgFr_sg_ent_state(sg_fr) < complete || (SgFr_sg_ent_state(sg_fr) >= complete && TrNode_child(ans_node)!= NULL))
+	   if (__atomic_load_n(&SgFr_sg_ent_state(sg_fr), __ATOMIC_ACQUIRE) < complete ||
+	       __atomic_load_n(&TrNode_child(ans_node), __ATOMIC_RELAXED) != NULL)
 	     do_not_complete_tables = 1;
 	   
 	 }
@@ -88,6 +88,12 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
 #define Flag_LocalTrie          0x100
 #define Flag_GlobalTrie         0x200
 #define Flags_TrieMode          (Flag_LocalTrie | Flag_GlobalTrie)
+#define Flag_Variant            0x1000
+#define Flag_Subsumptive        0x2000
+#define Flags_CallMode          (Flag_Variant | Flag_Subsumptive)
+#define Flag_Incremental        0x4000
+#define Flag_NonIncremental     0x8000
+#define Flags_IncrementalMode   (Flag_Incremental | Flag_NonIncremental)
 
 #define SetMode_Batched(X)      (X) = ((X) & ~Flags_SchedulingMode) | Flag_Batched
 #define SetMode_Local(X)        (X) = ((X) & ~Flags_SchedulingMode) | Flag_Local
@@ -95,12 +101,20 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
 #define SetMode_LoadAnswers(X)  (X) = ((X) & ~Flags_AnswersMode) | Flag_LoadAnswers
 #define SetMode_LocalTrie(X)    (X) = ((X) & ~Flags_TrieMode) | Flag_LocalTrie
 #define SetMode_GlobalTrie(X)   (X) = ((X) & ~Flags_TrieMode) | Flag_GlobalTrie
+#define SetMode_Variant(X)      (X) = ((X) & ~Flags_CallMode) | Flag_Variant
+#define SetMode_Subsumptive(X)  (X) = ((X) & ~Flags_CallMode) | Flag_Subsumptive
+#define SetMode_Incremental(X)  (X) = ((X) & ~Flags_IncrementalMode) | Flag_Incremental
+#define SetMode_NonIncremental(X) (X) = ((X) & ~Flags_IncrementalMode) | Flag_NonIncremental
 #define IsMode_Batched(X)       ((X) & Flag_Batched)
 #define IsMode_Local(X)         ((X) & Flag_Local)
 #define IsMode_ExecAnswers(X)   ((X) & Flag_ExecAnswers)
 #define IsMode_LoadAnswers(X)   ((X) & Flag_LoadAnswers)
 #define IsMode_LocalTrie(X)     ((X) & Flag_LocalTrie)
 #define IsMode_GlobalTrie(X)    ((X) & Flag_GlobalTrie)
+#define IsMode_Variant(X)       ((X) & Flag_Variant)
+#define IsMode_Subsumptive(X)   ((X) & Flag_Subsumptive)
+#define IsMode_Incremental(X)   ((X) & Flag_Incremental)
+#define IsMode_NonIncremental(X) ((X) & Flag_NonIncremental)
 
 
 
@@ -216,6 +230,72 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
 #define IS_GLOBAL_TRIE_HASH(NODE)       (TrNode_entry(NODE) == GLOBAL_TRIE_HASH_MARK)
 #define HASH_TRIE_LOCK(NODE)            GLOBAL_trie_locks((((CELL) (NODE)) >> 5) & (TRIE_LOCK_BUCKETS - 1))
 
+/* lock-free tries (TRIE_TYPE)_INSERT_WITH_CAS: a chain of nodes being moved **
+** to a hash or to bigger buckets is frozen by tagging the pointer to it     */
+#define TRIE_CAS(PTR, OLD, NEW)         __sync_bool_compare_and_swap(PTR, OLD, NEW)
+#define TRIE_LOAD(X)                    __atomic_load_n(&(X), __ATOMIC_ACQUIRE)
+#define TRIE_STORE(X, VALUE)            __atomic_store_n(&(X), VALUE, __ATOMIC_RELEASE)
+#define TRIE_FREEZE(PTR)                ((CELL) (PTR) | 0x1)
+#define IS_TRIE_FROZEN(PTR)             ((CELL) (PTR) & 0x1)
+#define TRIE_UNFREEZE(PTR)              ((CELL) (PTR) & ~(0x1))
+/* bucket arrays replaced by an expansion may still be read by concurrent **
+** insertions, so they are kept (frozen) until the hash itself is freed   */
+#define FREE_OLD_HASH_BUCKETS(HASH)                                         \
+        { void **old_buckets = (void **) Hash_old_buckets(HASH);            \
+          while (old_buckets) {                                             \
+            void **next_buckets = (void **) TRIE_UNFREEZE(*old_buckets);    \
+            FREE_BUCKETS(old_buckets);                                      \
+            old_buckets = next_buckets;                                     \
+          }                                                                 \
+        }
+/* read a consistent view of a hash, waiting while it is being expanded   **
+** (a negative number of buckets marks the thread expanding the hash)     */
+#define TRIE_CAS_LOAD_HASH(HASH, BUCKETS, NUM_BUCKETS)                                        \
+        do {                                                                                  \
+          NUM_BUCKETS = TRIE_LOAD(Hash_num_buckets(HASH));                                    \
+          BUCKETS = TRIE_LOAD(Hash_buckets(HASH));                                            \
+        } while (NUM_BUCKETS < 0 || NUM_BUCKETS != TRIE_LOAD(Hash_num_buckets(HASH)))
+/* link NEW_NODE in front of FIRST, failing if HEAD no longer points to FIRST */
+#define TRIE_CAS_PUSH_NODE(HEAD, FIRST, NEW_NODE)                                             \
+        (TrNode_next(NEW_NODE) = (FIRST), TRIE_CAS(HEAD, FIRST, NEW_NODE))
+/* move the (frozen) chain starting at CHAIN to the buckets of a new HASH */
+#define TRIE_CAS_MOVE_CHAIN_TO_HASH(NODE_PTR, HASH, CHAIN)                                    \
+        { NODE_PTR chain_node = (CHAIN), next_node, *bucket;                                  \
+          do {                                                                                \
+            bucket = Hash_buckets(HASH) + HASH_ENTRY(TrNode_entry(chain_node), BASE_HASH_BUCKETS); \
+            next_node = TrNode_next(chain_node);                                              \
+            TrNode_next(chain_node) = *bucket;                                                \
+            *bucket = chain_node;                                                             \
+            Hash_num_nodes(HASH)++;                                                           \
+            chain_node = next_node;                                                           \
+          } while (chain_node);                                                               \
+        }
+/* double the buckets of HASH, once this thread negated its number of buckets;  **
+** each old bucket is frozen before its nodes are moved, so that inserters     **
+** seeing it frozen read the hash again, and the old array is kept for them    */
+#define TRIE_CAS_EXPAND_HASH(NODE_PTR, HASH, BUCKETS, NUM_BUCKETS)                            \
+        { NODE_PTR chain_node, next_node, *bucket, *old_bucket, *new_buckets;                 \
+          ALLOC_BUCKETS(new_buckets, (NUM_BUCKETS) * 2);                                      \
+          old_bucket = (BUCKETS) + (NUM_BUCKETS);                                             \
+          do {                                                                                \
+            old_bucket--;                                                                     \
+            do                                                                                \
+              chain_node = TRIE_LOAD(*old_bucket);                                            \
+            while (! TRIE_CAS(old_bucket, chain_node, (NODE_PTR) TRIE_FREEZE(chain_node)));   \
+            while (chain_node) {                                                              \
+              bucket = new_buckets + HASH_ENTRY(TrNode_entry(chain_node), (NUM_BUCKETS) * 2); \
+              next_node = TrNode_next(chain_node);                                            \
+              TrNode_next(chain_node) = *bucket;                                              \
+              *bucket = chain_node;                                                           \
+              chain_node = next_node;                                                         \
+            }                                                                                 \
+          } while (old_bucket != (BUCKETS));                                                  \
+          *(BUCKETS) = (NODE_PTR) TRIE_FREEZE(Hash_old_buckets(HASH));                        \
+          Hash_old_buckets(HASH) = (BUCKETS);                                                 \
+          TRIE_STORE(Hash_buckets(HASH), new_buckets);                                        \
+          TRIE_STORE(Hash_num_buckets(HASH), (NUM_BUCKETS) * 2);                              \
+        }
+
 /* auxiliary stack */
 #define STACK_PUSH_UP(ITEM, STACK)          *--(STACK) = (CELL)(ITEM)
 #define STACK_POP_UP(STACK)                 *--(STACK)
@@ -322,6 +402,24 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
 #define AnsHash_init_previous_field(HASH, SG_FR)
 #endif /* MODE_DIRECTED_TABLING */
 
+#ifdef TABLING_INCREMENTAL
+#define SgFr_init_incremental_fields(SG_FR)                   \
+        SgFr_inc_dependencies(SG_FR) = NULL;                  \
+        SgFr_inc_timestamp(SG_FR) = GLOBAL_inc_timestamp
+#define free_incremental_dependencies(SG_FR)                  \
+        { inc_dep_ptr dep = SgFr_inc_dependencies(SG_FR);     \
+          while (dep) {                                       \
+            inc_dep_ptr next = IncDep_next(dep);              \
+            FREE_BLOCK(dep);                                  \
+            dep = next;                                       \
+          }                                                   \
+          SgFr_inc_dependencies(SG_FR) = NULL;                \
+        }
+#else
+#define SgFr_init_incremental_fields(SG_FR)
+#define free_incremental_dependencies(SG_FR)
+#endif /* TABLING_INCREMENTAL */
+
 #if defined(YAPOR) || defined(THREADS_FULL_SHARING) || defined(THREADS_CONSUMER_SHARING)
 #define INIT_LOCK_SG_FR(SG_FR)  INIT_LOCK(SgFr_lock(SG_FR))
 #define LOCK_SG_FR(SG_FR)       LOCK(SgFr_lock(SG_FR))
@@ -376,6 +474,30 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
         UNLOCK_SG_FR(SG_FR)
 #endif /* ANSWER_TRIE_LOCK_AT_ENTRY_LEVEL */
 
+#ifdef SUBGOAL_TRIE_INSERT_WITH_CAS
+#define SgHash_init_old_buckets_field(HASH)   Hash_old_buckets(HASH) = NULL
+#define SgHash_free_old_buckets(HASH)         FREE_OLD_HASH_BUCKETS(HASH)
+#else
+#define SgHash_init_old_buckets_field(HASH)
+#define SgHash_free_old_buckets(HASH)
+#endif /* SUBGOAL_TRIE_INSERT_WITH_CAS */
+
+#ifdef ANSWER_TRIE_INSERT_WITH_CAS
+#define AnsHash_init_old_buckets_field(HASH)  Hash_old_buckets(HASH) = NULL
+#define AnsHash_free_old_buckets(HASH)        FREE_OLD_HASH_BUCKETS(HASH)
+#else
+#define AnsHash_init_old_buckets_field(HASH)
+#define AnsHash_free_old_buckets(HASH)
+#endif /* ANSWER_TRIE_INSERT_WITH_CAS */
+
+#ifdef GLOBAL_TRIE_INSERT_WITH_CAS
+#define GtHash_init_old_buckets_field(HASH)   Hash_old_buckets(HASH) = NULL
+#define GtHash_free_old_buckets(HASH)         FREE_OLD_HASH_BUCKETS(HASH)
+#else
+#define GtHash_init_old_buckets_field(HASH)
+#define GtHash_free_old_buckets(HASH)
+#endif /* GLOBAL_TRIE_INSERT_WITH_CAS */
+
 #ifdef SUBGOAL_TRIE_LOCK_USING_NODE_FIELD
 #define LOCK_SUBGOAL_NODE(NODE)       LOCK(TrNode_lock(NODE))
 #define UNLOCK_SUBGOAL_NODE(NODE)     UNLOCK(TrNode_lock(NODE))
@@ -480,6 +602,8 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
         SetMode_Batched(TabEnt_flags(TAB_ENT));                        \
         SetMode_ExecAnswers(TabEnt_flags(TAB_ENT));                    \
         SetMode_LocalTrie(TabEnt_flags(TAB_ENT));                      \
+        SetMode_Variant(TabEnt_flags(TAB_ENT));                        \
+        SetMode_NonIncremental(TabEnt_flags(TAB_ENT));                 \
         TabEnt_mode(TAB_ENT) = TabEnt_flags(TAB_ENT);                  \
         if (IsMode_Local(yap_flags[TABLING_MODE_FLAG]))                \
           SetMode_Local(TabEnt_mode(TAB_ENT));                         \
@@ -487,6 +611,8 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
           SetMode_LoadAnswers(TabEnt_mode(TAB_ENT));                   \
         if (IsMode_GlobalTrie(yap_flags[TABLING_MODE_FLAG]))           \
           SetMode_GlobalTrie(TabEnt_mode(TAB_ENT));                    \
+        if (IsMode_Subsumptive(yap_flags[TABLING_MODE_FLAG]))          \
+          SetMode_Subsumptive(TabEnt_mode(TAB_ENT));                   \
         TabEnt_init_mode_directed_field(TAB_ENT, MODE_ARRAY);          \
         TabEnt_init_subgoal_trie_field(TAB_ENT);                       \
         TabEnt_next(TAB_ENT) = GLOBAL_root_tab_ent;                    \
@@ -530,6 +656,7 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
           SgFr_first_answer(SG_FR) = NULL;                         \
           SgFr_last_answer(SG_FR) = NULL;                          \
 	  SgFr_init_mode_directed_fields(SG_FR, MODE_ARRAY);	   \
+          SgFr_init_incremental_fields(SG_FR);                     \
           SgFr_state(SG_FR) = ready;                               \
 	}
 
@@ -606,7 +733,8 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
         Hash_mark(HASH) = SUBGOAL_TRIE_HASH_MARK;               \
         Hash_num_buckets(HASH) = BASE_HASH_BUCKETS;             \
         ALLOC_BUCKETS(Hash_buckets(HASH), BASE_HASH_BUCKETS);   \
-        Hash_num_nodes(HASH) = NUM_NODES
+        Hash_num_nodes(HASH) = NUM_NODES;                       \
+        SgHash_init_old_buckets_field(HASH)
 
 #define new_answer_trie_hash(HASH, NUM_NODES, SG_FR)            \
         ALLOC_ANSWER_TRIE_HASH(HASH);                           \
@@ -614,6 +742,7 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
         Hash_num_buckets(HASH) = BASE_HASH_BUCKETS;             \
         ALLOC_BUCKETS(Hash_buckets(HASH), BASE_HASH_BUCKETS);   \
         Hash_num_nodes(HASH) = NUM_NODES;                       \
+        AnsHash_init_old_buckets_field(HASH);                   \
         AnsHash_init_chain_fields(HASH, SG_FR)
 
 #define new_global_trie_hash(HASH, NUM_NODES)                   \
@@ -621,7 +750,8 @@ static inline tg_sol_fr_ptr CUT_prune_tg_solution_frames(tg_sol_fr_ptr, int);
         Hash_mark(HASH) = GLOBAL_TRIE_HASH_MARK;                \
         Hash_num_buckets(HASH) = BASE_HASH_BUCKETS;             \
         ALLOC_BUCKETS(Hash_buckets(HASH), BASE_HASH_BUCKETS);   \
-	Hash_num_nodes(HASH) = NUM_NODES
+	Hash_num_nodes(HASH) = NUM_NODES;                       \
+        GtHash_init_old_buckets_field(HASH)
 
 #ifdef LIMIT_TABLING
 #define insert_into_global_sg_fr_list(SG_FR)                                 \
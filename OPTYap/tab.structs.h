@@ -132,6 +132,9 @@ typedef struct subgoal_trie_hash {
   int number_of_buckets;
   struct subgoal_trie_node **buckets;
   int number_of_nodes;
+#ifdef SUBGOAL_TRIE_INSERT_WITH_CAS
+  struct subgoal_trie_node **old_buckets;
+#endif /* SUBGOAL_TRIE_INSERT_WITH_CAS */
 #ifdef USE_PAGES_MALLOC
   struct subgoal_trie_hash *next;
 #endif /* USE_PAGES_MALLOC */
@@ -144,6 +147,9 @@ typedef struct answer_trie_hash {
   int number_of_buckets;
   struct answer_trie_node **buckets;
   int number_of_nodes;
+#ifdef ANSWER_TRIE_INSERT_WITH_CAS
+  struct answer_trie_node **old_buckets;
+#endif /* ANSWER_TRIE_INSERT_WITH_CAS */
 #ifdef MODE_DIRECTED_TABLING
   struct answer_trie_hash *previous;	
 #endif /*MODE_DIRECTED_TABLING*/
@@ -157,6 +163,9 @@ typedef struct global_trie_hash {
   int number_of_buckets;
   struct global_trie_node **buckets;
   int number_of_nodes;
+#ifdef GLOBAL_TRIE_INSERT_WITH_CAS
+  struct global_trie_node **old_buckets;
+#endif /* GLOBAL_TRIE_INSERT_WITH_CAS */
 #ifdef USE_PAGES_MALLOC
   struct global_trie_hash *next;
 #endif /* USE_PAGES_MALLOC */
@@ -166,6 +175,7 @@ typedef struct global_trie_hash {
 #define Hash_num_buckets(X)  ((X)->number_of_buckets)
 #define Hash_buckets(X)      ((X)->buckets)
 #define Hash_num_nodes(X)    ((X)->number_of_nodes)
+#define Hash_old_buckets(X)  ((X)->old_buckets)
 #define Hash_previous(X)     ((X)->previous)
 #define Hash_next(X)         ((X)->next)
 
@@ -233,6 +243,22 @@ typedef enum {          /* do not change order !!! */
 
 
 
+/*************************************
+**      incremental_dependency      **
+*************************************/
+
+#ifdef TABLING_INCREMENTAL
+typedef struct incremental_dependency {
+  struct pred_entry *predicate;
+  struct incremental_dependency *next;
+} *inc_dep_ptr;
+
+#define IncDep_pred(X)  ((X)->predicate)
+#define IncDep_next(X)  ((X)->next)
+#endif /* TABLING_INCREMENTAL */
+
+
+
 /****************************
 **      subgoal_entry      **
 ****************************/
@@ -256,6 +282,10 @@ typedef struct subgoal_entry {
 #ifdef LIMIT_TABLING
   struct subgoal_frame *previous;
 #endif /* LIMIT_TABLING */
+#ifdef TABLING_INCREMENTAL
+  struct incremental_dependency *incremental_dependencies;
+  UInt incremental_timestamp;
+#endif /* TABLING_INCREMENTAL */
 #ifdef YAPOR
   struct or_frame *top_or_frame_on_generator_branch;
 #endif /* YAPOR */
@@ -326,6 +356,8 @@ typedef struct subgoal_frame {
 #define SgFr_invalid_chain(X)           (SUBGOAL_ENTRY(X) invalid_chain)
 #define SgFr_try_answer(X)              (SUBGOAL_ENTRY(X) try_answer)
 #define SgFr_previous(X)                (SUBGOAL_ENTRY(X) previous)
+#define SgFr_inc_dependencies(X)        (SUBGOAL_ENTRY(X) incremental_dependencies)
+#define SgFr_inc_timestamp(X)           (SUBGOAL_ENTRY(X) incremental_timestamp)
 #define SgFr_gen_top_or_fr(X)           (SUBGOAL_ENTRY(X) top_or_frame_on_generator_branch)
 #define SgFr_gen_worker(X)              (SUBGOAL_ENTRY(X) generator_worker)
 #define SgFr_sg_ent_state(X)            (SUBGOAL_ENTRY(X) state_flag)
@@ -354,6 +386,8 @@ typedef struct subgoal_frame {
                                 It is used when a subgoal was not completed during the previous evaluation.
                                 Not completed subgoals start by trying the answers already found.
   SgFr_previous:                a pointer to the previous subgoal frame on the chain.
+  SgFr_inc_dependencies:        a pointer to the chain of incremental predicates the answers depend on.
+  SgFr_inc_timestamp:           the incremental update timestamp at the time the evaluation started.
   SgFr_gen_top_or_fr:           a pointer to the top or-frame in the generator choice point branch. 
                                 When the generator choice point is shared the pointer is updated 
                                 to its or-frame. It is used to find the direct dependency node for 
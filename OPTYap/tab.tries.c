@@ -19,6 +19,9 @@
 #ifdef TABLING
 #include "Yatom.h"
 #include "YapHeap.h"
+#ifdef TABLING_INCREMENTAL
+#include "clause.h"
+#endif /* TABLING_INCREMENTAL */
 #include "tab.macros.h"
 
 static inline sg_node_ptr subgoal_trie_check_insert_entry(tab_ent_ptr, sg_node_ptr, Term USES_REGS);
@@ -145,12 +148,25 @@ static struct trie_statistics{
         if (TrStat_show == SHOW_MODE_STRUCTURE)  \
           Sfprintf(TrStat_out, MESG, ##ARGS)
 
+/* the global trie is shared by all threads: while other threads run, they may be
+   loading answers through a branch that is no longer referenced, so it is kept */
+#ifdef THREADS
+#define IF_ABOLISH_GLOBAL_TRIE_SHARED_DATA_STRUCTURES  if (GLOBAL_NOfThreads == 1)
+#define DECREMENT_GLOBAL_TRIE_REFERENCE(NODE)                                                               \
+        __sync_sub_and_fetch((CELL *) &TrNode_child(NODE), 1)
+#else
+#define IF_ABOLISH_GLOBAL_TRIE_SHARED_DATA_STRUCTURES
+#define DECREMENT_GLOBAL_TRIE_REFERENCE(NODE)                                                               \
+        (CELL) (TrNode_child(NODE) = (gt_node_ptr) ((unsigned long int) TrNode_child(NODE) - 1))
+#endif /* THREADS */
+
 #define CHECK_DECREMENT_GLOBAL_TRIE_REFERENCE(REF,MODE)		                                            \
         if (MODE == TRAVERSE_MODE_NORMAL && IsVarTerm(REF) && REF > VarIndexOfTableTerm(MAX_TABLE_VARS)) {  \
           register gt_node_ptr gt_node = (gt_node_ptr) (REF);	                                            \
-          TrNode_child(gt_node) = (gt_node_ptr) ((unsigned long int) TrNode_child(gt_node) - 1);            \
-          if (TrNode_child(gt_node) == 0)                                                                   \
-            FREE_GLOBAL_TRIE_BRANCH(gt_node,TRAVERSE_MODE_NORMAL);		                            \
+          if (DECREMENT_GLOBAL_TRIE_REFERENCE(gt_node) == 0) {                                              \
+            IF_ABOLISH_GLOBAL_TRIE_SHARED_DATA_STRUCTURES                                                   \
+              FREE_GLOBAL_TRIE_BRANCH(gt_node,TRAVERSE_MODE_NORMAL);		                            \
+          }                                                                                                 \
         }
 #ifdef GLOBAL_TRIE_FOR_SUBTERMS
 #define CHECK_DECREMENT_GLOBAL_TRIE_FOR_SUBTERMS_REFERENCE(REF,MODE)	                                    \
@@ -163,6 +179,145 @@ static struct trie_statistics{
         free_global_trie_branch(NODE PASS_REGS)
 #endif /* GLOBAL_TRIE_FOR_SUBTERMS */
 
+#ifdef TABLING_CALL_SUBSUMPTION
+#define SUBSUMPTIVE_MAX_TOKENS   1024
+#define SUBSUMPTIVE_MAX_DEPTH    16
+#define SUBSUMPTIVE_OPEN_LIST    -1
+
+#define SUBSUMPTIVE_TOKEN_BOUND  0  /* symbol that a subsuming trie must match */
+#define SUBSUMPTIVE_TOKEN_RAW    1  /* bits of a float or of a long integer */
+#define SUBSUMPTIVE_TOKEN_VAR    2  /* variable of the call */
+#define SUBSUMPTIVE_TOKEN_LIST   3  /* start of a compact list */
+
+/* the call being answered from a subsuming table, encoded as the sequence **
+** of trie entries that subgoal_search_loop() inserts for it; the arrays    **
+** are sized for the call and allocated in the same block as the structure */
+struct subsumptive_call {
+  int max_tokens;
+  int tokens;
+  Term *token;
+  Term *term;     /* call subterm starting at each token */
+  int *end;       /* token following that subterm */
+  char *kind;
+  int call_vars;
+  Term *call_var;
+  /* the variables of the subsuming subgoal and the call subterms they are bound to */
+  int vars;
+  int *binding;
+  /* the same subterms, in the order used by the answer trie of the subsuming subgoal */
+  int target_tokens;
+  int *target_map;
+  Term *target_token;
+  int *target_end;
+  char *target_kind;
+  Term *answer;
+  sg_fr_ptr sg_fr;
+  CELL *subs_ptr;
+  int done;
+};
+
+/* position reached in the answer trie: while depth is zero the entries are **
+** matched against the call, otherwise a whole answer subterm is skipped    */
+struct subsumptive_walk {
+  int pos;
+  int vars;
+  int raw;
+  int depth;
+  int pending[SUBSUMPTIVE_MAX_DEPTH];
+};
+
+#define SUBSUMPTIVE_ADD_TOKEN(CALL, TOKEN, KIND)                                  \
+        { int token_pos = (CALL)->tokens;                                         \
+          if (token_pos == (CALL)->max_tokens)                                    \
+            return FALSE;                                                         \
+          (CALL)->token[token_pos] = (Term) (TOKEN);                              \
+          (CALL)->term[token_pos] = 0;                                            \
+          (CALL)->end[token_pos] = token_pos + 1;                                 \
+          (CALL)->kind[token_pos] = KIND;                                         \
+          (CALL)->tokens = token_pos + 1;                                         \
+        }
+
+#define SUBSUMPTIVE_TRIE_CHILD(CHILD, PARENT, ENTRY, IS_TRIE_HASH, HASH_PTR)      \
+        { CHILD = TrNode_child(PARENT);                                           \
+          if (CHILD && IS_TRIE_HASH(CHILD))                                       \
+            CHILD = Hash_buckets((HASH_PTR) CHILD)                                \
+                      [HASH_ENTRY(ENTRY, Hash_num_buckets((HASH_PTR) CHILD))];    \
+          while (CHILD && TrNode_entry(CHILD) != (ENTRY))                         \
+            CHILD = TrNode_next(CHILD);                                           \
+        }
+
+#define SUBSUMPTIVE_PUSH_PENDING(WALK, TERMS)                                     \
+        if ((WALK).depth == SUBSUMPTIVE_MAX_DEPTH)                                \
+          (WALK).depth = -1;  /* too deep, unification checks the answers */     \
+        else                                                                      \
+          (WALK).pending[(WALK).depth++] = TERMS
+
+#ifdef TRIE_COMPACT_PAIRS
+#define SUBSUMPTIVE_SKIP_PAIR(WALK, ENTRY)                                        \
+        if ((ENTRY) == CompactPairEndList || (ENTRY) == CompactPairEndTerm) {     \
+          /* one more term closes the current compact list */                     \
+          (WALK).pending[(WALK).depth - 1] = 1;                                   \
+          break;                                                                  \
+        }
+#define SUBSUMPTIVE_PAIR_TERMS     SUBSUMPTIVE_OPEN_LIST
+#else
+#define SUBSUMPTIVE_SKIP_PAIR(WALK, ENTRY)
+#define SUBSUMPTIVE_PAIR_TERMS     2
+#endif /* TRIE_COMPACT_PAIRS */
+
+#define SUBSUMPTIVE_SKIP_ENTRY(CALL, WALK, ENTRY)                                 \
+        do {                                                                      \
+          Term skip_entry = ENTRY;                                                \
+          if ((WALK).depth < 0)                                                   \
+            break;                                                                \
+          if ((WALK).raw) {                                                       \
+            if (--(WALK).raw)                                                     \
+              break;                                                              \
+          } else {                                                                \
+            SUBSUMPTIVE_SKIP_PAIR(WALK, skip_entry);                              \
+            if ((WALK).pending[(WALK).depth - 1] != SUBSUMPTIVE_OPEN_LIST)        \
+              (WALK).pending[(WALK).depth - 1]--;                                 \
+            if (IsVarTerm(skip_entry)) {                                          \
+              if (VarIndexOfTableTerm(skip_entry) == (WALK).vars)                 \
+                (WALK).vars++;                                                    \
+            } else if (IsPairTerm(skip_entry)) {                                  \
+              SUBSUMPTIVE_PUSH_PENDING(WALK, SUBSUMPTIVE_PAIR_TERMS);             \
+              break;                                                              \
+            } else if (IsApplTerm(skip_entry)) {                                  \
+              Functor f = (Functor) RepAppl(skip_entry);                          \
+              if (f == FunctorDouble)  /* bits and closing functor */             \
+                (WALK).raw = sizeof(Float) / sizeof(Term) + 1;                    \
+              else if (f == FunctorLongInt)                                       \
+                (WALK).raw = 2;                                                   \
+              else                                                                \
+                SUBSUMPTIVE_PUSH_PENDING(WALK, ArityOfFunctor(f));                \
+              break;                                                              \
+            }                                                                     \
+          }                                                                       \
+          /* the current term is complete */                                      \
+          while ((WALK).depth && (WALK).pending[(WALK).depth - 1] == 0)           \
+            (WALK).depth--;                                                       \
+          if ((WALK).depth == 0)                                                  \
+            (WALK).pos = (CALL)->target_end[(WALK).pos];                          \
+        } while (0)
+
+static int subsumptive_count_tokens(Term, int);
+static int subsumptive_encode_term(struct subsumptive_call *, Term);
+static sg_fr_ptr subsumptive_subgoal_trie_search(struct subsumptive_call *, sg_node_ptr, int, int);
+static void subsumptive_answer_trie_search(struct subsumptive_call *, ans_node_ptr, struct subsumptive_walk USES_REGS);
+static void subsumptive_answer_check_insert(struct subsumptive_call *, ans_node_ptr USES_REGS);
+static void subsumptive_call_search(tab_ent_ptr, sg_fr_ptr, int, CELL * USES_REGS);
+#endif /* TABLING_CALL_SUBSUMPTION */
+#ifdef TABLING_INCREMENTAL
+static inline int incremental_subgoal_is_outdated(sg_fr_ptr);
+static int incremental_choice_points_use_answer_trie(choiceptr, ans_node_ptr);
+static int incremental_answer_trie_in_use(sg_fr_ptr USES_REGS);
+static void incremental_free_subgoal_frame(sg_fr_ptr);
+static void incremental_free_retired_subgoal_frames(USES_REGS1);
+static sg_fr_ptr incremental_renew_subgoal_frame(sg_fr_ptr USES_REGS);
+static void incremental_inherit_dependencies(sg_fr_ptr);
+#endif /* TABLING_INCREMENTAL */
+
 
 
 /******************************
@@ -507,6 +662,7 @@ static void free_global_trie_branch(gt_node_ptr current_node USES_REGS) {
       FREE_GLOBAL_TRIE_NODE(current_node);
       if (num_nodes == 0) {
 	FREE_BUCKETS(Hash_buckets(hash));
+	GtHash_free_old_buckets(hash);
 	FREE_GLOBAL_TRIE_HASH(hash);
 	if (parent_node != GLOBAL_root_gt) {
 #ifdef GLOBAL_TRIE_FOR_SUBTERMS
@@ -1008,6 +1164,499 @@ static inline void traverse_update_arity(char *str, int *str_index_ptr, int *ari
 
 
 
+#ifdef TABLING_CALL_SUBSUMPTION
+static int subsumptive_count_tokens(Term t, int left) {
+  /* tokens used by subsumptive_encode_term() for t, more than left if they do not fit */
+  int tokens = 1;
+
+  if (IsVarTerm(t) || IsAtomOrIntTerm(t))
+    return tokens;
+  if (IsPairTerm(t)) {
+    CELL *aux_pair = RepPair(t);
+#ifdef TRIE_COMPACT_PAIRS
+    tokens++;  /* end of the compact list */
+    while (tokens <= left) {
+      Term tail = Deref(aux_pair[1]);
+      tokens += subsumptive_count_tokens(Deref(aux_pair[0]), left - tokens);
+      if (! IsPairTerm(tail)) {
+	if (tail != TermNil && tokens <= left)
+	  tokens += subsumptive_count_tokens(tail, left - tokens);
+	break;
+      }
+      aux_pair = RepPair(tail);
+    }
+#else
+    tokens += subsumptive_count_tokens(Deref(aux_pair[0]), left - tokens);
+    if (tokens <= left)
+      tokens += subsumptive_count_tokens(Deref(aux_pair[1]), left - tokens);
+#endif /* TRIE_COMPACT_PAIRS */
+  } else if (IsApplTerm(t)) {
+    Functor f = FunctorOfTerm(t);
+    if (f == FunctorDouble) {
+      tokens += sizeof(Float) / sizeof(Term);
+    } else if (f == FunctorLongInt) {
+      tokens++;
+    } else if (f == FunctorDBRef || f == FunctorBigInt) {
+      return left + 1;
+    } else {
+      int i;
+      CELL *aux_appl = RepAppl(t);
+      for (i = 1; i <= ArityOfFunctor(f) && tokens <= left; i++)
+	tokens += subsumptive_count_tokens(Deref(aux_appl[i]), left - tokens);
+    }
+  } else {
+    return left + 1;
+  }
+  return tokens;
+}
+
+
+static int subsumptive_encode_term(struct subsumptive_call *call, Term t) {
+  int pos = call->tokens;
+
+  SUBSUMPTIVE_ADD_TOKEN(call, t, SUBSUMPTIVE_TOKEN_BOUND);
+  if (IsVarTerm(t)) {
+    int var_index;
+    if (IsTableVarTerm(t)) {
+      var_index = VarIndexOfTerm(t);
+    } else {
+      var_index = call->call_vars++;
+      call->call_var[var_index] = t;
+      *((CELL *)t) = GLOBAL_table_var_enumerator(var_index);
+    }
+    call->token[pos] = MakeTableVarTerm(var_index);
+    call->kind[pos] = SUBSUMPTIVE_TOKEN_VAR;
+    t = call->call_var[var_index];
+  } else if (IsAtomOrIntTerm(t)) {
+    /* nothing else to encode */
+  } else if (IsPairTerm(t)) {
+    CELL *aux_pair = RepPair(t);
+#ifdef TRIE_COMPACT_PAIRS
+    call->token[pos] = CompactPairInit;
+    call->kind[pos] = SUBSUMPTIVE_TOKEN_LIST;
+    while (1) {
+      Term tail = Deref(aux_pair[1]);
+      if (tail == TermNil) {
+	SUBSUMPTIVE_ADD_TOKEN(call, CompactPairEndList, SUBSUMPTIVE_TOKEN_BOUND);
+	if (! subsumptive_encode_term(call, Deref(aux_pair[0])))
+	  return FALSE;
+	break;
+      }
+      if (! subsumptive_encode_term(call, Deref(aux_pair[0])))
+	return FALSE;
+      if (! IsPairTerm(tail)) {
+	SUBSUMPTIVE_ADD_TOKEN(call, CompactPairEndTerm, SUBSUMPTIVE_TOKEN_BOUND);
+	if (! subsumptive_encode_term(call, tail))
+	  return FALSE;
+	break;
+      }
+      aux_pair = RepPair(tail);
+    }
+#else
+    call->token[pos] = AbsPair(NULL);
+    if (! subsumptive_encode_term(call, Deref(aux_pair[0])) ||
+	! subsumptive_encode_term(call, Deref(aux_pair[1])))
+      return FALSE;
+#endif /* TRIE_COMPACT_PAIRS */
+  } else if (IsApplTerm(t)) {
+    Functor f = FunctorOfTerm(t);
+    call->token[pos] = AbsAppl((Term *)f);
+    if (f == FunctorDouble) {
+      union {
+	Term t_dbl[sizeof(Float)/sizeof(Term)];
+	Float dbl;
+      } u;
+      u.dbl = FloatOfTerm(t);
+#if SIZEOF_DOUBLE == 2 * SIZEOF_INT_P
+      SUBSUMPTIVE_ADD_TOKEN(call, u.t_dbl[1], SUBSUMPTIVE_TOKEN_RAW);
+#endif /* SIZEOF_DOUBLE x SIZEOF_INT_P */
+      SUBSUMPTIVE_ADD_TOKEN(call, u.t_dbl[0], SUBSUMPTIVE_TOKEN_RAW);
+    } else if (f == FunctorLongInt) {
+      SUBSUMPTIVE_ADD_TOKEN(call, LongIntOfTerm(t), SUBSUMPTIVE_TOKEN_RAW);
+    } else if (f == FunctorDBRef || f == FunctorBigInt) {
+      return FALSE;
+    } else {
+      int i;
+      CELL *aux_appl = RepAppl(t);
+      for (i = 1; i <= ArityOfFunctor(f); i++)
+	if (! subsumptive_encode_term(call, Deref(aux_appl[i])))
+	  return FALSE;
+    }
+  } else {
+    return FALSE;
+  }
+  call->term[pos] = t;
+  call->end[pos] = call->tokens;
+  return TRUE;
+}
+
+
+static sg_fr_ptr subsumptive_subgoal_trie_search(struct subsumptive_call *call, sg_node_ptr current_node, int pos, int vars) {
+  sg_node_ptr child_node;
+  sg_fr_ptr sg_fr;
+  int i;
+
+  if (pos == call->tokens) {
+    if (! IS_SUBGOAL_LEAF_NODE(current_node))
+      return NULL;
+    sg_fr = get_subgoal_frame(current_node);
+    if (sg_fr == NULL || SgFr_state(sg_fr) < complete)
+      return NULL;
+#ifdef TABLING_INCREMENTAL
+    if (SgFr_inc_dependencies(sg_fr) && incremental_subgoal_is_outdated(sg_fr))
+      return NULL;
+#endif /* TABLING_INCREMENTAL */
+    call->vars = vars;
+    return sg_fr;
+  }
+  if (call->kind[pos] != SUBSUMPTIVE_TOKEN_VAR) {
+    /* try the entry of the call first, it leads to the most specific tables */
+    SUBSUMPTIVE_TRIE_CHILD(child_node, current_node, call->token[pos], IS_SUBGOAL_TRIE_HASH, sg_hash_ptr);
+    if (child_node && (sg_fr = subsumptive_subgoal_trie_search(call, child_node, pos + 1, vars)))
+      return sg_fr;
+    if (call->kind[pos] == SUBSUMPTIVE_TOKEN_RAW)
+      return NULL;
+  }
+  for (i = 0; i <= vars && i < MAX_TABLE_VARS; i++) {
+    SUBSUMPTIVE_TRIE_CHILD(child_node, current_node, MakeTableVarTerm(i), IS_SUBGOAL_TRIE_HASH, sg_hash_ptr);
+    if (child_node == NULL)
+      continue;
+    if (i == vars) {
+      /* first occurrence of the variable, it is bound to the whole call subterm */
+      call->binding[i] = pos;
+      if ((sg_fr = subsumptive_subgoal_trie_search(call, child_node, call->end[pos], vars + 1)))
+	return sg_fr;
+    } else if (call->end[pos] - pos == call->end[call->binding[i]] - call->binding[i] &&
+	       memcmp(call->token + pos, call->token + call->binding[i], (call->end[pos] - pos) * sizeof(Term)) == 0) {
+      /* repeated variable, the call subterms must be the same */
+      if ((sg_fr = subsumptive_subgoal_trie_search(call, child_node, call->end[pos], vars)))
+	return sg_fr;
+    }
+  }
+  return NULL;
+}
+
+
+static void subsumptive_answer_trie_search(struct subsumptive_call *call, ans_node_ptr current_node, struct subsumptive_walk walk USES_REGS) {
+  ans_node_ptr child_node;
+
+  if (call->done)
+    return;
+  if (IS_ANSWER_LEAF_NODE(current_node)) {
+    subsumptive_answer_check_insert(call, current_node PASS_REGS);
+    return;
+  }
+  if (walk.depth == 0) {
+    int kind = call->target_kind[walk.pos];
+    if (kind == SUBSUMPTIVE_TOKEN_BOUND || kind == SUBSUMPTIVE_TOKEN_RAW) {
+      /* indexed retrieval: only the entry of the call and the answer variables can match */
+      struct subsumptive_walk next_walk = walk;
+      SUBSUMPTIVE_TRIE_CHILD(child_node, current_node, call->target_token[walk.pos], IS_ANSWER_TRIE_HASH, ans_hash_ptr);
+      if (child_node) {
+	next_walk.pos++;
+	subsumptive_answer_trie_search(call, child_node, next_walk PASS_REGS);
+      }
+      if (kind == SUBSUMPTIVE_TOKEN_BOUND) {
+	int i;
+	for (i = 0; i <= walk.vars; i++) {
+	  SUBSUMPTIVE_TRIE_CHILD(child_node, current_node, MakeTableVarTerm(i), IS_ANSWER_TRIE_HASH, ans_hash_ptr);
+	  if (child_node) {
+	    next_walk = walk;
+	    next_walk.pos = call->target_end[walk.pos];
+	    if (i == walk.vars)
+	      next_walk.vars++;
+	    subsumptive_answer_trie_search(call, child_node, next_walk PASS_REGS);
+	  }
+	}
+      }
+      return;
+    }
+    /* a variable or a compact list of the call: skip a whole answer subterm */
+    walk.depth = 1;
+    walk.pending[0] = 1;
+  }
+  child_node = TrNode_child(current_node);
+  if (child_node && IS_ANSWER_TRIE_HASH(child_node)) {
+    ans_hash_ptr hash = (ans_hash_ptr) child_node;
+    ans_node_ptr *bucket = Hash_buckets(hash);
+    ans_node_ptr *last_bucket = bucket + Hash_num_buckets(hash);
+    do {
+      for (child_node = *bucket; child_node; child_node = TrNode_next(child_node)) {
+	struct subsumptive_walk next_walk = walk;
+	SUBSUMPTIVE_SKIP_ENTRY(call, next_walk, TrNode_entry(child_node));
+	subsumptive_answer_trie_search(call, child_node, next_walk PASS_REGS);
+      }
+    } while (++bucket != last_bucket);
+  } else {
+    for (; child_node; child_node = TrNode_next(child_node)) {
+      struct subsumptive_walk next_walk = walk;
+      SUBSUMPTIVE_SKIP_ENTRY(call, next_walk, TrNode_entry(child_node));
+      subsumptive_answer_trie_search(call, child_node, next_walk PASS_REGS);
+    }
+  }
+  return;
+}
+
+
+static void subsumptive_answer_check_insert(struct subsumptive_call *call, ans_node_ptr ans_node USES_REGS) {
+  sg_fr_ptr sg_fr = call->sg_fr;
+  CELL *stack_terms, *saved_H = H;
+  tr_fr_ptr saved_TR = TR;
+  int i;
+
+  stack_terms = load_answer_loop(ans_node PASS_REGS);
+  for (i = 0; i < call->vars; i++)
+    call->answer[i] = STACK_POP_DOWN(stack_terms);
+  for (i = 0; i < call->vars; i++)
+    if (! Yap_unify(call->answer[i], call->term[call->binding[i]]))
+      break;
+  if (i == call->vars) {
+    /* the answer is an instance of the call */
+    ans_node = answer_search(sg_fr, call->subs_ptr);
+    if (! IS_ANSWER_LEAF_NODE(ans_node)) {
+      TAG_AS_ANSWER_LEAF_NODE(ans_node);
+      if (SgFr_first_answer(sg_fr) == NULL)
+	SgFr_first_answer(sg_fr) = ans_node;
+      else
+	TrNode_child(SgFr_last_answer(sg_fr)) = ans_node;
+      SgFr_last_answer(sg_fr) = ans_node;
+    }
+    if (call->subs_ptr[0] == 0)
+      call->done = TRUE;  /* a ground call has at most one answer */
+  }
+  /* the answer terms are discarded with H, so only the variables of **
+  ** the call may stay bound, whether the bindings were trailed or not */
+  for (i = 0; i < call->call_vars; i++)
+    RESET_VARIABLE(call->call_var[i]);
+  TR = saved_TR;
+  H = saved_H;
+  return;
+}
+
+
+static void subsumptive_call_search(tab_ent_ptr tab_ent, sg_fr_ptr sg_fr, int pred_arity, CELL *subs_ptr USES_REGS) {
+  struct subsumptive_call *call;
+  sg_fr_ptr subsumer_sg_fr = NULL;
+  int i, n = 0, encoded = TRUE;
+
+  for (i = 1; i <= pred_arity && n <= SUBSUMPTIVE_MAX_TOKENS; i++)
+    n += subsumptive_count_tokens(Deref(XREGS[i]), SUBSUMPTIVE_MAX_TOKENS - n);
+  if (n == 0 || n > SUBSUMPTIVE_MAX_TOKENS)
+    return;
+  ALLOC_BLOCK(call, sizeof(struct subsumptive_call) + (6 * sizeof(Term) + 5 * sizeof(int) + 3) * n + sizeof(int), struct subsumptive_call);
+  call->token = (Term *) (call + 1);
+  call->term = call->token + n;
+  call->call_var = call->term + n;
+  call->answer = call->call_var + n;
+  call->target_token = call->answer + n;
+  call->end = (int *) (call->target_token + 2 * n);
+  call->binding = call->end + n;
+  call->target_map = call->binding + n;
+  call->target_end = call->target_map + n + 1;
+  call->kind = (char *) (call->target_end + 2 * n);
+  call->target_kind = call->kind + n;
+  call->max_tokens = n;
+  call->tokens = 0;
+  call->call_vars = 0;
+  for (i = 1; i <= pred_arity && encoded; i++)
+    encoded = subsumptive_encode_term(call, Deref(XREGS[i]));
+  /* reset variables */
+  for (i = 0; i < call->call_vars; i++)
+    RESET_VARIABLE(call->call_var[i]);
+  if (encoded)
+    subsumer_sg_fr = subsumptive_subgoal_trie_search(call, get_subgoal_trie(tab_ent), 0, 0);
+  if (subsumer_sg_fr) {
+    struct subsumptive_walk walk;
+    /* the answer trie of the subsuming subgoal stores the terms of its variables in   **
+    ** order, and closes floats and long integers with their functor (as expected by   **
+    ** load_answer_loop()), so target_map[] maps the call tokens to the target tokens  */
+    call->target_tokens = 0;
+    for (i = 0; i < call->vars; i++) {
+      int pos = call->binding[i], end = call->end[pos];
+      int target_pos = call->target_tokens;
+      for (; pos < end; pos++) {
+	call->target_map[pos] = target_pos;
+	call->target_token[target_pos] = call->token[pos];
+	call->target_kind[target_pos] = call->kind[pos];
+	call->target_end[target_pos] = target_pos + 1;
+	if (call->kind[pos] == SUBSUMPTIVE_TOKEN_RAW && (pos + 1 == end || call->kind[pos + 1] != SUBSUMPTIVE_TOKEN_RAW)) {
+	  int functor_pos = call->kind[pos - 1] == SUBSUMPTIVE_TOKEN_RAW ? pos - 2 : pos - 1;
+	  target_pos++;
+	  call->target_token[target_pos] = call->token[functor_pos];
+	  call->target_kind[target_pos] = SUBSUMPTIVE_TOKEN_RAW;
+	  call->target_end[target_pos] = target_pos + 1;
+	}
+	target_pos++;
+      }
+      call->target_map[end] = target_pos;
+      for (pos = call->binding[i]; pos < end; pos++)
+	if (call->kind[pos] != SUBSUMPTIVE_TOKEN_RAW)
+	  call->target_end[call->target_map[pos]] = call->target_map[call->end[pos]];
+      call->target_tokens = target_pos;
+    }
+    call->sg_fr = sg_fr;
+    call->subs_ptr = subs_ptr;
+    call->done = FALSE;
+    walk.pos = 0;
+    walk.vars = 0;
+    walk.raw = 0;
+    walk.depth = 0;
+    subsumptive_answer_trie_search(call, SgFr_answer_trie(subsumer_sg_fr), walk PASS_REGS);
+    mark_as_completed(sg_fr);
+#ifdef TABLING_INCREMENTAL
+    /* the answers are only valid as long as the ones of the subsuming subgoal */
+    { inc_dep_ptr dep = SgFr_inc_dependencies(subsumer_sg_fr);
+      while (dep) {
+	inc_dep_ptr new_dep;
+	ALLOC_BLOCK(new_dep, sizeof(struct incremental_dependency), struct incremental_dependency);
+	IncDep_pred(new_dep) = IncDep_pred(dep);
+	IncDep_next(new_dep) = SgFr_inc_dependencies(sg_fr);
+	SgFr_inc_dependencies(sg_fr) = new_dep;
+	dep = IncDep_next(dep);
+      }
+      SgFr_inc_timestamp(sg_fr) = SgFr_inc_timestamp(subsumer_sg_fr);
+    }
+#endif /* TABLING_INCREMENTAL */
+  }
+  FREE_BLOCK(call);
+  return;
+}
+#endif /* TABLING_CALL_SUBSUMPTION */
+
+
+
+#ifdef TABLING_INCREMENTAL
+static inline int incremental_subgoal_is_outdated(sg_fr_ptr sg_fr) {
+  inc_dep_ptr dep = SgFr_inc_dependencies(sg_fr);
+
+  while (dep) {
+    if (IncDep_pred(dep)->IncrementalTimeStampOfPred > SgFr_inc_timestamp(sg_fr))
+      return TRUE;
+    dep = IncDep_next(dep);
+  }
+  return FALSE;
+}
+
+
+static int incremental_choice_points_use_answer_trie(choiceptr cp, ans_node_ptr ans_trie) {
+  /* the answers of a completed subgoal are consumed either by loader **
+  ** choice points or by the choice points of its compiled answer trie */
+  while (cp) {
+    ans_node_ptr ans_node = NULL;
+    if (cp->cp_ap) {
+      op_numbers opnum = Yap_op_from_opcode(cp->cp_ap->opc);
+      if (opnum == _table_load_answer)
+	ans_node = LOAD_CP(cp)->cp_last_answer;
+      else if (opnum >= _trie_do_var && opnum <= _trie_retry_gterm)
+	ans_node = (ans_node_ptr) cp->cp_ap;
+    }
+    while (ans_node) {
+      if (ans_node == ans_trie)
+	return TRUE;
+      ans_node = (ans_node_ptr) UNTAG_ANSWER_NODE(TrNode_parent(ans_node));
+    }
+    cp = cp->cp_b;
+  }
+  return FALSE;
+}
+
+
+static int incremental_answer_trie_in_use(sg_fr_ptr sg_fr USES_REGS) {
+  dep_fr_ptr dep_fr = LOCAL_top_dep_fr;
+
+  if (incremental_choice_points_use_answer_trie(B, SgFr_answer_trie(sg_fr)))
+    return TRUE;
+  /* suspended branches are only reachable from their consumers */
+  while (dep_fr) {
+    if (incremental_choice_points_use_answer_trie(DepFr_cons_cp(dep_fr), SgFr_answer_trie(sg_fr)))
+      return TRUE;
+    dep_fr = DepFr_next(dep_fr);
+  }
+  return FALSE;
+}
+
+
+static void incremental_free_subgoal_frame(sg_fr_ptr sg_fr) {
+  ans_node_ptr ans_node;
+
+  free_answer_hash_chain(SgFr_hash_chain(sg_fr));
+  ans_node = SgFr_answer_trie(sg_fr);
+  if (TrNode_child(ans_node))
+    free_answer_trie(TrNode_child(ans_node), TRAVERSE_MODE_NORMAL, TRAVERSE_POSITION_FIRST);
+  FREE_ANSWER_TRIE_NODE(ans_node);
+#ifdef MODE_DIRECTED_TABLING
+  if (SgFr_mode_directed(sg_fr))
+    FREE_BLOCK(SgFr_mode_directed(sg_fr));
+#endif /* MODE_DIRECTED_TABLING */
+  free_incremental_dependencies(sg_fr);
+  FREE_SUBGOAL_FRAME(sg_fr);
+  return;
+}
+
+
+static void incremental_free_retired_subgoal_frames(USES_REGS1) {
+  sg_fr_ptr *sg_fr_addr = &GLOBAL_inc_retired_sg_fr;
+
+  while (*sg_fr_addr) {
+    sg_fr_ptr sg_fr = *sg_fr_addr;
+    if (incremental_answer_trie_in_use(sg_fr PASS_REGS)) {
+      sg_fr_addr = &SgFr_next(sg_fr);
+    } else {
+      *sg_fr_addr = SgFr_next(sg_fr);
+      incremental_free_subgoal_frame(sg_fr);
+    }
+  }
+  return;
+}
+
+
+static sg_fr_ptr incremental_renew_subgoal_frame(sg_fr_ptr sg_fr USES_REGS) {
+  ans_node_ptr ans_node;
+
+  incremental_free_retired_subgoal_frames(PASS_REGS1);
+  if (incremental_answer_trie_in_use(sg_fr PASS_REGS)) {
+    /* the old answers are still being consumed, retire the subgoal frame **
+    ** and evaluate the subgoal again in a new one                        */
+    sg_fr_ptr new_sg_fr;
+    new_subgoal_frame(new_sg_fr, SgFr_code(sg_fr), SgFr_mode_directed(sg_fr));
+#ifdef MODE_DIRECTED_TABLING
+    SgFr_mode_directed(sg_fr) = NULL;
+#endif /* MODE_DIRECTED_TABLING */
+    SgFr_next(sg_fr) = GLOBAL_inc_retired_sg_fr;
+    GLOBAL_inc_retired_sg_fr = sg_fr;
+    return new_sg_fr;
+  }
+  /* reuse the subgoal frame, the tabling instructions will find it ready */
+  free_answer_hash_chain(SgFr_hash_chain(sg_fr));
+  SgFr_hash_chain(sg_fr) = NULL;
+  ans_node = SgFr_answer_trie(sg_fr);
+  if (TrNode_child(ans_node))
+    free_answer_trie(TrNode_child(ans_node), TRAVERSE_MODE_NORMAL, TRAVERSE_POSITION_FIRST);
+  FREE_ANSWER_TRIE_NODE(ans_node);
+  new_answer_trie_node(ans_node, 0, 0, NULL, NULL, NULL);
+  SgFr_answer_trie(sg_fr) = ans_node;
+  SgFr_first_answer(sg_fr) = NULL;
+  SgFr_last_answer(sg_fr) = NULL;
+  free_incremental_dependencies(sg_fr);
+  SgFr_inc_timestamp(sg_fr) = GLOBAL_inc_timestamp;
+  SgFr_state(sg_fr) = ready;
+  return sg_fr;
+}
+
+
+static void incremental_inherit_dependencies(sg_fr_ptr sg_fr) {
+  inc_dep_ptr dep = SgFr_inc_dependencies(sg_fr);
+
+  while (dep) {
+    add_incremental_dependency(IncDep_pred(dep));
+    dep = IncDep_next(dep);
+  }
+  return;
+}
+#endif /* TABLING_INCREMENTAL */
+
+
+
 /*******************************
 **      Global functions      **
 *******************************/
@@ -1087,6 +1736,15 @@ sg_fr_ptr subgoal_search(yamop *preg, CELL **Yaddr) {
     __sync_synchronize();
     TAG_AS_SUBGOAL_LEAF_NODE(current_sg_node);
     UNLOCK_SUBGOAL_NODE(current_sg_node);
+#ifdef TABLING_CALL_SUBSUMPTION
+    if (IsMode_Subsumptive(TabEnt_mode(tab_ent)) && ! IsMode_GlobalTrie(TabEnt_mode(tab_ent)) &&
+#ifdef MODE_DIRECTED_TABLING
+	TabEnt_mode_directed(tab_ent) == NULL &&
+#endif /* MODE_DIRECTED_TABLING */
+	pred_arity)
+      /* answer the call from a more general completed subgoal, if any */
+      subsumptive_call_search(tab_ent, sg_fr, pred_arity, *Yaddr PASS_REGS);
+#endif /* TABLING_CALL_SUBSUMPTION */
 #else /* THREADS_FULL_SHARING || THREADS_CONSUMER_SHARING */
     sg_ent_ptr sg_ent = (sg_ent_ptr) UNTAG_SUBGOAL_NODE(TrNode_sg_ent(current_sg_node));
     new_subgoal_frame(sg_fr, sg_ent);
@@ -1121,12 +1779,52 @@ sg_fr_ptr subgoal_search(yamop *preg, CELL **Yaddr) {
       remove_from_global_sg_fr_list(sg_fr);
     }
 #endif /* LIMIT_TABLING */
+#ifdef TABLING_INCREMENTAL
+    if (SgFr_state(sg_fr) >= complete && SgFr_inc_dependencies(sg_fr) && incremental_subgoal_is_outdated(sg_fr)) {
+      /* an incremental predicate was updated after the subgoal was evaluated */
+      sg_fr = incremental_renew_subgoal_frame(sg_fr PASS_REGS);
+      *sg_fr_end = sg_fr;
+      TAG_AS_SUBGOAL_LEAF_NODE(current_sg_node);
+    }
+#endif /* TABLING_INCREMENTAL */
   }
+#ifdef TABLING_INCREMENTAL
+  /* the subgoals being evaluated depend on whatever the called subgoal depends on */
+  if (SgFr_inc_dependencies(sg_fr) && LOCAL_top_sg_fr)
+    incremental_inherit_dependencies(sg_fr);
+#endif /* TABLING_INCREMENTAL */
   UNLOCK_SUBGOAL_TRIE(tab_ent);
   return sg_fr;
 }
 
 
+#ifdef TABLING_INCREMENTAL
+void add_incremental_dependency(PredEntry *pe) {
+  CACHE_REGS
+  sg_fr_ptr sg_fr = LOCAL_top_sg_fr;
+
+  /* the dependencies of a subgoal being evaluated include the ones of the **
+  ** younger incremental subgoals, thus we can stop at the first subgoal   **
+  ** that already depends on the predicate                                 */
+  while (sg_fr) {
+    if (IsMode_Incremental(TabEnt_mode(SgFr_tab_ent(sg_fr)))) {
+      inc_dep_ptr dep = SgFr_inc_dependencies(sg_fr);
+      while (dep && IncDep_pred(dep) != pe)
+	dep = IncDep_next(dep);
+      if (dep)
+	return;
+      ALLOC_BLOCK(dep, sizeof(struct incremental_dependency), struct incremental_dependency);
+      IncDep_pred(dep) = pe;
+      IncDep_next(dep) = SgFr_inc_dependencies(sg_fr);
+      SgFr_inc_dependencies(sg_fr) = dep;
+    }
+    sg_fr = SgFr_next(sg_fr);
+  }
+  return;
+}
+#endif /* TABLING_INCREMENTAL */
+
+
 ans_node_ptr answer_search(sg_fr_ptr sg_fr, CELL *subs_ptr) {
 #define subs_arity *subs_ptr
   CACHE_REGS
@@ -1340,12 +2038,24 @@ void free_subgoal_trie(sg_node_ptr current_node, int mode, int position) {
   if (IS_SUBGOAL_TRIE_HASH(current_node)) {
     sg_node_ptr *bucket, *last_bucket;
     sg_hash_ptr hash;
+#ifdef SUBGOAL_TRIE_INSERT_WITH_CAS
+    int num_buckets;
+#endif /* SUBGOAL_TRIE_INSERT_WITH_CAS */
     hash = (sg_hash_ptr) current_node;
+#ifdef SUBGOAL_TRIE_INSERT_WITH_CAS
+    /* other threads may still insert in the hash: claim it as an expansion **
+    ** does, so that its nodes stay in their buckets while we visit them    */
+    do
+      TRIE_CAS_LOAD_HASH(hash, bucket, num_buckets);
+    while (! TRIE_CAS(&Hash_num_buckets(hash), num_buckets, -num_buckets));
+    last_bucket = bucket + num_buckets;
+#else
     bucket = Hash_buckets(hash);
     last_bucket = bucket + Hash_num_buckets(hash);
+#endif /* SUBGOAL_TRIE_INSERT_WITH_CAS */
     do {
       if (*bucket) {
-	sg_node_ptr next_node = *bucket;
+	sg_node_ptr next_node = TRIE_LOAD(*bucket);
 	do {
 	  current_node = next_node;
 	  next_node = TrNode_next(current_node);
@@ -1353,8 +2063,12 @@ void free_subgoal_trie(sg_node_ptr current_node, int mode, int position) {
 	} while (next_node);
       }
     } while (++bucket != last_bucket);
+#ifdef SUBGOAL_TRIE_INSERT_WITH_CAS
+    TRIE_STORE(Hash_num_buckets(hash), num_buckets);
+#endif /* SUBGOAL_TRIE_INSERT_WITH_CAS */
     IF_ABOLISH_SUBGOAL_TRIE_SHARED_DATA_STRUCTURES {
       FREE_BUCKETS(Hash_buckets(hash));
+      SgHash_free_old_buckets(hash);
       FREE_SUBGOAL_TRIE_HASH(hash);
     }
     return;
@@ -1383,16 +2097,42 @@ void free_subgoal_trie(sg_node_ptr current_node, int mode, int position) {
       child_mode = TRAVERSE_MODE_DOUBLE_END;
     else
       child_mode = TRAVERSE_MODE_NORMAL;
+#ifdef THREADS
+    { /* a node just inserted by another thread may not have children yet */
+      sg_node_ptr child_node;
+#ifdef SUBGOAL_TRIE_INSERT_WITH_CAS
+      /* freeze a chain while we visit it, so that it is not moved to a hash */
+      do
+        child_node = TRIE_LOAD(TrNode_child(current_node));
+      while (IS_TRIE_FROZEN(child_node) ||
+             (child_node && ! IS_SUBGOAL_TRIE_HASH(child_node) &&
+              ! TRIE_CAS(&TrNode_child(current_node), child_node, (sg_node_ptr) TRIE_FREEZE(child_node))));
+      if (child_node) {
+        int is_chain = ! IS_SUBGOAL_TRIE_HASH(child_node);
+        free_subgoal_trie(child_node, child_mode, TRAVERSE_POSITION_FIRST);
+        if (is_chain)
+          TRIE_STORE(TrNode_child(current_node), child_node);
+      }
+#else
+      child_node = TrNode_child(current_node);
+      if (child_node)
+        free_subgoal_trie(child_node, child_mode, TRAVERSE_POSITION_FIRST);
+#endif /* SUBGOAL_TRIE_INSERT_WITH_CAS */
+    }
+#else
     free_subgoal_trie(TrNode_child(current_node), child_mode, TRAVERSE_POSITION_FIRST);
+#endif /* THREADS */
   } else {
     sg_fr_ptr sg_fr = get_subgoal_frame_for_abolish(current_node PASS_REGS);
     if (sg_fr) {
-      ans_node_ptr ans_node;
-      free_answer_hash_chain(SgFr_hash_chain(sg_fr));
-      ans_node = SgFr_answer_trie(sg_fr);
-      if (TrNode_child(ans_node))
-	free_answer_trie(TrNode_child(ans_node), TRAVERSE_MODE_NORMAL, TRAVERSE_POSITION_FIRST);
+      /* the hash chain relinks the answer trie while it is being freed, so
+	 a shared answer trie must be left alone while other threads run */
       IF_ABOLISH_ANSWER_TRIE_SHARED_DATA_STRUCTURES {
+	ans_node_ptr ans_node;
+	free_answer_hash_chain(SgFr_hash_chain(sg_fr));
+	ans_node = SgFr_answer_trie(sg_fr);
+	if (TrNode_child(ans_node))
+	  free_answer_trie(TrNode_child(ans_node), TRAVERSE_MODE_NORMAL, TRAVERSE_POSITION_FIRST);
 	FREE_ANSWER_TRIE_NODE(ans_node);
 #if defined(THREADS_FULL_SHARING) || defined(THREADS_CONSUMER_SHARING)
 #ifdef MODE_DIRECTED_TABLING
@@ -1420,6 +2160,7 @@ void free_subgoal_trie(sg_node_ptr current_node, int mode, int position) {
       if (SgFr_mode_directed(sg_fr))
 	FREE_BLOCK(SgFr_mode_directed(sg_fr));
 #endif /* MODE_DIRECTED_TABLING && !THREADS_FULL_SHARING && !THREADS_CONSUMER_SHARING */
+      free_incremental_dependencies(sg_fr);
       FREE_SUBGOAL_FRAME(sg_fr);
     }
   }
@@ -1499,9 +2240,7 @@ void free_answer_trie(ans_node_ptr current_node, int mode, int position) {
 
 
 void free_answer_hash_chain(ans_hash_ptr hash) {
-#if defined(THREADS_NO_SHARING) || defined(THREADS_SUBGOAL_SHARING)
   CACHE_REGS
-#endif /* THREADS_NO_SHARING || THREADS_SUBGOAL_SHARING */
 
   while (hash) {
     ans_node_ptr chain_node, *bucket, *last_bucket;
@@ -1523,6 +2262,7 @@ void free_answer_hash_chain(ans_hash_ptr hash) {
     }
     next_hash = Hash_next(hash);
     FREE_BUCKETS(Hash_buckets(hash));
+    AnsHash_free_old_buckets(hash);
     FREE_ANSWER_TRIE_HASH(hash);
     hash = next_hash;
   }
@@ -1574,6 +2314,7 @@ void abolish_table(tab_ent_ptr tab_ent) {
 #ifdef LIMIT_TABLING
 	  remove_from_global_sg_fr_list(sg_fr);
 #endif /* LIMIT_TABLING */
+	  free_incremental_dependencies(sg_fr);
 	  FREE_SUBGOAL_FRAME(sg_fr);
 	}
       }
@@ -1584,6 +2325,9 @@ void abolish_table(tab_ent_ptr tab_ent) {
     FREE_SUBGOAL_TRIE_NODE(sg_node);
 #endif /* THREADS_NO_SHARING */
   }
+#ifdef TABLING_INCREMENTAL
+  incremental_free_retired_subgoal_frames(PASS_REGS1);
+#endif /* TABLING_INCREMENTAL */
   return;
 }
 
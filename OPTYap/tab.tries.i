@@ -16,10 +16,16 @@
 *********************/
 
 #ifdef MODE_GLOBAL_TRIE_ENTRY
+#ifdef THREADS
+/* the node locks do not cover the global trie entry, which other tries may share */
+#define INCREMENT_GLOBAL_TRIE_REFERENCE(ENTRY)                                                          \
+        __sync_fetch_and_add((CELL *) &TrNode_child((gt_node_ptr) (ENTRY)), 1)
+#else
 #define INCREMENT_GLOBAL_TRIE_REFERENCE(ENTRY)                                                          \
         { register gt_node_ptr entry_node = (gt_node_ptr) (ENTRY);                                      \
  	  TrNode_child(entry_node) = (gt_node_ptr) ((unsigned long int) TrNode_child(entry_node) + 1);  \
 	}
+#endif /* THREADS */
 #define NEW_SUBGOAL_TRIE_NODE(NODE, ENTRY, CHILD, PARENT, NEXT)        \
         INCREMENT_GLOBAL_TRIE_REFERENCE(ENTRY);                        \
         new_subgoal_trie_node(NODE, ENTRY, CHILD, PARENT, NEXT)
@@ -29,6 +35,8 @@
 #define NEW_GLOBAL_TRIE_NODE(NODE, ENTRY, CHILD, PARENT, NEXT)         \
         INCREMENT_GLOBAL_TRIE_REFERENCE(ENTRY);                        \
         new_global_trie_node(NODE, ENTRY, CHILD, PARENT, NEXT)
+#define CAS_INCREMENT_GLOBAL_TRIE_REFERENCE(ENTRY)                                                      \
+        __sync_fetch_and_add((CELL *) &TrNode_child((gt_node_ptr) (ENTRY)), 1)
 #else
 #define NEW_SUBGOAL_TRIE_NODE(NODE, ENTRY, CHILD, PARENT, NEXT)        \
         new_subgoal_trie_node(NODE, ENTRY, CHILD, PARENT, NEXT)
@@ -36,6 +44,7 @@
         new_answer_trie_node(NODE, INSTR, ENTRY, CHILD, PARENT, NEXT)
 #define NEW_GLOBAL_TRIE_NODE(NODE, ENTRY, CHILD, PARENT, NEXT)         \
         new_global_trie_node(NODE, ENTRY, CHILD, PARENT, NEXT)
+#define CAS_INCREMENT_GLOBAL_TRIE_REFERENCE(ENTRY)
 #endif /* MODE_GLOBAL_TRIE_ENTRY */
 
 
@@ -80,7 +89,83 @@
 ************************************************************************/
 
 #ifdef INCLUDE_SUBGOAL_TRIE_CHECK_INSERT
-#ifndef SUBGOAL_TRIE_LOCK_AT_WRITE_LEVEL /* SUBGOAL_TRIE_LOCK_AT_ENTRY_LEVEL || SUBGOAL_TRIE_LOCK_AT_NODE_LEVEL || ! YAPOR */
+#ifdef SUBGOAL_TRIE_INSERT_WITH_CAS
+#ifdef MODE_GLOBAL_TRIE_ENTRY
+static inline sg_node_ptr subgoal_trie_check_insert_gt_entry(tab_ent_ptr tab_ent, sg_node_ptr parent_node, Term t USES_REGS) {
+#else
+static inline sg_node_ptr subgoal_trie_check_insert_entry(tab_ent_ptr tab_ent, sg_node_ptr parent_node, Term t USES_REGS) {
+#endif /* MODE_GLOBAL_TRIE_ENTRY */
+  sg_node_ptr child_node, first_node, new_node = NULL;
+  sg_hash_ptr hash;
+  int count_nodes;
+
+subgoal_trie_chain:
+  first_node = TRIE_LOAD(TrNode_child(parent_node));
+  if (IS_TRIE_FROZEN(first_node))
+    /* another thread is moving the chain to a hash */
+    goto subgoal_trie_chain;
+  if (first_node && IS_SUBGOAL_TRIE_HASH(first_node)) {
+    hash = (sg_hash_ptr) first_node;
+    goto subgoal_trie_hash;
+  }
+  count_nodes = 0;
+  for (child_node = first_node; child_node; child_node = TrNode_next(child_node)) {
+    if (TrNode_entry(child_node) == t) {
+      if (new_node)
+        FREE_SUBGOAL_TRIE_NODE(new_node);
+      return child_node;
+    }
+    count_nodes++;
+  }
+  if (new_node == NULL)
+    new_subgoal_trie_node(new_node, t, NULL, parent_node, first_node);
+  if (! TRIE_CAS_PUSH_NODE(&TrNode_child(parent_node), first_node, new_node))
+    goto subgoal_trie_chain;
+  CAS_INCREMENT_GLOBAL_TRIE_REFERENCE(t);
+  count_nodes++;
+  if (count_nodes >= MAX_NODES_PER_TRIE_LEVEL &&
+      TRIE_CAS(&TrNode_child(parent_node), new_node, (sg_node_ptr) TRIE_FREEZE(new_node))) {
+    /* alloc a new hash */
+    new_subgoal_trie_hash(hash, 0, tab_ent);
+    TRIE_CAS_MOVE_CHAIN_TO_HASH(sg_node_ptr, hash, new_node);
+    TRIE_STORE(TrNode_child(parent_node), (sg_node_ptr) hash);
+  }
+  return new_node;
+
+subgoal_trie_hash:
+  { /* trie nodes with hashing */
+    sg_node_ptr *bucket, *hash_buckets;
+    int num_buckets;
+
+    TRIE_CAS_LOAD_HASH(hash, hash_buckets, num_buckets);
+    bucket = hash_buckets + HASH_ENTRY(t, num_buckets);
+  subgoal_trie_bucket:
+    first_node = TRIE_LOAD(*bucket);
+    if (IS_TRIE_FROZEN(first_node))
+      goto subgoal_trie_hash;
+    count_nodes = 0;
+    for (child_node = first_node; child_node; child_node = TrNode_next(child_node)) {
+      if (TrNode_entry(child_node) == t) {
+        if (new_node)
+          FREE_SUBGOAL_TRIE_NODE(new_node);
+        return child_node;
+      }
+      count_nodes++;
+    }
+    if (new_node == NULL)
+      new_subgoal_trie_node(new_node, t, NULL, parent_node, first_node);
+    if (! TRIE_CAS_PUSH_NODE(bucket, first_node, new_node))
+      goto subgoal_trie_bucket;
+    CAS_INCREMENT_GLOBAL_TRIE_REFERENCE(t);
+    count_nodes++;
+    if (__sync_add_and_fetch(&Hash_num_nodes(hash), 1) > num_buckets && count_nodes >= MAX_NODES_PER_BUCKET &&
+        TRIE_CAS(&Hash_num_buckets(hash), num_buckets, -num_buckets))
+      /* expand current hash */
+      TRIE_CAS_EXPAND_HASH(sg_node_ptr, hash, hash_buckets, num_buckets);
+    return new_node;
+  }
+}
+#elif !defined(SUBGOAL_TRIE_LOCK_AT_WRITE_LEVEL) /* SUBGOAL_TRIE_LOCK_AT_ENTRY_LEVEL || SUBGOAL_TRIE_LOCK_AT_NODE_LEVEL || ! YAPOR */
 #ifdef MODE_GLOBAL_TRIE_ENTRY
 static inline sg_node_ptr subgoal_trie_check_insert_gt_entry(tab_ent_ptr tab_ent, sg_node_ptr parent_node, Term t USES_REGS) {
 #else
@@ -379,7 +464,84 @@ subgoal_trie_hash:
 ************************************************************************/
 
 #ifdef INCLUDE_ANSWER_TRIE_CHECK_INSERT
-#ifndef ANSWER_TRIE_LOCK_AT_WRITE_LEVEL /* ANSWER_TRIE_LOCK_AT_ENTRY_LEVEL || ANSWER_TRIE_LOCK_AT_NODE_LEVEL || ! YAPOR */
+#ifdef ANSWER_TRIE_INSERT_WITH_CAS
+#ifdef MODE_GLOBAL_TRIE_ENTRY
+static inline ans_node_ptr answer_trie_check_insert_gt_entry(sg_fr_ptr sg_fr, ans_node_ptr parent_node, Term t, int instr USES_REGS) {
+#else
+static inline ans_node_ptr answer_trie_check_insert_entry(sg_fr_ptr sg_fr, ans_node_ptr parent_node, Term t, int instr USES_REGS) {
+#endif /* MODE_GLOBAL_TRIE_ENTRY */
+  ans_node_ptr child_node, first_node, new_node = NULL;
+  ans_hash_ptr hash;
+  int count_nodes;
+
+  TABLING_ERROR_CHECKING(answer_trie_check_insert_(gt)_entry, IS_ANSWER_LEAF_NODE(parent_node));
+answer_trie_chain:
+  first_node = TRIE_LOAD(TrNode_child(parent_node));
+  if (IS_TRIE_FROZEN(first_node))
+    /* another thread is moving the chain to a hash */
+    goto answer_trie_chain;
+  if (first_node && IS_ANSWER_TRIE_HASH(first_node)) {
+    hash = (ans_hash_ptr) first_node;
+    goto answer_trie_hash;
+  }
+  count_nodes = 0;
+  for (child_node = first_node; child_node; child_node = TrNode_next(child_node)) {
+    if (TrNode_entry(child_node) == t) {
+      if (new_node)
+        FREE_ANSWER_TRIE_NODE(new_node);
+      return child_node;
+    }
+    count_nodes++;
+  }
+  if (new_node == NULL)
+    new_answer_trie_node(new_node, instr, t, NULL, parent_node, first_node);
+  if (! TRIE_CAS_PUSH_NODE(&TrNode_child(parent_node), first_node, new_node))
+    goto answer_trie_chain;
+  CAS_INCREMENT_GLOBAL_TRIE_REFERENCE(t);
+  count_nodes++;
+  if (count_nodes >= MAX_NODES_PER_TRIE_LEVEL &&
+      TRIE_CAS(&TrNode_child(parent_node), new_node, (ans_node_ptr) TRIE_FREEZE(new_node))) {
+    /* alloc a new hash */
+    new_answer_trie_hash(hash, 0, sg_fr);
+    TRIE_CAS_MOVE_CHAIN_TO_HASH(ans_node_ptr, hash, new_node);
+    TRIE_STORE(TrNode_child(parent_node), (ans_node_ptr) hash);
+  }
+  return new_node;
+
+answer_trie_hash:
+  { /* trie nodes with hashing */
+    ans_node_ptr *bucket, *hash_buckets;
+    int num_buckets;
+
+    TRIE_CAS_LOAD_HASH(hash, hash_buckets, num_buckets);
+    bucket = hash_buckets + HASH_ENTRY(t, num_buckets);
+  answer_trie_bucket:
+    first_node = TRIE_LOAD(*bucket);
+    if (IS_TRIE_FROZEN(first_node))
+      goto answer_trie_hash;
+    count_nodes = 0;
+    for (child_node = first_node; child_node; child_node = TrNode_next(child_node)) {
+      if (TrNode_entry(child_node) == t) {
+        if (new_node)
+          FREE_ANSWER_TRIE_NODE(new_node);
+        return child_node;
+      }
+      count_nodes++;
+    }
+    if (new_node == NULL)
+      new_answer_trie_node(new_node, instr, t, NULL, parent_node, first_node);
+    if (! TRIE_CAS_PUSH_NODE(bucket, first_node, new_node))
+      goto answer_trie_bucket;
+    CAS_INCREMENT_GLOBAL_TRIE_REFERENCE(t);
+    count_nodes++;
+    if (__sync_add_and_fetch(&Hash_num_nodes(hash), 1) > num_buckets && count_nodes >= MAX_NODES_PER_BUCKET &&
+        TRIE_CAS(&Hash_num_buckets(hash), num_buckets, -num_buckets))
+      /* expand current hash */
+      TRIE_CAS_EXPAND_HASH(ans_node_ptr, hash, hash_buckets, num_buckets);
+    return new_node;
+  }
+}
+#elif !defined(ANSWER_TRIE_LOCK_AT_WRITE_LEVEL) /* ANSWER_TRIE_LOCK_AT_ENTRY_LEVEL || ANSWER_TRIE_LOCK_AT_NODE_LEVEL || ! YAPOR */
 #ifdef MODE_GLOBAL_TRIE_ENTRY
 static inline ans_node_ptr answer_trie_check_insert_gt_entry(sg_fr_ptr sg_fr, ans_node_ptr parent_node, Term t, int instr USES_REGS) {
 #else
@@ -680,7 +842,83 @@ answer_trie_hash:
 ************************************************************************/
 
 #ifdef INCLUDE_GLOBAL_TRIE_CHECK_INSERT
-#ifndef GLOBAL_TRIE_LOCK_AT_WRITE_LEVEL /* GLOBAL_TRIE_LOCK_AT_NODE_LEVEL || ! YAPOR */
+#ifdef GLOBAL_TRIE_INSERT_WITH_CAS
+#ifdef MODE_GLOBAL_TRIE_ENTRY
+static inline gt_node_ptr global_trie_check_insert_gt_entry(gt_node_ptr parent_node, Term t USES_REGS) {
+#else
+static inline gt_node_ptr global_trie_check_insert_entry(gt_node_ptr parent_node, Term t USES_REGS) {
+#endif /* MODE_GLOBAL_TRIE_ENTRY */
+  gt_node_ptr child_node, first_node, new_node = NULL;
+  gt_hash_ptr hash;
+  int count_nodes;
+
+global_trie_chain:
+  first_node = TRIE_LOAD(TrNode_child(parent_node));
+  if (IS_TRIE_FROZEN(first_node))
+    /* another thread is moving the chain to a hash */
+    goto global_trie_chain;
+  if (first_node && IS_GLOBAL_TRIE_HASH(first_node)) {
+    hash = (gt_hash_ptr) first_node;
+    goto global_trie_hash;
+  }
+  count_nodes = 0;
+  for (child_node = first_node; child_node; child_node = TrNode_next(child_node)) {
+    if (TrNode_entry(child_node) == t) {
+      if (new_node)
+        FREE_GLOBAL_TRIE_NODE(new_node);
+      return child_node;
+    }
+    count_nodes++;
+  }
+  if (new_node == NULL)
+    new_global_trie_node(new_node, t, NULL, parent_node, first_node);
+  if (! TRIE_CAS_PUSH_NODE(&TrNode_child(parent_node), first_node, new_node))
+    goto global_trie_chain;
+  CAS_INCREMENT_GLOBAL_TRIE_REFERENCE(t);
+  count_nodes++;
+  if (count_nodes >= MAX_NODES_PER_TRIE_LEVEL &&
+      TRIE_CAS(&TrNode_child(parent_node), new_node, (gt_node_ptr) TRIE_FREEZE(new_node))) {
+    /* alloc a new hash */
+    new_global_trie_hash(hash, 0);
+    TRIE_CAS_MOVE_CHAIN_TO_HASH(gt_node_ptr, hash, new_node);
+    TRIE_STORE(TrNode_child(parent_node), (gt_node_ptr) hash);
+  }
+  return new_node;
+
+global_trie_hash:
+  { /* trie nodes with hashing */
+    gt_node_ptr *bucket, *hash_buckets;
+    int num_buckets;
+
+    TRIE_CAS_LOAD_HASH(hash, hash_buckets, num_buckets);
+    bucket = hash_buckets + HASH_ENTRY(t, num_buckets);
+  global_trie_bucket:
+    first_node = TRIE_LOAD(*bucket);
+    if (IS_TRIE_FROZEN(first_node))
+      goto global_trie_hash;
+    count_nodes = 0;
+    for (child_node = first_node; child_node; child_node = TrNode_next(child_node)) {
+      if (TrNode_entry(child_node) == t) {
+        if (new_node)
+          FREE_GLOBAL_TRIE_NODE(new_node);
+        return child_node;
+      }
+      count_nodes++;
+    }
+    if (new_node == NULL)
+      new_global_trie_node(new_node, t, NULL, parent_node, first_node);
+    if (! TRIE_CAS_PUSH_NODE(bucket, first_node, new_node))
+      goto global_trie_bucket;
+    CAS_INCREMENT_GLOBAL_TRIE_REFERENCE(t);
+    count_nodes++;
+    if (__sync_add_and_fetch(&Hash_num_nodes(hash), 1) > num_buckets && count_nodes >= MAX_NODES_PER_BUCKET &&
+        TRIE_CAS(&Hash_num_buckets(hash), num_buckets, -num_buckets))
+      /* expand current hash */
+      TRIE_CAS_EXPAND_HASH(gt_node_ptr, hash, hash_buckets, num_buckets);
+    return new_node;
+  }
+}
+#elif !defined(GLOBAL_TRIE_LOCK_AT_WRITE_LEVEL) /* GLOBAL_TRIE_LOCK_AT_NODE_LEVEL || ! YAPOR */
 #ifdef MODE_GLOBAL_TRIE_ENTRY
 static inline gt_node_ptr global_trie_check_insert_gt_entry(gt_node_ptr parent_node, Term t USES_REGS) {
 #else
@@ -1601,6 +1839,7 @@ static void invalidate_answer_trie(ans_node_ptr current_node, sg_fr_ptr sg_fr, i
     else
       SgFr_hash_chain(sg_fr) = Hash_next(hash);
     FREE_BUCKETS(Hash_buckets(hash));
+    AnsHash_free_old_buckets(hash);
     FREE_ANSWER_TRIE_HASH(hash);
   } else {
     if (position == TRAVERSE_POSITION_FIRST) {
@@ -1788,6 +2027,7 @@ static inline CELL *load_answer_loop(ans_node_ptr current_node USES_REGS) {
 ***************************/
 
 #undef INCREMENT_GLOBAL_TRIE_REFERENCE
+#undef CAS_INCREMENT_GLOBAL_TRIE_REFERENCE
 #undef NEW_SUBGOAL_TRIE_NODE
 #undef NEW_ANSWER_TRIE_NODE
 #undef NEW_GLOBAL_TRIE_NODE
@@ -389,6 +389,7 @@ index(working_directory,2,operating_system_support,library(system)).
 index(term_hash,2,terms,library(terms)).
 index(term_hash,4,terms,library(terms)).
 index(instantiated_term_hash,4,terms,library(terms)).
+index(variant_term_hash,4,terms,library(terms)).
 index(variant,2,terms,library(terms)).
 index(unifiable,3,terms,library(terms)).
 index(subsumes,2,terms,library(terms)).
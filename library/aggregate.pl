@@ -121,8 +121,6 @@ _|The development of this library was sponsored by SecuritEase,
 	term_variables/3 is a SWI-Prolog with a *|different definition|*.
 @tbd	Analysing the aggregation template and compiling a predicate
 	for the list aggregation can be done at compile time.
-@tbd	aggregate_all/3 can be rewritten to run in constant space using
-	non-backtrackable assignment on a term.
 */
 
 		 /*******************************
@@ -153,8 +151,57 @@ aggregate(Template, Discriminator, Goal0, Result) :-
 %%	aggregate_all(+Template, :Goal, -Result) is semidet.
 %
 %	Aggregate bindings in Goal according to Template.  The aggregate_all/3
-%	version performs findall/3 on Goal.
-
+%	version performs findall/3 on Goal.  The count, sum and max
+%	(min) templates run in constant space: they keep a running
+%	result in a term updated with nb_setarg/3 instead of building
+%	the list of solutions.
+
+aggregate_all(count, Goal, Count) :- !,
+	State = count(0),
+	(   call(Goal),
+	    arg(1, State, C0),
+	    C is C0+1,
+	    nb_setarg(1, State, C),
+	    fail
+	;   arg(1, State, Count)
+	).
+aggregate_all(sum(X), Goal, Sum) :- !,
+	State = sum(0),
+	(   call(Goal),
+	    arg(1, State, S0),
+	    S is S0+X,
+	    nb_setarg(1, State, S),
+	    fail
+	;   arg(1, State, Sum)
+	).
+aggregate_all(max(X), Goal, Max) :- !,
+	State = max([]),
+	(   call(Goal),
+	    arg(1, State, M0),
+	    (   M0 == []
+	    ->  M is X
+	    ;   M is max(M0,X)
+	    ),
+	    nb_setarg(1, State, M),
+	    fail
+	;   arg(1, State, M),
+	    M \== [],
+	    Max = M
+	).
+aggregate_all(min(X), Goal, Min) :- !,
+	State = min([]),
+	(   call(Goal),
+	    arg(1, State, M0),
+	    (   M0 == []
+	    ->  M is X
+	    ;   M is min(M0,X)
+	    ),
+	    nb_setarg(1, State, M),
+	    fail
+	;   arg(1, State, M),
+	    M \== [],
+	    Min = M
+	).
 aggregate_all(Template, Goal0, Result) :-
 	template_to_pattern(all, Template, Pattern, Goal0, Goal, Aggregate),
 	findall(Pattern, Goal, List),
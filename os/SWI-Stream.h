@@ -321,6 +321,7 @@ PL_EXPORT(int)		Sungetc(int c, IOSTREAM *s);
 PL_EXPORT(int)		Scanrepresent(int c, IOSTREAM *s);
 PL_EXPORT(int)		Sputcode(int c, IOSTREAM *s);
 PL_EXPORT(int)		Sgetcode(IOSTREAM *s);
+PL_EXPORT(size_t)	Sgetcodes(IOSTREAM *s, int *buf, size_t limit, int stop);
 PL_EXPORT(int)		Sungetcode(int c, IOSTREAM *s);
 					/* word I/O */
 PL_EXPORT(int)		Sputw(int w, IOSTREAM *s);
@@ -2322,10 +2322,159 @@ PRED_IMPL("read_pending_input", 3, read_pending_input, 0)
     return FALSE;
   }
 
+  return FALSE;
+}
+
+
+		 /*******************************
+		 *	      READUTIL		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Foreign versions of the time-critical predicates of library(readutil).
+They are defined in module read_util, where readutil.pl finds them and
+skips its Prolog fallbacks.  Input is decoded in blocks by Sgetcodes()
+into a buffer, after which the list is created in one go.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define READ_CHUNK 4096			/* codes per Sgetcodes() call */
+
+static int
+read_codes_to_buffer(IOSTREAM *s, Buffer b, int stop)
+{ for(;;)
+  { size_t n;
+
+    if ( freeSpaceBuffer(b) < READ_CHUNK*sizeof(int) &&
+	 !growBuffer(b, READ_CHUNK*sizeof(int)) )
+      outOfCore();
+
+    n = Sgetcodes(s, topBuffer(b, int), READ_CHUNK, stop);
+    b->top += n*sizeof(int);
+    if ( n > 0 && topBuffer(b, int)[-1] == stop )
+      return TRUE;
+    if ( n < READ_CHUNK )
+      return FALSE;			/* end-of-file or error */
+  }
+}
+
+
+static int
+unify_code_list(term_t head, term_t tail, const int *codes, size_t len)
+{ list_ctx ctx;
+  size_t i;
+
+  if ( len == 0 )
+    return tail ? PL_unify(head, tail) : PL_unify_nil(head);
+
+  if ( !allocList(len, &ctx) )
+    return FALSE;
+  for(i=0; i<len; i++)
+    addSmallIntList(&ctx, codes[i]);
+
+  return tail ? unifyDiffList(head, tail, &ctx) : unifyList(head, &ctx);
+}
+
+
+static foreign_t
+read_line_to_codes(term_t stream, term_t codes, term_t tail ARG_LD)
+{ IOSTREAM *s;
+
+  if ( getInputStream(stream, &s) )
+  { tmp_buffer b;
+    int eol, rc;
+    int *base;
+    size_t len;
+
+    initBuffer(&b);
+    eol = read_codes_to_buffer(s, (Buffer)&b, '\n');
+    if ( Sferror(s) )
+    { discardBuffer(&b);
+      return streamStatus(s);
+    }
+    base = baseBuffer(&b, int);
+    len  = entriesBuffer(&b, int);
+
+    if ( tail )				/* keep newline, Tail = [] at EOF */
+    { rc = ( unify_code_list(codes, tail, base, len) &&
+	     (eol || PL_unify_nil(tail)) );
+    } else if ( !eol && len == 0 )
+    { rc = PL_unify_atom(codes, ATOM_end_of_file);
+    } else				/* strip \n and every \r */
+    { size_t i, n;
+
+      if ( eol )
+	len--;
+      for(i=n=0; i<len; i++)
+      { if ( base[i] != '\r' )
+	  base[n++] = base[i];
+      }
+      rc = unify_code_list(codes, 0, base, n);
+    }
+    discardBuffer(&b);
+
+    if ( rc )
+      return streamStatus(s);
+    releaseStream(s);
+  }
+
   return FALSE;
 }
 
 
+static foreign_t
+read_stream_to_codes(term_t stream, term_t codes, term_t tail ARG_LD)
+{ IOSTREAM *s;
+
+  if ( getInputStream(stream, &s) )
+  { tmp_buffer b;
+    int rc;
+
+    initBuffer(&b);
+    read_codes_to_buffer(s, (Buffer)&b, -1);
+    if ( Sferror(s) )
+    { discardBuffer(&b);
+      return streamStatus(s);
+    }
+    rc = unify_code_list(codes, tail,
+			 baseBuffer(&b, int), entriesBuffer(&b, int));
+    discardBuffer(&b);
+
+    if ( rc )
+      return streamStatus(s);
+    releaseStream(s);
+  }
+
+  return FALSE;
+}
+
+
+static
+PRED_IMPL("read_line_to_codes", 2, read_line_to_codes2, 0)
+{ PRED_LD
+  return read_line_to_codes(A1, A2, 0 PASS_LD);
+}
+
+
+static
+PRED_IMPL("read_line_to_codes", 3, read_line_to_codes3, 0)
+{ PRED_LD
+  return read_line_to_codes(A1, A2, A3 PASS_LD);
+}
+
+
+static
+PRED_IMPL("read_stream_to_codes", 2, read_stream_to_codes2, 0)
+{ PRED_LD
+  return read_stream_to_codes(A1, A2, 0 PASS_LD);
+}
+
+
+static
+PRED_IMPL("read_stream_to_codes", 3, read_stream_to_codes3, 0)
+{ PRED_LD
+  return read_stream_to_codes(A1, A2, A3 PASS_LD);
+}
+
 static foreign_t
 put_byte(term_t stream, term_t byte ARG_LD)
 { IOSTREAM *s;
@@ -4669,6 +4818,14 @@ BeginPredDefs(file)
 //vsc
 EndPredDefs
 
+
+BeginPredDefs(readutil)
+  PRED_DEF("read_line_to_codes", 2, read_line_to_codes2, 0)
+  PRED_DEF("read_line_to_codes", 3, read_line_to_codes3, 0)
+  PRED_DEF("read_stream_to_codes", 2, read_stream_to_codes2, 0)
+  PRED_DEF("read_stream_to_codes", 3, read_stream_to_codes3, 0)
+EndPredDefs
+
 #if __YAP_PROLOG__
 
 void Yap_flush(void)
@@ -4734,6 +4891,10 @@ void *Yap_GetOutputStream(Atom at)
   return s;
 }
 
+void Yap_ReleaseStream(void *s)
+{ releaseStream((IOSTREAM *)s);
+}
+
 static int
 pl_get_time(term_t t)
 { return PL_unify_float(t, WallTime());
@@ -4820,6 +4981,7 @@ init_yap(void)
   PL_register_extensions(PL_predicates_from_read);
   PL_register_extensions(PL_predicates_from_tai);
   PL_register_extensions(PL_predicates_from_prologflag);
+  PL_register_extensions_in_module("read_util", PL_predicates_from_readutil);
 #ifdef __WINDOWS__
   PL_register_extensions(PL_predicates_from_win);
 #endif
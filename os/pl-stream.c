@@ -911,10 +911,41 @@ Scanrepresent(int c, IOSTREAM *s)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Encodings for which a byte below 0x80 always is the character itself.
+For these, Sgetcode() and Sgetcodes() can take printable ASCII straight
+from the buffer.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static inline int
+ascii_compatible(IOENC enc)
+{ return ( enc == ENC_UTF8 ||
+	   enc == ENC_ISO_LATIN_1 ||
+	   enc == ENC_OCTET ||
+	   enc == ENC_ASCII );
+}
+
+
 int
 Sgetcode(IOSTREAM *s)
 { int c;
 
+  if ( s->bufp < s->limitp && !s->tee && ascii_compatible(s->encoding) )
+  { c = *(unsigned char*)s->bufp;
+
+    if ( c > '\r' && c < 0x80 )	/* printable ASCII: no CR/NL/TAB logic */
+    { IOPOS *p = s->position;
+
+      s->bufp++;
+      if ( p )
+      { p->byteno++;
+	p->charno++;
+	p->linepos++;
+      }
+      return c;
+    }
+  }
+
 retry:
   switch(s->encoding)
   { case ENC_OCTET:
@@ -1064,6 +1095,169 @@ out:
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Sgetcodes() reads up to `limit' character codes into `buf', stopping
+after the code `stop' has been stored (pass -1 to read until `limit' or
+end-of-file).  The result is the same as calling Sgetcode() repeatedly,
+but for ASCII compatible encodings the buffer is decoded in runs:
+printable ASCII is tested and copied a word at a time, complete UTF-8
+sequences are validated and decoded in place, and the stream position
+is updated once per run.  Anything the run cannot handle (a malformed,
+overlong or split UTF-8 sequence, an exhausted buffer, a tee, another
+encoding) is passed to Sgetcode().
+
+Returns the number of codes stored.  A result below `limit' whose last
+code is not `stop' means end-of-file or an error; use Sferror() to
+distinguish.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define SWAR_ONES  (~(uintptr_t)0/0xff)
+#define SWAR_HIGH  (SWAR_ONES*0x80)
+					/* a byte is < 0x0e or >= 0x80 */
+#define SWAR_SPECIAL(w) ((((w) - SWAR_ONES*0x0e) | (w)) & SWAR_HIGH)
+
+static size_t
+Sdecode_run(IOSTREAM *s, int *buf, size_t limit, int stop, int *stopped)
+{ const unsigned char *p0 = (const unsigned char *)s->bufp;
+  const unsigned char *p  = p0;
+  const unsigned char *e  = (const unsigned char *)s->limitp;
+  int *o = buf, *oe = buf+limit;
+  IOPOS *pos = s->position;
+  int linepos = pos ? pos->linepos : 0;
+  int lines = 0, newline = FALSE;
+  int words = ( stop < 0x0e || stop >= 0x80 );
+  IOENC enc = s->encoding;
+
+  while ( o < oe )
+  { int c;
+
+    if ( words )
+    { while ( oe-o >= (ptrdiff_t)sizeof(uintptr_t) &&
+	      e-p >= (ptrdiff_t)sizeof(uintptr_t) )
+      { uintptr_t w;
+	size_t i;
+
+	memcpy(&w, p, sizeof(w));
+	if ( SWAR_SPECIAL(w) )
+	  break;
+	for(i=0; i<sizeof(w); i++)
+	  o[i] = p[i];
+	o += sizeof(w);
+	p += sizeof(w);
+	linepos += sizeof(w);
+      }
+      if ( o == oe )
+	break;
+    }
+
+    if ( p == e )
+      break;
+    c = *p;
+
+    if ( c > '\r' && c < 0x80 )
+    { p++;
+      linepos++;
+    } else if ( c >= 0x80 )
+    { if ( enc == ENC_UTF8 )
+      { int extra = UTF8_FBN(c);
+	int i;
+
+	if ( extra < 0 || e-p <= extra )
+	  break;			/* illegal start or split sequence */
+	c = UTF8_FBV(c, extra);
+	for(i=1; i<=extra; i++)
+	{ if ( !ISUTF8_CB(p[i]) )
+	    goto out;			/* let Sgetcode() report it */
+	  c = (c<<6)+(p[i]&0x3f);
+	}
+	if ( c < 0x80 )
+	  break;			/* overlong: may be a layout char */
+	p += extra+1;
+      } else if ( enc == ENC_ASCII && c > 128 )
+      { break;				/* let Sgetcode() warn */
+      } else
+      { p++;
+      }
+      linepos++;
+    } else
+    { switch(c)
+      { case '\n':
+	  lines++;
+	  linepos = 0;
+	  newline = TRUE;
+	  break;
+	case '\r':
+	  if ( (s->flags&SIO_TEXT) &&
+	       (s->newline == SIO_NL_DETECT || s->newline == SIO_NL_DOS) )
+	  { s->newline = SIO_NL_DOS;
+	    p++;			/* dropped, but counts as a byte */
+	    continue;
+	  }
+	  linepos = 0;
+	  newline = TRUE;
+	  break;
+	case '\b':
+	  if ( linepos > 0 )
+	    linepos--;
+	  break;
+	case '\t':
+	  linepos |= 7;
+	  /*FALLTHROUGH*/
+	default:
+	  linepos++;
+      }
+      p++;
+    }
+
+    *o++ = c;
+    if ( c == stop )
+    { *stopped = TRUE;
+      break;
+    }
+  }
+
+out:
+  s->bufp = (char *)p;
+  if ( pos )
+  { pos->byteno  += p-p0;
+    pos->charno  += o-buf;
+    pos->lineno  += lines;
+    pos->linepos  = linepos;
+  }
+  if ( newline )
+    s->flags &= ~SIO_NOLINEPOS;
+
+  return o-buf;
+}
+
+
+size_t
+Sgetcodes(IOSTREAM *s, int *buf, size_t limit, int stop)
+{ size_t n = 0;
+  int fast = ( !s->tee && ascii_compatible(s->encoding) );
+
+  while ( n < limit )
+  { int c;
+
+    if ( fast && s->bufp < s->limitp )
+    { int stopped = FALSE;
+
+      n += Sdecode_run(s, buf+n, limit-n, stop, &stopped);
+      if ( stopped || n == limit )
+	break;
+    }
+
+    if ( (c = Sgetcode(s)) == -1 )
+      break;
+    buf[n++] = c;
+    if ( c == stop )
+      break;
+  }
+
+  return n;
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 peek needs to keep track of the actual bytes processed because not doing
 so might lead to an  incorrect  byte-count   in  the  position term. The
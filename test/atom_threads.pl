@@ -0,0 +1,85 @@
+/* threads racing to create and look up the same new atoms, while the
+   atom table grows under them, must all get the same atom per name */
+
+t :-
+	current_prolog_flag(max_threads, 1), !,
+	format("atom_threads: skipped~n").
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("atom_threads: passed~n").
+t :-
+	format("atom_threads: FAILED~n"),
+	halt(1).
+
+threads(6).
+names(20000).
+
+check :-
+	message_queue_create(Q),
+	threads(N),
+	start(N, Q, Ids),
+	join(Ids),
+	collect(N, Q, [First|Lists]),
+	message_queue_destroy(Q),
+	same_atoms(Lists, First),
+	names(M),
+	length(First, M),
+	sort(First, Sorted),
+	length(Sorted, M).
+
+start(0, _, []) :- !.
+start(I, Q, [Id|Ids]) :-
+	thread_create(worker(I, Q), Id, []),
+	I1 is I-1,
+	start(I1, Q, Ids).
+
+join([]).
+join([Id|Ids]) :-
+	thread_join(Id, S),
+	S == true,
+	join(Ids).
+
+collect(0, _, []) :- !.
+collect(I, Q, [L|Ls]) :-
+	thread_get_message(Q, atoms(_, L)),
+	I1 is I-1,
+	collect(I1, Q, Ls).
+
+% each thread starts at a different name, and goes round the table twice:
+% the first time it mostly creates atoms, the second time it looks them up
+worker(I, Q) :-
+	names(M),
+	Start is (I * M) // 7,
+	walk(0, M, Start, Created),
+	walk(0, M, Start, Found),
+	Created == Found,
+	in_order(M, Start, Created, Atoms),
+	thread_send_message(Q, atoms(I, Atoms)).
+
+walk(M, M, _, []) :- !.
+walk(K, M, Start, [A|As]) :-
+	N is (Start + K) mod M,
+	number_codes(N, Cs),
+	atom_codes(A, [0'a,0't,0'h,0'_|Cs]),
+	K1 is K+1,
+	walk(K1, M, Start, As).
+
+% put the atoms back in name order, so that the lists can be compared
+in_order(M, Start, Atoms, Ordered) :-
+	Split is M - Start,
+	split(Split, Atoms, Tail, Head),
+	append_(Head, Tail, Ordered).
+
+split(0, L, [], L) :- !.
+split(N, [X|Xs], [X|Ys], Zs) :-
+	N1 is N-1,
+	split(N1, Xs, Ys, Zs).
+
+append_([], L, L).
+append_([X|Xs], L, [X|Ys]) :-
+	append_(Xs, L, Ys).
+
+same_atoms([], _).
+same_atoms([L|Ls], First) :-
+	L == First,
+	same_atoms(Ls, First).
@@ -0,0 +1,61 @@
+/* code space freed by a thread other than the one that allocated it,
+   while the owner is alive and after it has exited */
+
+t :-
+	current_prolog_flag(max_threads, 1), !,
+	format("code_cache: skipped~n").
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("code_cache: passed~n").
+t :-
+	format("code_cache: FAILED~n"),
+	halt(1).
+
+:- dynamic fact/2.
+
+clauses(5000).
+
+check :-
+	rounds(3).
+
+rounds(0) :- !.
+rounds(R) :-
+	% the owner is alive: its blocks go back on its remote list
+	run(add(main)),
+	in_thread(drop(main)),
+	run(add(main)),
+	run(drop(main)),
+	% the owner has exited: its blocks are freed by whoever drops them
+	in_thread(add(thread)),
+	run(drop(thread)),
+	in_thread(add(thread)),
+	in_thread(drop(thread)),
+	R1 is R-1,
+	rounds(R1).
+
+in_thread(G) :-
+	thread_create(run(G), Id, []),
+	thread_join(Id, S),
+	S == true.
+
+run(G) :-
+	call(G), !.
+
+add(Who) :-
+	clauses(N),
+	add(N, Who),
+	count(Who, N).
+
+add(0, _) :- !.
+add(I, Who) :-
+	assertz(fact(Who, f(I, [I, Who]))),
+	I1 is I-1,
+	add(I1, Who).
+
+drop(Who) :-
+	retractall(fact(Who, _)),
+	count(Who, 0).
+
+count(Who, N) :-
+	findall(X, fact(Who, X), L),
+	length(L, N).
@@ -0,0 +1,47 @@
+%
+% Exo tables: load_exo/1 facts answer every call pattern like the
+% same facts consulted, and each new call pattern builds one index.
+%
+% run as: echo "t. halt." | yap -l exo.pl
+%
+
+t :-
+	(   catch(exo, E, (print_message(error, E), fail))
+	->  format('exo: passed~n')
+	;   format('exo: FAILED~n'),
+	    halt(1)
+	).
+
+exo :-
+	tmp_file(exo, F),
+	atom_concat(F, '.pl', File),
+	open(File, write, S),
+	forall(between(1, 2000, I),
+	       ( J is I mod 37, K is I mod 5, format(S, 'e(~d, a~d, ~d).~n', [I, J, K]) )),
+	close(S),
+	load_exo([File]),
+	delete_file(File),
+	findall(I, e(I, a3, 1), L1),
+	findall(I, ref(I, a3, 1), L1),
+	findall(X-Y, e(77, X, Y), [a3-2]),
+	\+ e(77, a4, _),
+	findall(I, e(I, _, 4), L2),
+	findall(I, ref(I, _, 4), L2),
+	length(L2, 400),
+	trees(T0),
+	findall(I, e(I, a5, _), L3),
+	findall(I, ref(I, a5, _), L3),
+	trees(T1),
+	T1 =:= T0+1,
+	findall(I, e(I, a6, _), _),
+	trees(T2),
+	T2 =:= T1.
+
+ref(I, X, Y) :-
+	between(1, 2000, I),
+	J is I mod 37,
+	atomic_concat(a, J, X),
+	Y is I mod 5.
+
+trees(T) :-
+	statistics(indexing, [T|_]).
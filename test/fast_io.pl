@@ -0,0 +1,178 @@
+/* binary term exchange with fast_write/2 and fast_read/2 */
+
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("fast_io: passed~n").
+t :-
+	format("fast_io: FAILED~n"),
+	halt(1).
+
+check :-
+	tmp_file(fast_io, F),
+	round_trip(F),
+	shared(F),
+	cyclic(F),
+	truncated(F),
+	corrupted(F),
+	delete_file(F).
+
+% every term reads back as a variant of the one written
+round_trip(F) :-
+	terms(Ts),
+	write_terms(F, Ts),
+	read_terms(F, Rs),
+	variants(Ts, Rs).
+
+terms([[], foo, 'hello world', Latin1, Wide, WideF,
+       0, -1, 1000000000000, -4611686018427387904,
+       3.25, -2.5, 1.0e300,
+       String, WideString,
+       f(X,Y,X), [a|Y], g(_, Wide, h([X])), Long | Big]) :-
+	atom_codes(Latin1, [0'c,0'a,0'f,0xe9]),
+	atom_codes(Wide, [0x3b1,0x4e2d,0x1F600]),
+	WideF =.. [Wide, 1, Latin1],
+	string_to_atom(String, 'a string'),
+	string_to_atom(WideString, Wide),
+	numbers(20000, Long),
+	big_numbers(Big).
+
+big_numbers([B1, B2, R1, R2, f(B1, R1)]) :-
+	yap_flag(system_options, big_numbers), !,
+	B1 is 1 << 100,
+	B2 is 7 - (1 << 200),
+	R1 is 1 rdiv 3,
+	R2 is -22 rdiv 7.
+big_numbers([]).
+
+numbers(0, []) :- !.
+numbers(N, [N|Ns]) :-
+	N1 is N-1,
+	numbers(N1, Ns).
+
+variants([], []).
+variants([T|Ts], [R|Rs]) :-
+	\+ \+ ( numbervars(T, 0, _), numbervars(R, 0, _), T == R ),
+	variants(Ts, Rs).
+
+% a subterm written twice is read back once
+shared(F) :-
+	numbers(1000, L),
+	write_terms(F, [g(L, L)]),
+	read_terms(F, [R]),
+	arg(1, R, P),
+	setarg(1, P, changed),
+	arg(2, R, [changed|_]).
+
+% cyclic terms keep their cycles
+cyclic(F) :-
+	A = f(A, x),
+	L = [1,2|L],
+	write_terms(F, [A, L]),
+	read_terms(F, [B, M]),
+	B = f(C, x),
+	setarg(2, C, y),
+	arg(2, B, y),
+	M = [1,2|N],
+	setarg(1, N, 3),
+	M = [3|_].
+
+% every proper prefix of a record is an error, not a term
+truncated(F) :-
+	record_bytes(F, Bytes),
+	length(Bytes, Len),
+	truncated(1, Len, Bytes, F).
+
+truncated(Len, Len, _, _) :- !.
+truncated(N, Len, Bytes, F) :-
+	prefix(N, Bytes, Prefix),
+	write_bytes(F, Prefix),
+	read_error(F),
+	N1 is N+1,
+	truncated(N1, Len, Bytes, F).
+
+% a damaged record raises an error or gives some term, it never crashes
+corrupted(F) :-
+	record_bytes(F, [0'Y,0'B|Bytes]),
+	write_bytes(F, [0'Y,0'X|Bytes]),
+	read_error(F),
+	Bytes = [_|Body],
+	write_bytes(F, [0'Y,0'B,99|Body]),
+	read_error(F),
+	length(Bytes, Len),
+	corrupted(0, Len, [0'Y,0'B|Bytes], F).
+
+corrupted(Len, Len, _, _) :- !.
+corrupted(N, Len, Bytes, F) :-
+	Pos is N+2,
+	flip(Pos, Bytes, Damaged),
+	write_bytes(F, Damaged),
+	open(F, read, S, [type(binary)]),
+	catch(fast_read(S, _), error(_, _), true),
+	close(S),
+	N1 is N+1,
+	corrupted(N1, Len, Bytes, F).
+
+flip(0, [B|Bs], [D|Bs]) :- !,
+	D is B xor 0xff.
+flip(N, [B|Bs], [B|Ds]) :-
+	N1 is N-1,
+	flip(N1, Bs, Ds).
+
+record_bytes(F, Bytes) :-
+	X is 1 << 70,
+	string_to_atom(S, abc),
+	write_terms(F, [f(foo, S, X, [1,2,3], 2.5, g(Y, Y))]),
+	open(F, read, In, [type(binary)]),
+	read_bytes(In, Bytes),
+	close(In).
+
+read_error(F) :-
+	open(F, read, S, [type(binary)]),
+	catch((fast_read(S, _), Error = false), error(_, _), Error = true),
+	close(S),
+	Error == true.
+
+prefix(0, _, []) :- !.
+prefix(N, [B|Bs], [B|Ps]) :-
+	N1 is N-1,
+	prefix(N1, Bs, Ps).
+
+write_terms(F, Ts) :-
+	open(F, write, S, [type(binary)]),
+	write_terms_to(Ts, S),
+	close(S).
+
+write_terms_to([], _).
+write_terms_to([T|Ts], S) :-
+	fast_write(S, T),
+	write_terms_to(Ts, S).
+
+read_terms(F, Ts) :-
+	open(F, read, S, [type(binary)]),
+	fast_read(S, T),
+	read_terms_from(T, S, Ts),
+	close(S).
+
+read_terms_from(end_of_file, _, []) :- !.
+read_terms_from(T, S, [T|Ts]) :-
+	fast_read(S, T1),
+	read_terms_from(T1, S, Ts).
+
+write_bytes(F, Bytes) :-
+	open(F, write, S, [type(binary)]),
+	put_bytes(Bytes, S),
+	close(S).
+
+put_bytes([], _).
+put_bytes([B|Bs], S) :-
+	put_byte(S, B),
+	put_bytes(Bs, S).
+
+read_bytes(S, Bytes) :-
+	get_byte(S, B),
+	read_bytes(B, S, Bytes).
+
+read_bytes(-1, _, []) :- !.
+read_bytes(B, S, [B|Bs]) :-
+	get_byte(S, B1),
+	read_bytes(B1, S, Bs).
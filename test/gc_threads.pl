@@ -0,0 +1,75 @@
+/* garbage collect a large live heap with several marking threads, and
+   check that every cell kind and every shared variable survives */
+
+t :-
+	current_prolog_flag(max_threads, 1), !,
+	format("gc_threads: skipped~n").
+t :-
+	yap_flag(gc_threads, Old),
+	catch(check, E, (print_message(error, E), fail)), !,
+	yap_flag(gc_threads, Old),
+	format("gc_threads: passed~n").
+t :-
+	format("gc_threads: FAILED~n"),
+	halt(1).
+
+% well over the heap size where marking is shared out
+cells(150000).
+
+check :-
+	forall(member_(N, [1, 2, 4, 8]), with_threads(N)).
+
+with_threads(N) :-
+	yap_flag(gc_threads, N),
+	cells(C),
+	build(C, Vs, L),
+	statistics(garbage_collection, [G0|_]),
+	collect(3),
+	statistics(garbage_collection, [G1|_]),
+	G1 >= G0+3,
+	% bind the variables after the collections, through the list
+	bind(Vs, C),
+	walk(L, C).
+
+% garbage between the collections, so there is something to compact
+collect(0) :- !.
+collect(K) :-
+	cells(C),
+	build(C, _, _),
+	garbage_collect,
+	K1 is K-1,
+	collect(K1).
+
+% each element shares a variable with the list of variables and its
+% neighbour, and holds an atom, a small and a big integer, a float and
+% a string
+build(0, [], []) :- !.
+build(I, [V|Vs], [e(I, V, B, F, S, a, [I|W])|L]) :-
+	B is I << 70,
+	F is I/2,
+	number_codes(I, S),
+	I1 is I-1,
+	build(I1, Vs, L),
+	( L = [e(_, W, _, _, _, _, _)|_] -> true ; W = [] ).
+
+bind([], _).
+bind([V|Vs], I) :-
+	V = v(I),
+	I1 is I-1,
+	bind(Vs, I1).
+
+walk([], 0).
+walk([e(I, V, B, F, S, A, [I0|W])|L], I) :-
+	I0 == I,
+	V == v(I),
+	B =:= I << 70,
+	F =:= I/2,
+	number_codes(I, S),
+	A == a,
+	I1 is I-1,
+	( L = [e(_, W1, _, _, _, _, _)|_] -> W == W1 ; W == [] ),
+	walk(L, I1).
+
+member_(X, [X|_]).
+member_(X, [_|L]) :-
+	member_(X, L).
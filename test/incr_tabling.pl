@@ -0,0 +1,46 @@
+/* incremental tables are evaluated again after their dynamic
+   predicates change, and only then */
+
+:- dynamic edge/2, evals/1, unsupported/0.
+
+:- table path/2.
+
+% builds with threads have no incremental tabling
+:- catch((incremental(edge/2), incremental(path/2)),
+	 error(resource_error(tabling, _), _),
+	 assert(unsupported)).
+
+edge(a, b).
+edge(b, c).
+
+path(X, Y) :- count_eval, edge(X, Y).
+path(X, Y) :- edge(X, Z), path(Z, Y).
+
+count_eval :- retract(evals(N)), N1 is N+1, assert(evals(N1)).
+
+evals(0).
+
+reached(L) :- findall(Y, path(a, Y), L0), msort(L0, L).
+
+t :-
+	unsupported, !,
+	format("incr_tabling: skipped~n").
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("incr_tabling: passed~n").
+t :-
+	format("incr_tabling: FAILED~n"),
+	halt(1).
+
+check :-
+	reached([b,c]),
+	evals(N0),
+	reached([b,c]),
+	evals(N0),
+	assertz(edge(c, d)),
+	reached([b,c,d]),
+	evals(N1), N1 > N0,
+	reached([b,c,d]),
+	evals(N1),
+	retract(edge(b, c)),
+	reached([b]).
@@ -0,0 +1,72 @@
+/* the per-predicate indexing counters move when static, dynamic and
+   exo fact tables are first queried on their third argument */
+
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("index_stats: passed~n").
+t :-
+	format("index_stats: FAILED~n"),
+	halt(1).
+
+rows(1000).
+
+check :-
+	static_table,
+	dynamic_table,
+	exo_table.
+
+static_table :-
+	tmp_file(istat, F),
+	atom_concat(F, '.pl', File),
+	write_table(File, st),
+	consult(File),
+	delete_file(File),
+	moves(st(_, _, _, _)).
+
+dynamic_table :-
+	rows(N),
+	forall(between(1, N, I),
+	       ( row(I, A, B, C), assertz(dy(I, A, B, C)) )),
+	moves(dy(_, _, _, _)).
+
+exo_table :-
+	tmp_file(istat, F),
+	atom_concat(F, '.pl', File),
+	write_table(File, ex),
+	load_exo([File]),
+	delete_file(File),
+	moves(ex(_, _, _, _)).
+
+% query argument 3 alone, and see the counters go up
+moves(G) :-
+	arg(3, G, X),
+	predicate_property(G, indexing(T0, _, B0)),
+	statistics(indexing, [S0|_]),
+	X = c7,
+	findall(G, G, L),
+	length(L, 25),
+	predicate_property(G, indexing(T1, Args, B1)),
+	statistics(indexing, [S1|_]),
+	T1 > T0,
+	in(3, Args),
+	B1 > B0,
+	S1 > S0.
+
+in(X, [X|_]) :- !.
+in(X, [_|L]) :-
+	in(X, L).
+
+write_table(File, Name) :-
+	open(File, write, S),
+	rows(N),
+	forall(between(1, N, I),
+	       ( row(I, A, B, C), R =.. [Name, I, A, B, C],
+		 format(S, '~q.~n', [R]) )),
+	close(S).
+
+row(I, A, B, C) :-
+	J is I mod 13,
+	K is I mod 40,
+	atomic_concat(a, J, A),
+	atomic_concat(c, K, B),
+	C is I mod 3.
@@ -0,0 +1,51 @@
+/* thread message queues */
+
+t :-
+	current_prolog_flag(max_threads, 1), !,
+	format("message_queues: skipped~n").
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("message_queues: passed~n").
+t :-
+	format("message_queues: FAILED~n"),
+	halt(1).
+
+check :-
+	selective_receive,
+	queue_errors,
+	destroy_while_waiting.
+
+% a message that does not match leaves no bindings behind
+selective_receive :-
+	message_queue_create(Q),
+	thread_send_message(Q, p(1,2)),
+	thread_send_message(Q, p(3,3)),
+	thread_get_message(Q, p(X,X)),
+	X == 3,
+	\+ thread_peek_message(Q, p(Y,Y)),
+	var(Y),
+	thread_get_message(Q, p(A,B)),
+	A-B == 1-2,
+	message_queue_destroy(Q).
+
+queue_errors :-
+	catch(thread_send_message(no_such_queue, x), E1, true),
+	E1 = error(existence_error(queue, no_such_queue), _),
+	catch(thread_get_message(no_such_queue, x), E2, true),
+	E2 = error(existence_error(message_queue, no_such_queue), _),
+	message_queue_create(_, [alias(mq_test)]),
+	catch(thread_create(true, _, [alias(mq_test)]), E3, true),
+	E3 = error(permission_error(create, queue, alias(mq_test)), _),
+	message_queue_destroy(mq_test).
+
+% a receiver blocked on a queue that goes away gets an error
+destroy_while_waiting :-
+	message_queue_create(Q),
+	thread_create(catch(thread_get_message(Q, never),
+			    error(existence_error(message_queue, _), _),
+			    true),
+		      Id, []),
+	sleep(0.2),
+	message_queue_destroy(Q),
+	thread_join(Id, Status),
+	Status == true.
@@ -0,0 +1,74 @@
+/* or-parallel search: queens, puzzle and ham give the same solutions
+   however the workers share the search tree (run with -w N) */
+
+t :-
+	\+ yap_flag(system_options, or_parallelism), !,
+	format("or_parallel: skipped~n").
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("or_parallel: passed~n").
+t :-
+	format("or_parallel: FAILED~n"),
+	halt(1).
+
+check :-
+	parallel_findall(Q, queens(8, Q), Qs),
+	length(Qs, 92),
+	parallel_findall(S, puzzle(S), [[9,5,6,7,1,0,8,2]]),
+	parallel_findall(P, ham(P), Ps),
+	length(Ps, 140).
+
+% N queens
+
+queens(N, Qs) :-
+	range(1, N, Ns),
+	queens(Ns, [], Qs).
+
+queens([], Qs, Qs).
+queens(Unplaced, Safe, Qs) :-
+	sel(Q, Unplaced, Unplaced1),
+	\+ attacks(Q, 1, Safe),
+	queens(Unplaced1, [Q|Safe], Qs).
+
+attacks(Q, D, [Q1|_]) :- Q =:= Q1 + D.
+attacks(Q, D, [Q1|_]) :- Q =:= Q1 - D.
+attacks(Q, D, [_|Qs]) :- D1 is D + 1, attacks(Q, D1, Qs).
+
+range(N, N, [N]) :- !.
+range(M, N, [M|Ns]) :- M1 is M + 1, range(M1, N, Ns).
+
+% SEND + MORE = MONEY
+
+puzzle([S,E,N,D,M,O,R,Y]) :-
+	Ds0 = [0,1,2,3,4,5,6,7,8,9],
+	sel(S, Ds0, Ds1), S > 0,
+	sel(E, Ds1, Ds2),
+	sel(N, Ds2, Ds3),
+	sel(D, Ds3, Ds4),
+	sel(M, Ds4, Ds5), M > 0,
+	sel(O, Ds5, Ds6),
+	sel(R, Ds6, Ds7),
+	sel(Y, Ds7, _),
+	1000*S + 100*E + 10*N + D + 1000*M + 100*O + 10*R + E =:=
+	10000*M + 1000*O + 100*N + 10*E + Y.
+
+% Hamiltonian paths
+
+edge(a,b). edge(a,c). edge(a,d). edge(b,c). edge(b,e). edge(c,d).
+edge(c,f). edge(d,g). edge(e,f). edge(e,h). edge(f,g). edge(f,i).
+edge(g,j). edge(h,i). edge(h,k). edge(i,j). edge(i,l). edge(j,m).
+edge(k,l). edge(l,m). edge(k,a). edge(m,a). edge(b,h). edge(d,j).
+
+e(X, Y) :- edge(X, Y) ; edge(Y, X).
+
+ham(P) :-
+	path(a, [b,c,d,e,f,g,h,i,j,k,l,m], [a], P).
+
+path(_, [], P, P) :- !.
+path(X, Rest, Acc, P) :-
+	e(X, Y),
+	sel(Y, Rest, Rest1),
+	path(Y, Rest1, [Y|Acc], P).
+
+sel(X, [X|L], L).
+sel(X, [Y|L], [Y|R]) :- sel(X, L, R).
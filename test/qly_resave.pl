@@ -0,0 +1,45 @@
+%
+% Quick-load files: predicates loaded from a .qly file must survive
+% the file being rewritten, be it by qsave_module/1 or by anyone else.
+%
+% run as: echo "t. halt." | yap -l qly_resave.pl
+%
+
+t :-
+	(   catch(qly_resave, E, (print_message(error, E), fail))
+	->  format('qly_resave: passed~n')
+	;   format('qly_resave: FAILED~n'),
+	    halt(1)
+	).
+
+qly_resave :-
+	tmp_file(qly, Dir),
+	make_directory(Dir),
+	working_directory(Old, Dir),
+	call_cleanup(resave_in_dir, working_directory(_, Old)).
+
+resave_in_dir :-
+	open('qmod.pl', write, S),
+	format(S, ':- module(qmod, [p/2]).~n', []),
+	forall(between(1, 200, I),
+	       ( J is I*I, format(S, 'p(~d, f(~d, ~q)).~n', [I, J, "s"]) )),
+	format(S, 'q(X) :- p(X, _).~n', []),
+	close(S),
+	use_module(qmod),
+	qsave_module(qmod),
+	check_qmod,
+	% load from the file, save straight back on top of it
+	qload_module(qmod),
+	qsave_module(qmod),
+	check_qmod,
+	% again, but now truncate the file once it is loaded
+	qload_module(qmod),
+	open('qmod.qly', write, T),
+	close(T),
+	check_qmod.
+
+check_qmod :-
+	findall(X-Y, qmod:p(X, Y), L),
+	length(L, 200),
+	qmod:p(7, f(49, "s")),
+	qmod:q(200).
@@ -0,0 +1,79 @@
+/* the C versions of library(readutil) agree with the Prolog ones */
+
+:- prolog_load_context(directory, D),
+   atom_concat(D, '/../library', L),
+   atom_concat(D, '/../LGPL', LGPL),
+   atom_concat(D, '/../GPL', GPL),
+   assert(user:library_directory(L)),
+   assert(user:library_directory(LGPL)),
+   assert(user:library_directory(GPL)).
+
+:- use_module(library(readutil)).
+:- use_module(library(lists)).
+:- use_module(library(maplist)).
+
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("readutil: passed~n").
+t :-
+	format("readutil: FAILED~n"),
+	halt(1).
+
+check :-
+	Text = "a\rb\nxy\r\nlast\r",
+	lines(Text, read_line_to_codes, Lines),
+	lines(Text, read_util:pl_read_line_to_codes, PLines),
+	Lines == PLines,
+	Lines == ["ab", "xy", "last", end_of_file],
+	lines3(Text, read_line_to_codes, Lines3),
+	lines3(Text, read_util:pl_read_line_to_codes, PLines3),
+	Lines3 == PLines3,
+	Lines3 == ["a\rb\n", "xy\r\n", "last\r"],
+	whole(Text, read_stream_to_codes, All),
+	whole(Text, read_util:pl_read_stream_to_codes, PAll),
+	All == PAll,
+	All == Text,
+	lines("", read_line_to_codes, [end_of_file]),
+	lines("\r", read_line_to_codes, ["", end_of_file]),
+	long_line.
+
+% read_line_to_codes/2 until end_of_file
+lines(Text, Read, Lines) :-
+	with_text(Text, S, read_lines(S, Read, Lines)).
+
+read_lines(S, Read, [L|Ls]) :-
+	call(Read, S, L),
+	(   L == end_of_file
+	->  Ls = []
+	;   read_lines(S, Read, Ls)
+	).
+
+% read_line_to_codes/3 until the tail is []
+lines3(Text, Read, Lines) :-
+	with_text(Text, S, read_lines3(S, Read, Lines)).
+
+read_lines3(S, Read, [L|Ls]) :-
+	call(Read, S, L, T),
+	(   T == []
+	->  Ls = []
+	;   T = [],
+	    read_lines3(S, Read, Ls)
+	).
+
+whole(Text, Read, Codes) :-
+	with_text(Text, S, call(Read, S, Codes)).
+
+% lines longer than the block read by the C code
+long_line :-
+	length(L, 10000),
+	maplist(=(0'x), L),
+	append(L, [0'\n|L], Text),
+	lines(Text, read_line_to_codes, [L, L, end_of_file]).
+
+with_text(Text, S, Goal) :-
+	tmp_file(readutil, F),
+	open(F, write, O),
+	format(O, '~s', [Text]),
+	close(O),
+	open(F, read, S),
+	call_cleanup(Goal, (close(S), delete_file(F))).
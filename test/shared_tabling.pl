@@ -0,0 +1,81 @@
+/* several threads evaluating the same tables at once, whatever
+   --enable-table-sharing design the tables are shared with */
+
+t :-
+	current_prolog_flag(max_threads, 1), !,
+	format("shared_tabling: skipped~n").
+t :-
+	\+ yap_flag(system_options, tabling), !,
+	format("shared_tabling: skipped~n").
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("shared_tabling: passed~n").
+t :-
+	format("shared_tabling: FAILED~n"),
+	halt(1).
+
+:- table path/2, lpath/2, tri/3.
+:- tabling_mode(lpath/2, local).
+
+nodes(40).
+
+edge(X, Y) :-
+	nodes(N),
+	between(1, N, X),
+	( Y is X mod N + 1 ; Y is (X * 7) mod N + 1 ).
+
+path(X, Y) :- edge(X, Y).
+path(X, Y) :- path(X, Z), edge(Z, Y).
+
+lpath(X, Y) :- edge(X, Y).
+lpath(X, Y) :- edge(X, Z), lpath(Z, Y).
+
+% answers with compound terms and repeated subterms
+tri(X, Y, f(X, g(Y), [X,Y])) :- path(X, Y), X < Y.
+
+check :-
+	rounds(3).
+
+rounds(0) :- !.
+rounds(R) :-
+	abolish_all_tables,
+	numlist_(1, 6, Ids),
+	start(Ids, Threads),
+	join(Threads),
+	R1 is R-1,
+	rounds(R1).
+
+start([], []).
+start([I|Is], [T|Ts]) :-
+	thread_create(worker(I), T, []),
+	start(Is, Ts).
+
+join([]).
+join([T|Ts]) :-
+	thread_join(T, S),
+	S == true,
+	join(Ts).
+
+worker(I) :-
+	nodes(N),
+	N2 is N*N,
+	(   I mod 2 =:= 0
+	->  count(X-Y, path(X, Y), N2),
+	    count(Y, lpath(I, Y), N)
+	;   count(Y, lpath(I, Y), N),
+	    count(X-Y, path(X, Y), N2)
+	),
+	count(T, tri(I, _, T), C),
+	C =:= N-I,
+	count(Y, path(I, Y), N).
+
+count(T, G, N) :-
+	findall(T, G, L),
+	sort(L, S),
+	length(L, N),
+	length(S, N).
+
+numlist_(N, M, []) :- N > M, !.
+numlist_(N, M, [N|Ns]) :-
+	N1 is N+1,
+	numlist_(N1, M, Ns).
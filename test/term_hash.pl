@@ -0,0 +1,105 @@
+/* term_hash/4 and variant_term_hash/4 on small, deep and wide terms */
+
+:- prolog_load_context(directory, D),
+   atom_concat(D, '/../library', L),
+   assert(user:library_directory(L)).
+
+:- use_module(library(terms)).
+
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("term_hash: passed~n").
+t :-
+	format("term_hash: FAILED~n"),
+	halt(1).
+
+range(1073741824).
+
+check :-
+	variants,
+	kinds,
+	depth_limit,
+	deep,
+	wide.
+
+% variant terms hash alike, other terms apart
+variants :-
+	vh(f(X, g(Y, X), [Y]), H1),
+	vh(f(A, g(B, A), [B]), H1),
+	vh(f(Z, Z), H2),
+	vh(f(_, _), H3),
+	H2 =\= H3,
+	range(R),
+	term_hash(f(a, "s", 1.5, [1,2|c]), -1, R, H4),
+	H4 >= 0, H4 < R.
+
+% a variable, an integer, an atom, a float, a list and a compound
+% never share a hash by construction
+kinds :-
+	X = _,
+	BigI is 1 << 40,
+	Ts = [f(X), f(1), f(4), f(5), f(12), f(BigI), f(a), f('[]'), f(1.0),
+	      f([1]), f([X]), f(g), f(g(1)), f(g(X))],
+	hashes(Ts, Hs),
+	sort(Hs, S),
+	length(Ts, N),
+	length(S, N).
+
+depth_limit :-
+	range(R),
+	term_hash(f(a, g(b)), 2, R, H),
+	term_hash(f(a, g(c)), 2, R, H),
+	term_hash(f(a, g(b)), -1, R, H1),
+	term_hash(f(a, g(c)), -1, R, H2),
+	H1 =\= H2.
+
+% a chain of 300000 nested terms, with a variable at the bottom
+deep :-
+	nest(300000, X, T),
+	vh(T, H),
+	copy_term(T, C),
+	vh(C, H),
+	X = leaf,
+	range(R),
+	term_hash(T, -1, R, H1),
+	nest(300000, other, U),
+	term_hash(U, -1, R, H2),
+	H1 =\= H2.
+
+% a term with 200000 arguments and a list of 200000 elements
+wide :-
+	functor(T, w, 200000),
+	vh(T, H),
+	copy_term(T, C),
+	vh(C, H),
+	arg(1000, T, X),
+	arg(2000, T, X),
+	vh(T, H1),
+	H1 =\= H,
+	seq(200000, L),
+	range(R),
+	term_hash(L, -1, R, H2),
+	seq(200000, L2),
+	term_hash(L2, -1, R, H2),
+	L2 = [_|L3],
+	term_hash(L3, -1, R, H3),
+	H3 =\= H2.
+
+vh(T, H) :-
+	range(R),
+	variant_term_hash(T, -1, R, H).
+
+hashes([], []).
+hashes([T|Ts], [H|Hs]) :-
+	vh(T, H),
+	hashes(Ts, Hs).
+
+nest(0, X, X) :- !.
+nest(N, X, f(T)) :-
+	N1 is N-1,
+	nest(N1, X, T).
+
+seq(0, []) :- !.
+seq(N, [N|Ns]) :-
+	N1 is N-1,
+	seq(N1, Ns).
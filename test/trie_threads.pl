@@ -0,0 +1,86 @@
+/* threads inserting into the same subgoal, answer and global tries at
+   once, with some threads exiting while the others still read answers
+   through the global trie */
+
+t :-
+	current_prolog_flag(max_threads, 1), !,
+	format("trie_threads: skipped~n").
+t :-
+	\+ yap_flag(system_options, tabling), !,
+	format("trie_threads: skipped~n").
+t :-
+	catch(check, E, (print_message(error, E), fail)), !,
+	format("trie_threads: passed~n").
+t :-
+	format("trie_threads: FAILED~n"),
+	halt(1).
+
+:- table q/2, g/2.
+:- tabling_mode(g/2, global_trie).
+
+subgoals(2000).
+answers(40).
+gsubgoals(300).
+ganswers(30).
+
+% many subgoals, each with enough answers to hash its answer trie
+q(N, X) :-
+	answers(M),
+	between(1, M, I),
+	X is N*1000+I.
+
+% answers with compound terms, kept in the global trie
+g(N, f(X, [N, X])) :-
+	ganswers(M),
+	between(1, M, X).
+
+check :-
+	rounds(10).
+
+rounds(0) :- !.
+rounds(R) :-
+	abolish_all_tables,
+	numlist_(1, 8, Ids),
+	start(Ids, Threads),
+	join(Threads),
+	R1 is R-1,
+	rounds(R1).
+
+start([], []).
+start([I|Is], [T|Ts]) :-
+	thread_create(worker(I), T, []),
+	start(Is, Ts).
+
+join([]).
+join([T|Ts]) :-
+	thread_join(T, S),
+	S == true,
+	join(Ts).
+
+% each thread walks the subgoals in a different order, and the later
+% threads go round more times, so the first ones exit early
+worker(I) :-
+	Step is 2*I+1,
+	subgoals(N),
+	answers(A),
+	walk(0, N, Step, q, A),
+	gsubgoals(G),
+	ganswers(B),
+	Times is I // 2 + 1,
+	forall(between(1, Times, _), walk(0, G, Step, g, B)).
+
+walk(N, N, _, _, _) :- !.
+walk(K, N, Step, P, A) :-
+	S is (K*Step) mod N,
+	G =.. [P, S, X],
+	findall(X, G, L),
+	length(L, A),
+	sort(L, Sorted),
+	length(Sorted, A),
+	K1 is K+1,
+	walk(K1, N, Step, P, A).
+
+numlist_(N, M, []) :- N > M, !.
+numlist_(N, M, [N|Ns]) :-
+	N1 is N+1,
+	numlist_(N1, M, Ns).